@@ -0,0 +1,543 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "animationclock.h"
+#include "animationresultitem.h"
+#include "settings.h"
+#include "worksheet.h"
+#include "worksheetview.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+
+namespace
+{
+//frames without or with a very short delay are shown for 100ms like in the web browsers
+constexpr int DefaultFrameDelay = 100;
+constexpr int MinFrameDelay = 10;
+
+QImage readFrame(QImageReader& reader)
+{
+    QImage image = reader.read();
+    if (!image.isNull() && image.format() != QImage::Format_ARGB32_Premultiplied)
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    return image;
+}
+}
+
+AnimationClock::AnimationClock(Worksheet* worksheet) : QObject(worksheet),
+    m_worksheet(worksheet)
+{
+    setMaxSize(static_cast<qint64>(Settings::self()->animationCacheSize()) * 1024 * 1024);
+
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &AnimationClock::tick);
+    m_elapsed.start();
+}
+
+AnimationClock::~AnimationClock()
+{
+    //don't start the pending decodings and wait for the running ones, they refer to this object
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void AnimationClock::add(AnimationResultItem* item, const QString& fileName)
+{
+    if (m_players.contains(item))
+        remove(item);
+    else
+        connect(item, &QObject::destroyed, this, [this, item]() { remove(item); });
+
+    Player& player = m_players[item];
+    player.fileName = fileName;
+    player.fileId = fileId(fileName);
+    player.frames = frames(fileName, false);
+
+    //only the first frame is decoded right away, the other ones are decoded in the thread pool
+    item->showFrame(player.frames ? player.frames->images.value(0) : firstFrame(fileName));
+
+    if (m_worksheet && !m_viewConnection && !m_worksheet->views().isEmpty())
+        m_viewConnection = connect(m_worksheet->worksheetView(), &WorksheetView::viewRectChanged, this, &AnimationClock::updateVisibility);
+
+    start(item);
+}
+
+void AnimationClock::remove(AnimationResultItem* item)
+{
+    if (m_players.remove(item))
+        schedule();
+}
+
+void AnimationClock::start(AnimationResultItem* item)
+{
+    auto it = m_players.find(item);
+    if (it == m_players.end() || it->state == Running)
+        return;
+
+    if (it->state == Stopped)
+    {
+        //start from the beginning, the first frame is already shown
+        it->frame = 0;
+        it->loop = 0;
+        resetStream(*it);
+        if (!it->frames)
+            it->frames = frames(it->fileName, false);
+        it->due = m_elapsed.elapsed() + (it->frames && !it->frames->delays.isEmpty() ? it->frames->delays.constFirst() : DefaultFrameDelay);
+    }
+    else
+        it->due = m_elapsed.elapsed();
+
+    it->state = Running;
+    it->visible = isVisible(item);
+    if (!it->frames && isStreamed(it->fileId))
+        requestNextFrame(item, *it);
+    schedule();
+}
+
+void AnimationClock::pause(AnimationResultItem* item)
+{
+    auto it = m_players.find(item);
+    if (it == m_players.end() || it->state != Running)
+        return;
+
+    it->state = Paused;
+    schedule();
+}
+
+void AnimationClock::stop(AnimationResultItem* item)
+{
+    auto it = m_players.find(item);
+    if (it == m_players.end())
+        return;
+
+    it->state = Stopped;
+    it->frame = 0;
+    it->loop = 0;
+    resetStream(*it);
+    item->showFrame(it->frames ? it->frames->images.value(0) : firstFrame(it->fileName));
+
+    //the frames of a stopped animation can be dropped from the cache
+    it->frames.reset();
+    schedule();
+}
+
+AnimationClock::State AnimationClock::state(AnimationResultItem* item) const
+{
+    return m_players.value(item).state;
+}
+
+int AnimationClock::activeCount() const
+{
+    int count = 0;
+    for (const auto& player : m_players)
+        if (player.state == Running && player.visible)
+            ++count;
+
+    return count;
+}
+
+QImage AnimationClock::frame(const QString& fileName, int index)
+{
+    if (const auto& frames = this->frames(fileName, true))
+        return frames->images.value(index);
+
+    //the animation is too large to be cached, read up to the requested frame
+    QImageReader reader(fileName);
+    QImage image;
+    for (int i = 0; i <= index; ++i)
+    {
+        image = readFrame(reader);
+        if (image.isNull())
+            break;
+    }
+
+    return image;
+}
+
+int AnimationClock::frameCount(const QString& fileName)
+{
+    if (const auto& frames = this->frames(fileName, true))
+        return frames->images.size();
+
+    return QImageReader(fileName).imageCount();
+}
+
+void AnimationClock::setMaxSize(qint64 bytes)
+{
+    m_frames.setMaxCost(bytes);
+    m_streamed.clear();
+}
+
+qint64 AnimationClock::maxSize() const
+{
+    return m_frames.maxCost();
+}
+
+qint64 AnimationClock::size() const
+{
+    return m_frames.totalCost();
+}
+
+/*!
+ * checks which of the playing animations are visible in the view, called when the view is scrolled or resized.
+ * Animations becoming visible again continue with their next frame right away.
+ */
+void AnimationClock::updateVisibility()
+{
+    const qint64 now = m_elapsed.elapsed();
+    for (auto it = m_players.begin(); it != m_players.end(); ++it)
+    {
+        const bool visible = isVisible(it.key());
+        if (visible && !it->visible && it->state == Running)
+            it->due = now;
+        it->visible = visible;
+    }
+
+    schedule();
+}
+
+void AnimationClock::tick()
+{
+    const qint64 now = m_elapsed.elapsed();
+    for (auto it = m_players.begin(); it != m_players.end(); ++it)
+    {
+        if (it->state != Running)
+            continue;
+
+        //the items can also be moved out of the view by changes of the layout
+        it->visible = isVisible(it.key());
+        if (it->visible && it->due <= now)
+            advance(it.key(), *it);
+    }
+
+    schedule();
+}
+
+/*!
+ * starts the timer for the next due frame of the visible animations, the timer is stopped if there is none.
+ */
+void AnimationClock::schedule()
+{
+    qint64 next = -1;
+    for (const auto& player : std::as_const(m_players))
+    {
+        if (player.state == Running && player.visible && (next == -1 || player.due < next))
+            next = player.due;
+    }
+
+    if (next == -1)
+        m_timer.stop();
+    else
+        m_timer.start(static_cast<int>(qMax<qint64>(0, next - m_elapsed.elapsed())));
+}
+
+void AnimationClock::advance(AnimationResultItem* item, Player& player)
+{
+    QImage image;
+    int delay = DefaultFrameDelay;
+    const qint64 now = m_elapsed.elapsed();
+
+    if (!player.frames && !isStreamed(player.fileId))
+    {
+        //the frames are not decoded yet, the current frame stays visible
+        player.frames = frames(player.fileName, false);
+        if (!player.frames)
+        {
+            player.due = now + DefaultFrameDelay;
+            return;
+        }
+    }
+
+    if (const auto& frames = player.frames)
+    {
+        if (frames->images.isEmpty())
+        {
+            player.state = Stopped;
+            return;
+        }
+
+        int next = player.frame + 1;
+        if (next >= frames->images.size())
+        {
+            if (frames->loopCount != -1 && player.loop >= frames->loopCount)
+            {
+                player.state = Stopped;
+                return;
+            }
+            ++player.loop;
+            next = 0;
+        }
+
+        player.frame = next;
+        image = frames->images.value(next);
+        delay = frames->delays.value(next, DefaultFrameDelay);
+    }
+    else
+    {
+        //the frames don't fit into the cache, the next frame is decoded in advance
+        if (player.nextImage.isNull())
+        {
+            requestNextFrame(item, player);
+            player.due = now + MinFrameDelay;
+            return;
+        }
+
+        image = player.nextImage;
+        delay = player.nextDelay;
+        player.nextImage = QImage();
+        ++player.frame;
+        requestNextFrame(item, player);
+    }
+
+    player.due += delay;
+
+    //don't try to catch up with the frames missed while the application was busy
+    if (player.due < now)
+        player.due = now + delay;
+
+    if (!image.isNull())
+        item->showFrame(image);
+}
+
+/*!
+ * decodes the frame following the current frame of the animation not fitting into the cache in the thread pool.
+ */
+void AnimationClock::requestNextFrame(AnimationResultItem* item, Player& player)
+{
+    //the previous frame is still decoded or the next one is already available
+    if (player.request != 0 || !player.nextImage.isNull())
+        return;
+
+    //a new reader skips the frames shown already
+    int skip = 0;
+    if (!player.reader)
+    {
+        player.reader.reset(new QImageReader(player.fileName));
+        skip = player.frame + 1;
+    }
+
+    const auto reader = player.reader;
+    const quint64 request = ++m_requestCount;
+    player.request = request;
+    m_pool.start([this, item, reader, skip, request]() {
+        for (int i = 0; i < skip; ++i)
+            readFrame(*reader);
+
+        const QImage image = readFrame(*reader);
+        const int delay = AnimationClock::delay(reader->nextImageDelay());
+        const int loopCount = reader->loopCount();
+        QMetaObject::invokeMethod(this, [this, item, image, delay, loopCount, request]() {
+            //the animation was stopped or removed in the meantime
+            auto it = m_players.find(item);
+            if (it == m_players.end() || it->request != request)
+                return;
+
+            it->request = 0;
+            frameDecoded(*it, image, delay, loopCount);
+            if (it->state == Running && it->request == 0 && it->nextImage.isNull())
+                requestNextFrame(item, *it);
+            schedule();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void AnimationClock::frameDecoded(Player& player, const QImage& image, int delay, int loopCount)
+{
+    if (!image.isNull())
+    {
+        player.nextImage = image;
+        player.nextDelay = delay;
+        return;
+    }
+
+    //the end of the animation, it starts again with the first frame of a new reader
+    player.reader.reset();
+    const bool empty = (player.frame == -1);
+    if (empty || (loopCount != -1 && player.loop >= loopCount))
+    {
+        player.state = Stopped;
+        player.frame = 0;
+        return;
+    }
+
+    ++player.loop;
+    player.frame = -1;
+}
+
+void AnimationClock::resetStream(Player& player)
+{
+    player.reader.reset();
+    player.nextImage = QImage();
+    player.request = 0;
+}
+
+bool AnimationClock::isVisible(AnimationResultItem* item) const
+{
+    if (!item->isVisible() || !item->scene())
+        return false;
+
+    if (!m_worksheet || m_worksheet->views().isEmpty())
+        return true;
+
+    return m_worksheet->worksheetView()->viewRect().intersects(item->sceneBoundingRect());
+}
+
+bool AnimationClock::isStreamed(const QString& fileId) const
+{
+    const auto key = m_keys.constFind(fileId);
+    return key != m_keys.constEnd() && m_streamed.contains(*key);
+}
+
+/*!
+ * returns the cached frames of the animation in \c fileName. If they are not cached yet, they are decoded
+ * synchronously if \c decodeNow is \c true, and in the thread pool otherwise. A null pointer is returned
+ * if the frames are not available yet or if they don't fit into the cache.
+ */
+AnimationClock::FramesPointer AnimationClock::frames(const QString& fileName, bool decodeNow)
+{
+    const QString& id = fileId(fileName);
+    const auto key = m_keys.constFind(id);
+    if (key != m_keys.constEnd())
+    {
+        if (auto* frames = m_frames.object(*key))
+            return *frames;
+
+        if (m_streamed.contains(*key))
+            return FramesPointer();
+    }
+
+    if (decodeNow)
+    {
+        const QByteArray& key = contentKey(fileName);
+        return insert(id, key, m_frames.contains(key) ? FramesPointer() : decode(fileName, maxSize()));
+    }
+
+    if (!m_pending.contains(id))
+    {
+        m_pending.insert(id);
+        const qint64 maxSize = this->maxSize();
+        m_pool.start([this, fileName, id, maxSize]() {
+            const QByteArray& key = contentKey(fileName);
+            const auto& decoded = decode(fileName, maxSize);
+            QMetaObject::invokeMethod(this, [this, id, key, decoded]() {
+                m_pending.remove(id);
+                const auto& frames = insert(id, key, decoded);
+
+                //the animations waiting for the frames are played from the cache or frame by frame
+                for (auto it = m_players.begin(); it != m_players.end(); ++it)
+                {
+                    if (it->fileId != id || it->state == Stopped)
+                        continue;
+
+                    it->frames = frames;
+                    if (!frames && it->state == Running)
+                        requestNextFrame(it.key(), *it);
+                }
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    return FramesPointer();
+}
+
+/*!
+ * adds the frames \c decoded of the version \c fileId of an animation to the cache, the frames
+ * are shared with animations having the same content \c key. A null pointer marks the animation
+ * as too large for the cache.
+ */
+AnimationClock::FramesPointer AnimationClock::insert(const QString& fileId, const QByteArray& key, const FramesPointer& decoded)
+{
+    //the key of an overwritten version of the file is not needed anymore
+    const QString& prefix = fileId.section(QLatin1Char(':'), 0, -3) + QLatin1Char(':');
+    for (auto it = m_keys.begin(); it != m_keys.end();)
+        it = (it.key() != fileId && it.key().startsWith(prefix)) ? m_keys.erase(it) : std::next(it);
+    m_keys.insert(fileId, key);
+
+    if (auto* frames = m_frames.object(key))
+        return *frames;
+
+    if (!decoded)
+    {
+        m_streamed.insert(key);
+        return FramesPointer();
+    }
+
+    qint64 cost = 0;
+    for (const auto& image : std::as_const(decoded->images))
+        cost += image.sizeInBytes();
+
+    m_frames.insert(key, new FramesPointer(decoded), cost);
+    return decoded;
+}
+
+/*!
+ * identifies the current version of the file \c fileName by its name, modification time and size.
+ */
+QString AnimationClock::fileId(const QString& fileName)
+{
+    const QFileInfo info(fileName);
+    return fileName + QLatin1Char(':') + QString::number(info.lastModified().toMSecsSinceEpoch())
+        + QLatin1Char(':') + QString::number(info.size());
+}
+
+/*!
+ * returns the key of the animation in \c fileName in the frame cache, derived from the content
+ * of the file so that identical animations in different files share their frames.
+ */
+QByteArray AnimationClock::contentKey(const QString& fileName)
+{
+    QFile file(fileName);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (file.open(QIODevice::ReadOnly) && hash.addData(&file))
+        return hash.result();
+
+    return fileName.toUtf8();
+}
+
+/*!
+ * decodes all frames of the animation in \c fileName, returns a null pointer if they need more than \c maxSize bytes.
+ */
+AnimationClock::FramesPointer AnimationClock::decode(const QString& fileName, qint64 maxSize)
+{
+    QImageReader reader(fileName);
+    QSharedPointer<Frames> frames(new Frames);
+    frames->loopCount = reader.loopCount();
+
+    qint64 cost = 0;
+    QImage image = readFrame(reader);
+    while (!image.isNull())
+    {
+        cost += image.sizeInBytes();
+        if (cost > maxSize)
+        {
+            qDebug() << "the frames of the animation" << fileName << "exceed the cache size, decoding them while playing";
+            return FramesPointer();
+        }
+
+        frames->images << image;
+        frames->delays << delay(reader.nextImageDelay());
+        image = readFrame(reader);
+    }
+
+    return frames;
+}
+
+QImage AnimationClock::firstFrame(const QString& fileName)
+{
+    QImageReader reader(fileName);
+    return readFrame(reader);
+}
+
+int AnimationClock::delay(int delay)
+{
+    return delay < MinFrameDelay ? DefaultFrameDelay : delay;
+}
@@ -0,0 +1,129 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef ANIMATIONCLOCK_H
+#define ANIMATIONCLOCK_H
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+class QImageReader;
+
+class AnimationResultItem;
+class Worksheet;
+
+/**
+ * Plays the animations shown in the worksheet.
+ * All animations are advanced by one timer that is only running while at least one playing animation
+ * is visible in the view, animations scrolled out of the view are not advanced and not repainted.
+ * The frames are decoded in a thread pool and cached up to a memory budget, they are shared between
+ * animations with identical content. The frames of a playing animation are kept while it's played,
+ * also if they were dropped from the cache, playing animations don't evict each other's frames.
+ * Animations whose frames don't fit into the budget are not cached, their frames are decoded one
+ * after another in the thread pool while they are played.
+ */
+class AnimationClock : public QObject
+{
+  Q_OBJECT
+  public:
+    enum State {Stopped, Paused, Running};
+
+    explicit AnimationClock(Worksheet*);
+    ~AnimationClock() override;
+
+    /**
+     * Registers @p item playing the animation in @p fileName and shows its first frame.
+     * The item is removed automatically when it's deleted.
+     */
+    void add(AnimationResultItem* item, const QString& fileName);
+    void remove(AnimationResultItem*);
+
+    void start(AnimationResultItem*);
+    void pause(AnimationResultItem*);
+    void stop(AnimationResultItem*);
+    State state(AnimationResultItem*) const;
+
+    /**
+     * Returns the number of playing animations that are visible and advanced by the clock
+     */
+    int activeCount() const;
+
+    /**
+     * Returns the frame @p index of the animation in @p fileName.
+     * The animation is decoded synchronously if it's not cached yet.
+     */
+    QImage frame(const QString& fileName, int index);
+    int frameCount(const QString& fileName);
+
+    void setMaxSize(qint64 bytes);
+    qint64 maxSize() const;
+    qint64 size() const;
+
+  public Q_SLOTS:
+    void updateVisibility();
+
+  private:
+    struct Frames {
+        QVector<QImage> images;
+        QVector<int> delays;
+        int loopCount{-1};
+    };
+    using FramesPointer = QSharedPointer<const Frames>;
+
+    struct Player {
+        QString fileName;
+        QString fileId;
+        State state{Stopped};
+        bool visible{true};
+        int frame{0};
+        int loop{0};
+        qint64 due{0};
+        FramesPointer frames; //the cached frames, kept while the animation is played
+
+        //the frames of an animation not fitting into the cache are decoded one by one
+        QSharedPointer<QImageReader> reader;
+        QImage nextImage;
+        int nextDelay{0};
+        quint64 request{0};
+    };
+
+    void tick();
+    void schedule();
+    void advance(AnimationResultItem*, Player&);
+    void requestNextFrame(AnimationResultItem*, Player&);
+    void frameDecoded(Player&, const QImage&, int delay, int loopCount);
+    void resetStream(Player&);
+    bool isVisible(AnimationResultItem*) const;
+    bool isStreamed(const QString& fileId) const;
+    FramesPointer frames(const QString& fileName, bool decodeNow);
+    FramesPointer insert(const QString& fileId, const QByteArray& key, const FramesPointer&);
+    static QString fileId(const QString& fileName);
+    static QByteArray contentKey(const QString& fileName);
+    static FramesPointer decode(const QString& fileName, qint64 maxSize);
+    static QImage firstFrame(const QString& fileName);
+    static int delay(int delay);
+
+    Worksheet* m_worksheet;
+    QHash<AnimationResultItem*, Player> m_players;
+    QCache<QByteArray, FramesPointer> m_frames;
+    QHash<QString, QByteArray> m_keys; //the keys of the versions of the files in the cache
+    QSet<QByteArray> m_streamed;
+    QSet<QString> m_pending;
+    quint64 m_requestCount{0};
+    QTimer m_timer;
+    QElapsedTimer m_elapsed;
+    QMetaObject::Connection m_viewConnection;
+    QThreadPool m_pool;
+};
+
+#endif /* ANIMATIONCLOCK_H */
@@ -4,14 +4,15 @@
 */
 
 #include "animationresultitem.h"
+#include "animationclock.h"
 #include "commandentry.h"
+#include "worksheet.h"
 #include "worksheetview.h"
 #include "lib/result.h"
 #include "lib/animationresult.h"
 
 #include <QFileDialog>
 #include <QGraphicsSceneMouseEvent>
-#include <QMovie>
 
 #include <KLocalizedString>
 
@@ -34,15 +35,16 @@ void AnimationResultItem::populateMenu(QMenu* menu, QPointF)
     ResultItem::addCommonActions(this, menu);
 
     menu->addSeparator();
-    if (m_movie) {
-        if (m_movie->state() == QMovie::Running)
+    if (auto* clock = this->clock()) {
+        const auto state = clock->state(this);
+        if (state == AnimationClock::Running)
             menu->addAction(QIcon::fromTheme(QLatin1String("media-playback-pause")), i18n("Pause"),
                             this, SLOT(pauseMovie()));
         else
             menu->addAction(QIcon::fromTheme(QLatin1String("media-playback-start")), i18n("Start"),
-                            m_movie, SLOT(start()));
-        if (m_movie->state() == QMovie::Running ||
-            m_movie->state() == QMovie::Paused)
+                            this, SLOT(startMovie()));
+        if (state == AnimationClock::Running ||
+            state == AnimationClock::Paused)
             menu->addAction(QIcon::fromTheme(QLatin1String("media-playback-stop")), i18n("Stop"),
                             this, SLOT(stopMovie()));
     }
@@ -51,11 +53,11 @@ void AnimationResultItem::populateMenu(QMenu* menu, QPointF)
 void AnimationResultItem::update()
 {
     Q_ASSERT(m_result->type() == Cantor::AnimationResult::Type);
-    QMovie* mov;
     switch(m_result->type()) {
     case Cantor::AnimationResult::Type:
-        mov = static_cast<QMovie*>(m_result->data().value<QObject*>());
-        setMovie(mov);
+        //the frames are decoded and advanced by the clock of the worksheet, not by a movie per result
+        if (auto* clock = this->clock())
+            clock->add(this, m_result->url().toLocalFile());
         break;
     default:
         break;
@@ -78,33 +80,21 @@ double AnimationResultItem::height() const
 }
 
 
-void AnimationResultItem::setMovie(QMovie* movie)
+void AnimationResultItem::showFrame(const QImage& frame)
 {
-    if (m_movie) {
-        m_movie->disconnect(this, SLOT(updateFrame()));
-        m_movie->disconnect(this, SLOT(updateSize()));
-    }
-    m_movie = movie;
-    m_height = 0;
-    if (m_movie) {
-        connect(m_movie, &QMovie::frameChanged, this, &AnimationResultItem::updateFrame);
-        connect(m_movie, &QMovie::resized, this, &AnimationResultItem::updateSize);
-        m_movie->start();
-    }
-}
+    setImage(frame);
+    if (auto* worksheet = this->worksheet())
+        worksheet->update(mapRectToScene(boundingRect()));
 
-void AnimationResultItem::updateFrame()
-{
-    setImage(m_movie->currentImage());
-    worksheet()->update(mapRectToScene(boundingRect()));
+    if (m_height != frame.height()) {
+        m_height = frame.height();
+        Q_EMIT sizeChanged();
+    }
 }
 
-void AnimationResultItem::updateSize(QSize size)
+AnimationClock* AnimationResultItem::clock()
 {
-    if (m_height != size.height()) {
-        m_height = size.height();
-        Q_EMIT sizeChanged();
-    }
+    return worksheet() ? worksheet()->animationClock() : nullptr;
 }
 
 void AnimationResultItem::saveResult()
@@ -113,19 +103,22 @@ void AnimationResultItem::saveResult()
     result()->save(filename);
 }
 
+void AnimationResultItem::startMovie()
+{
+    if (auto* clock = this->clock())
+        clock->start(this);
+}
+
 void AnimationResultItem::stopMovie()
 {
-    if (m_movie) {
-        m_movie->stop();
-        m_movie->jumpToFrame(0);
-        worksheet()->update(mapRectToScene(boundingRect()));
-    }
+    if (auto* clock = this->clock())
+        clock->stop(this);
 }
 
 void AnimationResultItem::pauseMovie()
 {
-    if (m_movie)
-        m_movie->setPaused(true);
+    if (auto* clock = this->clock())
+        clock->pause(this);
 }
 
 void AnimationResultItem::deleteLater()
@@ -9,9 +9,10 @@
 #include "resultitem.h"
 #include "worksheetimageitem.h"
 
-class QMovie;
 class QGraphicsSceneMouseEvent;
 
+class AnimationClock;
+
 class CommandEntry;
 class WorksheetEntry;
 
@@ -35,24 +36,24 @@ class AnimationResultItem : public WorksheetImageItem, public ResultItem
     double width() const override;
     double height() const override;
 
+    /**
+     * Shows @p frame of the animation, called by the AnimationClock
+     */
+    void showFrame(const QImage& frame);
+
   protected:
     void mousePressEvent(QGraphicsSceneMouseEvent* event) override;
 
   protected Q_SLOTS:
     void saveResult();
+    void startMovie();
     void stopMovie();
     void pauseMovie();
 
   private:
-    void setMovie(QMovie*);
+    AnimationClock* clock();
 
-  private Q_SLOTS:
-    void updateFrame();
-    void updateSize(QSize);
-
-  private:
     double m_height{0.};
-    QMovie* m_movie{nullptr};
 };
 
 #endif //ANIMATIONRESULTITEM_H
@@ -40,6 +40,7 @@ void RSession::login()
 
     m_process = new QProcess(this);
     m_process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    registerProcess(m_process);
 #ifdef Q_OS_WIN
     m_process->start(QStandardPaths::findExecutable(QLatin1String("cantor_rserver.exe")));
 #else
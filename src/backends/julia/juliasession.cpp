@@ -7,10 +7,11 @@
 #include <random>
 
 #include <KProcess>
-#include <KMessageBox>
 #include <KLocalizedString>
 #include <QDBusConnection>
 #include <QDBusInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusReply>
 #include <QStandardPaths>
 #include <QDir>
@@ -57,34 +58,19 @@ void JuliaSession::login()
         << QStandardPaths::findExecutable(QLatin1String("cantor_juliaserver"));
 #endif
 
-    connect(m_process, &QProcess::errorOccurred, this, &JuliaSession::reportServerProcessError);
-
-    m_process->start();
-
-    if (!m_process->waitForStarted())
-    {
-        changeStatus(Session::Disable);
-        Q_EMIT error(i18n("Failed to start Julia, please check Julia installation."));
-        Q_EMIT loginDone();
-        delete m_process;
-        m_process = nullptr;
-        return;
-    }
+    startLoginProcess(m_process, QByteArrayLiteral("ready"), i18n("Failed to start Julia, please check Julia installation."));
+}
 
-    m_process->waitForReadyRead();
-    QTextStream stream(m_process->readAllStandardOutput());
+void JuliaSession::loginHandshakeDone(const QByteArray& pendingOutput)
+{
+    Q_UNUSED(pendingOutput);
 
-    QString readyStatus = QLatin1String("ready");
-    while (m_process->state() == QProcess::Running) {
-        const QString &rl = stream.readLine();
-        if (rl == readyStatus) {
-            break;
-        }
-    }
+    connect(m_process, &QProcess::errorOccurred, this, &JuliaSession::reportServerProcessError);
 
     if (!QDBusConnection::sessionBus().isConnected()) {
         qWarning() << "Can't connect to the D-Bus session bus.\n"
                       "To start it, run: eval `dbus-launch --auto-syntax`";
+        loginHandshakeFailed(i18n("Can't connect to the D-Bus session bus."));
         return;
     }
 
@@ -99,29 +85,48 @@ void JuliaSession::login()
     );
 
     if (!m_interface->isValid()) {
-        qWarning() << QDBusConnection::sessionBus().lastError().message();
+        const QString& message = QDBusConnection::sessionBus().lastError().message();
+        qWarning() << message;
+        loginHandshakeFailed(message);
         return;
     }
 
-    const QDBusReply<int> &reply = m_interface->call(QLatin1String("login"));
-    if (reply.isValid())
+    // the initialization of the julia runtime takes a while, don't block while waiting for it
+    m_loginCall = new QDBusPendingCallWatcher(m_interface->asyncCall(QLatin1String("login")), this);
+    connect(m_loginCall, &QDBusPendingCallWatcher::finished, this, &JuliaSession::serverLoginFinished);
+}
+
+void JuliaSession::loginHandshakeFailed(const QString& message)
+{
+    m_loginCall = nullptr;
+    delete m_interface;
+    m_interface = nullptr;
+    disconnect(m_process, &QProcess::errorOccurred, this, &JuliaSession::reportServerProcessError);
+    m_process->deleteLater();
+    m_process = nullptr;
+    Session::loginHandshakeFailed(message);
+}
+
+void JuliaSession::serverLoginFinished(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+
+    //the session was logged out while JuliaServer was logging in
+    if (watcher != m_loginCall || !m_interface)
+        return;
+    m_loginCall = nullptr;
+
+    //the failure is reported to the user by Session::abortLogin()
+    const QDBusPendingReply<int> reply = *watcher;
+    if (reply.isValid() && reply.value() == 1)
     {
-        int errorCode = reply.value();
-        if (errorCode != 0)
-        {
-            if (errorCode == 1)
-            {
-                const QString& juliaSysimgMissingFilepath = getError();
-                KMessageBox::error(nullptr, i18n("Julia session can't login due internal julia problem with missing internal file - \"%1\"", juliaSysimgMissingFilepath), i18n("Error - Cantor"));
-                return;
-            }
-            else // All error codes should be supported
-                assert(false);
-        }
+        const QString& juliaSysimgMissingFilepath = getError();
+        loginHandshakeFailed(i18n("Julia session can't login due internal julia problem with missing internal file - \"%1\"", juliaSysimgMissingFilepath));
+        return;
     }
-    else
+    else if (!reply.isValid() || reply.value() != 0)
     {
-        KMessageBox::error(nullptr, i18n("Julia session can't login due unknown internal problem"), i18n("Error - Cantor"));
+        loginHandshakeFailed(i18n("Julia session can't login due unknown internal problem"));
         return;
     }
 
@@ -148,8 +153,7 @@ void JuliaSession::login()
 
     updateVariables();
 
-    changeStatus(Session::Done);
-    Q_EMIT loginDone();
+    finishLogin();
     qDebug() << "login to julia done";
 }
 
@@ -158,17 +162,24 @@ void JuliaSession::logout()
     if(!m_process)
         return;
 
-    if(status() == Cantor::Session::Running)
+    //the process is also killed if the session is idle or still logging in
+    if(m_process->state() != QProcess::NotRunning)
     {
-        if(m_process && m_process->state() == QProcess::Running)
-        {
-            disconnect(m_process, &QProcess::errorOccurred, this, &JuliaSession::reportServerProcessError);
-            m_process->kill();
-        }
-        m_process->deleteLater();
-        m_process = nullptr;
-        interrupt();
+        disconnect(m_process, &QProcess::errorOccurred, this, &JuliaSession::reportServerProcessError);
+        m_process->kill();
     }
+    m_process->deleteLater();
+    m_process = nullptr;
+
+    if(status() == Cantor::Session::Running)
+        interrupt();
+
+    //the reply of a pending login call is ignored
+    delete m_loginCall;
+    m_loginCall = nullptr;
+    static_cast<JuliaVariableModel*>(variableModel())->setJuliaServer(nullptr);
+    delete m_interface;
+    m_interface = nullptr;
 
     if (!m_plotFilePrefixPath.isEmpty())
     {
@@ -235,6 +246,10 @@ void JuliaSession::runJuliaCommandAsync(const QString &command)
 
 void JuliaSession::onResultReady()
 {
+    //the reply arrived after the session was logged out
+    if (!m_interface || expressionQueue().isEmpty())
+        return;
+
     static_cast<JuliaExpression*>(expressionQueue().first())->finalize(getOutput(), getError(), getWasException());
     finishFirstExpression(true);
 }
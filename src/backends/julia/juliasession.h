@@ -14,6 +14,7 @@ class JuliaExpression;
 class JuliaVariableModel;
 class KProcess;
 class QDBusInterface;
+class QDBusPendingCallWatcher;
 namespace Cantor {
     class DefaultVariableModel;
 }
@@ -69,9 +70,15 @@ private Q_SLOTS:
     // Handler for cantor_juliaserver crashes
     void reportServerProcessError(QProcess::ProcessError serverError);
 
+    /**
+     * Called when the asynchronous login call to JuliaServer is finished
+     */
+    void serverLoginFinished(QDBusPendingCallWatcher*);
+
 private:
     KProcess* m_process{nullptr}; //< process to run JuliaServer inside
     QDBusInterface* m_interface{nullptr}; //< interface to JuliaServer
+    QDBusPendingCallWatcher* m_loginCall{nullptr}; //< pending asynchronous login call to JuliaServer
 
     /// Cache to speedup modules whos calls
     QMap<QString, QString> m_whos_cache;
@@ -82,6 +89,8 @@ private:
     bool m_isIntegratedPlotsSettingsEnabled{false};
 
     void runFirstExpression() override;
+    void loginHandshakeDone(const QByteArray&) override;
+    void loginHandshakeFailed(const QString&) override;
 
     /**
      * Runs Julia piece of code in synchronous mode
@@ -11,37 +11,24 @@
 #include "kalgebrasession.h"
 #include <KLocalizedString>
 
-#include <analitza/expression.h>
-#include <analitza/expressionstream.h>
-#include <analitza/analyzer.h>
-
 KAlgebraExpression::KAlgebraExpression( KAlgebraSession* session, bool internal)
     : Cantor::Expression(session, internal)
 {}
 
 void KAlgebraExpression::evaluate()
 {
-    setStatus(Cantor::Expression::Computing);
-
-    Analitza::Analyzer* a=static_cast<KAlgebraSession*>(session())->analyzer();
-    Analitza::Expression res;
-    QString cmd = command();
-    QTextStream stream(&cmd);
-
-    Analitza::ExpressionStream s(&stream);
-    for(; !s.atEnd();) {
-        a->setExpression(s.next());
-        res = a->evaluate();
+    //the command is evaluated in the worker thread of the session
+    session()->enqueueExpression(this);
+}
 
-        if(!a->isCorrect())
-            break;
-    }
+void KAlgebraExpression::parseOutput(const QString& output)
+{
+    setResult(new Cantor::TextResult(output));
+    setStatus(Cantor::Expression::Done);
+}
 
-    if(a->isCorrect()) {
-        setResult(new Cantor::TextResult(res.toString()));
-        setStatus(Cantor::Expression::Done);
-    } else {
-        setErrorMessage(i18n("Error: %1", a->errors().join(QLatin1String("\n"))));
-        setStatus(Cantor::Expression::Error);
-    }
+void KAlgebraExpression::parseError(const QString& error)
+{
+    setErrorMessage(i18n("Error: %1", error));
+    setStatus(Cantor::Expression::Error);
 }
@@ -20,8 +20,8 @@ class KAlgebraExpression : public Cantor::Expression
 
         void evaluate() override;
 
-        void parseOutput(const QString&) override {};
-        void parseError(const QString&) override {};
+        void parseOutput(const QString&) override;
+        void parseError(const QString&) override;
 };
 
 #endif
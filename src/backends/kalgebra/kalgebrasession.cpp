@@ -6,48 +6,60 @@
 
 #include "kalgebrasession.h"
 #include "kalgebravariablemodel.h"
+#include "kalgebraworker.h"
 
 #include "settings.h"
 
 #include "kalgebraexpression.h"
 #include <analitzagui/algebrahighlighter.h>
-#include <analitza/analyzer.h>
+#include <analitza/variables.h>
 #include <QTextEdit>
 
 #include <QDebug>
 #include "kalgebrasyntaxhelpobject.h"
 #include <analitzagui/operatorsmodel.h>
-#include <analitzagui/variablesmodel.h>
 
 KAlgebraSession::KAlgebraSession( Cantor::Backend* backend)
 : Session(backend, nullptr, new KeywordsManager(QStringLiteral("Kalgebra")))
 {
-    m_analyzer = new Analitza::Analyzer;
-    m_operatorsModel = new OperatorsModel;
+    qRegisterMetaType<QSharedPointer<Analitza::Variables>>();
 
-    auto* analitzaVariables = new Analitza::VariablesModel(m_analyzer->variables(), this);
+    m_variables.reset(new Analitza::Variables);
+    m_operatorsModel = new OperatorsModel;
+    m_operatorsModel->setVariables(m_variables);
 
-    m_variableModel = new KAlgebraVariableModel(analitzaVariables, m_operatorsModel, this);
+    m_variableModel = new KAlgebraVariableModel(m_operatorsModel, this);
     setVariableModel(m_variableModel);
 
-    m_operatorsModel->setVariables(m_analyzer->variables());
+    //the commands are evaluated in a separate thread, long computations don't block the GUI
+    m_worker = new KAlgebraWorker;
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &KAlgebraWorker::evaluated, this, &KAlgebraSession::evaluated);
+    m_thread.setObjectName(QStringLiteral("KAlgebraWorker"));
+    m_thread.start();
 }
 
 KAlgebraSession::~KAlgebraSession()
 {
-    delete m_analyzer;
+    //the running evaluation can't be aborted, wait until it's done
+    m_worker->cancel(m_evaluationId);
+    m_thread.quit();
+    m_thread.wait();
 }
 
 void KAlgebraSession::login()
 {
     Q_EMIT loginStarted();
+    changeStatus(Cantor::Session::Done);
+
+    //the scripts are queued before the first command of the worksheet
     if(!KAlgebraSettings::autorunScripts().isEmpty()){
         QString autorunScripts = KAlgebraSettings::self()->autorunScripts().join(QLatin1String("\n"));
 
         evaluateExpression(autorunScripts, KAlgebraExpression::DeleteOnFinish, true);
     }
 
-    changeStatus(Cantor::Session::Done);
     Q_EMIT loginDone();
 }
 
@@ -58,6 +70,17 @@ void KAlgebraSession::logout()
 
 void KAlgebraSession::interrupt()
 {
+    if (!expressionQueue().isEmpty())
+    {
+        //the running evaluation stops before its next statement, its result is dropped
+        m_canceledId = m_evaluationId;
+        m_worker->cancel(m_canceledId);
+
+        for (auto* expression : expressionQueue())
+            expression->setStatus(Cantor::Expression::Interrupted);
+        expressionQueue().clear();
+    }
+
     changeStatus(Cantor::Session::Done);
 }
 
@@ -68,16 +91,43 @@ Cantor::Expression* KAlgebraSession::evaluateExpression(const QString& cmd,
     KAlgebraExpression* expr=new KAlgebraExpression(this, internal);
     expr->setFinishingBehavior(behave);
 
-    changeStatus(Cantor::Session::Running);
     expr->setCommand(cmd);
     expr->evaluate();
-    changeStatus(Cantor::Session::Done);
 
-    m_operatorsModel->setVariables(m_analyzer->variables());
-    variableModel()->update();
     return expr;
 }
 
+void KAlgebraSession::runFirstExpression()
+{
+    auto* expression = expressionQueue().first();
+    connect(expression, &Cantor::Expression::statusChanged, this, &Session::currentExpressionStatusChanged);
+    expression->setStatus(Cantor::Expression::Computing);
+
+    const int id = ++m_evaluationId;
+    const QString& command = expression->command();
+    auto* worker = m_worker;
+    QMetaObject::invokeMethod(m_worker, [worker, id, command]() { worker->evaluate(id, command); });
+}
+
+void KAlgebraSession::evaluated(int id, const QString& result, const QStringList& errors, const QSharedPointer<Analitza::Variables>& variables)
+{
+    m_variables = variables;
+    m_operatorsModel->setVariables(m_variables);
+
+    //the expression of an interrupted evaluation is already finished, only the variables are taken over
+    if (id <= m_canceledId || expressionQueue().isEmpty())
+    {
+        variableModel()->update();
+        return;
+    }
+
+    auto* expression = expressionQueue().first();
+    if (errors.isEmpty())
+        expression->parseOutput(result);
+    else
+        expression->parseError(errors.join(QLatin1String("\n")));
+}
+
 Cantor::SyntaxHelpObject* KAlgebraSession::syntaxHelpFor(const QString& cmd)
 {
     return new KAlgebraSyntaxHelpObject(cmd, this);
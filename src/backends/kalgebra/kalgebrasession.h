@@ -9,12 +9,16 @@
 
 #include "session.h"
 
+#include <QSharedPointer>
+#include <QThread>
+
 class OperatorsModel;
 class KAlgebraExpression;
 class KAlgebraVariableModel;
+class KAlgebraWorker;
 
 namespace Analitza {
-class Analyzer;
+class Variables;
 }
 
 class KAlgebraSession : public Cantor::Session
@@ -31,12 +35,25 @@ class KAlgebraSession : public Cantor::Session
 
         Cantor::Expression* evaluateExpression(const QString& command, Cantor::Expression::FinishingBehavior behave = Cantor::Expression::FinishingBehavior::DoNotDelete, bool internal = false) override;
         Cantor::SyntaxHelpObject* syntaxHelpFor(const QString& cmd) override;
-        Analitza::Analyzer* analyzer() const { return m_analyzer; }
+        /**
+         * Returns a copy of the variables of the analyzer taken after the last evaluation.
+         * The analyzer itself is only accessed in the worker thread.
+         */
+        QSharedPointer<Analitza::Variables> variables() const { return m_variables; }
         OperatorsModel* operatorsModel();
         QSyntaxHighlighter* syntaxHighlighter(QObject* parent) override;
 
+    protected:
+        void runFirstExpression() override;
+
     private:
-        Analitza::Analyzer* m_analyzer{nullptr};
+        void evaluated(int id, const QString& result, const QStringList& errors, const QSharedPointer<Analitza::Variables>&);
+
+        QThread m_thread;
+        KAlgebraWorker* m_worker{nullptr};
+        int m_evaluationId{0};
+        int m_canceledId{0};
+        QSharedPointer<Analitza::Variables> m_variables;
         OperatorsModel* m_operatorsModel{nullptr};
         KAlgebraVariableModel* m_variableModel{nullptr};
 };
@@ -1,36 +1,26 @@
 #include "kalgebravariablemodel.h"
 
 #include "backend.h"
-#include <analitza/analyzer.h>
-#include <analitzagui/variablesmodel.h>
+#include <analitza/object.h>
+#include <analitza/variables.h>
 #include <analitzagui/operatorsmodel.h>
 #include"kalgebrasession.h"
 
-KAlgebraVariableModel::KAlgebraVariableModel(Analitza::VariablesModel* analitzaVars, OperatorsModel* analitzaFuncs, Cantor::Session* session)
-: Cantor::DefaultVariableModel(session), m_analitzaVariables(analitzaVars), m_analitzaFunctions(analitzaFuncs)
+KAlgebraVariableModel::KAlgebraVariableModel(OperatorsModel* analitzaFuncs, Cantor::Session* session)
+: Cantor::DefaultVariableModel(session), m_analitzaFunctions(analitzaFuncs)
 {
 }
 
 void KAlgebraVariableModel::update()
 {
-    if (!m_analitzaVariables || !m_analitzaFunctions) 
+    //the copy of the variables taken after the last evaluation, the analyzer is used in the worker thread
+    const auto& variables = static_cast<KAlgebraSession*>(session())->variables();
+    if (!variables || !m_analitzaFunctions)
         return;
 
-    m_analitzaVariables->updateInformation();
-    KAlgebraSession* kalgebraSession = static_cast<KAlgebraSession*>(session());
-    m_analitzaFunctions->setVariables(kalgebraSession->analyzer()->variables());
-
-
     QList<Variable> newVariables;
-    for (int i = 0; i < m_analitzaVariables->rowCount(QModelIndex()); ++i) {
-        QModelIndex nameIndex = m_analitzaVariables->index(i, 0);
-        QModelIndex valueIndex = m_analitzaVariables->index(i, 1);
-        if (nameIndex.isValid() && valueIndex.isValid()) {
-            QString name = m_analitzaVariables->data(nameIndex).toString();
-            QString value = m_analitzaVariables->data(valueIndex).toString();
-            newVariables.append(Variable(name, value));
-        }
-    }
+    for (auto it = variables->constBegin(); it != variables->constEnd(); ++it)
+        newVariables.append(Variable(it.key(), it.value()->toString()));
 
     QStringList newFunctions;
     for (int i = 0; i < m_analitzaFunctions->rowCount(QModelIndex()); ++i) {
@@ -3,21 +3,17 @@
 
 #include "defaultvariablemodel.h"
 
-namespace Analitza {
-    class VariablesModel;
-}
 class OperatorsModel;
 
 
 class KAlgebraVariableModel : public Cantor::DefaultVariableModel
 {
 public:
-    KAlgebraVariableModel(Analitza::VariablesModel* analitzaVars, OperatorsModel* analitzaFuncs, Cantor::Session* session);
+    KAlgebraVariableModel(OperatorsModel* analitzaFuncs, Cantor::Session* session);
 
     void update() override;
 
 private:
-    Analitza::VariablesModel* m_analitzaVariables{nullptr};
     OperatorsModel* m_analitzaFunctions{nullptr};
 };
 
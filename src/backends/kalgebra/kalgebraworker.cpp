@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kalgebraworker.h"
+
+#include <QTextStream>
+
+#include <analitza/analyzer.h>
+#include <analitza/expression.h>
+#include <analitza/expressionstream.h>
+
+KAlgebraWorker::KAlgebraWorker() : QObject(),
+    m_analyzer(new Analitza::Analyzer)
+{
+}
+
+KAlgebraWorker::~KAlgebraWorker()
+{
+    delete m_analyzer;
+}
+
+void KAlgebraWorker::cancel(int id)
+{
+    int current = m_canceledId.loadAcquire();
+    while (current < id && !m_canceledId.testAndSetOrdered(current, id, current))
+        ;
+}
+
+bool KAlgebraWorker::isCanceled(int id) const
+{
+    return id <= m_canceledId.loadAcquire();
+}
+
+void KAlgebraWorker::evaluate(int id, const QString& command)
+{
+    if (isCanceled(id))
+        return;
+
+    Analitza::Expression res;
+    QString cmd = command;
+    QTextStream stream(&cmd);
+
+    Analitza::ExpressionStream s(&stream);
+    for(; !s.atEnd();) {
+        //the statements evaluated so far are kept like in an interrupted process
+        if (isCanceled(id))
+            break;
+
+        m_analyzer->setExpression(s.next());
+        res = m_analyzer->evaluate();
+
+        if(!m_analyzer->isCorrect())
+            break;
+    }
+
+    const QSharedPointer<Analitza::Variables> variables(new Analitza::Variables(*m_analyzer->variables()));
+    if (m_analyzer->isCorrect())
+        Q_EMIT evaluated(id, res.toString(), QStringList(), variables);
+    else
+        Q_EMIT evaluated(id, QString(), m_analyzer->errors(), variables);
+}
@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KALGEBRA_WORKER_H
+#define KALGEBRA_WORKER_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include <analitza/variables.h>
+
+namespace Analitza {
+class Analyzer;
+}
+
+/**
+ * Evaluates the commands of a KAlgebra session in the worker thread of the session.
+ * The worker owns the Analyzer, it's only accessed in the worker thread. The variables
+ * are passed to the GUI thread as a copy after every evaluation.
+ * Analitza can't abort a running evaluation, a canceled command is stopped before its next statement,
+ * the session drops its result.
+ */
+class KAlgebraWorker : public QObject
+{
+    Q_OBJECT
+    public:
+        KAlgebraWorker();
+        ~KAlgebraWorker() override;
+
+        /**
+         * Cancels the evaluation of the commands with ids up to @p id, can be called from any thread
+         */
+        void cancel(int id);
+
+    public Q_SLOTS:
+        void evaluate(int id, const QString& command);
+
+    Q_SIGNALS:
+        /**
+         * Emitted once the command @p id is evaluated or was canceled while it was evaluated
+         */
+        void evaluated(int id, const QString& result, const QStringList& errors, const QSharedPointer<Analitza::Variables>& variables);
+
+    private:
+        bool isCanceled(int id) const;
+
+        Analitza::Analyzer* m_analyzer;
+        QAtomicInt m_canceledId{0};
+};
+
+#endif
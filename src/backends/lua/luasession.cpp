@@ -51,6 +51,7 @@ void LuaSession::login()
 
     connect(m_process, &QProcess::readyReadStandardOutput, this, &LuaSession::readIntroMessage);
     connect(m_process, &QProcess::started, this, &LuaSession::processStarted);
+    registerProcess(m_process);
     m_process->start();
 
     if (!m_process->waitForStarted())
@@ -18,11 +18,9 @@
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
-#include <QImage>
 #include <QRegularExpression>
 #include <QScreen>
 #include <QTemporaryFile>
-#include <QTimer>
 #include <QUrl>
 
 #include <KLocalizedString>
@@ -40,17 +38,16 @@ MaximaExpression::~MaximaExpression() {
 void MaximaExpression::evaluate()
 {
     m_errorBuffer.clear();
+    m_errorContent.clear();
+    m_pendingText.clear();
+    m_resultCount = 0;
+    m_hasValueSeparator = false;
 
     if(m_tempFile)
     {
         delete m_tempFile;
         m_tempFile = nullptr;
         m_isPlot = false;
-        m_plotResult = nullptr;
-        m_plotResultIndex = -1;
-        m_plotResultLoadScheduled = false;
-        m_plotFileLastSize = -1;
-        m_plotResultLoadAttempts = 0;
     }
 
     QString cmd = command();
@@ -93,10 +90,6 @@ void MaximaExpression::evaluate()
             setStatus(Cantor::Expression::Error);
             return;
         }
-
-        m_fileWatch.removePaths(m_fileWatch.files());
-        m_fileWatch.addPath(m_tempFile->fileName());
-        connect(&m_fileWatch, &QFileSystemWatcher::fileChanged, this, &MaximaExpression::imageChanged,  Qt::UniqueConnection);
     }
 
     bool isComment = true;
@@ -237,15 +230,80 @@ void MaximaExpression::forceDone()
 }
 
 /*!
-    example output for the simple expression '5+5':
-    latex mode - "<cantor-result><cantor-text>\n(%o1) 10\n</cantor-text><cantor-latex>\\mbox{\\tt\\red(\\mathrm{\\%o1}) \\black}10</cantor-latex></cantor-result>\n<cantor-prompt>(%i2) </cantor-prompt>\n"
-    text mode  - "<cantor-result><cantor-text>\n(%o1) 10\n</cantor-text></cantor-result>\n<cantor-prompt>(%i2) </cantor-prompt>\n"
+ * parses the complete output of a command up to and including the next prompt.
+ * The session feeds the output section by section via parseToken() while reading it,
+ * this function is for the cases when the whole output is available at once.
  */
 void MaximaExpression::parseOutput(const QString& out)
 {
-    const int promptStart = out.indexOf(QLatin1String("<cantor-prompt>"));
-    const int promptEnd = out.indexOf(QLatin1String("</cantor-prompt>"));
-    const QString prompt = out.mid(promptStart + 15, promptEnd - promptStart - 15).simplified();
+    MaximaOutputTokenizer tokenizer;
+    const auto& tokens = tokenizer.feed(out.toLocal8Bit());
+    for (const auto& token : tokens)
+        parseToken(token);
+}
+
+/*!
+ * handles one section of the tagged output as soon as it was received.
+ * The untagged output is collected until the next result or prompt, the results
+ * are added right away and the prompt finishes the processing of the output.
+ */
+void MaximaExpression::parseToken(const MaximaOutputTokenizer::Token& token)
+{
+    static const QString valueSeparator = QStringLiteral("cantor-value-separator");
+
+    switch (token.type)
+    {
+    case MaximaOutputTokenizer::Token::Text:
+        if (token.text.contains(valueSeparator))
+            m_hasValueSeparator = true;
+        m_pendingText += token.text;
+        break;
+    case MaximaOutputTokenizer::Token::Result:
+        if (token.text.contains(valueSeparator))
+            m_hasValueSeparator = true;
+
+        if (m_resultCount == 0)
+        {
+            if (isHelpRequest() || m_isHelpRequestAdditional)
+                m_errorContent += m_pendingText;
+            else if (!m_pendingText.trimmed().isEmpty())
+            {
+                //there is a result but also the error buffer is not empty. This is the case when
+                //warnings are generated, for example, the output of rat(0.75*10) is:
+                //"\nrat: replaced 7.5 by 15/2 = 7.5\n<cantor-result><cantor-text>\n(%o2) 15/2\n</cantor-text></cantor-result>\n<cantor-prompt>(%i3) </cantor-prompt>\n".
+                //In such cases we just add a new text result with the warning.
+                qDebug() << "warning: " << m_pendingText;
+                auto* result = new Cantor::TextResult(m_pendingText.trimmed());
+
+                //the output of tex() function is also placed outside of the result section, don't treat it as a warning
+                if (!command().remove(QLatin1Char(' ')).startsWith(QLatin1String("tex(")))
+                    result->setIsWarning(true);
+                addResult(result);
+            }
+        }
+
+        //the output between the results is not relevant
+        m_pendingText.clear();
+        ++m_resultCount;
+        parseResult(token);
+        break;
+    case MaximaOutputTokenizer::Token::Prompt:
+        parsePrompt(token.text);
+        break;
+    }
+}
+
+void MaximaExpression::parsePrompt(const QString& rawPrompt)
+{
+    const QString prompt = rawPrompt.simplified();
+
+    //the error message is the output outside of the <cantor*> tags
+    QString errorContent = m_errorContent + m_pendingText.trimmed();
+    const bool hasValueSeparator = m_hasValueSeparator;
+    m_errorContent.clear();
+    m_pendingText.clear();
+    m_resultCount = 0;
+    m_hasValueSeparator = false;
 
     if (prompt.trimmed() != QLatin1String("MAXIMA>") && static_cast<MaximaSession*>(session())->mode() == MaximaSession::Lisp)
     {
@@ -269,57 +327,14 @@ void MaximaExpression::parseOutput(const QString& out)
 
     qDebug()<<"new input label: " << prompt;
 
-    QString errorContent;
-
-    //parse the results
-    int resultStart = out.indexOf(QLatin1String("<cantor-result>"));
-    if (resultStart != -1) {
-        errorContent += out.mid(0, resultStart);
-        if (!errorContent.isEmpty() && !(isHelpRequest() || m_isHelpRequestAdditional))
-        {
-            //there is a result but also the error buffer is not empty. This is the case when
-            //warnings are generated, for example, the output of rat(0.75*10) is:
-            //"\nrat: replaced 7.5 by 15/2 = 7.5\n<cantor-result><cantor-text>\n(%o2) 15/2\n</cantor-text></cantor-result>\n<cantor-prompt>(%i3) </cantor-prompt>\n".
-            //In such cases we just add a new text result with the warning.
-            qDebug() << "warning: " << errorContent;
-            auto* result = new Cantor::TextResult(errorContent.trimmed());
-
-            //the output of tex() function is also placed outside of the result section, don't treat it as a warning
-            if (!command().remove(QLatin1Char(' ')).startsWith(QLatin1String("tex(")))
-                result->setIsWarning(true);
-            addResult(result);
-            errorContent.clear();
-        }
-    }
-
-    while (resultStart != -1)
-    {
-        int resultEnd = out.indexOf(QLatin1String("</cantor-result>"), resultStart + 15);
-        const QString resultContent = out.mid(resultStart + 15, resultEnd - resultStart - 15);
-        parseResult(resultContent);
-
-        //search for the next openning <cantor-result> tag after the current closing </cantor-result> tag
-        resultStart = out.indexOf(QLatin1String("<cantor-result>"), resultEnd + 16);
-    }
-
-    //parse the error message, the part outside of the <cantor*> tags
-    int lastResultEnd = out.lastIndexOf(QLatin1String("</cantor-result>"));
-    if (lastResultEnd != -1)
-        lastResultEnd += 16;
-    else
-        lastResultEnd = 0;
-
-    errorContent += out.mid(lastResultEnd, promptStart - lastResultEnd).trimmed();
-
     // if there was no error output on stdout, check the stderr content, if available.
      if (errorContent.isEmpty() && !m_errorBuffer.isEmpty())
         errorContent = m_errorBuffer.trimmed();
 
     if (errorContent.isEmpty())
     {
-        // For plots we set Done status in imageChanged
-        if (!m_isPlot || m_plotResult)
-            setStatus(Cantor::Expression::Done);
+        // the plot files are still being loaded, the status is set once they're available
+        setStatusAfterPlots(Cantor::Expression::Done);
     }
     else
     {
@@ -338,7 +353,7 @@ void MaximaExpression::parseOutput(const QString& out)
             qDebug()<<"setting status to DONE";
             setStatus(Cantor::Expression::Done);
         }
-        else if (out.contains(QLatin1String("cantor-value-separator")))
+        else if (hasValueSeparator)
         {
             //we don't interpret the error output as an error in the following cases:
             //1. when fetching variables, in addition to the actual result with variable names and values,
@@ -384,24 +399,19 @@ void MaximaExpression::parseOutput(const QString& out)
     }
 }
 
-void MaximaExpression::parseResult(const QString& resultContent)
+void MaximaExpression::parseResult(const MaximaOutputTokenizer::Token& token)
 {
     //in case we asked for additional input for the help request,
     //no need to process the result - we're not done yet and maxima is waiting for further input
     if (m_isHelpRequestAdditional)
         return;
 
-    qDebug()<<"result content: " << resultContent;
-
     //text part of the output
-    const int textContentStart = resultContent.indexOf(QLatin1String("<cantor-text>"));
-    const int textContentEnd = resultContent.indexOf(QLatin1String("</cantor-text>"));
-    QString textContent = resultContent.mid(textContentStart + 13, textContentEnd - textContentStart - 13).trimmed();
+    QString textContent = token.text.trimmed();
     qDebug()<<"text content: " << textContent;
 
     //output label can be a part of the text content -> determine it
-    const QRegularExpression regex = QRegularExpression(MaximaSession::MaximaOutputPrompt.pattern());
-    QRegularExpressionMatch match = regex.match(textContent);
+    QRegularExpressionMatch match = MaximaSession::MaximaOutputPrompt.match(textContent);
     QString outputLabel;
     if (match.hasMatch()) // a match is found, so the output contains output label
         outputLabel = textContent.mid(match.capturedStart(0), match.capturedLength(0)).trimmed();
@@ -422,36 +432,30 @@ void MaximaExpression::parseResult(const QString& resultContent)
     //determine the actual result
     Cantor::Result* result = nullptr;
 
-    const int latexContentStart = resultContent.indexOf(QLatin1String("<cantor-latex>"));
     //Handle system maxima output for plotting commands
     if (m_isPlot)
     {
         // plot/draw command can be part of a multi-line input having other non-plot related commands.
         // parse the output of every command of the multi-line input and only add plot result if
-        // the output has plot/draw specific keywords
+        // the output has plot/draw specific keywords.
+        // this output announces the plot file. gnuplot can still be writing it and Maxima can't determine
+        // the size of the file, the file is loaded once its size doesn't change anymore.
         if ( (!m_isDraw && textContent.endsWith(QString::fromLatin1("\"%1\"]").arg(m_tempFile->fileName())))
             || (m_isDraw && (textContent.startsWith(QLatin1String("[gr2d(explicit")) || textContent.startsWith(QLatin1String("[gr3d(explicit"))) ) )
         {
-            m_plotResultIndex = results().size();
-            // Gnuplot could generate plot before we parse text output from maxima and after
-            // If we already have plot result, just add it
-            // Else set info message, and replace it by real result in imageChanged function later
-            if (m_plotResult)
-                result = m_plotResult;
-            else
-            {
-                schedulePlotResultLoad();
-                result = new Cantor::TextResult(i18n("Waiting for the plot result"));
-            }
+            PlotFile file;
+            file.fileName = m_tempFile->fileName();
+            file.format = QFileInfo(file.fileName).suffix();
+            loadPlot(file, results().size());
+            result = new Cantor::TextResult(i18n("Waiting for the plot result"));
         }
         else
             result = new Cantor::TextResult(textContent);
     }
-    else if (latexContentStart != -1)
+    else if (token.hasLatex)
     {
         //latex output is available
-        const int latexContentEnd = resultContent.indexOf(QLatin1String("</cantor-latex>"));
-        QString latexContent = resultContent.mid(latexContentStart + 14, latexContentEnd - latexContentStart - 14).trimmed();
+        QString latexContent = token.latex.trimmed();
         qDebug()<<"latex content: " << latexContent;
 
         Cantor::TextResult* textResult;
@@ -523,8 +527,11 @@ void MaximaExpression::parseError(const QString& out)
     m_errorBuffer.append(out);
 }
 
-void MaximaExpression::parseHelpSelectionPrompt(const QString& prompt)
+void MaximaExpression::parseHelpSelectionPrompt(const QString& pendingOutput)
 {
+    const QString prompt = (m_pendingText + pendingOutput).trimmed();
+    m_pendingText.clear();
+
     if (!m_errorBuffer.isEmpty())
     {
         auto* result = new Cantor::HelpResult(QLatin1Char(' ') + m_errorBuffer.trimmed());
@@ -549,65 +556,3 @@ void MaximaExpression::addInformation(const QString& information)
 
     static_cast<MaximaSession*>(session())->sendInputToProcess(inf+QLatin1Char('\n'));
 }
-
-void MaximaExpression::imageChanged()
-{
-    schedulePlotResultLoad();
-}
-
-void MaximaExpression::schedulePlotResultLoad()
-{
-    if (m_plotResult || m_plotResultLoadScheduled)
-        return;
-
-    m_plotResultLoadScheduled = true;
-    QTimer::singleShot(100, this, &MaximaExpression::loadPlotResult);
-}
-
-void MaximaExpression::loadPlotResult()
-{
-    m_plotResultLoadScheduled = false;
-
-    if (!m_tempFile || m_plotResult)
-        return;
-
-    const QFileInfo plotFileInfo(m_tempFile->fileName());
-    if (!plotFileInfo.exists() || plotFileInfo.size() <= 0)
-    {
-        if (m_plotResultLoadAttempts < 10)
-        {
-            ++m_plotResultLoadAttempts;
-            schedulePlotResultLoad();
-        }
-        else if (m_plotResultIndex != -1 && status() == Cantor::Expression::Computing)
-            setStatus(Cantor::Expression::Done);
-
-        return;
-    }
-
-    // QFileSystemWatcher can notify before gnuplot finishes writing.
-    if (plotFileInfo.size() != m_plotFileLastSize)
-    {
-        m_plotFileLastSize = plotFileInfo.size();
-        schedulePlotResultLoad();
-        return;
-    }
-
-    auto* plotResult = new Cantor::ImageResult(QUrl::fromLocalFile(m_tempFile->fileName()));
-    if (plotResult->data().value<QImage>().isNull() && m_plotResultLoadAttempts < 10)
-    {
-        delete plotResult;
-        ++m_plotResultLoadAttempts;
-        schedulePlotResultLoad();
-        return;
-    }
-
-    m_plotResult = plotResult;
-
-    if (m_plotResultIndex != -1)
-    {
-        replaceResult(m_plotResultIndex, m_plotResult);
-        if (status() == Cantor::Expression::Computing)
-            setStatus(Cantor::Expression::Done);
-    }
-}
@@ -8,7 +8,7 @@
 #define _MAXIMAEXPRESSION_H
 
 #include "expression.h"
-#include <QFileSystemWatcher>
+#include "maximaoutputtokenizer.h"
 
 class QTemporaryFile;
 
@@ -28,31 +28,28 @@ public:
 
     //reads from @param out until a prompt indicates that a new expression has started
     void parseOutput(const QString&) override;
+    void parseToken(const MaximaOutputTokenizer::Token&);
     void parseError(const QString&) override;
     void addInformation(const QString&) override;
 
     void parseHelpSelectionPrompt(const QString&);
 
-private Q_SLOTS:
-    void imageChanged();
-    void loadPlotResult();
-
 private:
-    void parseResult(const QString&);
-    void schedulePlotResultLoad();
+    void parseResult(const MaximaOutputTokenizer::Token&);
+    void parsePrompt(const QString&);
 
     QTemporaryFile* m_tempFile = nullptr;
-    QFileSystemWatcher m_fileWatch;
     bool m_isHelpRequest = false;
     bool m_isHelpRequestAdditional = false;
     bool m_isPlot = false;
     bool m_isDraw = false;
-    Cantor::Result* m_plotResult = nullptr;
-    int m_plotResultIndex = -1;
-    bool m_plotResultLoadScheduled = false;
-    qint64 m_plotFileLastSize = -1;
-    int m_plotResultLoadAttempts = 0;
     QString m_errorBuffer;
+
+    // output collected while parsing the sections of the output up to the next prompt
+    QString m_pendingText;  // untagged output after the last result
+    QString m_errorContent; // untagged output before the first result of help requests
+    int m_resultCount = 0;
+    bool m_hasValueSeparator = false;
 };
 
 #endif /* _MAXIMAEXPRESSION_H */
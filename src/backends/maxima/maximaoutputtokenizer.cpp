@@ -0,0 +1,153 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "maximaoutputtokenizer.h"
+
+#include <QByteArrayMatcher>
+
+#include <algorithm>
+
+static const QByteArray ResultOpenTag = QByteArrayLiteral("<cantor-result>");
+static const QByteArray ResultCloseTag = QByteArrayLiteral("</cantor-result>");
+static const QByteArray PromptOpenTag = QByteArrayLiteral("<cantor-prompt>");
+static const QByteArray PromptCloseTag = QByteArrayLiteral("</cantor-prompt>");
+static const QByteArray TextOpenTag = QByteArrayLiteral("<cantor-text>");
+static const QByteArray TextCloseTag = QByteArrayLiteral("</cantor-text>");
+static const QByteArray LatexOpenTag = QByteArrayLiteral("<cantor-latex>");
+static const QByteArray LatexCloseTag = QByteArrayLiteral("</cantor-latex>");
+
+/*!
+    example output for the simple expression '5+5':
+    latex mode - "<cantor-result><cantor-text>\n(%o1) 10\n</cantor-text><cantor-latex>\\mbox{\\tt\\red(\\mathrm{\\%o1}) \\black}10</cantor-latex></cantor-result>\n<cantor-prompt>(%i2) </cantor-prompt>\n"
+    text mode  - "<cantor-result><cantor-text>\n(%o1) 10\n</cantor-text></cantor-result>\n<cantor-prompt>(%i2) </cantor-prompt>\n"
+ */
+QVector<MaximaOutputTokenizer::Token> MaximaOutputTokenizer::feed(const QByteArray& data)
+{
+    static const QByteArrayMatcher tagMatcher(QByteArrayLiteral("<cantor-"));
+
+    QVector<Token> tokens;
+    m_buffer += data;
+
+    while (true)
+    {
+        if (m_state == Outside)
+        {
+            const qsizetype index = tagMatcher.indexIn(m_buffer, m_scanOffset);
+            if (index == -1)
+            {
+                // keep a possibly split tag prefix for the next call
+                m_scanOffset = std::max(m_pos, m_buffer.size() - tagMatcher.pattern().size() + 1);
+                break;
+            }
+
+            // both opening tags have the same length, wait until the complete tag is available
+            if (m_buffer.size() - index < ResultOpenTag.size())
+            {
+                m_scanOffset = index;
+                break;
+            }
+
+            const QByteArray tag = QByteArray::fromRawData(m_buffer.constData() + index, ResultOpenTag.size());
+            State newState;
+            if (tag == ResultOpenTag)
+                newState = InResult;
+            else if (tag == PromptOpenTag)
+                newState = InPrompt;
+            else
+            {
+                m_scanOffset = index + 1;
+                continue;
+            }
+
+            if (index > m_pos)
+            {
+                Token token;
+                token.type = Token::Text;
+                token.text = QString::fromLocal8Bit(m_buffer.constData() + m_pos, index - m_pos);
+                tokens << token;
+            }
+
+            m_state = newState;
+            m_pos = index + ResultOpenTag.size();
+            m_scanOffset = m_pos;
+        }
+        else
+        {
+            const QByteArray& closeTag = (m_state == InResult) ? ResultCloseTag : PromptCloseTag;
+            const qsizetype index = m_buffer.indexOf(closeTag, m_scanOffset);
+            if (index == -1)
+            {
+                m_scanOffset = std::max(m_pos, m_buffer.size() - closeTag.size() + 1);
+                break;
+            }
+
+            const QByteArray content = QByteArray::fromRawData(m_buffer.constData() + m_pos, index - m_pos);
+            if (m_state == InResult)
+                tokens << resultToken(content);
+            else
+            {
+                Token token;
+                token.type = Token::Prompt;
+                token.text = QString::fromLocal8Bit(content);
+                tokens << token;
+            }
+
+            m_state = Outside;
+            m_pos = index + closeTag.size();
+            m_scanOffset = m_pos;
+        }
+    }
+
+    // drop the emitted part of the buffer once per call and not once per section
+    if (m_pos > 0)
+    {
+        m_buffer.remove(0, m_pos);
+        m_scanOffset -= m_pos;
+        m_pos = 0;
+    }
+
+    return tokens;
+}
+
+MaximaOutputTokenizer::Token MaximaOutputTokenizer::resultToken(const QByteArray& content)
+{
+    Token token;
+    token.type = Token::Result;
+
+    const qsizetype textStart = content.indexOf(TextOpenTag);
+    if (textStart != -1)
+    {
+        const qsizetype contentStart = textStart + TextOpenTag.size();
+        const qsizetype textEnd = content.indexOf(TextCloseTag, contentStart);
+        token.text = QString::fromLocal8Bit(content.mid(contentStart, textEnd == -1 ? -1 : textEnd - contentStart));
+    }
+
+    const qsizetype latexStart = content.indexOf(LatexOpenTag);
+    if (latexStart != -1)
+    {
+        const qsizetype contentStart = latexStart + LatexOpenTag.size();
+        const qsizetype latexEnd = content.indexOf(LatexCloseTag, contentStart);
+        token.latex = QString::fromLocal8Bit(content.mid(contentStart, latexEnd == -1 ? -1 : latexEnd - contentStart));
+        token.hasLatex = true;
+    }
+
+    return token;
+}
+
+void MaximaOutputTokenizer::reset()
+{
+    m_buffer.clear();
+    m_pos = 0;
+    m_scanOffset = 0;
+    m_state = Outside;
+}
+
+QString MaximaOutputTokenizer::pendingText() const
+{
+    if (m_state != Outside)
+        return QString();
+
+    return QString::fromLocal8Bit(m_buffer.constData() + m_pos, m_buffer.size() - m_pos);
+}
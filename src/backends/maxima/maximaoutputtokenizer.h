@@ -0,0 +1,52 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef _MAXIMAOUTPUTTOKENIZER_H
+#define _MAXIMAOUTPUTTOKENIZER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * Incremental tokenizer for the tagged output stream produced by Maxima with cantor-initmaxima.lisp.
+ * The output is split into the untagged text, the <cantor-result> and the <cantor-prompt> sections.
+ * Every section is returned exactly once as soon as it's closed, the already scanned bytes are never
+ * scanned again, so the parsing of long outputs is linear in their size.
+ */
+class MaximaOutputTokenizer
+{
+public:
+    struct Token {
+        enum Type {
+            Text,   ///< output outside of the cantor tags (warnings, errors, help texts, etc.)
+            Result, ///< a <cantor-result> section
+            Prompt  ///< a <cantor-prompt> section, the command is finished
+        };
+
+        Type type{Text};
+        QString text;  ///< untagged output, content of <cantor-text> or the prompt
+        QString latex; ///< content of <cantor-latex>, for results only
+        bool hasLatex{false};
+    };
+
+    QVector<Token> feed(const QByteArray&);
+    void reset();
+
+    /// returns the untagged output received after the last emitted section
+    QString pendingText() const;
+
+private:
+    enum State {Outside, InResult, InPrompt};
+
+    static Token resultToken(const QByteArray& content);
+
+    QByteArray m_buffer;
+    qsizetype m_pos{0};        // start of the not yet emitted part of m_buffer
+    qsizetype m_scanOffset{0}; // position to continue the search for the next tag at
+    State m_state{Outside};
+};
+
+#endif /* _MAXIMAOUTPUTTOKENIZER_H */
@@ -49,45 +49,16 @@ void MaximaSession::login()
     const QString initFile = locateCantorFile(QLatin1String("maximabackend/cantor-initmaxima.lisp"));
     arguments << QLatin1String("--init-lisp=") + initFile; //Set the name of the Lisp initialization file
 
-    // start the process
+    // start the process, the login continues in loginHandshakeDone() after the first maxima prompt
     m_process = new QProcess(this);
-    m_process->start(MaximaSettings::self()->path().toLocalFile(), arguments);
-    if (!m_process->waitForStarted())
-    {
-        changeStatus(Session::Disable);
-        Q_EMIT error(i18n("Failed to start Maxima, please check Maxima's installation."));
-        Q_EMIT loginDone();
-        delete m_process;
-        m_process = nullptr;
-        return;
-    }
-
-    // Wait until first maxima prompt
-    QString input;
-    while (!input.contains(QLatin1String("</cantor-prompt>")))
-    {
-        if (!m_process->waitForReadyRead())
-            break;
-        input += QString::fromLatin1(m_process->readAllStandardOutput());
-    }
-
-    if (input.isEmpty())
-    {
-        changeStatus(Session::Disable);
-        QString errorMsg = i18n("Maxima didn't respond with the proper prompt, please check Maxima installation.");
-        QString errStd = QString::fromLatin1(m_process->readAllStandardError());
-        if (!errStd.isEmpty())
-        {
-            errorMsg += QLatin1Char('\n') + i18n("Error: %1", errStd);
-            qDebug() << errorMsg;
-        }
+    m_process->setProgram(MaximaSettings::self()->path().toLocalFile());
+    m_process->setArguments(arguments);
+    startLoginProcess(m_process, QByteArrayLiteral("</cantor-prompt>"), i18n("Failed to start Maxima, please check Maxima's installation."));
+}
 
-        Q_EMIT error(errorMsg);
-        Q_EMIT loginDone();
-        delete m_process;
-        m_process = nullptr;
-        return;
-    }
+void MaximaSession::loginHandshakeDone(const QByteArray& pendingOutput)
+{
+    Q_UNUSED(pendingOutput);
 
     connect(m_process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(restartMaxima()));
     connect(m_process, SIGNAL(readyReadStandardOutput()), this, SLOT(readStdOut()));
@@ -114,11 +85,17 @@ void MaximaSession::login()
         write(QLatin1String("load(\"operatingsystem\"); chdir(\"") + dir + QLatin1String("\");"));
     }
 
-    changeStatus(Session::Done);
-    Q_EMIT loginDone();
+    finishLogin();
     qDebug()<<"login done";
 }
 
+void MaximaSession::loginHandshakeFailed(const QString& message)
+{
+    m_process->deleteLater();
+    m_process = nullptr;
+    Session::loginHandshakeFailed(message);
+}
+
 void MaximaSession::logout()
 {
     qDebug()<<"logout";
@@ -181,55 +158,57 @@ void MaximaSession::readStdErr()
 
 void MaximaSession::readStdOut()
 {
-    QString out = QString::fromLocal8Bit(m_process->readAllStandardOutput());
-    m_cache += out;
+    //the output is split into the tagged sections while reading it, every section
+    //is passed to the current expression only once as soon as it is complete
+    const auto& tokens = m_tokenizer.feed(m_process->readAllStandardOutput());
 
-    //collect the multi-line output until Maxima has finished the calculation and returns a new prompt
-    if ( !out.contains(QLatin1String("</cantor-prompt>")) )
+    bool promptFound = false;
+    for (const auto& token : tokens)
     {
-        // The Maxima help system's selection prompt ("Enter space-separated numbers, `all' or `none': ")
-        // is not wrapped in <cantor-prompt> tags. Without this detection, parseOutput() would never
-        // be called, causing a deadlock where we wait for a prompt that never comes while Maxima
-        // waits for user input.
-        if (!expressionQueue().isEmpty())
+        if (expressionQueue().isEmpty())
         {
-            auto* expr = static_cast<MaximaExpression*>(expressionQueue().first());
-            if (expr->isHelpRequest()
-                && m_cache.contains(QLatin1String("Enter space-separated numbers")))
-            {
-                const QString err = QString::fromLocal8Bit(m_process->readAllStandardError());
-                if (!err.isEmpty())
-                    expr->parseError(err);
-
-                QString prompt = m_cache.trimmed();
-                m_cache.clear();
-                expr->parseHelpSelectionPrompt(prompt);
-            }
+            //queue is empty, interrupt was called, nothing to do here
+            qDebug()<<"dropping output" << token.text;
+            continue;
         }
-        return;
-    }
 
-    if(expressionQueue().isEmpty())
-    {
-        //queue is empty, interrupt was called, nothing to do here
-        qDebug()<<m_cache;
-        m_cache.clear();
-        return;
+        auto* expr = static_cast<MaximaExpression*>(expressionQueue().first());
+        if (token.type == MaximaOutputTokenizer::Token::Prompt)
+        {
+            promptFound = true;
+
+            // flush any pending stderr before handling the prompt to ensure
+            // error messages are available in the error buffer of the expression
+            const QString err = QString::fromLocal8Bit(m_process->readAllStandardError());
+            if (!err.isEmpty())
+                expr->parseError(err);
+        }
+
+        expr->parseToken(token);
     }
 
-    auto* expr = expressionQueue().first();
-    if (!expr)
-        return; //should never happen
+    //collect the multi-line output until Maxima has finished the calculation and returns a new prompt
+    if (promptFound || expressionQueue().isEmpty())
+        return;
 
-    // flush any pending stderr before parsing stdout to ensure
-    // error messages are available in the error buffer for parseOutput()
-    const QString err = QString::fromLocal8Bit(m_process->readAllStandardError());
-    if (!err.isEmpty())
-        expr->parseError(err);
+    // The Maxima help system's selection prompt ("Enter space-separated numbers, `all' or `none': ")
+    // is not wrapped in <cantor-prompt> tags. Without this detection, the expression would never
+    // be finished, causing a deadlock where we wait for a prompt that never comes while Maxima
+    // waits for user input.
+    auto* expr = static_cast<MaximaExpression*>(expressionQueue().first());
+    if (expr->isHelpRequest())
+    {
+        const QString& pendingOutput = m_tokenizer.pendingText();
+        if (pendingOutput.contains(QLatin1String("Enter space-separated numbers")))
+        {
+            const QString err = QString::fromLocal8Bit(m_process->readAllStandardError());
+            if (!err.isEmpty())
+                expr->parseError(err);
 
-    qDebug()<<"output: " << m_cache;
-    expr->parseOutput(m_cache);
-    m_cache.clear();
+            m_tokenizer.reset();
+            expr->parseHelpSelectionPrompt(pendingOutput);
+        }
+    }
 }
 
 void MaximaSession::reportProcessError(QProcess::ProcessError e)
@@ -262,7 +241,7 @@ void MaximaSession::runFirstExpression()
         else
         {
             expr->setStatus(Cantor::Expression::Computing);
-            m_cache.clear();
+            m_tokenizer.reset();
             write(command + QLatin1Char('\n'));
         }
     }
@@ -291,7 +270,7 @@ void MaximaSession::interrupt()
     }
 
     changeStatus(Cantor::Session::Done);
-    m_cache.clear();
+    m_tokenizer.reset();
 }
 
 void MaximaSession::sendInputToProcess(const QString& input)
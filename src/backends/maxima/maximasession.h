@@ -8,6 +8,7 @@
 
 #include "session.h"
 #include "expression.h"
+#include "maximaoutputtokenizer.h"
 #include <QProcess>
 #include <QRegularExpression>
 
@@ -51,10 +52,12 @@ class MaximaSession : public Cantor::Session
     void reportProcessError(QProcess::ProcessError);
 
   private:
+    void loginHandshakeDone(const QByteArray&) override;
+    void loginHandshakeFailed(const QString&) override;
     void write(const QString&);
 
     QProcess* m_process{nullptr};
-    QString m_cache;
+    MaximaOutputTokenizer m_tokenizer;
     bool m_justRestarted{false};
     Mode m_mode{Maxima};
 };
@@ -14,6 +14,7 @@
 #include "imageresult.h"
 #include "syntaxhelpobject.h"
 #include "defaultvariablemodel.h"
+#include "maximaoutputtokenizer.h"
 
 #include <config-cantorlib.h>
 
@@ -529,6 +530,32 @@ void TestMaxima::testLispMode01()
     QCOMPARE(cleanOutput(e4->result()->data().toString()), QLatin1String("10"));
 }
 
+void TestMaxima::testOutputTokenizer()
+{
+    const QByteArray output = QByteArrayLiteral(
+        "\nrat: replaced 7.5 by 15/2 = 7.5\n"
+        "<cantor-result><cantor-text>\n(%o2) 15/2\n</cantor-text><cantor-latex>\\frac{15}{2}</cantor-latex></cantor-result>\n"
+        "<cantor-prompt>(%i3) </cantor-prompt>\n");
+
+    // feed the output byte by byte, every section has to be emitted exactly once
+    MaximaOutputTokenizer tokenizer;
+    QVector<MaximaOutputTokenizer::Token> tokens;
+    for (int i = 0; i < output.size(); ++i)
+        tokens << tokenizer.feed(output.mid(i, 1));
+
+    QCOMPARE(tokens.size(), 4);
+    QCOMPARE(tokens.at(0).type, MaximaOutputTokenizer::Token::Text);
+    QCOMPARE(tokens.at(0).text.trimmed(), QLatin1String("rat: replaced 7.5 by 15/2 = 7.5"));
+    QCOMPARE(tokens.at(1).type, MaximaOutputTokenizer::Token::Result);
+    QCOMPARE(tokens.at(1).text.trimmed(), QLatin1String("(%o2) 15/2"));
+    QVERIFY(tokens.at(1).hasLatex);
+    QCOMPARE(tokens.at(1).latex, QLatin1String("\\frac{15}{2}"));
+    QCOMPARE(tokens.at(2).type, MaximaOutputTokenizer::Token::Text);
+    QCOMPARE(tokens.at(3).type, MaximaOutputTokenizer::Token::Prompt);
+    QCOMPARE(tokens.at(3).text, QLatin1String("(%i3) "));
+    QCOMPARE(tokenizer.pendingText(), QLatin1String("\n"));
+}
+
 void TestMaxima::testLoginLogout()
 {
     // Logout from session twice and all must works fine
@@ -68,6 +68,9 @@ private Q_SLOTS:
 
     void testTextQuotes();
 
+    //tests the splitting of the tagged output arriving in chunks
+    void testOutputTokenizer();
+
     void testLoginLogout();
     void testRestartWhileRunning();
 
@@ -18,13 +18,14 @@
 #include <QDebug>
 #include <QFile>
 #include <QDir>
-#include <QFileSystemWatcher>
 #include <QRegularExpression>
 #include <QScreen>
 
 #include <KLocalizedString>
 
 static const QString printCommandTemplate = QString::fromLatin1("print(\"%1\", \"-S%2,%3\")");
+// announces the plot file after print() has written it, see Cantor::Expression::takePlotAnnouncements()
+static const QString announceCommandTemplate = QString::fromLatin1("printf(\"cantor-plot:%s:%d:%s\\n\", \"%1\", stat(\"%2\").size, \"%2\");");
 
 static const QStringList plotCommands({
     QLatin1String("plot"), QLatin1String("semilogx"), QLatin1String("semilogy"),
@@ -64,9 +65,6 @@ void OctaveExpression::evaluate()
 {
     m_plotFilename.clear();
 
-    m_finished = false;
-    m_plotPending = false;
-
     session()->enqueueExpression(this);
 }
 
@@ -90,7 +88,8 @@ QString OctaveExpression::internalCommand()
                     if (!cmd.endsWith(QLatin1Char(';')) && !cmd.endsWith(QLatin1Char(',')))
                         cmd += QLatin1Char(',');
 
-                    m_plotFilename = octaveSession->plotFilePrefixPath() + QString::number(id()) + QLatin1String(".") + plotExtensions[OctaveSettings::inlinePlotFormat()];
+                    const QString& extension = plotExtensions[OctaveSettings::inlinePlotFormat()];
+                    m_plotFilename = octaveSession->plotFilePrefixPath() + QString::number(id()) + QLatin1String(".") + extension;
 
                     int w, h;
                     if (OctaveSettings::inlinePlotFormat() == 0 || OctaveSettings::inlinePlotFormat() == 1) // for vector formats like PDF and SVG the size for 'print'  is provided in points
@@ -104,21 +103,8 @@ QString OctaveExpression::internalCommand()
                         w = OctaveSettings::plotWidth() / 2.54 * dpi;
                         h = OctaveSettings::plotHeight() / 2.54 * dpi;
                     }
-                    cmd += printCommandTemplate.arg(m_plotFilename, QString::number(w), QString::number(h));
-
-                    auto* watcher = fileWatcher();
-                    if (!watcher->files().isEmpty())
-                        watcher->removePaths(watcher->files());
-
-                    // add path works only for existing paths, so create the file
-                    QFile file(m_plotFilename);
-                    if (file.open(QFile::WriteOnly))
-                    {
-                        file.close();
-                        watcher->addPath(m_plotFilename);
-                        m_plotPending = true;
-                        connect(watcher, &QFileSystemWatcher::fileChanged, this, &OctaveExpression::imageChanged,  Qt::UniqueConnection);
-                    }
+                    cmd += printCommandTemplate.arg(m_plotFilename, QString::number(w), QString::number(h)) + QLatin1Char(';');
+                    cmd += announceCommandTemplate.arg(extension, m_plotFilename);
 
                     cmd = QLatin1String("figure('visible','off');") + cmd;
                 }
@@ -195,19 +181,22 @@ void OctaveExpression::parseOutput(const QString& output)
     else
         qDebug() << "parseOutput: " << output;
 
-    if (!output.trimmed().isEmpty())
+    QString text = output;
+    const auto& plots = takePlotAnnouncements(text);
+    for (const auto& plot : plots)
+        loadPlot(plot, -1, Cantor::PdfResult::Type);
+
+    if (!text.trimmed().isEmpty())
     {
         // TODO: what about help in comment? printf with '... help ...'?
         // This must be corrected.
         if (command().contains(QLatin1String("help")))
-            addResult(new Cantor::HelpResult(output));
+            addResult(new Cantor::HelpResult(text));
         else
-            addResult(new Cantor::TextResult(output));
+            addResult(new Cantor::TextResult(text));
     }
 
-    m_finished = true;
-    if (!m_plotPending)
-        setStatus(Done);
+    setStatusAfterPlots(Done);
 }
 
 void OctaveExpression::parseError(const QString& error)
@@ -220,35 +209,3 @@ void OctaveExpression::parseError(const QString& error)
     else
         Expression::parseError(error);
 }
-
-void OctaveExpression::imageChanged()
-{
-    QFile file(m_plotFilename);
-    if(!file.open(QIODevice::ReadOnly)/* || file.size() <= 0*/)
-    {
-        m_plotPending = false;
-        setResult(new Cantor::TextResult(i18n("Invalid image file generated.")));
-        setStatus(Error);
-        return;
-    }
-
-    const QUrl& url = QUrl::fromLocalFile(m_plotFilename);
-    QByteArray pdfData = file.readAll();
-    auto* newResult = new Cantor::PdfResult(url, pdfData);
-
-    bool found = false;
-    for (int i = 0; i < results().size(); i++)
-        if (results()[i]->type() == newResult->type())
-        {
-            replaceResult(i, newResult);
-            found = true;
-        }
-
-    if (!found)
-        addResult(newResult);
-
-    m_plotPending = false;
-
-    if (m_finished && status() == Expression::Computing)
-        setStatus(Done);
-}
@@ -26,14 +26,11 @@ public:
 
     void parseOutput(const QString&) override;
     void parseError(const QString&) override;
-    void imageChanged();
 
     const static QStringList plotExtensions;
 
 private:
     QString m_resultString;
-    bool m_finished = false;
-    bool m_plotPending = false;
     QString m_plotFilename;
 };
 
@@ -20,11 +20,14 @@
 #include <KLocalizedString>
 #include <KMessageBox>
 
+#include <QByteArrayMatcher>
 #include <QTimer>
 #include <QFile>
 #include <QDir>
 #include <QStringView>
 
+#include <algorithm>
+
 #ifndef Q_OS_WIN
 #include <signal.h>
 #endif
@@ -87,18 +90,16 @@ void OctaveSession::login()
     // check whether we can write to the temp folder for integrated plot files
     checkWritableTempFolder();
 
-    m_process->start(OctaveSettings::path().toLocalFile(), args);
+    m_process->setProgram(OctaveSettings::path().toLocalFile());
+    m_process->setArguments(args);
     qDebug() << "starting " << m_process->program();
 
-    if (!m_process->waitForStarted())
-    {
-        changeStatus(Session::Disable);
-        Q_EMIT error(i18n("Failed to start Octave, please check Octave installation."));
-        Q_EMIT loginDone();
-        delete m_process;
-        m_process = nullptr;
-        return;
-    }
+    startLoginProcess(m_process, QByteArray(), i18n("Failed to start Octave, please check Octave installation."));
+}
+
+void OctaveSession::loginHandshakeDone(const QByteArray& pendingOutput)
+{
+    Q_UNUSED(pendingOutput);
 
     connect(m_process, &QProcess::readyReadStandardOutput, this, &OctaveSession::readOutput);
     connect(m_process, &QProcess::readyReadStandardError, this, &OctaveSession::readError);
@@ -148,11 +149,17 @@ void OctaveSession::login()
         evaluateExpression(mfilenameTemplate.arg(worksheetPathWithoutExtension, path), OctaveExpression::DeleteOnFinish, true);
     }
 
-    changeStatus(Cantor::Session::Done);
-    Q_EMIT loginDone();
+    finishLogin();
     qDebug()<<"login done";
 }
 
+void OctaveSession::loginHandshakeFailed(const QString& message)
+{
+    m_process->deleteLater();
+    m_process = nullptr;
+    Session::loginHandshakeFailed(message);
+}
+
 void OctaveSession::logout()
 {
     qDebug()<<"logout";
@@ -192,6 +199,8 @@ void OctaveSession::logout()
     expressionQueue().clear();
 
     m_output.clear();
+    m_outputBuffer.clear();
+    m_outputScanOffset = 0;
     m_previousPromptNumber = 1;
 
     Session::logout();
@@ -221,6 +230,8 @@ void OctaveSession::interrupt()
         // If we move this code for interruption to Session, we need add function for
         // cleaning before setting Done status
         m_output.clear();
+        m_outputBuffer.clear();
+        m_outputScanOffset = 0;
         m_process->write("\n");
 
         qDebug()<<"done interrupting";
@@ -279,32 +290,66 @@ void OctaveSession::readError()
             exp->parseError(error);
 
         m_output.clear();
+        m_outputBuffer.remove(0, m_outputScanOffset);
+        m_outputScanOffset = 0;
     }
 }
 
 void OctaveSession::readOutput()
 {
-    while (m_process->bytesAvailable() > 0)
+    // The output is collected as raw bytes and scanned for the prompts with a fixed-string search.
+    // Only the prompt candidates are decoded and checked with the regular expressions, the output
+    // in front of a prompt is decoded and passed to the expression in one go.
+    static const QByteArrayMatcher promptSentinel(QByteArrayLiteral("CANTOR_OCTAVE_BACKEND_"));
+    static const QByteArray promptEnd = QByteArrayLiteral("> ");
+    static const qsizetype maxPromptLength = 64;
+
+    m_outputBuffer += m_process->readAllStandardOutput();
+
+    while (true)
     {
-        QString line = QString::fromLocal8Bit(m_process->readLine());
+        const qsizetype pos = promptSentinel.indexIn(m_outputBuffer, m_outputScanOffset);
+        if (pos == -1)
+        {
+            // no prompt yet, continue after the already scanned part next time, a sentinel might be split
+            m_outputScanOffset = std::max(qsizetype(0), m_outputBuffer.size() - promptSentinel.pattern().size() + 1);
+            break;
+        }
+
+        const qsizetype end = m_outputBuffer.indexOf(promptEnd, pos);
+        if (end == -1 && m_outputBuffer.size() - pos < maxPromptLength)
+        {
+            // the prompt is not complete yet
+            m_outputScanOffset = pos;
+            break;
+        }
 
-        qDebug()<<"start parsing " << "  " << line;
-        QRegularExpressionMatch match = m_prompt.match(line);
+        if (end == -1 || end - pos > maxPromptLength)
+        {
+            // the sentinel is part of the regular output
+            m_outputScanOffset = pos + 1;
+            continue;
+        }
+
+        const qsizetype promptLength = end + promptEnd.size() - pos;
+        const QString candidate = QString::fromLocal8Bit(m_outputBuffer.constData() + pos, promptLength);
+        QRegularExpressionMatch match = m_prompt.match(candidate, 0, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption);
         if (match.hasMatch())
         {
+            qDebug() << "prompt catch" << candidate;
             const int promptNumber = match.captured(1).toInt();
-            // Add all text before prompt, if exists
-            m_output += line.left(match.capturedStart(0));
+            m_output = QString::fromLocal8Bit(m_outputBuffer.constData(), pos);
+            m_outputBuffer.remove(0, pos + promptLength);
+            m_outputScanOffset = 0;
+
             if (!expressionQueue().isEmpty())
             {
                 const QString& command = expressionQueue().first()->command();
                 if (m_previousPromptNumber + 1 == promptNumber || isSpecialOctaveCommand(command))
                 {
+                    readError();
                     if (!expressionQueue().isEmpty())
-                    {
-                        readError();
                         expressionQueue().first()->parseOutput(m_output);
-                    }
                 }
                 else
                 {
@@ -314,19 +359,23 @@ void OctaveSession::readOutput()
             }
             m_previousPromptNumber = promptNumber;
             m_output.clear();
+            continue;
         }
-        else if ((match = m_subprompt.match(line)).hasMatch()
-                 && match.captured(1).toInt() == m_previousPromptNumber)
+
+        match = m_subprompt.match(candidate, 0, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption);
+        if (match.hasMatch() && match.captured(1).toInt() == m_previousPromptNumber)
         {
             // User don't write finished octave statement (for example, write 'a = [1,2, ' only), so
             // octave print subprompt and waits input finish.
             m_syntaxError = true;
             qDebug() << "subprompt catch";
             m_process->write(")]'\"\n"); // force exit from subprompt
-            m_output.clear();
+            m_outputBuffer.remove(0, pos + promptLength);
+            m_outputScanOffset = 0;
+            continue;
         }
-        else
-            m_output += line;
+
+        m_outputScanOffset = pos + 1;
     }
 }
 
@@ -46,11 +46,15 @@ class OctaveSession : public Cantor::Session
         int m_previousPromptNumber{1};
         bool m_syntaxError{false};
         QString m_output;
+        QByteArray m_outputBuffer; // raw output of octave not yet split at a prompt
+        qsizetype m_outputScanOffset{0}; // position in m_outputBuffer to continue the prompt search at
         QString m_plotFilePrefixPath;
         bool m_isIntegratedPlotsEnabled{false}; // Better move it in worksheet, like isCompletion, etc.
         bool m_writableTempFolder{false};
 
     private:
+        void loginHandshakeDone(const QByteArray&) override;
+        void loginHandshakeFailed(const QString&) override;
         void readFromOctave(QByteArray);
         bool isDoNothingCommand(const QString&);
         bool isSpecialOctaveCommand(const QString&);
@@ -107,6 +107,22 @@ void TestOctave::testMatrixDefinition()
     ));
 }
 
+//Large output
+void TestOctave::testLargeMatrixOutput()
+{
+    Cantor::Expression* e = nullptr;
+    QBENCHMARK {
+        e = evalExp(QLatin1String("disp(reshape(1:300000, 100000, 3))"));
+    }
+
+    QVERIFY(e != nullptr);
+    QVERIFY(e->result() != nullptr);
+
+    const QString& result = e->result()->data().toString().trimmed();
+    QCOMPARE(result.count(QLatin1Char('\n')) + 1, 100000);
+    QVERIFY(result.endsWith(QLatin1String("300000")));
+}
+
 //Comments
 void TestOctave::testComment00()
 {
@@ -31,6 +31,10 @@ private Q_SLOTS:
     void testVariableDefinition();
     void testMatrixDefinition();
 
+    //large output
+    //tests the output of a big matrix, also used as a benchmark for the output reader
+    void testLargeMatrixOutput();
+
     //comments
     void testComment00();
     void testComment01();
@@ -8,6 +8,7 @@
 #include <config-cantorlib.h>
 
 #include "textresult.h"
+#include "outputcapture.h"
 #include "imageresult.h"
 #include "helpresult.h"
 #include "session.h"
@@ -16,7 +17,6 @@
 #include <QDebug>
 #include <QDir>
 #include <QTemporaryFile>
-#include <QFileSystemWatcher>
 
 #include <KLocalizedString>
 
@@ -62,8 +62,9 @@ QString PythonExpression::internalCommand()
             setStatus(Cantor::Expression::Error);
             return QString();
         }
-        QString saveFigCommand = QLatin1String("savefig('%1')");
-        cmd.replace(QLatin1String("show()"), saveFigCommand.arg(m_tempFile->fileName()));
+        // the file is announced once it's written, see Cantor::Expression::takePlotAnnouncements()
+        QString saveFigCommand = QLatin1String("savefig(r'%1'); print(r'cantor-plot:%2:%d:%1' % __import__('os').path.getsize(r'%1'))");
+        cmd.replace(QLatin1String("show()"), saveFigCommand.arg(m_tempFile->fileName(), extension));
 
         // set the plot size in inches
         // TODO: matplotlib is usually imported via "import matplotlib.pyplot as plt" and we set
@@ -72,11 +73,6 @@ QString PythonExpression::internalCommand()
         const double w = PythonSettings::plotWidth() / 2.54;
         const double h = PythonSettings::plotHeight() / 2.54;
         cmd += QLatin1String("\nplt.figure(figsize=(%1, %2))").arg(QString::number(w), QString::number(h));
-
-        QFileSystemWatcher* watcher = fileWatcher();
-        watcher->removePaths(watcher->files());
-        watcher->addPath(m_tempFile->fileName());
-        connect(watcher, &QFileSystemWatcher::fileChanged, this, &PythonExpression::imageChanged,  Qt::UniqueConnection);
     }
     // TODO: handle other plotting frameworks
 
@@ -120,42 +116,42 @@ void PythonExpression::parseOutput(const QString& output)
         QString resultStr = output;
         setResult(new Cantor::HelpResult(resultStr.remove(output.lastIndexOf(QLatin1String("None")), 4)));
     } else {
-        if (!output.isEmpty())
-            addResult(new Cantor::TextResult(output));
+        QString text = output;
+        const auto& plots = takePlotAnnouncements(text);
+        if (!text.isEmpty())
+            addResult(new Cantor::TextResult(text));
+
+        for (const auto& plot : plots)
+            loadPlot(plot);
      }
 
-    setStatus(Cantor::Expression::Done);
+    setStatusAfterPlots(Cantor::Expression::Done);
 }
 
-void PythonExpression::parseWarning(const QString& warning)
+void PythonExpression::parseOutput(Cantor::OutputCapture& output)
 {
-    if (!warning.isEmpty())
+    if (!output.isTruncated() || command().simplified().startsWith(QLatin1String("help(")))
     {
-        auto* result = new Cantor::TextResult(warning);
-        result->setStdErr(true);
-        addResult(result);
+        parseOutput(output.text());
+        return;
     }
+
+    qDebug() << "expression output truncated, total size: " << output.size();
+    const auto& plots = takePlotAnnouncements(output);
+    addResult(output.createResult());
+
+    for (const auto& plot : plots)
+        loadPlot(plot);
+
+    setStatusAfterPlots(Cantor::Expression::Done);
 }
 
-void PythonExpression::imageChanged()
+void PythonExpression::parseWarning(const QString& warning)
 {
-    if(m_tempFile->size() <= 0)
-        return;
-
-    auto* newResult = new Cantor::ImageResult(QUrl::fromLocalFile(m_tempFile->fileName()));
-    if (result() == nullptr)
-        setResult(newResult);
-    else
+    if (!warning.isEmpty())
     {
-        bool found = false;
-        for (int i = 0; i < results().size(); i++)
-            if (results()[i]->type() == newResult->type())
-            {
-                replaceResult(i, newResult);
-                found = true;
-            }
-        if (!found)
-            addResult(newResult);
+        auto* result = new Cantor::TextResult(warning);
+        result->setStdErr(true);
+        addResult(result);
     }
-    setStatus(Done);
 }
@@ -9,6 +9,10 @@
 #include "expression.h"
 class QTemporaryFile;
 
+namespace Cantor {
+class OutputCapture;
+}
+
 class PythonExpression : public Cantor::Expression
 {
   Q_OBJECT
@@ -20,10 +24,10 @@ class PythonExpression : public Cantor::Expression
     QString internalCommand() override;
 
     void parseOutput(const QString&) override;
+    void parseOutput(Cantor::OutputCapture&);
     void parseWarning(const QString&);
 
 private:
-    void imageChanged();
     QTemporaryFile* m_tempFile{nullptr};
 };
 
@@ -53,12 +53,15 @@ void PythonServer::runPythonCommand(const string& command)
         "import sys;\n"\
         "class CatchOutPythonBackend:\n"\
         "  def __init__(self, std_stream):\n"\
-        "    self.value = ''\n"\
+        "    self.chunks = []\n"\
         "    self.encoding = std_stream.encoding\n"\
+        "  @property\n"\
+        "  def value(self):\n"\
+        "    return ''.join(self.chunks)\n"\
         "  def flush():\n"\
         "    pass\n"\
         "  def write(self, txt):\n"\
-        "    self.value += txt\n"\
+        "    self.chunks.append(txt)\n"\
         "outputPythonBackend = CatchOutPythonBackend(sys.stdout)\n"\
         "errorPythonBackend  = CatchOutPythonBackend(sys.stderr)\n"\
         "sys.stdout = outputPythonBackend\n"\
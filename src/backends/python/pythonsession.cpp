@@ -49,6 +49,9 @@ PythonSession::~PythonSession()
 void PythonSession::login()
 {
     qDebug()<<"login";
+    if (m_process && isLoggingIn())
+        return;
+
     Q_EMIT loginStarted();
 
     if (m_process)
@@ -60,32 +63,18 @@ void PythonSession::login()
 #ifdef Q_OS_WIN
     const QString& serverExecutablePath = QStandardPaths::findExecutable(QLatin1String("cantor_pythonserver.exe"));
     // On Windows QProcess can't handle paths with spaces, so add escaping
-    m_process->start(QLatin1String("\"") + serverExecutablePath + QLatin1String("\""));
+    m_process->setProgram(QLatin1String("\"") + serverExecutablePath + QLatin1String("\""));
 #else
     const QString& serverExecutablePath = QStandardPaths::findExecutable(QLatin1String("cantor_pythonserver"));
-    m_process->start(serverExecutablePath);
+    m_process->setProgram(serverExecutablePath);
 #endif
 
-    if (!m_process->waitForStarted())
-    {
-        changeStatus(Session::Disable);
-        Q_EMIT error(i18n("Failed to start Python, please check Python installation."));
-        Q_EMIT loginDone();
-        delete m_process;
-        m_process = nullptr;
-        return;
-    }
-
-    m_process->waitForReadyRead();
-    QTextStream stream(m_process->readAllStandardOutput());
+    startLoginProcess(m_process, QByteArrayLiteral("ready"), i18n("Failed to start Python, please check Python installation."));
+}
 
-    const QString& readyStatus = QString::fromLatin1("ready");
-    while (m_process->state() == QProcess::Running)
-    {
-        const QString& rl = stream.readLine();
-        if (rl == readyStatus)
-            break;
-    }
+void PythonSession::loginHandshakeDone(const QByteArray& pendingOutput)
+{
+    Q_UNUSED(pendingOutput);
 
     connect(m_process, &QProcess::readyReadStandardOutput, this, &PythonSession::readOutput);
     connect(m_process, &QProcess::errorOccurred, this, &PythonSession::reportServerProcessError);
@@ -120,8 +109,14 @@ void PythonSession::login()
         evaluateExpression(autorunScripts, Cantor::Expression::DeleteOnFinish, true);
     }
 
-    changeStatus(Session::Done);
-    Q_EMIT loginDone();
+    finishLogin();
+}
+
+void PythonSession::loginHandshakeFailed(const QString& message)
+{
+    m_process->deleteLater();
+    m_process = nullptr;
+    Session::loginHandshakeFailed(message);
 }
 
 void PythonSession::logout()
@@ -172,6 +167,9 @@ void PythonSession::interrupt()
         expressionQueue().clear();
 
         m_output.clear();
+        m_error.clear();
+        m_errorFlag.clear();
+        m_messageField = 0;
 
         qDebug()<<"done interrupting";
     }
@@ -200,6 +198,9 @@ void PythonSession::runFirstExpression()
     qDebug() << "run first expression" << command;
     expr->setStatus(Cantor::Expression::Computing);
 
+    //the output of internal expressions is parsed and needs to be complete
+    m_output.setBudget(expr->isInternal() ? 0 : Cantor::OutputCapture::defaultBudget());
+
     if (expr->isInternal() && command.startsWith(QLatin1String("%variables ")))
     {
         const QString arg = command.section(QLatin1String(" "), 1);
@@ -218,47 +219,69 @@ void PythonSession::sendCommand(const QString& command, const QStringList argume
 
 void PythonSession::readOutput()
 {
+    //the messages are scanned while they arrive so the output doesn't need to be
+    //accumulated and split as a whole, it's passed on to the capture in chunks
     while (m_process->bytesAvailable() > 0)
     {
-        const QByteArray& bytes = m_process->readAll();
-        m_output.append(QString::fromUtf8(bytes));
-    }
+        const QString& text = m_decoder.decode(m_process->readAll());
+        qsizetype start = 0;
+        for (qsizetype i = 0; i < text.size(); ++i)
+        {
+            const QChar c = text.at(i);
+            if (c != unitSep && c != messageEnd)
+                continue;
 
-    qDebug() << "m_output: " << m_output;
+            appendMessageField(QStringView(text).mid(start, i - start));
+            start = i + 1;
 
-    if (!m_output.contains(messageEnd))
-        return;
+            if (c == unitSep)
+                ++m_messageField;
+            else
+                processMessage();
+        }
+        appendMessageField(QStringView(text).mid(start));
+    }
+}
 
-    const QStringList packages = m_output.split(messageEnd, Qt::SkipEmptyParts);
-    if (m_output.endsWith(messageEnd))
-        m_output.clear();
-    else
-        m_output = m_output.section(messageEnd, -1);
+void PythonSession::appendMessageField(QStringView text)
+{
+    if (text.isEmpty())
+        return;
 
-    for (const QString& message: packages)
+    switch (m_messageField)
     {
-        if (expressionQueue().isEmpty())
-            break;
+    case 0:
+        m_output.append(text.toString());
+        break;
+    case 1:
+        m_error += text;
+        break;
+    default:
+        m_errorFlag += text;
+    }
+}
 
-        const QString& output = message.section(unitSep, 0, 0);
-        const QString& error = message.section(unitSep, 1, 1);
-        bool isError = message.section(unitSep, 2, 2).toInt();
-        auto* expr = expressionQueue().first();
-        if (isError)
-        {
-            if(error.isEmpty()){
-                expr->parseOutput(output);
-            } else {
-                expr->parseError(error);
-            }
-        }
+void PythonSession::processMessage()
+{
+    if (!expressionQueue().isEmpty())
+    {
+        auto* expr = static_cast<PythonExpression*>(expressionQueue().first());
+        const bool isError = m_errorFlag.toInt();
+        if (isError && !m_error.isEmpty())
+            expr->parseError(m_error);
         else
         {
-            static_cast<PythonExpression*>(expr)->parseWarning(error);
-            expr->parseOutput(output);
+            if (!isError)
+                expr->parseWarning(m_error);
+            expr->parseOutput(m_output);
         }
         finishFirstExpression(true);
     }
+
+    m_output.clear();
+    m_error.clear();
+    m_errorFlag.clear();
+    m_messageField = 0;
 }
 
 void PythonSession::reportServerProcessError(QProcess::ProcessError serverError)
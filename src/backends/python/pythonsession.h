@@ -8,7 +8,9 @@
 #define _PYTHONSESSION_H
 
 #include "session.h"
+#include "outputcapture.h"
 #include <QStringList>
+#include <QStringDecoder>
 #include <QProcess>
 
 class PythonSession : public Cantor::Session
@@ -30,7 +32,14 @@ class PythonSession : public Cantor::Session
 
   private:
     QProcess* m_process{nullptr};
-    QString m_output;
+
+    //fields of the message currently being received from the server,
+    //the output of the expression is kept within the configured budget
+    QStringDecoder m_decoder{QStringDecoder::Utf8};
+    Cantor::OutputCapture m_output;
+    QString m_error;
+    QString m_errorFlag;
+    int m_messageField{0};
     QString m_plotFilePrefixPath;
     int m_plotFileCounter{0};
 
@@ -39,11 +48,15 @@ class PythonSession : public Cantor::Session
     void reportServerProcessError(QProcess::ProcessError);
 
   private:
+    void loginHandshakeDone(const QByteArray&) override;
+    void loginHandshakeFailed(const QString&) override;
     void runFirstExpression() override;
     void updateGraphicPackagesFromSettings();
     QString graphicPackageErrorMessage(QString packageId) const override;
 
     void sendCommand(const QString& command, const QStringList arguments = QStringList()) const;
+    void appendMessageField(QStringView);
+    void processMessage();
 };
 
 #endif /* _PYTHONSESSION_H */
@@ -10,9 +10,13 @@
 #include "expression.h"
 #include "imageresult.h"
 #include "defaultvariablemodel.h"
+#include "extension.h"
+#include "backend.h"
 
 #include "settings.h"
 
+#include <QTemporaryDir>
+
 QString TestPython3::backendName()
 {
     return QLatin1String("python");
@@ -298,6 +302,25 @@ void TestPython3::testVariableCleanupAfterRestart()
     QCOMPARE(0, model->rowCount());
 }
 
+void TestPython3::testAsynchronousLogin()
+{
+    session()->logout();
+    QCOMPARE(session()->loginState(), Cantor::Session::LoggedOut);
+
+    // login() returns before the server is ready, expressions submitted meanwhile are queued
+    QSignalSpy spy(session(), SIGNAL(loginDone()));
+    session()->login();
+    QVERIFY(session()->isLoggingIn());
+
+    auto* e = evalExp(QLatin1String("2+2"));
+    QVERIFY(!spy.isEmpty());
+    QCOMPARE(session()->loginState(), Cantor::Session::LoggedIn);
+
+    QVERIFY(e != nullptr);
+    QVERIFY(e->result());
+    QCOMPARE(e->result()->data().toString(), QLatin1String("4"));
+}
+
 void TestPython3::testDictVariable()
 {
     if (!PythonSettings::variableManagement())
@@ -317,6 +340,53 @@ void TestPython3::testDictVariable()
     evalExp(QLatin1String("del d"));
 }
 
+void TestPython3::testVariablesCheckpoint()
+{
+    auto* ext = dynamic_cast<Cantor::VariableManagementExtension*>(session()->backend()->extension(QLatin1String("VariableManagementExtension")));
+    QVERIFY(ext != nullptr);
+
+    auto* e = evalExp(QLatin1String("import numpy"));
+    QVERIFY(e != nullptr);
+    if (e->status() != Cantor::Expression::Done)
+        QSKIP("This test needs numpy", SkipSingle);
+
+    e = evalExp(QLatin1String(
+        "a = numpy.arange(12.0).reshape(3, 4)\n"
+        "f = numpy.asfortranarray(a)\n"
+        "l = [1, 'two', {'three': numpy.ones(3)}]"
+    ));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    QTemporaryDir dir;
+    const QString& fileName = dir.filePath(QLatin1String("variables.cantorpy"));
+    e = evalExp(ext->saveVariables(fileName));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    evalExp(QLatin1String("del a; del f; del l"));
+
+    e = evalExp(ext->loadVariables(fileName));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    //the arrays are mapped from the file and keep their memory layout, changing them doesn't modify the file
+    e = evalExp(QLatin1String("print((a == numpy.arange(12.0).reshape(3, 4)).all(), (f == a).all(), f.flags.f_contiguous, l[1], l[2]['three'].sum())"));
+    QVERIFY(e != nullptr);
+    QVERIFY(e->result());
+    QCOMPARE(e->result()->data().toString(), QLatin1String("True True True two 3.0"));
+
+    evalExp(QLatin1String("a[0, 0] = 5; del a; del f; del l"));
+    e = evalExp(ext->loadVariables(fileName));
+    QVERIFY(e != nullptr);
+    e = evalExp(QLatin1String("print(a[0, 0])"));
+    QVERIFY(e != nullptr);
+    QVERIFY(e->result());
+    QCOMPARE(e->result()->data().toString(), QLatin1String("0.0"));
+
+    evalExp(QLatin1String("del a; del f; del l; del numpy"));
+}
+
 void TestPython3::testInterrupt()
 {
     QSKIP("doesn't work on CI", SkipSingle);
@@ -32,8 +32,10 @@ class TestPython3 : public BackendTest
     void testVariableChangeSizeType();
     void testVariableCleanupAfterRestart();
     void testDictVariable();
+    void testVariablesCheckpoint();
 
     void testInterrupt();
+    void testAsynchronousLogin();
 
     void testWarning();
   private:
@@ -1,9 +1,54 @@
-import shelve
-shelvePythonBackend = shelve.open('%1')
-for keyPythonBackend in shelvePythonBackend:
-  globals()[keyPythonBackend] = shelvePythonBackend[keyPythonBackend]
-
-shelvePythonBackend.close()
-del(shelve)
-del(shelvePythonBackend)
-del(keyPythonBackend)
+# Reads the variables from a checkpoint file written by variables_saver.py.
+# The file is mapped into the memory, the numpy arrays and the out of band buffers of the pickled values
+# are created on top of the mapping and their data is only read from the disk when it's accessed.
+# The mapping is copy-on-write, changing the loaded arrays doesn't modify the file.
+# Files written by older versions with shelve are still loaded.
+def loadVariablesPythonBackend(fileName):
+    import mmap
+    import pickle
+    import struct
+
+    with open(fileName, 'rb') as file:
+        if file.read(8) != b'CANTORPY':
+            return None
+        mapped = mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_COPY)
+
+    view = memoryview(mapped)
+    indexOffset = struct.unpack_from('<Q', view, 8)[0]
+    index = pickle.loads(view[indexOffset:])
+
+    variables = {}
+    for name, entry in index.items():
+        try:
+            if entry[0] == 'ndarray':
+                import numpy
+                kind, offset, size, dtype, shape, fortran = entry
+                if size == 0:
+                    value = numpy.empty(shape, dtype=dtype)
+                elif fortran:
+                    value = numpy.frombuffer(view, dtype=dtype, count=size // dtype.itemsize, offset=offset).reshape(shape[::-1]).T
+                else:
+                    value = numpy.frombuffer(view, dtype=dtype, count=size // dtype.itemsize, offset=offset).reshape(shape)
+            else:
+                kind, offset, size, blocks = entry
+                buffers = [view[blockOffset:blockOffset + blockSize] for blockOffset, blockSize in blocks]
+                value = pickle.loads(view[offset:offset + size], buffers=buffers) if buffers else pickle.loads(view[offset:offset + size])
+        except Exception:
+            # e.g. instances of classes which are not defined in this session
+            continue
+        variables[name] = value
+
+    return variables
+
+variablesPythonBackend = loadVariablesPythonBackend(r'%1')
+if variablesPythonBackend is None:
+    import shelve
+    shelvePythonBackend = shelve.open(r'%1')
+    variablesPythonBackend = dict(shelvePythonBackend)
+    shelvePythonBackend.close()
+    del(shelve)
+    del(shelvePythonBackend)
+
+globals().update(variablesPythonBackend)
+del(variablesPythonBackend)
+del(loadVariablesPythonBackend)
@@ -1,11 +1,71 @@
-import shelve
-shelvePythonBackend = shelve.open('%1', 'n')
-for keyPythonBackend in dir():
-  if (not 'PythonBackend' in keyPythonBackend)\
-      and (not '__' in keyPythonBackend)\
-      and (not '<module ' in str(globals()[keyPythonBackend])):
-    shelvePythonBackend[keyPythonBackend] = globals()[keyPythonBackend]
-shelvePythonBackend.close()
-del(shelve)
-del(shelvePythonBackend)
-del(keyPythonBackend)
+# Writes the variables of the session into a binary checkpoint file:
+# the magic bytes, the offset of the index, the 64 bytes aligned data blocks and the pickled index at the end.
+# The memory of the numpy arrays is written as it is so that it can be mapped on load without any copies,
+# all other values are pickled with protocol 5 and their large buffers are written out of band.
+def saveVariablesPythonBackend(fileName, variables):
+    import os
+    import pickle
+    import struct
+    import sys
+    import types
+
+    # there can't be any arrays if numpy wasn't imported in the session
+    numpy = sys.modules.get('numpy')
+
+    def align(file):
+        file.write(b'\0' * (-file.tell() & 63))
+        return file.tell()
+
+    # the arrays loaded from a previous checkpoint can still be mapped from the old file,
+    # it's replaced instead of being overwritten
+    index = {}
+    temporaryFileName = fileName + '.tmp'
+    with open(temporaryFileName, 'wb') as file:
+        file.write(b'CANTORPY')
+        file.write(struct.pack('<Q', 0))
+
+        for name, value in variables:
+            if 'PythonBackend' in name or '__' in name or isinstance(value, types.ModuleType):
+                continue
+
+            if numpy is not None and type(value) is numpy.ndarray and not value.dtype.hasobject:
+                fortran = value.ndim > 1 and value.flags.f_contiguous and not value.flags.c_contiguous
+                data = value.T if fortran else numpy.ascontiguousarray(value)
+                offset = align(file)
+                file.write(data.reshape(-1).view(numpy.uint8))
+                index[name] = ('ndarray', offset, data.nbytes, value.dtype, value.shape, fortran)
+                continue
+
+            try:
+                buffers = []
+                if pickle.HIGHEST_PROTOCOL >= 5:
+                    payload = pickle.dumps(value, protocol=5, buffer_callback=buffers.append)
+                    try:
+                        buffers = [buffer.raw() for buffer in buffers]
+                    except BufferError:
+                        # not contiguous, keep the buffers in band
+                        buffers = []
+                        payload = pickle.dumps(value, protocol=5)
+                else:
+                    payload = pickle.dumps(value, protocol=pickle.HIGHEST_PROTOCOL)
+            except Exception:
+                # values like open files or generators can't be saved
+                continue
+
+            offset = align(file)
+            file.write(payload)
+            blocks = []
+            for buffer in buffers:
+                blocks.append((align(file), buffer.nbytes))
+                file.write(buffer)
+            index[name] = ('pickle', offset, len(payload), blocks)
+
+        indexOffset = align(file)
+        pickle.dump(index, file, protocol=pickle.HIGHEST_PROTOCOL)
+        file.seek(8)
+        file.write(struct.pack('<Q', indexOffset))
+
+    os.replace(temporaryFileName, fileName)
+
+saveVariablesPythonBackend(r'%1', list(globals().items()))
+del(saveVariablesPythonBackend)
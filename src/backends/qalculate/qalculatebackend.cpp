@@ -11,6 +11,7 @@
 #include "qalculatesession.h"
 #include "qalculateextensions.h"
 #include "qalculatesettingswidget.h"
+#include "qalculateworker.h"
 
 #include <KLocalizedString>
 #include <KPluginFactory>
@@ -63,8 +64,13 @@ QUrl QalculateBackend::helpUrl() const
 
 bool QalculateBackend::requirementsFullfilled(QString* const reason) const
 {
-    const QString& path = QalculateSettings::self()->path().toLocalFile();
-    return Cantor::Backend::checkExecutable(QLatin1String("Qalculate!"), path, reason);
+    //the commands are evaluated with libqalculate directly, the qalc executable is not needed
+    if (QalculateWorker::initCalculator())
+        return true;
+
+    if (reason)
+        *reason = i18n("The definitions of libqalculate couldn't be loaded. Please check the installation of libqalculate and try again.");
+    return false;
 }
 
 KConfigSkeleton* QalculateBackend::config() const
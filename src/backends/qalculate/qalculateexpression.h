@@ -8,6 +8,7 @@
 #define QALCULATE_EXPRESSION_H
 
 #include "expression.h"
+#include "qalculateworker.h"
 #include <vector>
 #include <string>
 #include <libqalculate/Calculator.h>
@@ -26,26 +27,28 @@ public:
     ~QalculateExpression() override;
 
     void evaluate() override;
+
+    /**
+     * Runs the expression once it's the first one in the queue of the session
+     */
+    void run();
     void parseOutput(const QString&) override;
     void parseError(const QString&) override;
 
+    /**
+     * Shows the plot calculated in the worker thread of the session and the messages of the calculator
+     */
+    void parsePlotResult(const QString& imageFile, const QStringList& errors, const QStringList& warnings, const QStringList& information);
+
 private:
     QTemporaryFile* m_tempFile{nullptr};
 
-    QString m_message;
-    enum MsgType { MSG_NONE=0, MSG_INFO=1, MSG_WARN=2, MSG_ERR=4 };
-
     void evaluatePlotCommand();
 
-    bool stringToBool(const QString&, bool*);
-    void deletePlotDataParameters(const std::vector<PlotDataParameters*>&);
-    void showMessage(QString msg, MessageType mtype);
-    int checkForCalculatorMessages();
-    void updateVariables();
+    QalculatePlotDefaults plotDefaults();
     QSharedPointer<PrintOptions> printOptions();
     EvaluationOptions evaluationOptions();
     ParseOptions parseOptions();
-    std::string unlocalizeExpression(QString expr);
 };
 
 #endif
@@ -9,31 +9,26 @@
 #include "session.h"
 #include "qalculateexpression.h"
 
-#include <QQueue>
 #include <QMap>
+#include <QThread>
 
-class QProcess;
+class QalculateWorker;
 
 class QalculateSession : public Cantor::Session
 {
     Q_OBJECT
 
 private:
-    QProcess* m_process{nullptr};
-    QalculateExpression* m_currentExpression{nullptr};
-    QString m_output;
-    QString m_finalOutput;
-    QString m_currentCommand;
-    QString m_saveError;
-    QQueue<QalculateExpression*> m_expressionQueue;
-    QQueue<QString> m_commandQueue;
-    bool m_isSaveCommand{false};
+    QThread m_thread;
+    QalculateWorker* m_worker{nullptr};
+    int m_evaluationId{0};
+    int m_canceledId{0};
+    int m_clearedId{0};
+    QMap<QString,QString> m_variables;
 
 private:
-    void runExpressionQueue();
-    void runCommandQueue();
-    QString parseSaveCommand(QString& currentCmd);
-    void storeVariables(QString& currentCmd, QString output);
+    void evaluated(int id, const QString& result, const QStringList& errors, const QMap<QString, QString>& variables);
+    void plotted(int id, const QString& imageFile, const QStringList& errors, const QStringList& warnings, const QStringList& information);
 
 public:
     explicit QalculateSession(Cantor::Backend*);
@@ -45,17 +40,24 @@ public:
     void interrupt() override;
 
     Cantor::Expression* evaluateExpression(const QString& command, Cantor::Expression::FinishingBehavior behave = Cantor::Expression::FinishingBehavior::DoNotDelete, bool internal = false) override;
-    void runExpression();
-    const QMap<QString,QString>& getVariables() const;
 
-public:
-    QMap<QString,QString> variables;
+    /**
+     * Evaluates the current expression with libqalculate in the worker thread
+     */
+    void runExpression(const EvaluationOptions&, const PrintOptions&);
+
+    /**
+     * Calculates the plot command of the current expression in the worker thread
+     */
+    void runPlot(const EvaluationOptions&, const QalculatePlotDefaults&, const QString& fileName);
+
+    /**
+     * Returns the variables defined by the user with their values as read from the calculator after the last evaluation
+     */
+    const QMap<QString,QString>& getVariables() const;
 
-public Q_SLOTS:
-    void readOutput();
-    void readError();
-    void processStarted();
-    void currentExpressionStatusChanged(Cantor::Expression::Status status);
+protected:
+    void runFirstExpression() override;
 };
 
 #endif
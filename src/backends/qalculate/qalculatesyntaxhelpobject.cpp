@@ -7,9 +7,13 @@
 #include "qalculatesyntaxhelpobject.h"
 #include "settings.h"
 #include "qalculatesession.h"
+#include "qalculateworker.h"
 
 #include <KLocalizedString>
 
+#include <chrono>
+#include <mutex>
+
 #include <libqalculate/Calculator.h>
 #include <libqalculate/ExpressionItem.h>
 #include <libqalculate/Unit.h>
@@ -42,6 +46,13 @@ void QalculateSyntaxHelpObject::fetchInformation()
         return;
     }
 
+    //the calculator is shared with the worker threads of the sessions, don't block the GUI for a long calculation in another session
+    std::unique_lock<QMutex> locker(*QalculateWorker::calculatorMutex(), std::defer_lock);
+    if (!locker.try_lock_for(std::chrono::seconds(1))) {
+        m_answer = i18n("The calculator is busy, try again after the running calculations have finished.");
+        return;
+    }
+
     auto* item = CALCULATOR->getActiveExpressionItem(std::move(cmd));
     if (!item) {
         m_answer = i18n("No function, variable or unit with specified name exist.");
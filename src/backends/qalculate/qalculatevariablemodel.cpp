@@ -1,5 +1,6 @@
 #include "qalculatevariablemodel.h"
 #include "qalculatesession.h"
+#include "qalculateworker.h"
 
 #include <libqalculate/Calculator.h>
 #include <libqalculate/Unit.h>
@@ -7,6 +8,9 @@
 #include <libqalculate/Function.h>
 
 #include <QDebug>
+#include <QTimer>
+
+#include <mutex>
 
 using namespace Cantor;
 
@@ -22,29 +26,38 @@ QalculateVariableModel::~QalculateVariableModel()
 void QalculateVariableModel::update()
 {
     QList<Variable> newVars;
-    QStringList newFuncs;
 
     const auto& sessionVars = m_session->getVariables();
     for (auto it = sessionVars.constBegin(); it != sessionVars.constEnd(); ++it)
         newVars.append(Variable(it.key(), it.value()));
 
-    if (CALCULATOR) {
+    //the definitions of the calculator don't change, they are read only once.
+    //the variables defined by the user are provided by the session.
+    //the calculator is locked while a session evaluates, the GUI thread doesn't wait for it but tries again later.
+    std::unique_lock<QMutex> locker(*QalculateWorker::calculatorMutex(), std::defer_lock);
+    if (CALCULATOR && m_calculatorVariables.isEmpty() && !locker.try_lock())
+        QTimer::singleShot(100, this, &QalculateVariableModel::update);
+    else if (CALCULATOR && m_calculatorVariables.isEmpty()) {
         for ( auto* item : CALCULATOR->variables ) {
-            QString name = QLatin1String(item->name(true).c_str());
-            newVars.append(Variable(name, QString()));
+            if (!item->isLocal())
+                m_calculatorVariables << QLatin1String(item->name(true).c_str());
         }
 
         for ( ExpressionItem* item : CALCULATOR->functions) 
-            newFuncs << QLatin1String(item->name(true).c_str());
+            m_calculatorFunctions << QLatin1String(item->name(true).c_str());
 
         for (Unit* item : CALCULATOR->units) {
-            newVars.append(Variable(QLatin1String(item->name(true).c_str()), QString()));
-            newVars.append(Variable(QLatin1String(item->singular().c_str()), QString()));
+            m_calculatorVariables << QLatin1String(item->name(true).c_str());
+            m_calculatorVariables << QLatin1String(item->singular().c_str());
         }
+        locker.unlock();
     }
 
+    for (const auto& name : std::as_const(m_calculatorVariables))
+        newVars.append(Variable(name, QString()));
+
     setVariables(newVars);
-    setFunctions(newFuncs);
+    setFunctions(m_calculatorFunctions);
 
     setInitiallyPopulated();
 }
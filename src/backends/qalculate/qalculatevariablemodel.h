@@ -16,6 +16,8 @@ public:
 
 private:
     QalculateSession* m_session{nullptr};
+    QStringList m_calculatorVariables;
+    QStringList m_calculatorFunctions;
 };
 
 #endif // QALCULATE_VARIABLE_MODEL_H
@@ -0,0 +1,758 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "qalculateworker.h"
+
+#include <libqalculate/Variable.h>
+
+#include <KLocalizedString>
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QTextStream>
+
+QalculateWorker::QalculateWorker() : QObject()
+{
+}
+
+QalculateWorker::~QalculateWorker()
+{
+    clearVariables();
+}
+
+QMutex* QalculateWorker::calculatorMutex()
+{
+    static QMutex mutex;
+    return &mutex;
+}
+
+/*!
+ * creates the calculator shared by all sessions and loads its definitions, if not done yet.
+ * Returns \c false if the global definitions of libqalculate couldn't be loaded.
+ */
+bool QalculateWorker::initCalculator()
+{
+    //-1 as long as the calculator is not created, the calculator doesn't need to be locked afterwards
+    static QAtomicInt definitionsLoaded{-1};
+    if (definitionsLoaded.loadAcquire() != -1)
+        return definitionsLoaded.loadAcquire() == 1;
+
+    QMutexLocker locker(calculatorMutex());
+    if (!CALCULATOR)
+    {
+        new Calculator();
+        definitionsLoaded.storeRelease(CALCULATOR->loadGlobalDefinitions() ? 1 : 0);
+        CALCULATOR->loadLocalDefinitions();
+        CALCULATOR->loadExchangeRates();
+    }
+
+    return definitionsLoaded.loadAcquire() == 1;
+}
+
+void QalculateWorker::cancel(int id)
+{
+    int current = m_canceledId.loadAcquire();
+    while (current < id && !m_canceledId.testAndSetOrdered(current, id, current))
+        ;
+
+    const int running = m_runningId.loadAcquire();
+    if (running != 0 && running <= id)
+        CALCULATOR->abort();
+}
+
+bool QalculateWorker::isCanceled(int id) const
+{
+    return id <= m_canceledId.loadAcquire();
+}
+
+void QalculateWorker::evaluate(int id, const QString& command, const EvaluationOptions& eo, const PrintOptions& po)
+{
+    if (isCanceled(id))
+        return;
+
+    QMutexLocker locker(calculatorMutex());
+    m_runningId.storeRelease(id);
+    setVariablesActive(true);
+
+    QStringList output;
+    QStringList errors;
+    const auto& lines = command.split(QLatin1Char('\n'));
+    for (const auto& line : lines)
+    {
+        if (isCanceled(id))
+            break;
+
+        const QString& result = evaluateLine(line, eo, po, errors);
+        if (!result.isEmpty())
+            output << result;
+
+        if (!errors.isEmpty())
+            break;
+    }
+
+    m_runningId.storeRelease(0);
+    const auto& variables = userVariables(po);
+    setVariablesActive(false);
+    locker.unlock();
+
+    Q_EMIT evaluated(id, output.join(QLatin1Char('\n')), errors, variables);
+}
+
+QString QalculateWorker::evaluateLine(const QString& line, const EvaluationOptions& eo, const PrintOptions& po, QStringList& errors)
+{
+    const QString& command = line.trimmed();
+    if (command.isEmpty())
+        return QString();
+
+    //the definitions and the mode don't need to be saved by qalc anymore, they are kept in the calculator
+    static const QRegularExpression ignoredRegex(QStringLiteral("^(?:save\\s*definitions|save\\s*mode)$"),
+                                                 QRegularExpression::CaseInsensitiveOption);
+    if (ignoredRegex.match(command).hasMatch())
+        return QString();
+
+    //"saveVariables file" and "loadVariables file" are used by the variable manager, spaces in the file name are escaped
+    static const QRegularExpression fileRegex(QStringLiteral("^(saveVariables|loadVariables)\\s+(.+)$"),
+                                              QRegularExpression::CaseInsensitiveOption);
+    auto match = fileRegex.match(command);
+    if (match.hasMatch())
+    {
+        QString fileName = match.captured(2);
+        fileName.replace(QLatin1String("\\ "), QLatin1String(" "));
+        if (match.captured(1).compare(QLatin1String("saveVariables"), Qt::CaseInsensitive) == 0)
+            saveVariables(fileName, po, errors);
+        else
+            loadVariables(fileName, eo, po, errors);
+        return QString();
+    }
+
+    //"store name" and "save name" assign the last result to the variable
+    static const QRegularExpression storeRegex(QStringLiteral("^(?:store|save)\\s+([a-zA-Z_]\\w*)$"),
+                                               QRegularExpression::CaseInsensitiveOption);
+    match = storeRegex.match(command);
+    if (match.hasMatch())
+    {
+        storeVariable(match.captured(1), m_lastResult, errors);
+        return QString();
+    }
+
+    //"name := expression" and "name = expression" assign the result of the expression to the variable
+    static const QRegularExpression assignmentRegex(QStringLiteral("^([a-zA-Z_]\\w*)\\s*(?::=|=(?!=))\\s*(.+)$"));
+    QString expression = command;
+    QString variable;
+    match = assignmentRegex.match(command);
+    if (match.hasMatch())
+    {
+        variable = match.captured(1);
+        expression = match.captured(2);
+    }
+
+    CALCULATOR->clearMessages();
+    MathStructure parsed;
+    CALCULATOR->startControl();
+    const MathStructure result = CALCULATOR->calculate(CALCULATOR->unlocalizeExpression(expression.toStdString(), eo.parse_options), eo, &parsed);
+    const bool aborted = CALCULATOR->aborted();
+    CALCULATOR->stopControl();
+
+    QStringList messages;
+    collectMessages(messages, errors);
+    if (aborted)
+        errors << i18n("The calculation was aborted.");
+    if (!errors.isEmpty())
+        return messages.join(QLatin1Char('\n'));
+
+    m_lastResult = result;
+    if (!variable.isEmpty())
+        storeVariable(variable, result, errors);
+
+    //the same form as the output of qalc, the parsed expression and the result
+    bool isApproximate = false;
+    PrintOptions resultOptions = po;
+    resultOptions.is_approximate = &isApproximate;
+    const QString& value = print(result, resultOptions);
+    const QString& left = variable.isEmpty() ? print(parsed, po) : variable;
+    messages << left + (isApproximate ? QStringLiteral(" ≈ ") : QStringLiteral(" = ")) + value;
+
+    return messages.join(QLatin1Char('\n'));
+}
+
+void QalculateWorker::storeVariable(const QString& name, const MathStructure& value, QStringList& errors)
+{
+    auto* variable = m_variables.value(name);
+    if (variable)
+    {
+        variable->set(value);
+        return;
+    }
+
+    const std::string& variableName = name.toStdString();
+    if (CALCULATOR->variableNameIsValid(variableName) && !CALCULATOR->nameTaken(variableName))
+    {
+        variable = new KnownVariable(std::string(), variableName, value);
+        CALCULATOR->addVariable(variable);
+        m_variables.insert(name, variable);
+    }
+    else
+        errors << i18n("Could not save the variable %1, the name is invalid or already used.", name);
+}
+
+/*!
+ * writes the variables of the session as assignments, one per line, to \c fileName
+ */
+void QalculateWorker::saveVariables(const QString& fileName, const PrintOptions& po, QStringList& errors) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        errors << i18n("Could not write the variables to %1: %2", fileName, file.errorString());
+        return;
+    }
+
+    //fractions instead of rounded decimal numbers for the values of the variables
+    PrintOptions exactOptions = po;
+    exactOptions.number_fraction_format = FRACTION_FRACTIONAL;
+    exactOptions.use_unicode_signs = false;
+
+    QTextStream stream(&file);
+    for (auto it = m_variables.constBegin(); it != m_variables.constEnd(); ++it)
+        stream << it.key() << QLatin1String(" := ") << print(it.value()->get(), exactOptions) << QLatin1Char('\n');
+
+    stream.flush();
+    if (file.error() != QFileDevice::NoError)
+        errors << i18n("Could not write the variables to %1: %2", fileName, file.errorString());
+}
+
+/*!
+ * defines the variables saved by saveVariables() in \c fileName in the session
+ */
+void QalculateWorker::loadVariables(const QString& fileName, const EvaluationOptions& eo, const PrintOptions& po, QStringList& errors)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        errors << i18n("Could not read the variables from %1: %2", fileName, file.errorString());
+        return;
+    }
+
+    //only the assignments written by saveVariables() are evaluated
+    static const QRegularExpression assignmentRegex(QStringLiteral("^[a-zA-Z_]\\w*\\s*:=\\s*.+$"));
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line) && errors.isEmpty())
+    {
+        if (assignmentRegex.match(line.trimmed()).hasMatch())
+            evaluateLine(line, eo, po, errors);
+    }
+}
+
+/*!
+ * the variables of the session are only active while the calculator is used by this worker,
+ * the other sessions can neither use them nor are their names taken.
+ */
+void QalculateWorker::setVariablesActive(bool active)
+{
+    for (auto* variable : std::as_const(m_variables))
+        variable->setActive(active);
+}
+
+void QalculateWorker::clearVariables()
+{
+    QMutexLocker locker(calculatorMutex());
+
+    //the last result can refer to the variables
+    m_lastResult.clear();
+    for (auto* variable : std::as_const(m_variables))
+        variable->destroy();
+    m_variables.clear();
+}
+
+/*!
+ * returns the variables defined in the session with their values.
+ */
+QMap<QString, QString> QalculateWorker::userVariables(const PrintOptions& po) const
+{
+    QMap<QString, QString> variables;
+    for (auto it = m_variables.constBegin(); it != m_variables.constEnd(); ++it)
+        variables.insert(it.key(), print(it.value()->get(), po));
+
+    return variables;
+}
+
+QString QalculateWorker::print(MathStructure structure, const PrintOptions& po)
+{
+    structure.format(po);
+    return QString::fromStdString(structure.print(po));
+}
+
+void QalculateWorker::collectMessages(QStringList& output, QStringList& errors)
+{
+    if (!CALCULATOR->message())
+        return;
+
+    while (true)
+    {
+        const QString& text = QString::fromStdString(CALCULATOR->message()->message());
+        switch (CALCULATOR->message()->type())
+        {
+        case MESSAGE_ERROR:
+            errors << text;
+            break;
+        case MESSAGE_WARNING:
+            output << i18n("warning: %1", text);
+            break;
+        default:
+            output << text;
+            break;
+        }
+
+        if (!CALCULATOR->nextMessage())
+            break;
+    }
+}
+
+void QalculateWorker::plot(int id, const QString& command, const EvaluationOptions& eo, const QalculatePlotDefaults& defaults, const QString& fileName)
+{
+    if (isCanceled(id))
+        return;
+
+    QMutexLocker locker(calculatorMutex());
+    m_runningId.storeRelease(id);
+    setVariablesActive(true);
+    CALCULATOR->clearMessages();
+
+    Messages messages;
+    std::vector<PlotDataParameters*> dataParameters;
+    const QString& imageFile = calculatePlot(command, eo, defaults, fileName, dataParameters, messages);
+    for (auto* parameters : dataParameters)
+        delete parameters;
+
+    m_runningId.storeRelease(0);
+    setVariablesActive(false);
+    locker.unlock();
+
+    Q_EMIT plotted(id, imageFile, messages.errors, messages.warnings, messages.information);
+}
+
+/*!
+ * parses the options of the plot command, calculates the points of the functions and plots them with gnuplot.
+ * Returns the image file of an inline plot, the plot is canceled on the first error or warning.
+ */
+QString QalculateWorker::calculatePlot(const QString& command, const EvaluationOptions& eo, const QalculatePlotDefaults& defaults,
+                                       const QString& fileName, std::vector<PlotDataParameters*>& plotDataParameterList, Messages& messages)
+{
+    if (!CALCULATOR->canPlot()) {
+        messages.errors << i18n("Qalculate reports it cannot print. Is gnuplot installed?");
+        return QString();
+    }
+
+    QString argString = command.mid(command.indexOf(QLatin1String("plot"))+4);
+    argString = QLatin1String(unlocalizeExpression(argString).c_str());
+    argString = argString.trimmed();
+
+    QList<QStringList> argumentsList;
+    QStringList arguments;
+
+    // Split argString into the arguments
+    int i = 0;
+    int j = 0;
+    QString arg;
+    while (i < argString.size()) {
+        if (argString[i] == QLatin1Char('"') || argString[i] == QLatin1Char('\'')) {
+            ++j;
+            while (j < argString.size() && argString[j] != argString[i]) {
+                if (argString[j] == QLatin1Char('\\')) {
+                    ++j;
+                    if (j == argString.size())
+                        continue; // just ignore trailing backslashes
+                }
+                arg += argString[j];
+                ++j;
+            }
+            if (j == argString.size()) {
+                messages.errors << i18n("missing %1", argString[i]);
+                return QString();
+            }
+            ++j;
+        } else if (argString[i] == QLatin1Char(',')) {
+            argumentsList.append(arguments);
+            arguments.clear();
+            ++j;
+        } else {
+            while (j < argString.size() && !argString[j].isSpace() &&
+                   argString[j] != QLatin1Char('=') && argString[j] != QLatin1Char(',')) {
+                if (argString[j] == QLatin1Char('\\')) {
+                    ++j;
+                    if (j == argString.size())
+                        continue; // just ignore trailing backslashes
+                }
+                arg += argString[j];
+                ++j;
+            }
+        }
+        if (j < argString.size() && argString[j] == QLatin1Char('=')) {
+            // Parse things like title="..." as one argument
+            arg += QLatin1Char('=');
+            i = ++j;
+            continue;
+        }
+        if (!arg.isEmpty()) {
+            arguments << arg;
+            arg.clear();
+        }
+        while (j < argString.size() && argString[j].isSpace())
+            ++j;
+        i = j;
+    }
+    argumentsList.append(arguments);
+
+    // Parse the arguments and compute the points to be plotted
+    std::vector<MathStructure> y_vectors;
+    std::vector<MathStructure> x_vectors;
+    PlotParameters plotParameters = defaults.parameters;
+    bool plotInline = defaults.plotInline;
+    MathStructure xMin;
+    MathStructure xMax;
+    xMin.setUndefined();
+    xMax.setUndefined();
+    MathStructure stepLength;
+    stepLength.setUndefined();
+    int steps = defaults.steps;
+
+    const QString mustBeNumber = i18n("%1 must be a number.");
+    const QString mustBeInteger = i18n("%1 must be a integer.");
+    const QString mustBeBoolean = i18n("%1 must be a boolean.");
+    const QString invalidOption = i18n("invalid option for %1: %2");
+
+    for (const auto& dataArguments : std::as_const(argumentsList)) {
+        std::string xVariable = "x";
+        auto* plotDataParams = new PlotDataParameters(defaults.dataParameters);
+        plotDataParameterList.push_back(plotDataParams);
+        std::string expression;
+        int lastExpressionEntry = -1;
+        for (int j = 0; j < dataArguments.size(); ++j) {
+            const QString& argument = dataArguments[j];
+            bool ok = true;
+            // PlotParameters
+            if (argument.startsWith(QLatin1String("plottitle=")))
+                plotParameters.title = argument.mid(10).toLatin1().data();
+            else if (argument.startsWith(QLatin1String("ylabel=")))
+                plotParameters.y_label = argument.mid(7).toLatin1().data();
+            else if (argument.startsWith(QLatin1String("xlabel=")))
+                plotParameters.x_label = argument.mid(7).toLatin1().data();
+            else if (argument.startsWith(QLatin1String("filename=")))
+                plotParameters.filename = argument.mid(9).toLatin1().data();
+            else if (argument.startsWith(QLatin1String("filetype="))) {
+                const QString& option = argument.mid(9);
+                if (option == QLatin1String("auto"))
+                    plotParameters.filetype = PLOT_FILETYPE_AUTO;
+                else if (option == QLatin1String("png"))
+                    plotParameters.filetype = PLOT_FILETYPE_PNG;
+                else if (option == QLatin1String("ps"))
+                    plotParameters.filetype = PLOT_FILETYPE_PS;
+                else if (option == QLatin1String("eps"))
+                    plotParameters.filetype = PLOT_FILETYPE_EPS;
+                else if (option == QLatin1String("latex"))
+                    plotParameters.filetype = PLOT_FILETYPE_LATEX;
+                else if (option == QLatin1String("svg"))
+                    plotParameters.filetype = PLOT_FILETYPE_SVG;
+                else if (option == QLatin1String("fig"))
+                    plotParameters.filetype = PLOT_FILETYPE_FIG;
+                else {
+                    messages.errors << invalidOption.arg(QLatin1String("filetype"), option);
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("font=")))
+                plotParameters.font = argument.mid(5).toLatin1().data();
+            else if (argument.startsWith(QLatin1String("color="))) {
+                plotParameters.color = stringToBool(argument.mid(6), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("color"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("ylog="))) {
+                plotParameters.y_log = stringToBool(argument.mid(5), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("ylog"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("xlog="))) {
+                plotParameters.x_log = stringToBool(argument.mid(5), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("xlog"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("ylogbase="))) {
+                const MathStructure ylogStr = CALCULATOR->calculate(argument.mid(9).toLatin1().data(), eo);
+                if (takePlotMessages(messages))
+                    return QString();
+                if (!ylogStr.isNumber()) {
+                    messages.errors << mustBeNumber.arg(QLatin1String("ylogbase"));
+                    return QString();
+                }
+                plotParameters.y_log_base = ylogStr.number().floatValue();
+            }
+            else if (argument.startsWith(QLatin1String("xlogbase="))) {
+                const MathStructure xlogStr = CALCULATOR->calculate(argument.mid(9).toLatin1().data(), eo);
+                if (takePlotMessages(messages))
+                    return QString();
+                if (!xlogStr.isNumber()) {
+                    messages.errors << mustBeNumber.arg(QLatin1String("xlogbase"));
+                    return QString();
+                }
+                plotParameters.x_log_base = xlogStr.number().floatValue();
+            }
+            else if (argument.startsWith(QLatin1String("grid="))) {
+                plotParameters.grid = stringToBool(argument.mid(5), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("grid"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("linewidth="))) {
+                const MathStructure lineWidthStr = CALCULATOR->calculate(argument.mid(10).toLatin1().data(), eo);
+                if (!lineWidthStr.isNumber() || !lineWidthStr.number().isInteger()) {
+                    messages.errors << mustBeInteger.arg(QLatin1String("linewidth"));
+                    return QString();
+                }
+                plotParameters.linewidth = lineWidthStr.number().intValue();
+            }
+            else if (argument.startsWith(QLatin1String("border="))) {
+                plotParameters.show_all_borders = stringToBool(argument.mid(7), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("border"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("legend="))) {
+                const QString& option = argument.mid(7);
+                if (option == QLatin1String("none"))
+                    plotParameters.legend_placement = PLOT_LEGEND_NONE;
+                else if (option == QLatin1String("top_left"))
+                    plotParameters.legend_placement = PLOT_LEGEND_TOP_LEFT;
+                else if (option == QLatin1String("top_right"))
+                    plotParameters.legend_placement = PLOT_LEGEND_TOP_RIGHT;
+                else if (option == QLatin1String("bottom_left"))
+                    plotParameters.legend_placement = PLOT_LEGEND_BOTTOM_LEFT;
+                else if (option == QLatin1String("bottom_right"))
+                    plotParameters.legend_placement = PLOT_LEGEND_BOTTOM_RIGHT;
+                else if (option == QLatin1String("below"))
+                    plotParameters.legend_placement = PLOT_LEGEND_BELOW;
+                else if (option == QLatin1String("outside"))
+                    plotParameters.legend_placement = PLOT_LEGEND_OUTSIDE;
+                else {
+                    messages.errors << invalidOption.arg(QLatin1String("legend"), option);
+                    return QString();
+                }
+            }
+            // PlotDataParameters
+            else if (argument.startsWith(QLatin1String("title=")))
+                plotDataParams->title = argument.mid(6).toLatin1().data();
+            else if (argument.startsWith(QLatin1String("smoothing="))) {
+                const QString& option = argument.mid(10);
+                if (option == QLatin1String("none"))
+                    plotDataParams->smoothing = PLOT_SMOOTHING_NONE;
+                else if (option == QLatin1String("monotonic"))
+                    plotDataParams->smoothing = PLOT_SMOOTHING_UNIQUE;
+                else if (option == QLatin1String("csplines"))
+                    plotDataParams->smoothing = PLOT_SMOOTHING_CSPLINES;
+                else if (option == QLatin1String("bezier"))
+                    plotDataParams->smoothing = PLOT_SMOOTHING_BEZIER;
+                else if (option == QLatin1String("sbezier"))
+                    plotDataParams->smoothing = PLOT_SMOOTHING_SBEZIER;
+                else {
+                    messages.errors << invalidOption.arg(QLatin1String("smoothing"), option);
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("style="))) {
+                const QString& option = argument.mid(6);
+                if (option == QLatin1String("lines"))
+                    plotDataParams->style = PLOT_STYLE_LINES;
+                else if (option == QLatin1String("points"))
+                    plotDataParams->style = PLOT_STYLE_POINTS;
+                else if (option == QLatin1String("points_lines"))
+                    plotDataParams->style = PLOT_STYLE_POINTS_LINES;
+                else if (option == QLatin1String("boxes"))
+                    plotDataParams->style = PLOT_STYLE_BOXES;
+                else if (option == QLatin1String("histogram"))
+                    plotDataParams->style = PLOT_STYLE_HISTOGRAM;
+                else if (option == QLatin1String("steps"))
+                    plotDataParams->style = PLOT_STYLE_STEPS;
+                else if (option == QLatin1String("candlesticks"))
+                    plotDataParams->style = PLOT_STYLE_CANDLESTICKS;
+                else if (option == QLatin1String("dots"))
+                    plotDataParams->style = PLOT_STYLE_DOTS;
+                else {
+                    messages.errors << invalidOption.arg(QLatin1String("style"), option);
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("xaxis2="))) {
+                plotDataParams->xaxis2 = stringToBool(argument.mid(7), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("xaxis2"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("yaxis2="))) {
+                plotDataParams->yaxis2 = stringToBool(argument.mid(7), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("yaxis2"));
+                    return QString();
+                }
+            }
+            // Custom options
+            else if (argument.startsWith(QLatin1String("inline="))) {
+                plotInline = stringToBool(argument.mid(7), &ok);
+                if (!ok) {
+                    messages.errors << mustBeBoolean.arg(QLatin1String("inline"));
+                    return QString();
+                }
+            }
+            else if (argument.startsWith(QLatin1String("xmin="))) {
+                xMin = CALCULATOR->calculate(argument.mid(5).toLatin1().data(), eo);
+                if (takePlotMessages(messages))
+                    return QString();
+            }
+            else if (argument.startsWith(QLatin1String("xmax="))) {
+                xMax = CALCULATOR->calculate(argument.mid(5).toLatin1().data(), eo);
+                if (takePlotMessages(messages))
+                    return QString();
+            }
+            else if (argument.startsWith(QLatin1String("step="))) {
+                stepLength = CALCULATOR->calculate(argument.mid(5).toLatin1().data(), eo);
+                if (takePlotMessages(messages))
+                    return QString();
+                steps = -1;
+            }
+            else if (argument.startsWith(QLatin1String("steps="))) {
+                const MathStructure stepsStr = CALCULATOR->calculate(argument.mid(6).toLatin1().data(), eo);
+                if (takePlotMessages(messages))
+                    return QString();
+                if (!stepsStr.isNumber() || !stepsStr.number().isInteger()) {
+                    messages.errors << mustBeInteger.arg(QLatin1String("steps"));
+                    return QString();
+                }
+                steps = stepsStr.number().intValue();
+                stepLength.setUndefined();
+            }
+            else if (argument.startsWith(QLatin1String("xvar=")))
+                xVariable = argument.mid(5).toLatin1().data();
+            else if (expression.empty()) {
+                expression = argument.toLatin1().data();
+                lastExpressionEntry = j;
+            }
+            else if (lastExpressionEntry == j-1) {
+                expression += " ";
+                expression += argument.toLatin1().data();
+                lastExpressionEntry = j;
+            }
+            else {
+                messages.errors << i18n("found multiple expressions in one plot command (%1 and %2).", QLatin1String(expression.c_str()), argument);
+                return QString();
+            }
+        }
+        if (expression.empty())
+            continue;
+        if (xMin.isUndefined()) {
+            if (!plotParameters.auto_x_min)
+                xMin = plotParameters.x_min;
+            else
+                xMin = 0.0;
+        }
+        if (xMax.isUndefined()) {
+            if (!plotParameters.auto_x_max)
+                xMax = plotParameters.x_max;
+            else
+                xMax = 10.0;
+        }
+        if (plotDataParams->title.empty())
+            plotDataParams->title = expression;
+        MathStructure x_vec, y_vec;
+        x_vec.clearVector();
+        if (!stepLength.isUndefined())
+            y_vec = CALCULATOR->expressionToPlotVector(expression, xMin, xMax, stepLength, &x_vec, xVariable, eo.parse_options);
+        else
+            y_vec = CALCULATOR->expressionToPlotVector(expression, xMin, xMax, steps, &x_vec, xVariable, eo.parse_options);
+        if (takePlotMessages(messages))
+            return QString();
+
+        x_vectors.push_back(x_vec);
+        y_vectors.push_back(y_vec);
+    }
+
+    if (plotInline && plotParameters.filename.empty()) {
+        plotParameters.filename = fileName.toLatin1().data();
+        plotParameters.filetype = PLOT_FILETYPE_AUTO;
+    }
+
+    CALCULATOR->plotVectors(&plotParameters, y_vectors, x_vectors, plotDataParameterList);
+    if (takePlotMessages(messages))
+        return QString();
+
+    return plotInline ? QString::fromStdString(plotParameters.filename) : QString();
+}
+
+/*!
+ * takes the messages of the calculator, returns @c true if there was an error or a warning.
+ */
+bool QalculateWorker::takePlotMessages(Messages& messages)
+{
+    if (!CALCULATOR->message())
+        return false;
+
+    bool failed = false;
+    while (true)
+    {
+        const QString& text = QString::fromStdString(CALCULATOR->message()->message());
+        switch (CALCULATOR->message()->type())
+        {
+        case MESSAGE_ERROR:
+            messages.errors << text;
+            failed = true;
+            break;
+        case MESSAGE_WARNING:
+            messages.warnings << text;
+            failed = true;
+            break;
+        default:
+            messages.information << text;
+            break;
+        }
+
+        if (!CALCULATOR->nextMessage())
+            break;
+    }
+
+    return failed;
+}
+
+bool QalculateWorker::stringToBool(const QString& string, bool* ok)
+{
+    *ok = true;
+    if (string == QLatin1String("true") || string == QLatin1String("1"))
+        return true;
+    if (string == QLatin1String("false") || string == QLatin1String("0"))
+        return false;
+
+    *ok = false;
+    return false;
+}
+
+std::string QalculateWorker::unlocalizeExpression(QString expression)
+{
+    // copy'n'pasted from qalculate plasma applet
+    return CALCULATOR->unlocalizeExpression(
+             expression.replace(QChar(0xA3), QLatin1String("GBP"))
+                       .replace(QChar(0xA5), QLatin1String("JPY"))
+                       .replace(QLatin1String("$"), QLatin1String("USD"))
+                       .replace(QChar(0x20AC), QLatin1String("EUR"))
+                       .toLatin1().data()
+           );
+}
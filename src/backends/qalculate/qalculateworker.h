@@ -0,0 +1,105 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef QALCULATE_WORKER_H
+#define QALCULATE_WORKER_H
+
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+#include <libqalculate/Calculator.h>
+
+class KnownVariable;
+
+/**
+ * The parameters of a plot taken from the settings of the backend, the options of the plot command override them
+ */
+struct QalculatePlotDefaults
+{
+    PlotParameters parameters;
+    PlotDataParameters dataParameters;
+    bool plotInline{true};
+    int steps{100};
+};
+
+/**
+ * Evaluates the commands of a Qalculate session directly with libqalculate in the worker thread of the session.
+ * CALCULATOR is shared by all sessions, it's only used while calculatorMutex() is locked.
+ * The variables defined in a session are only active in the calculator while the worker of this session uses it,
+ * they are not visible in the other sessions. After every command they are passed to the GUI thread together with the result.
+ */
+class QalculateWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    QalculateWorker();
+    ~QalculateWorker() override;
+
+    /**
+     * Cancels the evaluation of the commands with ids up to @p id, can be called from any thread.
+     * A running calculation of one of these commands is aborted.
+     */
+    void cancel(int id);
+
+    static QMutex* calculatorMutex();
+    static bool initCalculator();
+
+    void evaluate(int id, const QString& command, const EvaluationOptions&, const PrintOptions&);
+
+    /**
+     * Calculates the plot command @p command, an inline plot without a file name given in the command is saved in @p fileName
+     */
+    void plot(int id, const QString& command, const EvaluationOptions&, const QalculatePlotDefaults&, const QString& fileName);
+
+    /**
+     * Removes the variables defined in the session from the calculator
+     */
+    void clearVariables();
+
+Q_SIGNALS:
+    /**
+     * Emitted once the command @p id is evaluated or was canceled while it was evaluated
+     */
+    void evaluated(int id, const QString& result, const QStringList& errors, const QMap<QString, QString>& variables);
+
+    /**
+     * Emitted once the plot command @p id is calculated, @p imageFile is the image of an inline plot
+     */
+    void plotted(int id, const QString& imageFile, const QStringList& errors, const QStringList& warnings, const QStringList& information);
+
+private:
+    struct Messages
+    {
+        QStringList errors;
+        QStringList warnings;
+        QStringList information;
+    };
+
+    bool isCanceled(int id) const;
+    void setVariablesActive(bool);
+    QString evaluateLine(const QString& line, const EvaluationOptions&, const PrintOptions&, QStringList& errors);
+    void storeVariable(const QString& name, const MathStructure& value, QStringList& errors);
+    void saveVariables(const QString& fileName, const PrintOptions&, QStringList& errors) const;
+    void loadVariables(const QString& fileName, const EvaluationOptions&, const PrintOptions&, QStringList& errors);
+    QMap<QString, QString> userVariables(const PrintOptions&) const;
+    static QString print(MathStructure, const PrintOptions&);
+    static void collectMessages(QStringList& output, QStringList& errors);
+    QString calculatePlot(const QString& command, const EvaluationOptions&, const QalculatePlotDefaults&, const QString& fileName,
+                          std::vector<PlotDataParameters*>&, Messages&);
+    static bool takePlotMessages(Messages&);
+    static bool stringToBool(const QString&, bool*);
+    static std::string unlocalizeExpression(QString);
+
+    QMap<QString, KnownVariable*> m_variables;
+    MathStructure m_lastResult;
+    QAtomicInt m_canceledId{0};
+    QAtomicInt m_runningId{0};
+};
+
+#endif
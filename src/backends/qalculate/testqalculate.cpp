@@ -0,0 +1,135 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "testqalculate.h"
+
+#include "backend.h"
+#include "defaultvariablemodel.h"
+#include "extension.h"
+#include "session.h"
+#include "result.h"
+
+#include <QTemporaryDir>
+
+QString TestQalculate::backendName()
+{
+    return QLatin1String("qalculate");
+}
+
+static QString variableValue(Cantor::Session* session, const QString& name)
+{
+    const auto& variables = session->variableModel()->variables();
+    for (const auto& variable : variables)
+    {
+        if (variable.name == name)
+            return variable.value;
+    }
+
+    return QString();
+}
+
+void TestQalculate::testSimpleCommand()
+{
+    auto* e = evalExp(QLatin1String("2+2"));
+
+    QVERIFY(e != nullptr);
+    QVERIFY(e->result() != nullptr);
+
+    QCOMPARE(cleanOutput(e->result()->data().toString()), QLatin1String("2 + 2 = 4"));
+}
+
+/*!
+ * both "name = expression" and "name := expression" define a variable of the session
+ */
+void TestQalculate::testVariableDefinition()
+{
+    auto* e = evalExp(QLatin1String("testqalculate_a = 5"));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    e = evalExp(QLatin1String("testqalculate_b := testqalculate_a * 2"));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    QTRY_COMPARE(variableValue(session(), QLatin1String("testqalculate_a")), QLatin1String("5"));
+    QTRY_COMPARE(variableValue(session(), QLatin1String("testqalculate_b")), QLatin1String("10"));
+}
+
+/*!
+ * the calculator is shared by all sessions, the variables of a session must not be visible in the other sessions
+ * and must be removed from the calculator on logout.
+ */
+void TestQalculate::testVariableIsolation()
+{
+    auto* e = evalExp(QLatin1String("testqalculate_c := 3"));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    auto* other = session()->backend()->createSession();
+    other->login();
+    QCOMPARE(other->loginState(), Cantor::Session::LoggedIn);
+
+    //the name is not taken in the other session, the variable is defined there with its own value
+    auto* otherExpression = other->evaluateExpression(QLatin1String("testqalculate_c := 7\ntestqalculate_d := 1"));
+    QTRY_COMPARE(otherExpression->status(), Cantor::Expression::Done);
+    QTRY_COMPARE(variableValue(other, QLatin1String("testqalculate_c")), QLatin1String("7"));
+    QVERIFY(other->variableModel()->variableNames().contains(QLatin1String("testqalculate_d")));
+
+    e = evalExp(QLatin1String("testqalculate_c * 2"));
+    QVERIFY(e != nullptr);
+    QVERIFY(e->result() != nullptr);
+    QVERIFY(cleanOutput(e->result()->data().toString()).endsWith(QLatin1String(" = 6")));
+    QCOMPARE(variableValue(session(), QLatin1String("testqalculate_c")), QLatin1String("3"));
+    QVERIFY(!session()->variableModel()->variableNames().contains(QLatin1String("testqalculate_d")));
+
+    //the variables of the other session are removed on logout, the name can be used again
+    other->logout();
+    delete other;
+
+    e = evalExp(QLatin1String("testqalculate_d := 2"));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+    QTRY_COMPARE(variableValue(session(), QLatin1String("testqalculate_d")), QLatin1String("2"));
+    QCOMPARE(variableValue(session(), QLatin1String("testqalculate_c")), QLatin1String("3"));
+}
+
+/*!
+ * the variable manager saves the variables of the session to a file and loads them in another session
+ */
+void TestQalculate::testSaveLoadVariables()
+{
+    auto* extension = dynamic_cast<Cantor::VariableManagementExtension*>(session()->backend()->extension(QLatin1String("VariableManagementExtension")));
+    QVERIFY(extension);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString& fileName = dir.filePath(QLatin1String("saved variables"));
+
+    auto* e = evalExp(QLatin1String("testqalculate_e := 3/4"));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+
+    e = evalExp(extension->saveVariables(fileName));
+    QVERIFY(e != nullptr);
+    QCOMPARE(e->status(), Cantor::Expression::Done);
+    QVERIFY(QFile::exists(fileName));
+
+    auto* other = session()->backend()->createSession();
+    other->login();
+    QCOMPARE(other->loginState(), Cantor::Session::LoggedIn);
+
+    auto* otherExpression = other->evaluateExpression(extension->loadVariables(fileName));
+    QTRY_COMPARE(otherExpression->status(), Cantor::Expression::Done);
+    QTRY_COMPARE(variableValue(other, QLatin1String("testqalculate_e")), variableValue(session(), QLatin1String("testqalculate_e")));
+
+    //a missing file is reported as an error
+    otherExpression = other->evaluateExpression(extension->loadVariables(dir.filePath(QLatin1String("missing"))));
+    QTRY_COMPARE(otherExpression->status(), Cantor::Expression::Error);
+
+    other->logout();
+    delete other;
+}
+
+QTEST_MAIN( TestQalculate )
@@ -0,0 +1,28 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef _TESTQALCULATE_H
+#define _TESTQALCULATE_H
+
+#include "backendtest.h"
+
+/** This class test some of the basic functions of the Qalculate backend
+    The different tests represent some general expressions for preventing possible future regression
+**/
+class TestQalculate : public BackendTest
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+    void testSimpleCommand();
+    void testVariableDefinition();
+    void testVariableIsolation();
+    void testSaveLoadVariables();
+
+private:
+    QString backendName() override;
+};
+
+#endif /* _TESTQALCULATE_H */
@@ -8,13 +8,10 @@
 
 #include "sagesession.h"
 #include "textresult.h"
-#include "imageresult.h"
-#include "animationresult.h"
 #include "helpresult.h"
 
 #include <QDebug>
 #include <KLocalizedString>
-#include <QMimeDatabase>
 #include <QRegularExpression>
 
 SageExpression::SageExpression( Cantor::Session* session, bool internal ) : Cantor::Expression(session, internal)
@@ -23,7 +20,7 @@ SageExpression::SageExpression( Cantor::Session* session, bool internal ) : Cant
 
 void SageExpression::evaluate()
 {
-    m_imagePath.clear();
+    m_plotFiles.clear();
 
     m_isHelpRequest=false;
 
@@ -51,15 +48,19 @@ void SageExpression::parseOutput(const QString& text)
         return;
     }
 
-    if (text.startsWith(QLatin1String("Launched png viewer"))
-        || text.startsWith(QLatin1String("Launched pdf viewer"))
-        || text.startsWith(QLatin1String("Launched gif viewer")) )
+    QString output = text;
+
+    //the plot files are announced in front of the message of the viewer, s.a. SageSession::login()
+    m_plotFiles << takePlotAnnouncements(output);
+
+    if (output.startsWith(QLatin1String("Launched png viewer"))
+        || output.startsWith(QLatin1String("Launched pdf viewer"))
+        || output.startsWith(QLatin1String("Launched gif viewer")) )
     {
         evalFinished();
         return;
     }
 
-    QString output = text;
     //remove carriage returns, we only use \n internally
     output.remove(QLatin1Char('\r'));
     //replace appearing backspaces, as they mess the whole output up
@@ -136,23 +137,13 @@ void SageExpression::parseOutput(const QString& text)
     }
 }
 
-void SageExpression::addFileResult( const QString& path )
-{
-  QUrl url = QUrl::fromLocalFile(path);
-  QMimeDatabase db;
-  QMimeType type = db.mimeTypeForUrl(url);
-
-  if(m_imagePath.isEmpty()||type.name().contains(QLatin1String("image"))||path.endsWith(QLatin1String(".png"))||path.endsWith(QLatin1String(".gif")))
-      m_imagePath = path;
-}
-
 void SageExpression::evalFinished()
 {
     qDebug()<<"evaluation finished";
     qDebug()<<m_outputCache;
 
-    //check if our image path contains a valid image that we can try to show
-    const bool hasImage=!m_imagePath.isNull();
+    //announcements which were split from the message of the viewer
+    m_plotFiles << takePlotAnnouncements(m_outputCache);
 
     if (!m_outputCache.isEmpty())
     {
@@ -209,26 +200,14 @@ void SageExpression::evalFinished()
             addResult(result);
         }
     }
-    qDebug()<<"has image " << hasImage;
+    qDebug()<<"plot files " << m_plotFiles.size();
 
-    if (hasImage)
-    {
-        QMimeDatabase db;
-        QMimeType type = db.mimeTypeForUrl(QUrl::fromLocalFile(m_imagePath));
-        qDebug()<<"mime type " << type;
-        qDebug()<<"image path " << m_imagePath;
-        if(type.inherits(QLatin1String("image/gif")))
-        {
-            qDebug()<<"adding animation";
-            addResult( new Cantor::AnimationResult(QUrl::fromLocalFile(m_imagePath), i18n("Result of %1" , command() ) ) );
-        }
-        else
-        {
-            qDebug()<<"adding image";
-            addResult( new Cantor::ImageResult(QUrl::fromLocalFile(m_imagePath ), i18n("Result of %1" , command() ) ) );
-        }
-    }
-    setStatus(Cantor::Expression::Done);
+    //gif files are added as an animation
+    for (const auto& plot : std::as_const(m_plotFiles))
+        loadPlot(plot);
+    m_plotFiles.clear();
+
+    setStatusAfterPlots(Cantor::Expression::Done);
 }
 
 void SageExpression::onProcessError(const QString& msg)
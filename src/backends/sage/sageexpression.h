@@ -17,7 +17,6 @@ class SageExpression : public Cantor::Expression
 
     void evaluate() override;
     void parseOutput(const QString&) override;
-    void addFileResult(const QString&);
     void onProcessError(const QString&);
 
   public Q_SLOTS:
@@ -28,7 +27,7 @@ class SageExpression : public Cantor::Expression
 
   private:
     QString m_outputCache;
-    QString m_imagePath;
+    QVector<PlotFile> m_plotFiles;
     bool m_isHelpRequest{false};
     int m_promptCount{0};
     bool m_syntaxError{false};
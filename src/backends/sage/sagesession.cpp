@@ -35,8 +35,7 @@ static QByteArray initCmd = "import os\n"\
                            "try: \n "\
                            "    SAGE_TMP = sage.misc.temporary_file.TMP_DIR_FILENAME_BASE.name \n "\
                            "except AttributeError: \n "\
-                           "    SAGE_TMP = sage.misc.misc.SAGE_TMP \n "\
-                           "print('%s %s' % ('____TMP_DIR____', SAGE_TMP))\n";
+                           "    SAGE_TMP = sage.misc.misc.SAGE_TMP \n";
 
 static QByteArray newInitCmd =
     "__CANTOR_IPYTHON_SHELL__=get_ipython()   \n "\
@@ -90,7 +89,6 @@ bool SageSession::VersionInfo::operator>=(SageSession::VersionInfo other) const
 
 SageSession::SageSession(Cantor::Backend* backend) : Session(backend, nullptr, new KeywordsManager(QStringLiteral("Python")))
 {
-    connect(&m_dirWatch, &KDirWatch::created, this, &SageSession::fileCreated);
     setVariableModel(new SageVariableModel(this));
 }
 
@@ -118,6 +116,7 @@ void SageSession::login()
     arguments << QLatin1String("--simple-prompt"); // suppress the colorizing of the output
 
     m_process = new QProcess(this);
+    registerProcess(m_process);
     m_process->start(SageSettings::self()->path().toLocalFile(), arguments);
 
     if (!m_process->waitForStarted())
@@ -147,6 +146,11 @@ void SageSession::login()
         // deactivate external viewers
         initCmd += "sage.misc.viewer.viewer.png_viewer('false')\n";
         initCmd += "sage.misc.viewer.viewer.pdf_viewer('false')\n";
+
+        // instead of launching the viewer, announce the written plot file, s.a. Cantor::Expression::takePlotAnnouncements()
+        initCmd += "sage.repl.rich_output.backend_ipython.BackendIPythonCommandline.launch_viewer = "
+                   "lambda self, image_file, plain_text: (print('cantor-plot:%s:%d:%s' % (os.path.splitext(image_file)[1][1:], os.path.getsize(image_file), image_file)), "
+                   "'Launched %s viewer for %s' % (os.path.splitext(image_file)[1][1:], plain_text))[1]\n";
     }
     else
     {
@@ -242,21 +246,6 @@ void SageSession::readStdOut()
     qDebug()<<"out: " << out;
     m_outputCache += out;
 
-    if ( m_outputCache.contains( QLatin1String("___TMP_DIR___") ) )
-    {
-        int index = m_outputCache.indexOf(QLatin1String("___TMP_DIR___") )+14;
-        int endIndex = m_outputCache.indexOf(QLatin1String("\n"), index);
-
-        if(endIndex == -1)
-            m_tmpPath = m_outputCache.mid( index ).trimmed();
-        else
-            m_tmpPath = m_outputCache.mid( index, endIndex-index ).trimmed();
-
-        qDebug()<<"tmp path: "<<m_tmpPath;
-
-        m_dirWatch.addDir(m_tmpPath, KDirWatch::WatchFiles);
-    }
-
     if(!m_isInitialized)
     {
         // enforce the minimal version Sage 9.2 (released Oct 24, 2020).
@@ -454,20 +443,6 @@ void SageSession::sendInputToProcess(const QString& input)
     m_process->write(input.toUtf8());
 }
 
-void SageSession::fileCreated( const QString& path )
-{
-    if (!SageSettings::self()->integratePlots())
-        return;
-
-    qDebug()<<"got a file " << path;
-    if (!expressionQueue().isEmpty())
-    {
-        auto* expr = static_cast<SageExpression*>(expressionQueue().first());
-        if (expr)
-           expr->addFileResult( path );
-    }
-}
-
 void SageSession::setTypesettingEnabled(bool enable)
 {
     if (m_process)
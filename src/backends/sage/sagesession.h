@@ -10,7 +10,6 @@
 #include "session.h"
 #include "expression.h"
 
-#include <KDirWatch>
 #include <QProcess>
 
 class SageSession : public Cantor::Session
@@ -68,7 +67,6 @@ class SageSession : public Cantor::Session
     void processFinished(int exitCode, QProcess::ExitStatus);
     void expressionFinished(Cantor::Expression::Status);
     void reportProcessError(QProcess::ProcessError);
-    void fileCreated(const QString& path);
 
   private:
     void defineCustomFunctions();
@@ -76,8 +74,6 @@ class SageSession : public Cantor::Session
 
     QProcess* m_process{nullptr};
     bool m_isInitialized{false};
-    QString m_tmpPath;
-    KDirWatch m_dirWatch;
     bool m_waitingForPrompt{false};
     QString m_outputCache;
     VersionInfo m_sageVersion;
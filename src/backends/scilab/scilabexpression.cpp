@@ -4,16 +4,15 @@
 */
 
 #include "scilabexpression.h"
+#include "scilabsession.h"
 
 #include <config-cantorlib.h>
 
 #include "textresult.h"
-#include "imageresult.h"
 #include "helpresult.h"
 
 #include <QDebug>
 #include <QDir>
-#include <QFile>
 #include <QRandomGenerator>
 
 #include <KIconLoader>
@@ -21,8 +20,6 @@
 #include "settings.h"
 #include "defaultvariablemodel.h"
 
-using ScilabPlotResult = Cantor::ImageResult;
-
 ScilabExpression::ScilabExpression( Cantor::Session* session, bool internal ) : Cantor::Expression(session, internal)
 {
 }
@@ -42,7 +39,12 @@ void ScilabExpression::evaluate()
             if(commandList.at(count).toLocal8Bit().contains("plot")){
                 auto generator = QRandomGenerator::system();
 
-                exportCommand = QString::fromLatin1("\nxs2png(gcf(), 'cantor-export-scilab-figure-%1.png');\ndelete(gcf());").arg(generator->generate());
+                const QString& fileName = QDir::tempPath() + QString::fromLatin1("/cantor-export-scilab-figure-%1.png").arg(generator->generate());
+
+                // announce the exported file, s.a. Cantor::Expression::takePlotAnnouncements()
+                exportCommand = QString::fromLatin1("\nxs2png(gcf(), '%1');"
+                                                    "\ncantor_plot_info = fileinfo('%1'); mprintf('cantor-plot:png:%d:%s\\n', cantor_plot_info(1), '%1'); clear cantor_plot_info;"
+                                                    "\ndelete(gcf());").arg(fileName);
 
                 commandList[count].append(exportCommand);
 
@@ -68,7 +70,10 @@ void ScilabExpression::evaluate()
 void ScilabExpression::parseOutput(const QString& output)
 {
     qDebug() << "output: " << output;
-    const QStringList lines = output.split(QLatin1String("\n"));
+    QString text = output;
+    const auto& plots = takePlotAnnouncements(text);
+
+    const QStringList lines = text.split(QLatin1String("\n"));
     bool isPrefixLines = true;
     for (const QString& line : lines)
     {
@@ -82,8 +87,14 @@ void ScilabExpression::parseOutput(const QString& output)
     if (!m_output.simplified().isEmpty())
         setResult(new Cantor::TextResult(m_output));
 
+    for (const auto& plot : plots)
+    {
+        static_cast<ScilabSession*>(session())->addPlotFile(plot.fileName);
+        loadPlot(plot);
+    }
+
     evalFinished();
-    setStatus(Cantor::Expression::Done);
+    setStatusAfterPlots(Cantor::Expression::Done);
 }
 
 void ScilabExpression::parseError(const QString& error)
@@ -92,21 +103,6 @@ void ScilabExpression::parseError(const QString& error)
     evalFinished(); // TODO: remove this, the update of the model should be handled the same way as for other backends
 }
 
-void ScilabExpression::parsePlotFile(QString filename)
-{
-    qDebug() << "parsePlotFile";
-    qDebug() << "ScilabExpression::parsePlotFile: " << filename;
-
-    setResult(new ScilabPlotResult(QUrl::fromLocalFile(filename)));
-
-    setPlotPending(false);
-
-    if (m_finished){
-        qDebug() << "ScilabExpression::parsePlotFile: done";
-        setStatus(Done);
-    }
-}
-
 void ScilabExpression::evalFinished()
 {
     qDebug() << "evaluation finished";
@@ -127,8 +123,3 @@ void ScilabExpression::evalFinished()
         }
     }
 }
-
-void ScilabExpression::setPlotPending(bool plot)
-{
-    m_plotPending = plot;
-}
@@ -20,16 +20,12 @@ class ScilabExpression : public Cantor::Expression
         void evaluate() override;
         void parseOutput(const QString&) override;
         void parseError(const QString&) override;
-        void parsePlotFile(QString filename);
-        void setPlotPending(bool plot);
 
     public Q_SLOTS:
         void evalFinished();
 
     private:
         QString m_output;
-        bool m_finished = false;
-        bool m_plotPending = false;
 };
 
 #endif /* _SCILABEXPRESSION_H */
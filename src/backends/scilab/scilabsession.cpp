@@ -12,7 +12,6 @@
 #include <QProcess>
 #include <QTextEdit>
 
-#include <KDirWatch>
 #include <KLocalizedString>
 
 #include <settings.h>
@@ -55,6 +54,7 @@ void ScilabSession::login()
     qDebug() << m_process->program();
 
     m_process->setProcessChannelMode(QProcess::SeparateChannels);
+    registerProcess(m_process);
     m_process->start();
     m_process->waitForStarted();
 
@@ -81,15 +81,6 @@ void ScilabSession::login()
         qDebug() << "Processing command to change chdir in Scilab. Command " << pathScilabOperations.toLocal8Bit();
 
         m_process->write(pathScilabOperations.toLocal8Bit());
-
-        m_watch = new KDirWatch(this);
-        m_watch->setObjectName(QLatin1String("ScilabDirWatch"));
-
-        m_watch->addDir(tempPath, KDirWatch::WatchFiles);
-
-        qDebug() << "addDir " <<  tempPath << "? " << m_watch->contains(QLatin1String(tempPath.toLocal8Bit()));
-
-        QObject::connect(m_watch, &KDirWatch::created, this, &ScilabSession::plotFileChanged);
     }
 
     if(!ScilabSettings::self()->autorunScripts().isEmpty()){
@@ -254,16 +245,10 @@ void ScilabSession::readOutput()
     }
 }
 
-void ScilabSession::plotFileChanged(const QString& filename)
+void ScilabSession::addPlotFile(const QString& fileName)
 {
-    qDebug() << "plotFileChanged filename:" << filename;
-
-    if (!expressionQueue().isEmpty() && (filename.contains(QLatin1String("cantor-export-scilab-figure")))){
-         qDebug() << "Calling parsePlotFile";
-         static_cast<ScilabExpression*>(expressionQueue().first())->parsePlotFile(filename);
-
-         m_listPlotName.append(filename);
-    }
+    if (!m_listPlotName.contains(fileName))
+        m_listPlotName.append(fileName);
 }
 
 //TODO: unify with the funcion in the base class
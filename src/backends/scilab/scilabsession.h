@@ -15,7 +15,6 @@ namespace Cantor {
 }
 
 class ScilabExpression;
-class KDirWatch;
 class QProcess;
 
 class ScilabSession : public Cantor::Session
@@ -36,14 +35,17 @@ class ScilabSession : public Cantor::Session
         void runFirstExpression() override;
         Cantor::DefaultVariableModel* variableModel() const override;
 
+        /**
+         * registers the plot file @p fileName written by an expression, it's deleted on logout.
+         */
+        void addPlotFile(const QString& fileName);
+
     public Q_SLOTS:
         void readOutput();
         void readError();
-        void plotFileChanged(const QString& filename);
 
     private:
         QProcess* m_process = nullptr;
-        KDirWatch* m_watch = nullptr;
         QStringList m_listPlotName;
         QString m_output;
         Cantor::DefaultVariableModel* m_variableModel;
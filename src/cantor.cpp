@@ -41,6 +41,7 @@
 
 #include "backendchoosedialog.h"
 #include "hierarchyfontsettings.h"
+#include "sessionschedulerpanel.h"
 #include "settings.h"
 #include "ui_settings.h"
 #include "ui_formating.h"
@@ -300,6 +301,12 @@ void CantorShell::handleTocNodesChanged(QVariantList nodes)
         Q_EMIT tocNodesChanged(nodes);
 }
 
+void CantorShell::handleTocNodesUpdated(QVariantMap delta)
+{
+    if (sender() == m_part)
+        Q_EMIT tocNodesUpdated(delta);
+}
+
 void CantorShell::handleCurrentTocNodeChanged(const QString& nodeId)
 {
     if (sender() == m_part)
@@ -447,6 +454,7 @@ void CantorShell::addWorksheet(const QString& backendName)
         connect(part, SIGNAL(worksheetSave(QUrl)), this, SLOT(onWorksheetSave(QUrl)));
         connect(part, SIGNAL(showHelp(QString)), this, SIGNAL(showHelp(QString)));
         connect(part, SIGNAL(tocNodesChanged(QVariantList)), this, SLOT(handleTocNodesChanged(QVariantList)));
+        connect(part, SIGNAL(tocNodesUpdated(QVariantMap)), this, SLOT(handleTocNodesUpdated(QVariantMap)));
         connect(part, SIGNAL(currentTocNodeChanged(QString)), this, SLOT(handleCurrentTocNodeChanged(QString)));
         connect(part, SIGNAL(tocReadOnlyChanged(bool)), this, SLOT(handleTocReadOnlyChanged(bool)));
         connect(this, SIGNAL(settingsChanges()), part, SIGNAL(settingsChanges()));
@@ -866,6 +874,25 @@ void CantorShell::initPanels()
 
         m_panels.append(docker);
     }
+
+    //the sessions of all worksheets, not bound to the current worksheet like the panels of the plugins
+    auto* schedulerPanel = new SessionSchedulerPanel(this);
+    schedulerPanel->setNameProvider([this](Cantor::Session* session) {
+        for (auto* part : std::as_const(m_parts))
+        {
+            auto* wa = part->findChild<Cantor::WorksheetAccessInterface*>(Cantor::WorksheetAccessInterface::Name);
+            if (wa && wa->session() == session)
+                return m_tabWidget->tabText(m_tabWidget->indexOf(part->widget()));
+        }
+        return QString();
+    });
+
+    m_schedulerDocker = new QDockWidget(i18n("Sessions"), this);
+    m_schedulerDocker->setObjectName(QLatin1String("SessionScheduler"));
+    m_schedulerDocker->setWidget(schedulerPanel);
+    m_schedulerDocker->setWindowIcon(QIcon::fromTheme(QStringLiteral("view-process-system")));
+    addDockWidget(Qt::RightDockWidgetArea, m_schedulerDocker);
+    m_schedulerDocker->hide();
 }
 
 void CantorShell::updatePanel()
@@ -951,6 +978,9 @@ void CantorShell::updatePanel()
                 }
     }
 
+    if (m_schedulerDocker)
+        panelActions << m_schedulerDocker->toggleViewAction();
+
     plugActionList(QLatin1String("view_show_panel_list"), panelActions);
 
     updateNewSubmenu();
@@ -15,6 +15,7 @@
 #include <QStringList>
 #include <QMap>
 #include <QVariantList>
+#include <QVariantMap>
 
 #include "lib/panelpluginhandler.h"
 #include "lib/panelplugin.h"
@@ -68,6 +69,7 @@ protected:
 Q_SIGNALS:
     void showHelp(QString);
     void tocNodesChanged(QVariantList);
+    void tocNodesUpdated(QVariantMap);
     void currentTocNodeChanged(QString);
     void requestNavigateToTocNode(QString nodeId);
     void requestRenameHierarchyEntry(QString hierarchyId, QString newName);
@@ -105,6 +107,7 @@ private Q_SLOTS:
     void forwardRenamePlot(const QString& commandId, const QString& resultId, const QString& newTitle);
     void forwardDeletePlot(const QString& commandId, const QString& resultId);
     void handleTocNodesChanged(QVariantList nodes);
+    void handleTocNodesUpdated(QVariantMap delta);
     void handleCurrentTocNodeChanged(const QString& nodeId);
     void handleTocReadOnlyChanged(bool readOnly);
     void closeTab(int index = -1);
@@ -137,6 +140,7 @@ private:
     KParts::ReadWritePart* m_part{nullptr};
     QTabWidget* m_tabWidget;
     QList<QDockWidget*> m_panels;
+    QDockWidget* m_schedulerDocker{nullptr};
     QList<QAction*> m_newBackendActions;
     KRecentFilesAction* m_recentProjectsAction;
 
@@ -14,6 +14,7 @@
 #include "lib/assistant.h"
 #include "lib/backend.h"
 #include "lib/extension.h"
+#include "lib/sessionscheduler.h"
 #include "lib/worksheetaccess.h"
 #include "scripteditor/scripteditorwidget.h"
 #include "searchbar.h"
@@ -41,6 +42,7 @@
 #include <QFile>
 #include <QFileDialog>
 #include <QIcon>
+#include <QPdfWriter>
 #include <QPrinter>
 #include <QPrintPreviewDialog>
 #include <QPrintDialog>
@@ -134,6 +136,7 @@ CantorPart::CantorPart(QObject* parent, const QVariantList& args)
     connect(m_worksheet, &Worksheet::showHelp, this, &CantorPart::showHelp);
     connect(m_worksheet, &Worksheet::loaded, this, &CantorPart::initialized);
     connect(m_worksheet, &Worksheet::tocNodesChanged, this, &CantorPart::tocNodesChanged);
+    connect(m_worksheet, &Worksheet::tocNodesUpdated, this, &CantorPart::tocNodesUpdated);
     connect(m_worksheet, &Worksheet::currentTocNodeChanged, this, &CantorPart::currentTocNodeChanged);
     connect(this, &CantorPart::requestNavigateToTocNode, m_worksheet, &Worksheet::navigateToTocNode);
     connect(this, &CantorPart::requestRenameHierarchyEntry, m_worksheet, &Worksheet::renameHierarchyEntry);
@@ -278,6 +281,18 @@ CantorPart::CantorPart(QObject* parent, const QVariantList& args)
     collection->addAction(QLatin1String("enable_animations"), m_animateWorksheet);
     connect(m_animateWorksheet, &KToggleAction::toggled, m_worksheet, &Worksheet::enableAnimations);
 
+    m_memoizeResults = new KToggleAction(i18n("Reuse Unchanged Results"), collection);
+    m_memoizeResults->setToolTip(i18n("Don't reevaluate the entries whose command and referenced variables didn't change since the last evaluation"));
+    m_memoizeResults->setChecked(Settings::self()->resultMemoizationDefault());
+    collection->addAction(QLatin1String("enable_result_memoization"), m_memoizeResults);
+    connect(m_memoizeResults, &KToggleAction::toggled, m_worksheet, &Worksheet::enableResultMemoization);
+
+    m_saveSessionState = new KToggleAction(i18n("Save Session State"), collection);
+    m_saveSessionState->setToolTip(i18n("Save the state of the session with the worksheet and restore it when the worksheet is opened again, so the entries don't need to be reevaluated"));
+    m_saveSessionState->setChecked(Settings::self()->sessionStateSavingDefault());
+    collection->addAction(QLatin1String("enable_session_state_saving"), m_saveSessionState);
+    connect(m_saveSessionState, &KToggleAction::toggled, m_worksheet, &Worksheet::enableSessionStateSaving);
+
     if (MathRenderer::mathRenderAvailable())
     {
         m_embeddedMath= new KToggleAction(i18n("Embedded Math"), collection);
@@ -298,6 +313,12 @@ CantorPart::CantorPart(QObject* parent, const QVariantList& args)
     connect(evaluateCurrent, &QAction::triggered, m_worksheet, &Worksheet::evaluateCurrentEntry);
     m_editActions.push_back(evaluateCurrent);
 
+    QAction* evaluateStale = new QAction(QIcon::fromTheme(QLatin1String("view-refresh")), i18n("Evaluate Stale Entries"), collection);
+    evaluateStale->setToolTip(i18n("Evaluate the entries that weren't evaluated yet or that depend on modified entries"));
+    collection->addAction(QLatin1String("evaluate_stale"), evaluateStale);
+    connect(evaluateStale, &QAction::triggered, m_worksheet, &Worksheet::evaluateStaleEntries);
+    m_editActions.push_back(evaluateStale);
+
     QAction* insertCommandEntry = new QAction(QIcon::fromTheme(QLatin1String("run-build")), i18n("Insert Command Entry"), collection);
     collection->addAction(QLatin1String("insert_command_entry"),  insertCommandEntry);
     collection->setDefaultShortcut(insertCommandEntry, Qt::CTRL | Qt::Key_Return);
@@ -565,10 +586,17 @@ void CantorPart::exportToPDF()
     if (path.isEmpty()) // "Cancel" was clicked
         return;
 
-    QPrinter printer;
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    printer.setOutputFileName(path);
-    m_worksheet->print(&printer);
+    //the pages are written to the file one after another, only the current page is kept in memory
+    bool completed = false;
+    {
+        QPdfWriter writer(path);
+        writer.setCreator(QStringLiteral("Cantor"));
+        writer.setTitle(url().fileName());
+        completed = printWithProgress(&writer, i18n("Exporting to PDF..."));
+    }
+
+    if (!completed)
+        QFile::remove(path);
 }
 
 void CantorPart::exportToLatex()
@@ -652,6 +680,7 @@ void CantorPart::worksheetStatusChanged(Cantor::Session::Status status)
 {
     qDebug()<<"worksheet status changed:" << status;
     unsigned int count = ++m_sessionStatusCounter;
+    m_sessionWaiting = false;
     switch (status) {
     case Cantor::Session::Running:
     {
@@ -681,6 +710,29 @@ void CantorPart::worksheetStatusChanged(Cantor::Session::Status status)
     }
 }
 
+/*!
+ * the expressions of a session waiting for the sessions of the other worksheets
+ * are not evaluated yet but can be interrupted already.
+ */
+void CantorPart::sessionSchedulerChanged()
+{
+    auto* session = m_worksheet->session();
+    if (!session)
+        return;
+
+    const bool waiting = session->isWaitingForScheduler();
+    if (waiting && !m_sessionWaiting)
+    {
+        m_sessionWaiting = true;
+        m_evaluate->setText(i18n("Interrupt"));
+        m_evaluate->setShortcut(Qt::CTRL | Qt::Key_I);
+        m_evaluate->setIcon(QIcon::fromTheme(QLatin1String("dialog-close")));
+        setStatusMessage(i18n("Waiting for other sessions..."));
+    }
+    else if (!waiting && m_sessionWaiting)
+        worksheetStatusChanged(session->status());
+}
+
 void CantorPart::showSessionError(const QString& message)
 {
     qDebug()<<"Error: "<<message;
@@ -693,11 +745,12 @@ void CantorPart::initialized()
     if (!m_worksheet->isReadOnly())
     {
         connect(m_worksheet->session(), &Cantor::Session::statusChanged, this, &CantorPart::worksheetStatusChanged);
+        connect(Cantor::SessionScheduler::instance(), &Cantor::SessionScheduler::sessionsChanged, this, &CantorPart::sessionSchedulerChanged, Qt::UniqueConnection);
         connect(m_worksheet->session(), &Cantor::Session::loginStarted,this, &CantorPart::worksheetSessionLoginStarted);
         connect(m_worksheet->session(), &Cantor::Session::loginDone,this, &CantorPart::worksheetSessionLoginDone);
         connect(m_worksheet->session(), &Cantor::Session::error, this, &CantorPart::showSessionError);
 
-        if (m_worksheet->session()->status() == Cantor::Session::Disable)
+        if (m_worksheet->session()->status() == Cantor::Session::Disable && !m_worksheet->session()->isLoggingIn())
         {
             m_worksheet->session()->login();
         }
@@ -736,14 +789,13 @@ void CantorPart::initialized()
 }
 
 void CantorPart::worksheetSessionLoginStarted() {
+    // the login is asynchronous and doesn't block the GUI, so no wait cursor is shown here
     setStatusMessage(i18n("Initializing..."));
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 }
 
 void CantorPart::worksheetSessionLoginDone() {
     setStatusMessage(i18n("Ready"));
     m_restart->setEnabled(true);
-    QApplication::restoreOverrideCursor();
 }
 
 void CantorPart::enableTypesetting(bool enable)
@@ -945,11 +997,29 @@ void CantorPart::print()
     //    dialog->addEnabledOption(QAbstractPrintDialog::PrintSelection);
 
     if (dialog->exec() == QDialog::Accepted)
-        m_worksheet->print(&printer);
+        printWithProgress(&printer, i18n("Printing..."));
 
     delete dialog;
 }
 
+/*!
+ * prints the worksheet to \c device showing the progress of the printing
+ * in a dialog that allows to cancel it. Returns \c false if printing was canceled.
+ */
+bool CantorPart::printWithProgress(QPagedPaintDevice* device, const QString& label)
+{
+    QProgressDialog progress(label, i18n("Cancel"), 0, 0, widget());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    connect(&progress, &QProgressDialog::canceled, m_worksheet, &Worksheet::cancelPrinting);
+    connect(m_worksheet, &Worksheet::printProgress, &progress, [&progress](int page, int pageCount) {
+        progress.setMaximum(pageCount);
+        progress.setValue(page);
+    });
+
+    return m_worksheet->print(device);
+}
+
 void CantorPart::printPreview()
 {
     QPrintPreviewDialog* dialog = new QPrintPreviewDialog(widget());
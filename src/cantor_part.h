@@ -9,12 +9,14 @@
 #include <QPointer>
 #include <QRegularExpression>
 #include <QVariantList>
+#include <QVariantMap>
 #include <QVector>
 
 #include <KParts/ReadWritePart>
 #include "lib/session.h"
 
 class QWidget;
+class QPagedPaintDevice;
 class Worksheet;
 class WorksheetView;
 class SearchBar;
@@ -69,6 +71,7 @@ Q_SIGNALS:
     void setCaption(const QString& caption, const QIcon& icon);
     void showHelp(const QString&);
     void tocNodesChanged(QVariantList nodes);
+    void tocNodesUpdated(QVariantMap delta);
     void currentTocNodeChanged(QString nodeId);
     void worksheetSave(const QUrl&);
     void setBackendName(const QString&);
@@ -107,6 +110,7 @@ protected:
 
     void loadAssistants();
     void adjustGuiToSession();
+    bool printWithProgress(QPagedPaintDevice*, const QString& label);
 
     void setReadOnly();
 
@@ -125,6 +129,7 @@ protected Q_SLOTS:
     void printPreview();
 
     void worksheetStatusChanged(Cantor::Session::Status);
+    void sessionSchedulerChanged();
     void showSessionError(const QString&);
     void worksheetSessionLoginStarted();
     void worksheetSessionLoginDone();
@@ -179,12 +184,15 @@ private:
     KToggleAction* m_completion;
     KToggleAction* m_exprNumbering;
     KToggleAction* m_animateWorksheet;
+    KToggleAction* m_memoizeResults;
+    KToggleAction* m_saveSessionState;
     KToggleAction* m_embeddedMath;
     QVector<QAction*> m_editActions;
 
     QString m_cachedStatusMessage;
     bool m_statusBarBlocked{false};
     unsigned int m_sessionStatusCounter{0};
+    bool m_sessionWaiting{false};
     const QRegularExpression m_zoomRegexp{QLatin1String("(?:%?(\\d+(?:\\.\\d+)?)(?:%|\\s*))")};
 
 private Q_SLOTS:
@@ -38,6 +38,7 @@
 #include <QTextBlock>
 #include <QTextDocumentFragment>
 #include <QPainter>
+#include <QRegularExpression>
 #include <QUuid>
 
 #include <KLocalizedString>
@@ -125,6 +126,11 @@ CommandEntry::CommandEntry(Worksheet* worksheet) : WorksheetEntry(worksheet),
 
     connect(&m_controlElement, &WorksheetControlItem::doubleClick, this, &CommandEntry::changeResultCollapsingAction);
     connect(m_commandItem, &WorksheetTextEditorItem::execute, this, [=]() { evaluate();} );
+    connect(m_commandItem->document(), &KTextEditor::Document::textChanged, this, [=]() {
+        //the first modification after the evaluation invalidates the entries depending on this one
+        if (m_evaluatedInSession && !m_stale && this->worksheet())
+            this->worksheet()->commandEntryChanged(this);
+    });
     connect(m_commandItem, &WorksheetTextEditorItem::moveToPrevious, this, &CommandEntry::moveToPreviousItem);
     connect(m_commandItem, &WorksheetTextEditorItem::moveToNext, this, &CommandEntry::moveToNextItem);
     connect(m_promptItem, &WorksheetTextItem::drag, this, &CommandEntry::startDrag);
@@ -549,9 +555,13 @@ void CommandEntry::setExpression(Cantor::Expression* expr)
     {
         updatePrompt();
         if (worksheet())
-            worksheet()->refreshTocStructure();
+            worksheet()->refreshTocStructure(this);
     });
     connect(expr, &Cantor::Expression::statusChanged, this, &CommandEntry::expressionChangedStatus);
+    connect(expr, &Cantor::Expression::variablesChanged, this, [=](const QStringList& names) {
+        if (worksheet())
+            worksheet()->commandEntryVariablesChanged(this, names);
+    });
     connect(expr, &Cantor::Expression::needsAdditionalInformation, this, &CommandEntry::showAdditionalInformationPrompt);
     connect(expr, &Cantor::Expression::statusChanged, this,  [=]() { updatePrompt();} );
 
@@ -884,7 +894,9 @@ bool CommandEntry::evaluate(EvaluationOption evalOp)
 {
     if (m_isExecutionEnabled)
     {
-        if (worksheet()->session()->status() == Cantor::Session::Disable)
+        // the expression is queued by the session until an asynchronous login is finished
+        auto* session = worksheet()->session();
+        if (session->status() == Cantor::Session::Disable && !session->isLoggingIn())
             worksheet()->loginToSession();
 
         QToolTip::hideText();
@@ -903,6 +915,48 @@ bool CommandEntry::evaluate(EvaluationOption evalOp)
             return false;
         }
 
+        if (session->isResultMemoizationEnabled() && !session->isLoggingIn())
+        {
+            //the variable model is updated after the queued expressions are evaluated,
+            //the fingerprint can only be determined once the session is idle
+            if (session->status() == Cantor::Session::Running)
+            {
+                disconnect(m_memoizationWait);
+                m_memoizationWait = connect(session, &Cantor::Session::statusChanged, this, [this, evalOp](Cantor::Session::Status status) {
+                    if (status == Cantor::Session::Running)
+                        return;
+
+                    disconnect(m_memoizationWait);
+                    if (status == Cantor::Session::Done)
+                        evaluate(evalOp);
+                });
+                return true;
+            }
+
+            const QByteArray& fingerprint = session->dependencyFingerprint(cmd);
+            if (m_expression && m_expression->status() == Cantor::Expression::Done
+                && !fingerprint.isEmpty() && cmd == m_memoizedCommand && fingerprint == m_memoizedFingerprint)
+            {
+                qDebug() << "command and its dependencies unchanged, reusing the results of" << cmd;
+                m_stale = false;
+                m_evaluatedInSession = true;
+                updatePrompt();
+                evaluateNext(m_evaluationOption);
+                m_evaluationOption = DoNothing;
+                return true;
+            }
+
+            m_memoizedCommand = cmd;
+            m_memoizedFingerprint = fingerprint;
+        }
+        else
+        {
+            m_memoizedCommand.clear();
+            m_memoizedFingerprint.clear();
+        }
+
+        parseDependencies(cmd);
+
         auto* expr = worksheet()->session()->evaluateExpression(cmd);
         connect(expr, &Cantor::Expression::gotResult, this, [=]() { worksheet()->gotResult(expr); });
 
@@ -920,11 +974,18 @@ bool CommandEntry::evaluate(EvaluationOption evalOp)
 
 void CommandEntry::interruptEvaluation()
 {
+    cancelPendingEvaluation();
+
     auto* expr = expression();
     if(expr)
         expr->interrupt();
 }
 
+void CommandEntry::cancelPendingEvaluation()
+{
+    disconnect(m_memoizationWait);
+}
+
 void CommandEntry::updateEntry()
 {
     qDebug() << "update Entry";
@@ -969,7 +1030,7 @@ void CommandEntry::updateEntry()
         }
 
         if (addedResultItem && worksheet())
-            worksheet()->scheduleTocStructureRefresh();
+            worksheet()->scheduleTocStructureRefresh(this);
     }
     else
     {
@@ -1042,6 +1103,9 @@ void CommandEntry::expressionChangedStatus(Cantor::Expression::Status status)
         case Cantor::Expression::Done:
             m_promptItemAnimation->stop();
             m_promptItem->setOpacity(1.);
+            m_stale = false;
+            m_evaluatedInSession = true;
+            worksheet()->commandEntryEvaluated(this);
             evaluateNext(m_evaluationOption);
             m_evaluationOption = DoNothing;
             break;
@@ -1131,17 +1195,135 @@ void CommandEntry::showAdditionalInformationPrompt(const QString& question)
 
 }
 
+bool CommandEntry::isStale() const
+{
+    return m_stale || !m_evaluatedInSession;
+}
+
+void CommandEntry::markStale()
+{
+    if (m_stale)
+        return;
+
+    m_stale = true;
+    updatePrompt();
+}
+
+void CommandEntry::invalidateSessionState()
+{
+    m_evaluatedInSession = false;
+    m_stale = false;
+    m_definedVariables.clear();
+    updatePrompt();
+}
+
+/*!
+ * marks the entry as evaluated in the current session, called when the state of the session saved
+ * after the evaluation of this entry was restored.
+ */
+void CommandEntry::restoreSessionState(const QStringList& definedVariables)
+{
+    //the names assigned as a side effect were reported by the variable model before the state was saved
+    parseDependencies(command());
+    addDefinedVariables(definedVariables);
+    m_evaluatedInSession = true;
+    m_stale = false;
+    updatePrompt();
+}
+
+const QSet<QString>& CommandEntry::definedVariables() const
+{
+    return m_definedVariables;
+}
+
+const QSet<QString>& CommandEntry::referencedVariables() const
+{
+    return m_referencedVariables;
+}
+
+void CommandEntry::addDefinedVariables(const QStringList& names)
+{
+    for (const auto& name : names)
+        m_definedVariables.insert(name);
+}
+
+/*!
+ * determines the names referenced and assigned by \c command. The assignments are detected
+ * with a simple per-backend parsing of the statements, the names changed in the session
+ * as a side effect are reported later by the variable model, s.a. Worksheet::commandEntryVariablesChanged().
+ */
+void CommandEntry::parseDependencies(const QString& command)
+{
+    static const QRegularExpression identifier(QStringLiteral("[A-Za-z_%][A-Za-z0-9_%]*"));
+    static const QRegularExpression rIdentifier(QStringLiteral("[A-Za-z.][A-Za-z0-9_.]*"));
+    // x = 1, x += 1, x[1] = 1, a, b = f(), [a, b] = f(), x := 1
+    static const QRegularExpression assignment(QStringLiteral("^\\s*\\[?\\s*([A-Za-z_][\\w\\s,]*?)\\s*\\]?\\s*(?:\\[[^\\]]*\\]\\s*)?(?:\\*\\*|//|>>|<<|[-+*/%&|^@.:])?=(?!=)"));
+    // def f(), function f(), class A
+    static const QRegularExpression definition(QStringLiteral("^\\s*(?:def|function|class)\\s+([A-Za-z_][\\w.]*)"));
+    // Maxima: x : 1, f(x) := x
+    static const QRegularExpression maximaAssignment(QStringLiteral("^\\s*([A-Za-z_%][\\w%]*)\\s*(?:\\([^()]*\\)\\s*)?::?=?(?!=)"));
+    // R: x <- 1, x <<- 1, x = 1
+    static const QRegularExpression rAssignment(QStringLiteral("^\\s*([A-Za-z.][\\w.]*)\\s*(?:<<?-|=(?!=))"));
+
+    static const QRegularExpression separator(QStringLiteral("[;\\n]"));
+    static const QRegularExpression maximaSeparator(QStringLiteral("[;$\\n]"));
+
+    const QString& backendName = worksheet()->session()->backend()->name();
+    const QRegularExpression* names = &identifier;
+    const QRegularExpression* statementSeparator = &separator;
+    QVector<const QRegularExpression*> patterns;
+    if (backendName == QLatin1String("Maxima"))
+    {
+        statementSeparator = &maximaSeparator;
+        patterns << &maximaAssignment;
+    }
+    else if (backendName == QLatin1String("R"))
+    {
+        names = &rIdentifier;
+        patterns << &rAssignment;
+    }
+    else
+        patterns << &assignment << &definition;
+
+    m_referencedVariables.clear();
+    auto it = names->globalMatch(command);
+    while (it.hasNext())
+        m_referencedVariables.insert(it.next().captured(0));
+
+    m_definedVariables.clear();
+    const auto& statements = command.split(*statementSeparator, Qt::SkipEmptyParts);
+    for (const auto& statement : statements)
+    {
+        for (const auto* pattern : std::as_const(patterns))
+        {
+            const auto& match = pattern->match(statement);
+            if (!match.hasMatch())
+                continue;
+
+            const auto& targets = match.captured(1).split(QLatin1Char(','), Qt::SkipEmptyParts);
+            for (const auto& target : targets)
+                if (!target.trimmed().isEmpty())
+                    m_definedVariables.insert(target.trimmed());
+        }
+    }
+}
+
 void CommandEntry::removeResults()
 {
     //clear the Result objects
     if(m_expression)
         m_expression->clearResults();
+
+    //the removed results can't be reused anymore
+    m_memoizedFingerprint.clear();
 }
 
 void CommandEntry::removeResult(Cantor::Result* result)
 {
     if (m_expression)
         m_expression->removeResult(result);
+
+    m_memoizedFingerprint.clear();
 }
 
 void CommandEntry::removeResultItem(int index)
@@ -1160,7 +1342,7 @@ void CommandEntry::removeResultItem(int index)
 
     recalculateSize();
     if (worksheet())
-        worksheet()->scheduleTocStructureRefresh();
+        worksheet()->scheduleTocStructureRefresh(this);
 }
 
 void CommandEntry::clearResultItems()
@@ -1181,7 +1363,7 @@ void CommandEntry::clearResultItems()
     m_resultItems.clear();
     recalculateSize();
     if (hadResultItems && worksheet())
-        worksheet()->scheduleTocStructureRefresh();
+        worksheet()->scheduleTocStructureRefresh(this);
 }
 
 void CommandEntry::replaceResultItem(int index)
@@ -1208,7 +1390,7 @@ void CommandEntry::replaceResultItem(int index)
 
             recalculateSize();
             if (worksheet())
-                worksheet()->scheduleTocStructureRefresh();
+                worksheet()->scheduleTocStructureRefresh(this);
         }
         return;
     }
@@ -1226,7 +1408,7 @@ void CommandEntry::replaceResultItem(int index)
         m_resultItems.remove(index);
         recalculateSize();
         if (worksheet())
-            worksheet()->scheduleTocStructureRefresh();
+            worksheet()->scheduleTocStructureRefresh(this);
         return;
     }
 
@@ -1240,7 +1422,7 @@ void CommandEntry::replaceResultItem(int index)
     }
     recalculateSize();
     if (worksheet())
-        worksheet()->scheduleTocStructureRefresh();
+        worksheet()->scheduleTocStructureRefresh(this);
 }
 
 void CommandEntry::resultItemClicked(Cantor::Result* result)
@@ -1288,6 +1470,8 @@ void CommandEntry::updatePrompt(const QString& postfix)
             cformat.setForeground(kcolor.foreground(KColorScheme::NegativeText));
         else if(m_expression->status() == Cantor::Expression::Interrupted)
             cformat.setForeground(kcolor.foreground(KColorScheme::NeutralText));
+        else if(m_stale && m_evaluatedInSession)
+            cformat.setForeground(kcolor.foreground(KColorScheme::InactiveText));
     }
 
     c.insertText(postfix, cformat);
@@ -10,6 +10,7 @@
 
 #include <QPointer>
 #include <QPair>
+#include <QSet>
 #include <QTimer>
 
 #include "worksheetentry.h"
@@ -51,6 +52,19 @@ class CommandEntry : public WorksheetEntry
 
     bool isEmpty() override;
     bool isExcludedFromExecution();
+
+    /**
+     * Returns \c true if the entry wasn't evaluated in the current session yet
+     * or if it was marked as stale because an entry it depends on was changed
+     */
+    bool isStale() const;
+    void markStale();
+    void invalidateSessionState();
+    void restoreSessionState(const QStringList& definedVariables);
+    const QSet<QString>& definedVariables() const;
+    const QSet<QString>& referencedVariables() const;
+    void addDefinedVariables(const QStringList&);
+
     bool isResultCollapsed();
     int resultItemCount() const;
     ResultItem* resultItemAt(int index) const;
@@ -70,6 +84,11 @@ class CommandEntry : public WorksheetEntry
 
     void interruptEvaluation() override;
 
+    /**
+     * Cancels the evaluation waiting for the session to finish the queued expressions, s.a. evaluate()
+     */
+    void cancelPendingEvaluation();
+
 
     bool focusEntry(int pos = WorksheetTextEditorItem::TopLeft, qreal xCoord = 0) override;
 
@@ -127,6 +146,7 @@ class CommandEntry : public WorksheetEntry
 
     using PlotResultMetadata = QPair<QString, QString>;
 
+    void parseDependencies(const QString& command);
     void cachePlotResultMetadata();
     void restorePlotResultMetadata(Cantor::Result* result, int plotIndex);
 
@@ -144,6 +164,17 @@ class CommandEntry : public WorksheetEntry
     QVector<PlotResultMetadata> m_plotResultMetadataToRestore;
     QString m_displayName;
 
+    //command and the dependency fingerprint of the last evaluation, used for the result memoization
+    QString m_memoizedCommand;
+    QByteArray m_memoizedFingerprint;
+    QMetaObject::Connection m_memoizationWait;
+
+    //dependency tracking for the evaluation of the stale entries
+    bool m_stale{false};
+    bool m_evaluatedInSession{false};
+    QSet<QString> m_definedVariables;
+    QSet<QString> m_referencedVariables;
+
     DynamicHighlighter* m_dynamicHighlighter;
     bool m_variableHighlightingEnabled = true;
 
@@ -0,0 +1,176 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "imagecache.h"
+#include "settings.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QImageReader>
+
+ImageCache::ImageCache()
+{
+    setMaxSize(static_cast<qint64>(Settings::self()->imageCacheSize()) * 1024 * 1024);
+}
+
+ImageCache::~ImageCache()
+{
+    //don't start the pending decodings and wait for the running ones, they refer to this object
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QImage ImageCache::image(const QString& fileName, const QSize& size)
+{
+    const QString& id = fileId(fileName);
+    const QSize& level = levelSize(fileName, id, size);
+    const QString& key = ImageCache::key(id, level);
+    if (auto* image = m_images.object(key))
+        return *image;
+
+    if (!m_pending.contains(key))
+    {
+        m_pending.insert(key);
+        const quint64 request = ++m_requestCount;
+        m_latestRequests[fileName] = request;
+        m_pool.start([this, fileName, level, key, request]() {
+            const QImage& image = decode(fileName, level);
+            QMetaObject::invokeMethod(this, [this, fileName, key, image, request]() {
+                m_pending.remove(key);
+
+                //a later request for another version or size of the image superseded this one
+                if (m_latestRequests.value(fileName) != request)
+                    return;
+
+                m_latestRequests.remove(fileName);
+                insert(key, image);
+                Q_EMIT imageDecoded(fileName, image);
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    return QImage();
+}
+
+QImage ImageCache::decodedImage(const QString& fileName, const QSize& size)
+{
+    const QString& id = fileId(fileName);
+    const QSize& level = levelSize(fileName, id, size);
+    const QString& key = ImageCache::key(id, level);
+    if (auto* image = m_images.object(key))
+        return *image;
+
+    const QImage& image = decode(fileName, level);
+    insert(key, image);
+    return image;
+}
+
+QImage ImageCache::uncachedImage(const QString& fileName, const QSize& size)
+{
+    return decode(fileName, levelSize(fileName, fileId(fileName), size));
+}
+
+/*!
+ * returns the smallest level of the mip chain of an image of the size \c originalSize
+ * that is not smaller than \c size. The levels are obtained by halving the original size.
+ */
+QSize ImageCache::mipLevelSize(const QSize& originalSize, const QSize& size)
+{
+    if (!originalSize.isValid() || !size.isValid())
+        return originalSize;
+
+    QSize level = originalSize;
+    while (level.width() / 2 >= size.width() && level.height() / 2 >= size.height()
+           && level.width() > 1 && level.height() > 1)
+        level /= 2;
+
+    return level;
+}
+
+void ImageCache::setMaxSize(qint64 bytes)
+{
+    m_images.setMaxCost(bytes);
+}
+
+qint64 ImageCache::maxSize() const
+{
+    return m_images.maxCost();
+}
+
+qint64 ImageCache::size() const
+{
+    return m_images.totalCost();
+}
+
+void ImageCache::clear()
+{
+    m_images.clear();
+    m_originalSizes.clear();
+    m_latestRequests.clear();
+}
+
+/*!
+ * identifies the current version of the file \c fileName by its name, modification time and size.
+ * The backends write their plots into the same temporary files again.
+ */
+QString ImageCache::fileId(const QString& fileName)
+{
+    const QFileInfo info(fileName);
+    return fileName + QLatin1Char(':') + QString::number(info.lastModified().toMSecsSinceEpoch())
+        + QLatin1Char(':') + QString::number(info.size());
+}
+
+QString ImageCache::key(const QString& fileId, const QSize& levelSize)
+{
+    return fileId + QLatin1Char(':') + QString::number(levelSize.width()) + QLatin1Char('x') + QString::number(levelSize.height());
+}
+
+QImage ImageCache::decode(const QString& fileName, const QSize& levelSize)
+{
+    QImageReader reader(fileName);
+    if (levelSize.isValid() && reader.size().isValid() && levelSize != reader.size())
+        reader.setScaledSize(levelSize);
+
+    QImage image = reader.read();
+    if (image.isNull())
+    {
+        qDebug() << "failed to decode the image" << fileName << reader.errorString();
+        return image;
+    }
+
+    //convert here and not in the GUI thread when the pixmap is created
+    if (image.format() != QImage::Format_ARGB32_Premultiplied)
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    return image;
+}
+
+void ImageCache::insert(const QString& key, const QImage& image)
+{
+    if (image.isNull())
+        return;
+
+    //images larger than the cache are not stored, QCache deletes them right away
+    m_images.insert(key, new QImage(image), image.sizeInBytes());
+}
+
+QSize ImageCache::levelSize(const QString& fileName, const QString& fileId, const QSize& size)
+{
+    auto it = m_originalSizes.find(fileId);
+    if (it == m_originalSizes.end())
+    {
+        //the size of an overwritten version of the file is not needed anymore
+        const QString& prefix = fileName + QLatin1Char(':');
+        for (auto old = m_originalSizes.begin(); old != m_originalSizes.end();)
+            old = old.key().startsWith(prefix) ? m_originalSizes.erase(old) : std::next(old);
+
+        //only the header is read here, the image is not decoded
+        QImageReader reader(fileName);
+        it = m_originalSizes.insert(fileId, reader.size());
+    }
+
+    return mipLevelSize(*it, size);
+}
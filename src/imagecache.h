@@ -0,0 +1,75 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+/**
+ * Cache for the decoded raster images shown in the worksheet.
+ * The images are decoded in a thread pool directly into the level of a mip chain
+ * (the original size halved as long as it's not smaller than the requested size)
+ * closest to the size they are shown in, the full resolution image is not kept in memory.
+ * The cache is limited by the number of bytes of the decoded images, the least recently used
+ * images are dropped first. The images are identified by the name, the modification time and the size
+ * of their files, a file overwritten under the same name is decoded again.
+ */
+class ImageCache : public QObject
+{
+  Q_OBJECT
+  public:
+    ImageCache();
+    ~ImageCache() override;
+
+    /**
+     * Returns the decoded image for @p fileName fitting @p size (in device pixels).
+     * If the image is not in the cache yet, a null image is returned, the image is
+     * decoded asynchronously and imageDecoded() is emitted once it's available.
+     */
+    QImage image(const QString& fileName, const QSize& size);
+
+    /**
+     * Decodes the image synchronously if it's not in the cache yet.
+     */
+    QImage decodedImage(const QString& fileName, const QSize& size);
+
+    /**
+     * Decodes the image synchronously without storing it in the cache,
+     * used for the images needed only once like the high resolution images for printing.
+     */
+    QImage uncachedImage(const QString& fileName, const QSize& size);
+
+    static QSize mipLevelSize(const QSize& originalSize, const QSize& size);
+
+    void setMaxSize(qint64 bytes);
+    qint64 maxSize() const;
+    qint64 size() const;
+
+    void clear();
+
+  Q_SIGNALS:
+    void imageDecoded(const QString& fileName, const QImage&);
+
+  private:
+    static QString fileId(const QString& fileName);
+    static QString key(const QString& fileId, const QSize& levelSize);
+    static QImage decode(const QString& fileName, const QSize& levelSize);
+    void insert(const QString& key, const QImage&);
+    QSize levelSize(const QString& fileName, const QString& fileId, const QSize& size);
+
+    QCache<QString, QImage> m_images;
+    QHash<QString, QSize> m_originalSizes; //original sizes of the versions of the files
+    QSet<QString> m_pending;
+    QHash<QString, quint64> m_latestRequests; //the number of the latest decoding requested for a file
+    quint64 m_requestCount{0};
+    QThreadPool m_pool;
+};
+
+#endif /* IMAGECACHE_H */
@@ -13,10 +13,14 @@
 #include <config-cantor.h>
 
 #include <KLocalizedString>
+#include <QApplication>
 #include <QFileDialog>
 #include <QGraphicsSceneMouseEvent>
 #include <QImageReader>
 
+//same factor as used by Cantor::Renderer for the high resolution rendering of the math
+static const qreal HighResolutionFactor = 5.0;
+
 ImageResultItem::ImageResultItem(QGraphicsObject* parent, Cantor::Result* result)
     : WorksheetImageItem(parent), ResultItem(result)
 {
@@ -68,9 +72,12 @@ void ImageResultItem::update()
     switch(m_result->type()) {
     case Cantor::ImageResult::Type:
     {
-        QSize displaySize = static_cast<Cantor::ImageResult*>(m_result)->displaySize();
-        if (displaySize.isValid())
-            setImage(m_result->data().value<QImage>(), displaySize);
+        auto* imageResult = static_cast<Cantor::ImageResult*>(m_result);
+        const QSize displaySize = imageResult->displaySize();
+        if (!imageResult->isVector())
+            showRasterImage(displaySize);
+        else if (displaySize.isValid())
+            setImage(imageResult->renderToDisplaySize(displaySize), displaySize);
         else
             setImage(m_result->data().value<QImage>());
     }
@@ -134,7 +141,10 @@ void ImageResultItem::applyDisplaySize(const QSizeF& size)
     if (m_result->type() == Cantor::ImageResult::Type) {
         auto* imageResult = static_cast<Cantor::ImageResult*>(m_result);
         imageResult->setDisplaySize(displaySize);
-        setImage(imageResult->renderToDisplaySize(displaySize), displaySize);
+        if (imageResult->isVector())
+            setImage(imageResult->renderToDisplaySize(displaySize), displaySize);
+        else
+            showRasterImage(displaySize);
     }
     else if (m_result->type() == Cantor::PdfResult::Type) {
         auto* pdfResult = static_cast<Cantor::PdfResult*>(m_result);
@@ -168,6 +178,65 @@ void ImageResultItem::renderPdf(const QSize& displaySize)
     setImage(image, displaySize);
 }
 
+/*!
+ * shows the raster image decoded in the resolution needed for \c displaySize.
+ * The image is decoded asynchronously by the image cache of the worksheet,
+ * the previous image is shown until the new one is available.
+ */
+void ImageResultItem::showRasterImage(const QSize& displaySize)
+{
+    auto* imageResult = static_cast<Cantor::ImageResult*>(m_result);
+    const QSize& size = displaySize.isValid() ? displaySize : imageResult->originalSize();
+    const QString& fileName = imageResult->url().toLocalFile();
+    auto* worksheet = this->worksheet();
+    if (!worksheet || fileName.isEmpty() || !size.isValid())
+    {
+        const QImage& image = imageResult->data().value<QImage>();
+        if (size.isValid())
+            setImage(image, size);
+        else
+            setImage(image);
+        return;
+    }
+
+    setSize(size);
+
+    auto* cache = worksheet->imageCache();
+    if (worksheet->renderer()->isHighResolution())
+    {
+        //the high resolution image is needed only for printing the current page,
+        //don't displace the images shown on the screen from the cache
+        const qreal ratio = worksheet->renderer()->scale() * HighResolutionFactor;
+        setImage(cache->uncachedImage(fileName, size * ratio), size);
+        return;
+    }
+
+    auto* view = worksheet->worksheetView();
+    if (!m_imageDecodedConnection)
+        m_imageDecodedConnection = connect(cache, &ImageCache::imageDecoded, this, &ImageResultItem::rasterImageDecoded);
+    if (!m_scaleFactorConnection && view)
+        m_scaleFactorConnection = connect(view, &WorksheetView::scaleFactorChanged, this, [this]() {
+            showRasterImage(size().toSize());
+        });
+
+    const qreal ratio = view ? view->devicePixelRatioF() * view->scaleFactor() : qApp->devicePixelRatio();
+    const QImage& image = cache->image(fileName, size * ratio);
+    if (!image.isNull())
+    {
+        setImage(image, size);
+        QGraphicsObject::update();
+    }
+}
+
+void ImageResultItem::rasterImageDecoded(const QString& fileName, const QImage& image)
+{
+    if (fileName != static_cast<Cantor::ImageResult*>(m_result)->url().toLocalFile())
+        return;
+
+    setImage(image, size().toSize());
+    QGraphicsObject::update();
+}
+
 QRectF ImageResultItem::boundingRect() const
 {
     return QRectF(0, 0, width(), height());
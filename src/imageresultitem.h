@@ -46,6 +46,8 @@ class ImageResultItem : public WorksheetImageItem, public ResultItem
     void flushResizePreview();
     void applyDisplaySize(const QSizeF& size);
     void renderPdf(const QSize& displaySize = QSize());
+    void showRasterImage(const QSize& displaySize);
+    void rasterImageDecoded(const QString& fileName, const QImage&);
 
     qreal m_parentZValue{0.0};
     qreal m_zValue{0.0};
@@ -57,6 +59,8 @@ class ImageResultItem : public WorksheetImageItem, public ResultItem
     bool m_resizePreviewDirty{false};
     bool m_resizePreviewActive{false};
     bool m_moveFollowingEntriesDuringResize{true};
+    QMetaObject::Connection m_imageDecodedConnection;
+    QMetaObject::Connection m_scaleFactorConnection;
 };
 
 #endif // IMAGERESULTITEM_H
@@ -22,7 +22,7 @@ class Cantor::AnimationResultPrivate
     AnimationResultPrivate() = default;
 
     QUrl url;
-    QMovie* movie;
+    QMovie* movie{nullptr};
     QString alt;
 };
 
@@ -30,8 +30,6 @@ AnimationResult::AnimationResult(const QUrl &url, const QString& alt ) : d(new A
 {
     d->url=url;
     d->alt=alt;
-    d->movie=new QMovie();
-    d->movie->setFileName(url.toLocalFile());
 }
 
 
@@ -48,6 +46,10 @@ QString AnimationResult::toHtml()
 
 QVariant AnimationResult::data()
 {
+    //the worksheet plays the animation from the file, the movie is only created on request
+    if (!d->movie)
+        d->movie = new QMovie(d->url.toLocalFile());
+
     return QVariant::fromValue(static_cast<QObject*>(d->movie));
 }
 
@@ -14,16 +14,50 @@ using namespace Cantor;
 #include "textresult.h"
 #include "imageresult.h"
 #include "latexresult.h"
+#include "pdfresult.h"
+#include "animationresult.h"
+#include "outputcapture.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
-#include <QString>
 #include <QFileSystemWatcher>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
 
 #include <KLocalizedString>
 #include <KProcess>
 #include <KZip>
 
+namespace {
+
+/*!
+ * waits in the worker thread until the size of the file \c fileName didn't change for 100 ms, but not longer than two seconds.
+ * Used for the backends that can't determine the size of the written plot file, the file can still be written
+ * by the plotting program when it's announced. Returns the size of the file or -1 if it doesn't exist or is empty.
+ */
+qint64 waitForCompleteFile(const QString& fileName)
+{
+    qint64 previousSize = -1;
+    for (int attempt = 0; attempt < 20; ++attempt)
+    {
+        const qint64 size = QFileInfo(fileName).size();
+        if (size > 0 && size == previousSize)
+            return size;
+
+        previousSize = size;
+        QThread::msleep(100);
+    }
+
+    return -1;
+}
+
+}
+
 class Cantor::ExpressionPrivate
 {
 public:
@@ -39,6 +73,9 @@ public:
     Expression::FinishingBehavior finishingBehavior{Expression::DoNotDelete};
     bool internal{false};
     bool helpRequest{false};
+    int pendingPlots{0};
+    bool hasStatusAfterPlots{false};
+    Expression::Status statusAfterPlots{Expression::Done};
     QFileSystemWatcher* fileWatcher{nullptr};
 };
 
@@ -309,6 +346,143 @@ QFileSystemWatcher* Expression::fileWatcher() {
     return d->fileWatcher;
 }
 
+QVector<Expression::PlotFile> Expression::takePlotAnnouncements(QString& output)
+{
+    QVector<PlotFile> files;
+    if (!output.contains(QLatin1String("cantor-plot:")))
+        return files;
+
+    static const QRegularExpression regex(QStringLiteral("^cantor-plot:(\\w+):(-?\\d+):([^\\r\\n]+)\\r?(\\n|$)"),
+                                          QRegularExpression::MultilineOption);
+    auto match = regex.match(output);
+    while (match.hasMatch())
+    {
+        PlotFile file;
+        file.format = match.captured(1).toLower();
+        file.size = match.captured(2).toLongLong();
+        file.fileName = match.captured(3).trimmed();
+
+        //the file was overwritten by a later plot command of the same expression, only the last version exists
+        auto it = std::find_if(files.begin(), files.end(), [&file](const PlotFile& f) { return f.fileName == file.fileName; });
+        if (it != files.end())
+            files.erase(it);
+        files << file;
+
+        const int start = match.capturedStart();
+        output.remove(start, match.capturedLength());
+        match = regex.match(output, start);
+    }
+
+    return files;
+}
+
+QVector<Expression::PlotFile> Expression::takePlotAnnouncements(OutputCapture& output)
+{
+    QVector<PlotFile> files;
+    output.filter([&files](QString& text) {
+        files << takePlotAnnouncements(text);
+    });
+
+    return files;
+}
+
+/*!
+ * the plot file was announced by the backend after it was written completely, its content is read
+ * in a worker thread without polling the file system and the result is created and added in the GUI thread.
+ */
+void Expression::loadPlot(const PlotFile& file, int index, int resultType)
+{
+    ++d->pendingPlots;
+
+    //the animations are played from the file, their content isn't needed
+    const bool isAnimation = (resultType == AnimationResult::Type || (resultType == -1 && file.format == QLatin1String("gif")));
+
+    QPointer<Expression> guard(this);
+    QThreadPool::globalInstance()->start([guard, file, index, resultType, isAnimation]() {
+        bool loaded = false;
+        QByteArray content;
+        const qint64 expectedSize = (file.size < 0) ? waitForCompleteFile(file.fileName) : file.size;
+        const QFileInfo info(file.fileName);
+        //a different size means the file was overwritten in the meantime, it's not the announced plot anymore
+        if (info.exists() && info.size() > 0 && info.size() == expectedSize)
+        {
+            if (isAnimation)
+                loaded = true;
+            else
+            {
+                QFile plot(file.fileName);
+                if (plot.open(QIODevice::ReadOnly))
+                {
+                    content = plot.readAll();
+                    loaded = !content.isEmpty();
+                }
+            }
+        }
+        else
+            qDebug() << "the announced plot file" << file.fileName << "doesn't exist or has the wrong size";
+
+        const QString& fileName = info.absoluteFilePath();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [guard, loaded, content, fileName, index, resultType, isAnimation]() {
+            if (!guard)
+                return;
+
+            Result* result = nullptr;
+            if (loaded)
+            {
+                const QUrl& url = QUrl::fromLocalFile(fileName);
+                if (isAnimation)
+                    result = new AnimationResult(url);
+                else if (resultType == PdfResult::Type)
+                    result = new PdfResult(url, content);
+                else
+                    result = new ImageResult(url, content);
+            }
+            guard->plotLoaded(result, index, fileName);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void Expression::plotLoaded(Result* result, int index, const QString& fileName)
+{
+    --d->pendingPlots;
+
+    if (!result)
+    {
+        qDebug() << "failed to load the plot file" << fileName;
+        result = new TextResult(i18n("Invalid image file generated."));
+    }
+
+    if (index >= 0 && index < d->results.size())
+        replaceResult(index, result);
+    else
+        addResult(result);
+
+    if (d->pendingPlots == 0 && d->hasStatusAfterPlots)
+    {
+        d->hasStatusAfterPlots = false;
+        //the expression could have been interrupted while the plots were loaded
+        if (d->status == Computing)
+            setStatus(d->statusAfterPlots);
+    }
+}
+
+bool Expression::hasPendingPlots() const
+{
+    return d->pendingPlots > 0;
+}
+
+void Expression::setStatusAfterPlots(Status status)
+{
+    if (d->pendingPlots == 0)
+    {
+        setStatus(status);
+        return;
+    }
+
+    d->hasStatusAfterPlots = true;
+    d->statusAfterPlots = status;
+}
+
 int Expression::id()
 {
     return d->id;
@@ -9,6 +9,7 @@
 
 #include <QObject>
 #include <QDomElement>
+#include <QVector>
 
 #include "cantor_export.h"
 
@@ -22,6 +23,7 @@ namespace Cantor
 {
 class Session;
 class Result;
+class OutputCapture;
 class LatexRenderer;
 class ExpressionPrivate;
 
@@ -46,6 +48,15 @@ class CANTOR_EXPORT Expression : public QObject
         Interrupted  ///< The Expression was interrupted by the user while running
     };
 
+    /**
+     * Plot file announced by a backend once it's completely written, see takePlotAnnouncements()
+     */
+    struct PlotFile {
+        QString fileName;
+        QString format; ///< extension of the file, e.g. "png", "pdf" or "gif"
+        qint64 size{-1}; ///< size of the file in bytes, -1 if the backend can't determine it, the file is then loaded once its size doesn't change anymore
+    };
+
     /**
      * Enum indicating how this Expression behaves on finishing
      */
@@ -211,6 +222,20 @@ class CANTOR_EXPORT Expression : public QObject
     void setIsHelpRequest(bool);
     bool isHelpRequest() const;
 
+    /**
+     * Removes the lines announcing finished plot files from the output @p output of a backend
+     * and returns the announced files.
+     * The plot commands of the backends print the line "cantor-plot:<format>:<size>:<file name>"
+     * after the plot file was written, <size> is -1 if it can't be determined.
+     * A file announced several times is only returned once.
+     */
+    static QVector<PlotFile> takePlotAnnouncements(QString& output);
+
+    /**
+     * Removes the plot announcements from the part of @p output kept in memory and returns the announced files.
+     */
+    static QVector<PlotFile> takePlotAnnouncements(OutputCapture& output);
+
   Q_SIGNALS:
     /**
      * the Id of this Expression changed
@@ -252,6 +277,13 @@ class CANTOR_EXPORT Expression : public QObject
      */
     void needsAdditionalInformation(const QString& question);
 
+    /**
+     * the variable model of the session reported the variables @p names as added or changed
+     * after this expression was evaluated. Only emitted if the changes can be attributed to this expression,
+     * i.e. if no other expression of the user was evaluated before the variable model was updated.
+     */
+    void variablesChanged(const QStringList& names);
+
   //These are protected, because only subclasses will handle results/status changes
   protected:
     // Protected constructor, useful for derived classes with own id setting strategy
@@ -273,9 +305,32 @@ class CANTOR_EXPORT Expression : public QObject
     //used for example if special packages are needed
     virtual QString additionalLatexHeaders();
 
+    /**
+     * @deprecated the backends announce their plot files in the output once they're written,
+     * use takePlotAnnouncements() and loadPlot() instead of watching the files.
+     */
     QFileSystemWatcher* fileWatcher();
 
+    /**
+     * Reads the announced plot file @p file in a worker thread and adds it as a new result once it's loaded,
+     * or replaces the result at @p index with it if @p index is valid.
+     * @p resultType is the type of the created result, ImageResult::Type, PdfResult::Type or AnimationResult::Type.
+     * If it's -1, an AnimationResult is created for gif files and an ImageResult for all other formats.
+     */
+    void loadPlot(const PlotFile& file, int index = -1, int resultType = -1);
+
+    /**
+     * returns \c true if plot files started with loadPlot() are still being loaded.
+     */
+    bool hasPendingPlots() const;
+
+    /**
+     * Sets the status to @p status once all plot files started with loadPlot() are loaded.
+     */
+    void setStatusAfterPlots(Status status);
+
   private:
+    void plotLoaded(Result*, int index, const QString& fileName);
     void renderResultAsLatex(Result*);
     void latexRendered(LatexRenderer*, Result*);
 
@@ -9,10 +9,14 @@
 using namespace Cantor;
 
 #include <QApplication>
+#include <QBuffer>
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QImage>
+#include <QImageReader>
 #include <QImageWriter>
+#include <QJsonObject>
 #include <QPainter>
 #include <QScreen>
 #include <QSvgRenderer>
@@ -28,105 +32,240 @@ class Cantor::ImageResultPrivate
     ImageResultPrivate() = default;
 
     QUrl url;
-    QImage img;
+    QImage img; // only used if the image couldn't be stored in a file
     QString alt;
     QSize displaySize;
     QSize originalSize;
     QString extension;
-    QByteArray data; // byte array used to store the contnent of PDF and SVG files
+    QByteArray data; // the encoded content of vector images (PDF and SVG), the only copy of such an image kept in memory
 
     QString originalFormat{JupyterUtils::pngMime};
-    QString svgContent; // HACK: qt can't easily render svg, so, if we load the result from Jupyter svg image, store original svg
+    QJsonObject jupyterBundle; // the original mime bundle, saved again as it is
+
+    // the last rendering of the vector image, rendered again only for another size or device pixel ratio
+    mutable QImage rendered;
+    mutable QSize renderedSize;
+    mutable qreal renderedPixelRatio{0.};
+
+    // the raster image decoded in the display resolution, decoded again only for another size or version of the file
+    mutable QImage decoded;
+    mutable QString decodedId;
+
+    bool isVector() const
+    {
+        return extension == QLatin1String("pdf") || extension == QLatin1String("svg") || originalFormat == JupyterUtils::svgMime;
+    }
+
+    // the full resolution of raster images is not kept in memory, only a copy in the display resolution
+    QImage image() const
+    {
+        if (!img.isNull())
+            return img;
+
+        if (isVector() && !data.isEmpty())
+        {
+            const QSize& size = displaySize.isValid() ? displaySize : originalSize;
+            return render(size, QGuiApplication::primaryScreen()->devicePixelRatio());
+        }
+
+        if (url.isLocalFile())
+            return decodeToDisplaySize();
+
+        return QImage();
+    }
+
+    // the image in its full resolution, read from the file again, for saving and exporting
+    QImage fullImage() const
+    {
+        if (!img.isNull() || isVector() || !url.isLocalFile())
+            return image();
+
+        return QImage(url.toLocalFile());
+    }
+
+    QImage decodeToDisplaySize() const;
+
+    QImage render(const QSize& size, qreal pixelRatio) const;
+    QImage renderImage(const QSize& size, qreal pixelRatio) const;
+    void setContent(const QByteArray& content);
 };
 
-ImageResult::ImageResult(const QUrl &url, const QString& alt) :  d(new ImageResultPrivate)
+/*!
+ * keeps the encoded content of the vector image and determines its size, the image itself is rendered when it's needed.
+ */
+void Cantor::ImageResultPrivate::setContent(const QByteArray& content)
 {
-    d->url = url;
-    d->alt = alt;
-    d->extension = url.toLocalFile().right(3).toLower();
+    data = content;
+    if (data.isEmpty())
+        return;
 
-    if (d->extension == QLatin1String("pdf") || d->extension == QLatin1String("svg")) // vector formats
+    // the document size is in points, convert to pixels
+    QSizeF size;
+    if (extension == QLatin1String("pdf"))
     {
-        QFile file(url.toLocalFile());
-        if (!file.open(QIODevice::ReadOnly))
+        auto document = Poppler::Document::loadFromData(data);
+        if (!document) {
+            qDebug()<< "Failed to process the byte array of the PDF file " << url.toLocalFile();
             return;
+        }
 
-        d->data = file.readAll();
-        if (d->data.isEmpty())
+        auto page = document->page(0);
+        if (!page) {
+            qDebug() << "Failed to process the first page in the PDF file.";
             return;
+        }
 
-        const double dpi = QGuiApplication::primaryScreen()->logicalDotsPerInchX();
-        const double pixelRatio = QGuiApplication::primaryScreen()->devicePixelRatio();
+        size = page->pageSizeF();
+    }
+    else
+        size = QSvgRenderer(data).defaultSize();
 
-        const double superSample = 2.0;
-        const double totalScale = (dpi / 72.0) * pixelRatio * superSample;
+    const double dpi = QGuiApplication::primaryScreen()->logicalDotsPerInchX();
+    if (!displaySize.isValid() && size.isValid())
+        displaySize = QSize(qRound(size.width() * dpi / 72.0), qRound(size.height() * dpi / 72.0));
 
-        if (d->extension == QLatin1String("pdf"))
-        {
-            auto document = Poppler::Document::loadFromData(d->data);
-            if (!document) {
-                qDebug()<< "Failed to process the byte array of the PDF file " << url.toLocalFile();
-                return;
-            }
-
-            auto page = document->page(0);
-            if (!page) {
-                qDebug() << "Failed to process the first page in the PDF file.";
-                return;
-            }
-
-            document->setRenderHint(Poppler::Document::TextAntialiasing);
-            document->setRenderHint(Poppler::Document::Antialiasing);
-            document->setRenderHint(Poppler::Document::TextHinting);
-            document->setRenderHint(Poppler::Document::TextSlightHinting);
-            document->setRenderHint(Poppler::Document::ThinLineSolid);
-
-            d->img = page->renderToImage(72.0 * totalScale, 72.0 * totalScale);
-
-            if (!d->img.isNull()) {
-                if (d->img.format() != QImage::Format_ARGB32_Premultiplied)
-                    d->img = d->img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-
-                double ratio = pixelRatio * superSample;
-                d->img.setDevicePixelRatio(ratio);
-
-                if (!d->displaySize.isValid())
-                    d->displaySize = QSize(qRound(d->img.width() / ratio), qRound(d->img.height() / ratio));
-            }
-        }
-        else
-        {
-            QSvgRenderer renderer(d->data);
-
-            // SVG document size is in points, convert to pixels
-            const auto& size = renderer.defaultSize();
-            if (!d->displaySize.isValid())
-                d->displaySize = QSize(qRound(size.width() * dpi / 72.0), qRound(size.height() * dpi / 72.0));
-            int w = qRound(size.width() * totalScale);
-            int h = qRound(size.height() * totalScale);
-
-            d->img = QImage(w, h, QImage::Format_ARGB32_Premultiplied);
-            d->img.fill(Qt::transparent);
-
-            // render
-            QPainter painter;
-            painter.begin(&d->img);
-            painter.setRenderHint(QPainter::Antialiasing, true);
-            painter.setRenderHint(QPainter::TextAntialiasing, true);
-            painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
-            renderer.render(&painter);
-            painter.end();
-
-            d->img.setDevicePixelRatio(pixelRatio * superSample);
+    if (displaySize.isValid())
+        originalSize = displaySize;
+}
+
+/*!
+ * decodes the raster image directly in the resolution it's shown in, limited by the size of the screen.
+ * The decoded image is kept until the display size or the file change.
+ */
+QImage Cantor::ImageResultPrivate::decodeToDisplaySize() const
+{
+    const QString& fileName = url.toLocalFile();
+    const QFileInfo info(fileName);
+    auto* screen = QGuiApplication::primaryScreen();
+    const qreal pixelRatio = screen ? screen->devicePixelRatio() : 1.0;
+
+    QSize size = (displaySize.isValid() ? displaySize : originalSize) * pixelRatio;
+    if (screen && size.isValid())
+        size = size.boundedTo(screen->size() * pixelRatio).expandedTo(QSize(1, 1));
+
+    QImageReader reader(fileName);
+    const QSize& sourceSize = reader.size();
+    if (size.isValid() && sourceSize.isValid())
+        size = sourceSize.scaled(size.boundedTo(sourceSize), Qt::KeepAspectRatio);
+
+    const QString& id = fileName + QLatin1Char(':') + QString::number(info.lastModified().toMSecsSinceEpoch())
+                        + QLatin1Char(':') + QString::number(info.size())
+                        + QLatin1Char(':') + QString::number(size.width()) + QLatin1Char('x') + QString::number(size.height());
+    if (id == decodedId)
+        return decoded;
+
+    if (size.isValid() && size != sourceSize)
+        reader.setScaledSize(size);
+
+    decoded = reader.read();
+    decodedId = id;
+    return decoded;
+}
+
+QImage Cantor::ImageResultPrivate::render(const QSize& size, qreal pixelRatio) const
+{
+    if (size != renderedSize || pixelRatio != renderedPixelRatio)
+    {
+        rendered = renderImage(size, pixelRatio);
+        renderedSize = size;
+        renderedPixelRatio = pixelRatio;
+    }
+
+    return rendered;
+}
+
+/*!
+ * renders the vector image to the size \c size in device independent pixels,
+ * super sampled and for the device pixel ratio \c pixelRatio.
+ */
+QImage Cantor::ImageResultPrivate::renderImage(const QSize& size, qreal pixelRatio) const
+{
+    if (!size.isValid() || data.isEmpty())
+        return QImage();
+
+    const qreal superSample = 2.0 * pixelRatio;
+    const QSize renderSize(qMin(qRound(size.width() * superSample), 16384),
+                           qMin(qRound(size.height() * superSample), 16384));
+
+    if (extension == QLatin1String("pdf")) {
+        auto document = Poppler::Document::loadFromData(data);
+        if (!document)
+            return QImage();
+
+        auto page = document->page(0);
+        if (!page)
+            return QImage();
+
+        document->setRenderHint(Poppler::Document::Antialiasing, true);
+        document->setRenderHint(Poppler::Document::TextAntialiasing, true);
+        document->setRenderHint(Poppler::Document::TextHinting, true);
+        document->setRenderHint(Poppler::Document::TextSlightHinting, true);
+        document->setRenderHint(Poppler::Document::ThinLineSolid, true);
+
+        const QSizeF pageSize = page->pageSizeF();
+        if (!pageSize.isValid())
+            return QImage();
+
+        const qreal scale = qMax(renderSize.width() / pageSize.width(), renderSize.height() / pageSize.height());
+        QImage image = page->renderToImage(72.0 * scale, 72.0 * scale);
+        if (!image.isNull()) {
+            if (image.format() != QImage::Format_ARGB32_Premultiplied)
+                image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(superSample);
         }
+        return image;
     }
-    else // raster formats
-        d->img.load(d->url.toLocalFile());
 
-    if (d->displaySize.isValid())
-        d->originalSize = d->displaySize;
-    else if (!d->img.isNull())
-        d->originalSize = d->img.size();
+    QSvgRenderer renderer(data);
+    if (!renderer.isValid())
+        return QImage();
+
+    QImage image(renderSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setRenderHint(QPainter::TextAntialiasing, true);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    renderer.render(&painter);
+    painter.end();
+    image.setDevicePixelRatio(superSample);
+    return image;
+}
+
+ImageResult::ImageResult(const QUrl &url, const QString& alt) :  d(new ImageResultPrivate)
+{
+    d->url = url;
+    d->alt = alt;
+    d->extension = url.toLocalFile().right(3).toLower();
+
+    if (isVector())
+    {
+        QFile file(url.toLocalFile());
+        if (file.open(QIODevice::ReadOnly))
+            d->setContent(file.readAll());
+    }
+    else // raster formats, only the header is read to determine the size
+        d->originalSize = QImageReader(d->url.toLocalFile()).size();
+}
+
+/*!
+ * creates the result for the image file \c url whose content \c content was already read, e.g. in a worker thread.
+ * The file isn't read again, raster images are read from it only when they're shown.
+ */
+ImageResult::ImageResult(const QUrl& url, const QByteArray& content, const QString& alt) : d(new ImageResultPrivate)
+{
+    d->url = url;
+    d->alt = alt;
+    d->extension = url.toLocalFile().right(3).toLower();
+
+    if (isVector())
+        d->setContent(content);
+    else
+    {
+        QBuffer buffer;
+        buffer.setData(content);
+        d->originalSize = QImageReader(&buffer).size();
+    }
 }
 
 Cantor::ImageResult::ImageResult(const QImage& image, const QString& alt) :  d(new ImageResultPrivate)
@@ -139,8 +278,12 @@ Cantor::ImageResult::ImageResult(const QImage& image, const QString& alt) :  d(n
     imageFile.setAutoRemove(false);
     if (imageFile.open())
     {
-        d->img.save(imageFile.fileName(), "PNG");
-        d->url = QUrl::fromLocalFile(imageFile.fileName());
+        if (d->img.save(imageFile.fileName(), "PNG"))
+        {
+            //the image is read from the file again when needed
+            d->url = QUrl::fromLocalFile(imageFile.fileName());
+            d->img = QImage();
+        }
     }
 }
 
@@ -161,7 +304,7 @@ QString ImageResult::toLatex()
 
 QVariant ImageResult::data()
 {
-    return QVariant(d->img);
+    return QVariant(d->image());
 }
 
 QUrl ImageResult::url()
@@ -188,6 +331,11 @@ QString ImageResult::extension()
     return d->extension;
 }
 
+bool ImageResult::isVector() const
+{
+    return d->isVector();
+}
+
 QDomElement ImageResult::toXml(QDomDocument& doc)
 {
     auto e = doc.createElement(QStringLiteral("Result"));
@@ -221,22 +369,19 @@ QJsonValue Cantor::ImageResult::toJupyterJson()
     else
         root.insert(QLatin1String("output_type"), QLatin1String("display_data"));
 
-    QImage image;
-    if (d->img.isNull())
-        image.load(d->url.toLocalFile());
-    else
-        image = d->img;
-
     QJsonObject data;
 
-    // HACK: see ImageResultPrivate::svgContent
-    if (d->originalFormat == JupyterUtils::svgMime)
-        data.insert(JupyterUtils::svgMime, JupyterUtils::toJupyterMultiline(d->svgContent));
+    if (!d->jupyterBundle.isEmpty())
+        data = d->jupyterBundle;
     else
-        data = JupyterUtils::packMimeBundle(d->img, d->originalFormat);
-
-    data.insert(JupyterUtils::textMime, JupyterUtils::toJupyterMultiline(d->alt));
+    {
+        if (d->originalFormat == JupyterUtils::svgMime)
+            data.insert(JupyterUtils::svgMime, JupyterUtils::toJupyterMultiline(QString::fromUtf8(d->data)));
+        else
+            data = JupyterUtils::packMimeBundle(d->fullImage(), d->originalFormat);
 
+        data.insert(JupyterUtils::textMime, JupyterUtils::toJupyterMultiline(d->alt));
+    }
 
     root.insert(QLatin1String("data"), data);
 
@@ -265,7 +410,7 @@ void ImageResult::saveAdditionalData(KZip* archive)
 void ImageResult::save(const QString& fileName)
 {
     bool rc = false;
-    if (d->extension == QLatin1String("pdf") || d->extension == QLatin1String("svg"))
+    if (d->isVector() && !d->data.isEmpty())
     {
         QFile file(fileName);
         if (file.open(QIODevice::WriteOnly))
@@ -276,7 +421,7 @@ void ImageResult::save(const QString& fileName)
         }
     }
     else
-        rc = d->img.save(fileName);
+        rc = d->fullImage().save(fileName);
 
     if (!rc)
         qDebug()<<"saving to " << fileName << " failed.";
@@ -304,61 +449,11 @@ void Cantor::ImageResult::setOriginalSize(const QSize& size)
 
 QImage Cantor::ImageResult::renderToDisplaySize(const QSize& size)
 {
-    if (!size.isValid())
-        return d->img;
-
-    constexpr qreal superSample = 2.0;
-    const QSize renderSize(qMin(qRound(size.width() * superSample), 16384),
-                           qMin(qRound(size.height() * superSample), 16384));
-
-    if (d->extension == QLatin1String("pdf")) {
-        auto document = Poppler::Document::loadFromData(d->data);
-        if (!document)
-            return d->img;
-
-        auto page = document->page(0);
-        if (!page)
-            return d->img;
-
-        document->setRenderHint(Poppler::Document::Antialiasing, true);
-        document->setRenderHint(Poppler::Document::TextAntialiasing, true);
-        document->setRenderHint(Poppler::Document::TextHinting, true);
-
-        const QSizeF pageSize = page->pageSizeF();
-        if (!pageSize.isValid())
-            return d->img;
+    if (!size.isValid() || !d->isVector())
+        return d->image();
 
-        const qreal scale = qMax(renderSize.width() / pageSize.width(), renderSize.height() / pageSize.height());
-        QImage image = page->renderToImage(72.0 * scale, 72.0 * scale);
-        if (!image.isNull()) {
-            if (image.format() != QImage::Format_ARGB32_Premultiplied)
-                image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            image.setDevicePixelRatio(superSample);
-        }
-        return image;
-    }
-
-    QByteArray svgData = d->data;
-    if (svgData.isEmpty() && d->originalFormat == JupyterUtils::svgMime)
-        svgData = d->svgContent.toUtf8();
-
-    if (d->extension == QLatin1String("svg") || d->originalFormat == JupyterUtils::svgMime) {
-        QSvgRenderer renderer(svgData);
-        if (!renderer.isValid())
-            return d->img;
-
-        QImage image(renderSize, QImage::Format_ARGB32_Premultiplied);
-        image.fill(Qt::transparent);
-        QPainter painter(&image);
-        painter.setRenderHint(QPainter::Antialiasing, true);
-        painter.setRenderHint(QPainter::TextAntialiasing, true);
-        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
-        renderer.render(&painter);
-        image.setDevicePixelRatio(superSample);
-        return image;
-    }
-
-    return d->img;
+    const QImage& image = d->render(size, 1.0);
+    return image.isNull() ? d->image() : image;
 }
 
 void Cantor::ImageResult::setOriginalFormat(const QString& format)
@@ -373,5 +468,12 @@ QString Cantor::ImageResult::originalFormat()
 
 void Cantor::ImageResult::setSvgContent(const QString& svgContent)
 {
-    d->svgContent = svgContent;
+    d->data = svgContent.toUtf8();
+    d->rendered = QImage();
+    d->renderedSize = QSize();
+}
+
+void Cantor::ImageResult::setJupyterBundle(const QJsonObject& bundle)
+{
+    d->jupyterBundle = bundle;
 }
@@ -22,6 +22,7 @@ class CANTOR_EXPORT ImageResult : public Result
   public:
     enum{Type=2};
     explicit ImageResult( const QUrl& url, const QString& alt=QString());
+    ImageResult( const QUrl& url, const QByteArray& content, const QString& alt=QString());
     explicit ImageResult( const QImage& image, const QString& alt=QString());
     ~ImageResult() override;
 
@@ -34,6 +35,14 @@ class CANTOR_EXPORT ImageResult : public Result
     QString mimeType() override;
     QString extension();
 
+    /**
+     * Returns @c true if the image was created from a PDF or an SVG file.
+     * Raster images are kept in memory only in the resolution they're shown in, limited by the size of the screen,
+     * and are read from the file again for saving.
+     * Only the encoded content of vector images is kept in memory, they're rendered when needed.
+     */
+    bool isVector() const;
+
     QSize displaySize();
     void setDisplaySize(QSize size);
     QSize originalSize() const;
@@ -44,6 +53,13 @@ class CANTOR_EXPORT ImageResult : public Result
     void setOriginalFormat(const QString& format);
     void setSvgContent(const QString& svgContent);
 
+    /**
+     * Sets the Jupyter mime bundle the image was loaded from.
+     * The bundle is written back unchanged when the worksheet is saved as a Jupyter notebook,
+     * the image is not encoded again.
+     */
+    void setJupyterBundle(const QJsonObject& bundle);
+
     QDomElement toXml(QDomDocument& doc) override;
     QJsonValue toJupyterJson() override;
     void saveAdditionalData(KZip* archive) override;
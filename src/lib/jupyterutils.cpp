@@ -16,6 +16,7 @@
 #include <QImageReader>
 #include <QImageWriter>
 #include <QBuffer>
+#include <QDir>
 #include <QString>
 #include <QUrl>
 #include <QTemporaryFile>
@@ -319,6 +320,29 @@ QImage JupyterUtils::loadImage(const QJsonValue& mimeBundle, const QString& key)
     return image;
 }
 
+QString JupyterUtils::saveEncodedImage(const QJsonValue& mimeBundle, const QString& key)
+{
+    if (!mimeBundle.isObject() || key == svgMime || !QImageReader::supportedMimeTypes().contains(key.toLatin1()))
+        return QString();
+
+    const QJsonValue& data = mimeBundle.toObject().value(key);
+    if (!data.isString() && !data.isArray())
+        return QString();
+
+    const QByteArray& bytes = QByteArray::fromBase64(fromJupyterMultiline(data).toLatin1());
+    if (bytes.isEmpty())
+        return QString();
+
+    // the suffix is needed to recognize the format when the image is read from the file
+    const QString& suffix = mimeDatabase.mimeTypeForName(key).preferredSuffix();
+    QTemporaryFile file(QDir::tempPath() + QLatin1String("/cantor_image-XXXXXX.") + suffix);
+    file.setAutoRemove(false);
+    if (!file.open() || file.write(bytes) != bytes.size())
+        return QString();
+
+    return file.fileName();
+}
+
 QJsonObject JupyterUtils::packMimeBundle(const QImage& image, const QString& mime)
 {
     QJsonObject mimeBundle;
@@ -68,6 +68,12 @@ class CANTOR_EXPORT JupyterUtils
     static QJsonObject getKernelspec(const Cantor::Backend* backend);
 
     static QImage loadImage(const QJsonValue& mimeBundle, const QString& key);
+
+    /**
+     * Writes the encoded raster image stored under @p key in @p mimeBundle to a temporary file without decoding it.
+     * Returns the name of the file or an empty string if the bundle doesn't contain a base64 encoded image for this key.
+     */
+    static QString saveEncodedImage(const QJsonValue& mimeBundle, const QString& key);
     static QJsonObject packMimeBundle(const QImage& image, const QString& mime);
     static QStringList imageKeys(const QJsonValue& mimeBundle);
     static QString firstImageKey(const QJsonValue& mimeBundle);
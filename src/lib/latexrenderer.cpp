@@ -4,6 +4,7 @@
  */
 
 #include "latexrenderer.h"
+#include "texworker.h"
 using namespace Cantor;
 
 #include <QProcess>
@@ -32,6 +33,7 @@ public:
     QString latexFilename;
     QString pdfFilename;
     QString uuid;
+    QString formatName;
     QTemporaryFile* texFile;
     QColor bgColor{Qt::white};
     QColor textColor{Qt::black};
@@ -226,7 +228,14 @@ bool LatexRenderer::renderWithLatex()
 
     // qDebug()<<"full tex:\n"<<expressionTex;
 
-    d->texFile->write(expressionTex.toUtf8());
+    //the preamble is loaded from a precompiled format once it's available, only the body is written then
+    QString preamble;
+    QString body;
+    d->formatName.clear();
+    if (TexWorker::splitDocument(expressionTex, &preamble, &body))
+        d->formatName = TexWorker::format(preamble, false);
+
+    d->texFile->write((d->formatName.isEmpty() ? expressionTex : body).toUtf8());
     d->texFile->flush();
 
     QString fileName = d->texFile->fileName();
@@ -243,7 +252,11 @@ bool LatexRenderer::renderWithLatex()
     if (!pdflatex.isEmpty())
     {
         p->setProgram(pdflatex);
-        p->setArguments({QStringLiteral("-jobname=cantor_") + d->uuid, QStringLiteral("-halt-on-error"), fileName});
+        QStringList arguments{QStringLiteral("-jobname=cantor_") + d->uuid, QStringLiteral("-halt-on-error")};
+        if (!d->formatName.isEmpty())
+            arguments << QStringLiteral("-fmt=") + d->formatName;
+        arguments << fileName;
+        p->setArguments(arguments);
 
         connect(p, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(convertingDone()) );
         p->start();
@@ -275,6 +288,15 @@ void LatexRenderer::convertingDone()
     }
     else
     {
+        //typeset the complete document again if pdflatex couldn't load the format
+        auto* process = qobject_cast<QProcess*>(sender());
+        if (!d->formatName.isEmpty() && process && !TexWorker::hasTexErrors(QString::fromUtf8(process->readAllStandardOutput())))
+        {
+            TexWorker::discardFormat(d->formatName);
+            if (renderWithLatex())
+                return;
+        }
+
         d->success=false;
         setErrorMessage(QStringLiteral("failed to create the latex preview pdf"));
         Q_EMIT error();
@@ -0,0 +1,166 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "outputcapture.h"
+#include "textresult.h"
+#include "cantor_libs_settings.h"
+using namespace Cantor;
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <KLocalizedString>
+
+class Cantor::OutputCapturePrivate
+{
+  public:
+    qsizetype budget{0};
+    QString head;
+    QString tail;
+    QTemporaryFile* spillFile{nullptr};
+    qsizetype spilledLength{0};
+
+    qsizetype headBudget() const { return budget / 2; }
+    qsizetype tailBudget() const { return budget - budget / 2; }
+
+    void spill(qsizetype count)
+    {
+        if (!spillFile)
+        {
+            spillFile = new QTemporaryFile(QDir::tempPath() + QLatin1String("/cantor_output-XXXXXX.txt"));
+            if (!spillFile->open())
+                qWarning() << "failed to create the file for the omitted output" << spillFile->fileName();
+        }
+
+        //don't split a surrogate pair
+        if (count < tail.size() && tail.at(count - 1).isHighSurrogate())
+            --count;
+
+        if (spillFile->isOpen())
+            spillFile->write(QStringView(tail).left(count).toUtf8());
+        spilledLength += count;
+        tail.remove(0, count);
+    }
+
+    QString omissionNote() const
+    {
+        return QLatin1Char('\n') + i18np("[... 1 character omitted, the complete output is available in the saved worksheet ...]",
+                                         "[... %1 characters omitted, the complete output is available in the saved worksheet ...]",
+                                         spilledLength) + QLatin1Char('\n');
+    }
+};
+
+OutputCapture::OutputCapture(qsizetype budget) : d(new OutputCapturePrivate)
+{
+    d->budget = budget;
+}
+
+OutputCapture::~OutputCapture()
+{
+    delete d->spillFile;
+    delete d;
+}
+
+qsizetype OutputCapture::defaultBudget()
+{
+    //the budget is configured in millions of characters
+    return static_cast<qsizetype>(CantorLibsSettings::self()->outputBudget()) * 1000000;
+}
+
+void OutputCapture::setBudget(qsizetype budget)
+{
+    d->budget = budget;
+}
+
+void OutputCapture::append(const QString& text)
+{
+    if (text.isEmpty())
+        return;
+
+    if (d->budget <= 0)
+    {
+        d->head += text;
+        return;
+    }
+
+    qsizetype offset = 0;
+    if (d->head.size() < d->headBudget())
+    {
+        offset = std::min(text.size(), d->headBudget() - d->head.size());
+        d->head += QStringView(text).left(offset);
+    }
+
+    if (offset == text.size())
+        return;
+
+    d->tail += QStringView(text).mid(offset);
+
+    //spill in larger blocks instead of on every append, the tail exceeds its budget by at most one block
+    const qsizetype block = std::min<qsizetype>(d->tailBudget(), 1024 * 1024);
+    if (d->tail.size() > d->tailBudget() + block)
+        d->spill(d->tail.size() - d->tailBudget());
+}
+
+void OutputCapture::clear()
+{
+    d->head.clear();
+    d->tail.clear();
+    delete d->spillFile;
+    d->spillFile = nullptr;
+    d->spilledLength = 0;
+}
+
+bool OutputCapture::isEmpty() const
+{
+    return d->head.isEmpty() && d->tail.isEmpty() && d->spilledLength == 0;
+}
+
+qsizetype OutputCapture::size() const
+{
+    return d->head.size() + d->spilledLength + d->tail.size();
+}
+
+bool OutputCapture::isTruncated() const
+{
+    return d->spilledLength != 0;
+}
+
+void OutputCapture::filter(const std::function<void(QString&)>& function)
+{
+    function(d->head);
+    function(d->tail);
+}
+
+QString OutputCapture::text() const
+{
+    if (!isTruncated())
+        return d->head + d->tail;
+
+    return d->head + d->omissionNote() + d->tail;
+}
+
+TextResult* OutputCapture::createResult()
+{
+    if (!isTruncated() || !d->spillFile || !d->spillFile->isOpen())
+    {
+        auto* result = new TextResult(text());
+        clear();
+        return result;
+    }
+
+    const QString& note = d->omissionNote();
+    auto* result = new TextResult(d->head + note + d->tail);
+
+    //the result takes over the spilled part and removes the file once it's deleted
+    d->spillFile->setAutoRemove(false);
+    d->spillFile->close();
+    result->setOmittedOutput(d->spillFile->fileName(), d->head.size(), note.size());
+
+    clear();
+    return result;
+}
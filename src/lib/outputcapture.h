@@ -0,0 +1,85 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef CANTOR_OUTPUTCAPTURE_H
+#define CANTOR_OUTPUTCAPTURE_H
+
+#include <QString>
+
+#include <functional>
+
+#include "cantor_export.h"
+
+namespace Cantor
+{
+
+class TextResult;
+class OutputCapturePrivate;
+
+/**
+ * Accumulates the output of an expression within a memory budget.
+ * The output is kept in memory completely as long as it fits into the budget.
+ * Otherwise only its head and tail are kept, the part in between is written to a temporary file.
+ * The text result created from the capture refers to this file, so the complete output is still
+ * available for saving without holding it in memory.
+ */
+class CANTOR_EXPORT OutputCapture
+{
+  public:
+    /**
+     * Creates a capture keeping at most @p budget characters in memory.
+     */
+    explicit OutputCapture(qsizetype budget = defaultBudget());
+    ~OutputCapture();
+
+    /**
+     * Returns the output budget in characters as configured in the settings.
+     */
+    static qsizetype defaultBudget();
+
+    /**
+     * Sets the number of characters kept in memory, 0 for unlimited
+     */
+    void setBudget(qsizetype);
+
+    void append(const QString&);
+    void clear();
+
+    bool isEmpty() const;
+
+    /**
+     * Returns the size of the complete captured output in characters
+     */
+    qsizetype size() const;
+
+    /**
+     * Returns @c true if the output exceeded the budget and its middle part was spilled to disk
+     */
+    bool isTruncated() const;
+
+    /**
+     * Applies @p function to the head and to the tail of the output kept in memory, e.g. to remove lines from them.
+     * The part of a truncated output spilled to disk isn't changed.
+     */
+    void filter(const std::function<void(QString&)>& function);
+
+    /**
+     * Returns the output kept in memory, with a note about the omitted part if the output is truncated
+     */
+    QString text() const;
+
+    /**
+     * Creates a text result for the captured output and clears the capture.
+     * The ownership of the spilled part is transferred to the result.
+     */
+    TextResult* createResult();
+
+  private:
+    OutputCapturePrivate* d;
+};
+
+}
+
+#endif /* CANTOR_OUTPUTCAPTURE_H */
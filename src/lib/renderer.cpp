@@ -7,7 +7,11 @@
 
 #include <QUuid>
 #include <QDebug>
+#include <QCache>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QMutex>
+#include <QSharedPointer>
 #include <QScreen>
 
 #include <config-cantorlib.h>
@@ -20,6 +24,54 @@ using namespace Cantor;
 // and not common widespread in repositories
 static QMutex popplerMutex;
 
+// The parsed pdf documents of the formulas are kept open, changing the zoom only rasterizes them again.
+// A document is rendered by one thread at a time.
+struct PdfDocument
+{
+    std::unique_ptr<Poppler::Document> document;
+    QMutex mutex;
+};
+
+//every open document keeps its file open, only the documents of the recently rendered formulas are kept
+static QCache<QString, QSharedPointer<PdfDocument>> pdfDocuments(16);
+
+static void removePdfDocuments(const QString& fileName)
+{
+    const QString& prefix = fileName + QLatin1Char(':');
+    const auto keys = pdfDocuments.keys();
+    for (const auto& key : keys)
+        if (key.startsWith(prefix))
+            pdfDocuments.remove(key);
+}
+
+static QSharedPointer<PdfDocument> openPdf(const QString& fileName)
+{
+    auto& documents = pdfDocuments;
+
+    const QFileInfo info(fileName);
+    const QString& key = fileName + QLatin1Char(':') + QString::number(info.lastModified().toMSecsSinceEpoch());
+
+    QMutexLocker locker(&popplerMutex);
+    if (auto* cached = documents.object(key))
+        return *cached;
+
+    auto document = Poppler::Document::load(fileName);
+    if (document == nullptr)
+        return QSharedPointer<PdfDocument>();
+
+    document->setRenderHint(Poppler::Document::Antialiasing, true);
+    document->setRenderHint(Poppler::Document::TextAntialiasing, true);
+    document->setRenderHint(Poppler::Document::TextHinting, true);
+
+    QSharedPointer<PdfDocument> pdf(new PdfDocument);
+    pdf->document = std::move(document);
+
+    //the previous versions of the file are not needed anymore
+    removePdfDocuments(fileName);
+    documents.insert(key, new QSharedPointer<PdfDocument>(pdf));
+    return pdf;
+}
+
 class Cantor::RendererPrivate{
   public:
     double scale{1};
@@ -50,6 +102,11 @@ void Renderer::useHighResolution(bool b)
     d->useHighRes = b;
 }
 
+bool Renderer::isHighResolution() const
+{
+    return d->useHighRes;
+}
+
 QTextImageFormat Renderer::render(QTextDocument *document, const QUrl &url, const QString& uuid)
 {
     QTextImageFormat format;
@@ -94,24 +151,24 @@ QSizeF Renderer::renderToResource(QTextDocument *document,const QUrl &url, const
     return size;
 }
 
-QImage Renderer::pdfRenderToImage(const QUrl& url, double scale, bool highResolution, QSizeF* size, QString* errorReason)
+void Renderer::releasePdf(const QString& fileName)
 {
-    popplerMutex.lock();
-    auto document = Poppler::Document::load(url.toLocalFile());
-    popplerMutex.unlock();
+    QMutexLocker locker(&popplerMutex);
+    removePdfDocuments(fileName);
+}
 
-    if (document == nullptr)
+QImage Renderer::pdfRenderToImage(const QUrl& url, double scale, bool highResolution, QSizeF* size, QString* errorReason)
+{
+    const auto& pdf = openPdf(url.toLocalFile());
+    if (!pdf)
     {
         if (errorReason)
             *errorReason = QString::fromLatin1("Poppler library have failed to open file % as pdf").arg(url.toLocalFile());
         return QImage();
     }
 
-    document->setRenderHint(Poppler::Document::Antialiasing, true);
-    document->setRenderHint(Poppler::Document::TextAntialiasing, true);
-    document->setRenderHint(Poppler::Document::TextHinting, true);
-
-    auto pdfPage = document->page(0);
+    QMutexLocker locker(&pdf->mutex);
+    auto pdfPage = pdf->document->page(0);
     if (pdfPage == nullptr)
     {
         if (errorReason)
@@ -129,9 +186,8 @@ QImage Renderer::pdfRenderToImage(const QUrl& url, double scale, bool highResolu
 
     double targetDpi = dpiX * effectiveScale;
     QImage image = pdfPage->renderToImage(targetDpi, targetDpi);
-
-    popplerMutex.lock();
-    popplerMutex.unlock();
+    pdfPage.reset();
+    locker.unlock();
 
     if (image.isNull())
     {
@@ -35,6 +35,7 @@ class CANTOR_EXPORT Renderer
     qreal scale();
 
     void useHighResolution(bool b);
+    bool isHighResolution() const;
 
     QSizeF renderToResource(QTextDocument *document, const QUrl& url, const QUrl& internal);
 
@@ -42,6 +43,11 @@ class CANTOR_EXPORT Renderer
 
     static QImage pdfRenderToImage(const QUrl& url, double scale, bool useHighRes, QSizeF* size = nullptr, QString* errorReason = nullptr);
 
+    /**
+     * Closes the PDF document @p fileName kept open for rendering, to be called before the file is removed.
+     */
+    static void releasePdf(const QString& fileName);
+
   private:
     RendererPrivate* d;
 };
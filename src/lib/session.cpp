@@ -5,6 +5,7 @@
 */
 
 #include "session.h"
+#include "sessionscheduler.h"
 using namespace Cantor;
 
 #include <map>
@@ -13,9 +14,14 @@ using namespace Cantor;
 #include "textresult.h"
 #include "keywordsmanager.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QEventLoop>
+#include <QHash>
+#include <QPointer>
+#include <QProcess>
 #include <QQueue>
+#include <QRegularExpression>
 #include <QTimer>
 
 #include <KMessageBox>
@@ -38,17 +44,81 @@ class Cantor::SessionPrivate
     bool needUpdate{false};
     KeywordsManager* m_keywordsManager{nullptr};
     QString worksheetPath;
+
+    // login state machine
+    Session::LoginState loginState{Session::LoggedOut};
+    QPointer<QProcess> loginProcess;
+    QByteArray loginReadyMarker;
+    QByteArray loginBuffer;
+    QString loginStartErrorMessage;
+    QList<QMetaObject::Connection> loginConnections;
+    QList<QPointer<Cantor::Expression>> deferredExpressions;
+
+    // the scheduler lets only a limited number of sessions evaluate at the same time
+    bool waitingForScheduler{false};
+
+    // result memoization
+    bool resultMemoizationEnabled{false};
+    quint64 stateEpoch{0};
+    quint64 loginGeneration{0};
+    QList<QMetaObject::Connection> variableModelConnections;
+
+    // the expressions of the user evaluated since the last update of the variable model
+    // and the ones the running update reports the changed variables for
+    QList<QPointer<Cantor::Expression>> unreportedExpressions;
+    QList<QPointer<Cantor::Expression>> reportingExpressions;
+    // values of the variables by name, rebuilt lazily once per epoch
+    QHash<QString, QString> variableValues;
+    quint64 variableValuesEpoch{0};
+    bool variableValuesValid{false};
+    // the functions are listed without their definitions, the revisions are incremented on every (re)definition
+    QHash<QString, quint64> functionRevisions;
+
+    void countFunctionDefinitions(const QString& command);
+
+    void clearLoginConnections()
+    {
+        for (const auto& connection : std::as_const(loginConnections))
+            QObject::disconnect(connection);
+        loginConnections.clear();
+        loginBuffer.clear();
+    }
 };
 
+/*!
+ * increments the revisions of the functions defined in \c command. The common forms of the definitions
+ * of the backends are recognized, "def f(", "function f(", "function y = f(", "f(x) := ", "f(x) = ",
+ * "f <- function" and "f = lambda".
+ */
+void SessionPrivate::countFunctionDefinitions(const QString& command)
+{
+    static const QRegularExpression definitions[] = {
+        QRegularExpression(QStringLiteral("\\bdef\\s+([A-Za-z_]\\w*)")),
+        QRegularExpression(QStringLiteral("\\bfunction\\b[^\\n(]*?\\b([A-Za-z_]\\w*)\\s*\\(")),
+        QRegularExpression(QStringLiteral("^\\s*([A-Za-z_]\\w*)\\s*\\([^)\\n]*\\)\\s*(?::=|=(?!=))"), QRegularExpression::MultilineOption),
+        QRegularExpression(QStringLiteral("^\\s*([A-Za-z_]\\w*)\\s*(?:<-|=)\\s*(?:function|lambda)\\b"), QRegularExpression::MultilineOption)
+    };
+
+    for (const auto& definition : definitions)
+    {
+        auto it = definition.globalMatch(command);
+        while (it.hasNext())
+            ++functionRevisions[it.next().captured(1)];
+    }
+}
+
 Session::Session(Backend* backend ) : QObject(backend), d(new SessionPrivate)
 {
     d->backend = backend;
+    addToScheduler();
 }
 
 Session::Session(Backend* backend, DefaultVariableModel* model) : QObject(backend), d(new SessionPrivate)
 {
     d->backend = backend;
     d->variableModel = model;
+    watchVariableModel();
+    addToScheduler();
 }
 
 Session::Session(Backend* backend, DefaultVariableModel* model, KeywordsManager* keywordsManager) : QObject(backend), d(new SessionPrivate)
@@ -56,19 +126,36 @@ Session::Session(Backend* backend, DefaultVariableModel* model, KeywordsManager*
     d->backend = backend;
     d->variableModel = model;
     d->m_keywordsManager = keywordsManager;
+    watchVariableModel();
+    addToScheduler();
 }
 
 Session::~Session()
 {
+    SessionScheduler::instance()->removeSession(this);
     delete d->m_keywordsManager;
     delete d;
 }
 
 void Session::logout()
 {
-    if (d->status == Session::Running)
+    if (!interruptScheduledExpressions() && d->status == Session::Running)
         interrupt();
 
+    d->clearLoginConnections();
+    d->loginProcess = nullptr;
+    d->deferredExpressions.clear();
+    d->unreportedExpressions.clear();
+    d->reportingExpressions.clear();
+    d->waitingForScheduler = false;
+    SessionScheduler::instance()->release(this);
+    setLoginState(LoggedOut);
+
+    //nothing evaluated in the previous run of the backend can be reused
+    ++d->loginGeneration;
+    ++d->stateEpoch;
+    d->functionRevisions.clear();
+
     if (d->variableModel)
     {
         d->variableModel->clearVariables();
@@ -92,16 +179,84 @@ QList<Expression*>& Cantor::Session::expressionQueue() const
 
 void Session::enqueueExpression(Expression* expr)
 {
+    //the backend process is not ready yet, the expression is queued in finishLogin()
+    //after the initialization commands of the session. Only the internal initialization commands
+    //are evaluated while the session is initializing, some backends initialize asynchronously.
+    if (d->loginState == LoginStarting || d->loginState == LoginHandshake
+        || (d->loginState == LoginInitializing && !expr->isInternal()))
+    {
+        d->deferredExpressions.append(expr);
+        expr->setStatus(Cantor::Expression::Queued);
+        return;
+    }
+
     d->expressionQueue.append(expr);
 
     //run the newly added expression immediately if it's the only one in the queue
-    if (d->expressionQueue.size() == 1)
+    //and the limit of the sessions evaluating in parallel is not reached
+    if (d->expressionQueue.size() == 1 && !d->waitingForScheduler && SessionScheduler::instance()->acquire(this))
     {
         changeStatus(Cantor::Session::Running);
         runFirstExpression();
     }
     else
+    {
+        d->waitingForScheduler = d->waitingForScheduler || d->expressionQueue.size() == 1;
         expr->setStatus(Cantor::Expression::Queued);
+    }
+}
+
+int Session::pendingExpressionCount() const
+{
+    return d->expressionQueue.size() + d->deferredExpressions.size();
+}
+
+bool Session::isWaitingForScheduler() const
+{
+    return d->waitingForScheduler;
+}
+
+bool Session::interruptScheduledExpressions()
+{
+    if (!d->waitingForScheduler)
+        return false;
+
+    //the backend is idle, there is nothing to interrupt in the backend process
+    const auto expressions = d->expressionQueue;
+    d->expressionQueue.clear();
+    for (auto* expression : expressions)
+        expression->setStatus(Cantor::Expression::Interrupted);
+
+    d->waitingForScheduler = false;
+    SessionScheduler::instance()->release(this);
+    return true;
+}
+
+void Session::addToScheduler()
+{
+    auto* scheduler = SessionScheduler::instance();
+    scheduler->addSession(this);
+    connect(scheduler, &SessionScheduler::granted, this, [this](Session* session) {
+        if (session != this || !d->waitingForScheduler)
+            return;
+
+        d->waitingForScheduler = false;
+
+        //the queued expressions were interrupted in the meantime
+        if (d->expressionQueue.isEmpty())
+        {
+            SessionScheduler::instance()->release(this);
+            return;
+        }
+
+        changeStatus(Cantor::Session::Running);
+        runFirstExpression();
+    });
+}
+
+void Session::registerProcess(QProcess* process)
+{
+    SessionScheduler::instance()->addProcess(this, process);
 }
 
 void Session::runFirstExpression()
@@ -118,11 +273,23 @@ void Session::finishFirstExpression(bool setDoneAfterUpdate)
 
     auto* finishedExpression = d->expressionQueue.takeFirst();
     const bool needsUpdateTrigger = !finishedExpression->isInternal() && !finishedExpression->isHelpRequest();
+    if (needsUpdateTrigger)
+    {
+        d->unreportedExpressions << finishedExpression;
+        d->reportingExpressions.clear();
+
+        //the expression might have changed the state without a change visible in the variable model,
+        //e.g. if the variable management is disabled or an object was modified in place
+        ++d->stateEpoch;
+        d->countFunctionDefinitions(finishedExpression->command());
+    }
 
     if (!d->expressionQueue.isEmpty())
         runFirstExpression();
     else if (d->variableModel && needsUpdateTrigger)
     {
+        d->reportingExpressions = d->unreportedExpressions;
+        d->unreportedExpressions.clear();
         d->variableModel->update();
 
         // Some variable models could update internal lists without running expressions
@@ -164,9 +331,139 @@ Cantor::Session::Status Session::status()
     return d->status;
 }
 
+Session::LoginState Session::loginState() const
+{
+    return d->loginState;
+}
+
+bool Session::isLoggingIn() const
+{
+    return d->loginState == LoginStarting || d->loginState == LoginHandshake || d->loginState == LoginInitializing;
+}
+
+void Session::setLoginState(Session::LoginState state)
+{
+    if (d->loginState == state)
+        return;
+
+    d->loginState = state;
+    Q_EMIT loginStateChanged(state);
+}
+
+void Session::startLoginProcess(QProcess* process, const QByteArray& readyMarker, const QString& startErrorMessage)
+{
+    d->clearLoginConnections();
+    d->loginProcess = process;
+    d->loginReadyMarker = readyMarker;
+    d->loginStartErrorMessage = startErrorMessage;
+    registerProcess(process);
+    setLoginState(LoginStarting);
+
+    d->loginConnections << connect(process, &QProcess::started, this, [this]() {
+        setLoginState(LoginHandshake);
+        if (d->loginReadyMarker.isEmpty())
+        {
+            d->clearLoginConnections();
+            setLoginState(LoginInitializing);
+            loginHandshakeDone(QByteArray());
+        }
+    });
+
+    if (!readyMarker.isEmpty())
+    {
+        d->loginConnections << connect(process, &QProcess::readyReadStandardOutput, this, [this]() {
+            d->loginBuffer += d->loginProcess->readAllStandardOutput();
+            const int index = d->loginBuffer.indexOf(d->loginReadyMarker);
+            if (index == -1)
+                return;
+
+            const QByteArray pendingOutput = d->loginBuffer.mid(index + d->loginReadyMarker.size());
+            d->clearLoginConnections();
+            setLoginState(LoginInitializing);
+            loginHandshakeDone(pendingOutput);
+        });
+    }
+
+    d->loginConnections << connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart)
+            return;
+
+        d->clearLoginConnections();
+        loginHandshakeFailed(d->loginStartErrorMessage);
+    });
+
+    d->loginConnections << connect(process, &QProcess::finished, this, [this]() {
+        QString message = d->loginStartErrorMessage;
+        const QString& errStd = QString::fromLocal8Bit(d->loginProcess->readAllStandardError()).trimmed();
+        if (!errStd.isEmpty())
+            message += QLatin1Char('\n') + i18n("Error: %1", errStd);
+
+        d->clearLoginConnections();
+        loginHandshakeFailed(message);
+    });
+
+    if (process->state() == QProcess::NotRunning)
+        process->start();
+}
+
+void Session::loginHandshakeDone(const QByteArray& pendingOutput)
+{
+    Q_UNUSED(pendingOutput);
+    finishLogin();
+}
+
+void Session::loginHandshakeFailed(const QString& message)
+{
+    abortLogin(message);
+}
+
+void Session::finishLogin()
+{
+    d->loginProcess = nullptr;
+    setLoginState(LoggedIn);
+    changeStatus(d->expressionQueue.isEmpty() ? Done : Running);
+    Q_EMIT loginDone();
+
+    const auto deferred = d->deferredExpressions;
+    d->deferredExpressions.clear();
+    for (const auto& expression : deferred)
+        if (expression)
+            enqueueExpression(expression);
+}
+
+void Session::abortLogin(const QString& message)
+{
+    d->clearLoginConnections();
+    d->loginProcess = nullptr;
+    setLoginState(LoggedOut);
+
+    //expressions submitted while logging in can't be evaluated anymore
+    const auto deferred = d->deferredExpressions;
+    d->deferredExpressions.clear();
+    for (const auto& expression : deferred)
+        if (expression)
+            expression->setStatus(Cantor::Expression::Interrupted);
+
+    changeStatus(Disable);
+    Q_EMIT error(message);
+    Q_EMIT loginDone();
+}
+
 void Session::changeStatus(Session::Status newStatus)
 {
+    //sessions logging in synchronously don't drive the login state machine themselves
+    if (newStatus != Disable && d->loginState == LoggedOut)
+        setLoginState(LoggedIn);
+
     d->status = newStatus;
+
+    //nothing to evaluate anymore, the next session waiting for the scheduler can run
+    if (newStatus != Running && d->expressionQueue.isEmpty())
+    {
+        d->waitingForScheduler = false;
+        SessionScheduler::instance()->release(this);
+    }
+
     Q_EMIT statusChanged(newStatus);
 }
 
@@ -219,6 +516,9 @@ void Session::updateVariables()
 {
     if (d->variableModel)
     {
+        //the changes found by an explicit update are not caused by the last evaluated expressions
+        d->reportingExpressions.clear();
+        d->unreportedExpressions.clear();
         d->variableModel->update();
         d->needUpdate = false;
     }
@@ -227,6 +527,114 @@ void Session::updateVariables()
 void Cantor::Session::setVariableModel(Cantor::DefaultVariableModel* model)
 {
     d->variableModel = model;
+    watchVariableModel();
+}
+
+void Session::watchVariableModel()
+{
+    for (const auto& connection : std::as_const(d->variableModelConnections))
+        disconnect(connection);
+    d->variableModelConnections.clear();
+    ++d->stateEpoch;
+
+    if (!d->variableModel)
+        return;
+
+    auto bumpEpoch = [this]() { ++d->stateEpoch; };
+    auto* model = d->variableModel;
+    d->variableModelConnections << connect(model, &DefaultVariableModel::variablesAdded, this, bumpEpoch);
+    d->variableModelConnections << connect(model, &DefaultVariableModel::variablesRemoved, this, bumpEpoch);
+    d->variableModelConnections << connect(model, &DefaultVariableModel::functionsAdded, this, bumpEpoch);
+    d->variableModelConnections << connect(model, &DefaultVariableModel::functionsRemoved, this, bumpEpoch);
+    d->variableModelConnections << connect(model, &QAbstractItemModel::dataChanged, this, bumpEpoch);
+    d->variableModelConnections << connect(model, &QAbstractItemModel::modelReset, this, bumpEpoch);
+
+    d->variableModelConnections << connect(model, &DefaultVariableModel::variablesAdded, this, &Session::reportVariableChanges);
+    d->variableModelConnections << connect(model, &QAbstractItemModel::dataChanged, this, [this, model](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+        QStringList names;
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+            names << model->index(row, 0).data().toString();
+        reportVariableChanges(names);
+    });
+}
+
+/*!
+ * reports the variables \c names changed by the last update of the variable model to the expression
+ * that changed them. The changes can only be attributed if a single expression of the user
+ * was evaluated since the previous update, they are not reported otherwise.
+ */
+void Session::reportVariableChanges(const QStringList& names)
+{
+    if (names.isEmpty() || d->reportingExpressions.size() != 1 || !d->reportingExpressions.first())
+        return;
+
+    Q_EMIT d->reportingExpressions.first()->variablesChanged(names);
+}
+
+void Session::setResultMemoizationEnabled(bool enable)
+{
+    d->resultMemoizationEnabled = enable;
+}
+
+bool Session::isResultMemoizationEnabled() const
+{
+    return d->resultMemoizationEnabled;
+}
+
+quint64 Session::stateEpoch() const
+{
+    return d->stateEpoch;
+}
+
+QByteArray Session::dependencyFingerprint(const QString& command) const
+{
+    //without the values of the variables a changed dependency can't be detected
+    if (!d->variableModel || !(d->backend->capabilities() & Backend::VariableManagement))
+        return QByteArray();
+
+    if (!d->variableValuesValid || d->variableValuesEpoch != d->stateEpoch)
+    {
+        d->variableValues.clear();
+        const auto& variables = d->variableModel->variables();
+        for (const auto& variable : variables)
+            d->variableValues.insert(variable.name, variable.value);
+        //a redefined function changes the results of the commands calling it
+        for (const auto& function : d->variableModel->functions())
+            d->variableValues.insert(function, QLatin1String("function:") + QString::number(d->functionRevisions.value(function)));
+        d->variableValuesEpoch = d->stateEpoch;
+        d->variableValuesValid = true;
+    }
+
+    //the model wasn't updated yet
+    if (d->variableValues.isEmpty())
+        return QByteArray();
+
+    static const QRegularExpression identifier(QStringLiteral("[A-Za-z_][A-Za-z0-9_]*"));
+
+    //collect the referenced names, sorted and without duplicates, so the fingerprint
+    //doesn't depend on the order of the references in the command
+    QStringList names;
+    auto it = identifier.globalMatch(command);
+    while (it.hasNext())
+        names << it.next().captured(0);
+    names.sort();
+    names.removeDuplicates();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(d->loginGeneration));
+    for (const auto& name : std::as_const(names))
+    {
+        const auto value = d->variableValues.constFind(name);
+        if (value == d->variableValues.constEnd())
+            continue;
+
+        hash.addData(name.toUtf8());
+        hash.addData(QByteArrayView("=", 1));
+        hash.addData(value->toUtf8());
+        hash.addData(QByteArrayView("\0", 1));
+    }
+
+    return hash.result();
 }
 
 int Session::nextExpressionId()
@@ -8,6 +8,7 @@
 
 #include <QObject>
 #include <QStandardPaths>
+#include <QByteArray>
 
 #include "cantor_export.h"
 
@@ -19,6 +20,7 @@
 class QTextEdit;
 class QSyntaxHighlighter;
 class QAbstractItemModel;
+class QProcess;
 
 /**
  * Namespace collecting all Classes of the Cantor Libraries
@@ -46,6 +48,18 @@ class CANTOR_EXPORT Session : public QObject
       Disable  ///< the session don't login yet, or already logout
     };
 
+    /**
+     * The steps of the asynchronous login protocol.
+     * @see startLoginProcess()
+     */
+    enum LoginState {
+      LoggedOut,          ///< login wasn't started yet, has failed or the session was logged out
+      LoginStarting,      ///< the backend process is being started
+      LoginHandshake,     ///< the backend process is running, waiting for it to report readiness
+      LoginInitializing,  ///< the handshake is done, the session is sending its initialization commands
+      LoggedIn            ///< the login is complete, the session accepts expressions
+    };
+
     /**
      * Create a new Session. This should not set up the complete session yet.
      * That's the job of the login() function.
@@ -109,6 +123,24 @@ class CANTOR_EXPORT Session : public QObject
      */
     void enqueueExpression(Expression*);
 
+    /**
+     * Returns the number of expressions queued in the session, including the one being evaluated.
+     */
+    int pendingExpressionCount() const;
+
+    /**
+     * Returns \c true if the queued expressions wait for the SessionScheduler because
+     * the limit of the sessions evaluating at the same time is reached.
+     */
+    bool isWaitingForScheduler() const;
+
+    /**
+     * Interrupts the expressions waiting for the SessionScheduler. The backend didn't start to evaluate them,
+     * so they are removed from the queue without calling interrupt().
+     * Returns \c false if the session doesn't wait for the scheduler.
+     */
+    bool interruptScheduledExpressions();
+
     /**
      * Interrupts all the running calculations in this session
      * After this function expression queue must be clean
@@ -193,6 +225,16 @@ class CANTOR_EXPORT Session : public QObject
      * @return the status this Session has
      */
     Cantor::Session::Status status();
+
+    /**
+     * Returns the current step of the login protocol
+     */
+    LoginState loginState() const;
+
+    /**
+     * Returns \c true if login() was called and the session didn't finish logging in yet
+     */
+    bool isLoggingIn() const;
     /**
      * Returns whether typesetting is enabled or not
      * @return whether typesetting is enabled or not
@@ -215,6 +257,35 @@ class CANTOR_EXPORT Session : public QObject
 
     KeywordsManager* keywordsManager() const;
 
+    /**
+     * Enables or disables the memoization of the results.
+     * If enabled, the worksheet doesn't resubmit commands that were already evaluated successfully
+     * as long as their text and the values of the variables they reference are unchanged,
+     * and reuses their previous results instead.
+     * The memoization is disabled by default, since commands with side effects not visible
+     * in the variable model (I/O, random numbers, etc.) are skipped too.
+     */
+    void setResultMemoizationEnabled(bool);
+    bool isResultMemoizationEnabled() const;
+
+    /**
+     * Returns the state epoch of the session. The epoch is incremented each time an expression
+     * of the user was evaluated, the variable model reports changed variables or functions and on logout.
+     */
+    quint64 stateEpoch() const;
+
+    /**
+     * Returns the fingerprint of the session state relevant for @p command, i.e. a hash over
+     * the values of all variables the command references. Commands with the same text and the same
+     * fingerprint are expected to produce the same results.
+     * The fingerprint is only meaningful if the session is idle (status Done), since the variable model
+     * is updated only after all queued expressions were evaluated.
+     * Returns an empty array if the values of the variables are not available, i.e. if the session has
+     * no variable model, the variable management is disabled or the model is still empty.
+     * An empty fingerprint never matches, the results of the command must not be reused.
+     */
+    QByteArray dependencyFingerprint(const QString& command) const;
+
 public Q_SLOTS:
     void currentExpressionStatusChanged(Cantor::Expression::Status);
 
@@ -293,13 +364,64 @@ public Q_SLOTS:
 
     void setKeywordsManager(KeywordsManager*);
 
+    /**
+     * Shows the resource usage of the backend process @p process in the statistics of the SessionScheduler
+     * and starts it with the CPU budget of the scheduler. Has to be called before the process is started,
+     * startLoginProcess() calls it already.
+     */
+    void registerProcess(QProcess* process);
+
+    /**
+     * Starts the asynchronous login to a backend process.
+     * The process has to be configured already (program, arguments, channel mode) but not started.
+     * The login state machine is driven by the signals of the process: once it was started and
+     * @p readyMarker appeared on its standard output, loginHandshakeDone() is called with the output
+     * received after the marker. If the marker is empty, the handshake is considered done as soon as
+     * the process has started. If the process fails to start or exits before the handshake,
+     * loginHandshakeFailed() is called with @p startErrorMessage.
+     * Nothing in this function blocks, so several sessions can log in concurrently.
+     */
+    void startLoginProcess(QProcess*, const QByteArray& readyMarker, const QString& startErrorMessage);
+
+    /**
+     * Called when the backend process has reported readiness. Implementations should send their
+     * initialization commands here and call finishLogin() when the session is ready, also asynchronously.
+     * Until then only internal expressions are evaluated, the expressions of the user are queued after the login.
+     * The default implementation just calls finishLogin().
+     * @param pendingOutput the output of the process received after the ready marker
+     */
+    virtual void loginHandshakeDone(const QByteArray& pendingOutput);
+
+    /**
+     * Called when the login handshake failed. Implementations should release the backend process
+     * here and call the default implementation which aborts the login with @p message.
+     */
+    virtual void loginHandshakeFailed(const QString& message);
+
+    /**
+     * Marks the login as complete, runs the expressions queued while logging in and emits loginDone()
+     */
+    void finishLogin();
+
+    /**
+     * Marks the login as failed, disables the session and emits error() and loginDone()
+     */
+    void abortLogin(const QString& message);
+
+    void setLoginState(LoginState);
+
 Q_SIGNALS:
     void statusChanged(Cantor::Session::Status);
     void loginStarted();
     void loginDone();
+    void loginStateChanged(Cantor::Session::LoginState);
     void error(const QString&);
 
   private:
+    void watchVariableModel();
+    void reportVariableChanges(const QStringList& names);
+    void addToScheduler();
+
     SessionPrivate* d;
 };
 }
@@ -0,0 +1,330 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "sessionscheduler.h"
+#include "session.h"
+#include "cantor_libs_settings.h"
+using namespace Cantor;
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+//the variables read by OpenMP, OpenBLAS, MKL, numexpr and Apple's Accelerate
+const char* const threadVariables[] = {
+    "OMP_NUM_THREADS", "OPENBLAS_NUM_THREADS", "MKL_NUM_THREADS", "NUMEXPR_NUM_THREADS", "VECLIB_MAXIMUM_THREADS"
+};
+
+/*!
+ * returns \c base with the thread variables set to \c threads, variables already set by the user are kept
+ */
+QProcessEnvironment threadEnvironment(const QProcessEnvironment& base, int threads)
+{
+    QProcessEnvironment environment = base;
+    for (const char* name : threadVariables)
+    {
+        const QString& variable = QLatin1String(name);
+        if (!environment.contains(variable))
+            environment.insert(variable, QString::number(threads));
+    }
+
+    return environment;
+}
+
+/*!
+ * reads the CPU time in clock ticks and the resident memory in bytes of the process \c pid from /proc
+ */
+bool readProcessUsage(qint64 pid, qint64* ticks, qint64* memory)
+{
+#ifdef Q_OS_LINUX
+    QFile stat(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly))
+        return false;
+
+    //the name of the process in the second field can contain spaces, the other fields follow the closing parenthesis
+    const QByteArray& content = stat.readAll();
+    const auto fields = content.mid(content.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 22)
+        return false;
+
+    //utime and stime are the fields 14 and 15, rss the field 24
+    *ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+    *memory = fields.at(21).toLongLong() * sysconf(_SC_PAGESIZE);
+    return true;
+#else
+    Q_UNUSED(pid);
+    Q_UNUSED(ticks);
+    Q_UNUSED(memory);
+    return false;
+#endif
+}
+
+}
+
+class Cantor::SessionSchedulerPrivate
+{
+  public:
+    struct Entry {
+        QPointer<Session> session;
+        QPointer<QProcess> process;
+        int threadBudget{0};
+        bool running{false};
+        qint64 lastTicks{-1};
+        qint64 lastTime{0};
+    };
+
+    Entry* find(Session* session)
+    {
+        for (auto& entry : entries)
+            if (entry.session == session)
+                return &entry;
+        return nullptr;
+    }
+
+    int runningCount() const
+    {
+        int count = 0;
+        for (const auto& entry : entries)
+            if (entry.running && entry.session)
+                ++count;
+        return count;
+    }
+
+    /*!
+     * returns the number of sessions with a backend that is logged in or whose process is running,
+     * the session \c except is not counted
+     */
+    int activeCount(Session* except = nullptr) const
+    {
+        int count = 0;
+        for (const auto& entry : entries)
+        {
+            if (!entry.session || entry.session == except)
+                continue;
+
+            if (entry.session->status() != Session::Disable || (entry.process && entry.process->state() != QProcess::NotRunning))
+                ++count;
+        }
+        return count;
+    }
+
+    int threadBudget(int maxRunningSessions, Session* session = nullptr) const
+    {
+        //not more sessions than the limit evaluate at the same time, every one of them gets the same share of the cores
+        //so that the threads of the evaluating backends don't exceed the number of cores.
+        //Without a limit only the backends already started are known, the shares can sum up to more than all cores.
+        const int parallel = (maxRunningSessions > 0) ? maxRunningSessions : activeCount(session) + 1;
+        return qMax(1, QThread::idealThreadCount() / parallel);
+    }
+
+    QVector<Entry> entries;
+    QList<QPointer<Session>> waiting;
+    QElapsedTimer clock;
+};
+
+SessionScheduler::SessionScheduler() : d(new SessionSchedulerPrivate)
+{
+    d->clock.start();
+}
+
+SessionScheduler::~SessionScheduler()
+{
+    delete d;
+}
+
+SessionScheduler* SessionScheduler::instance()
+{
+    static SessionScheduler scheduler;
+    return &scheduler;
+}
+
+void SessionScheduler::setMaxRunningSessions(int count)
+{
+    CantorLibsSettings::setMaxRunningSessions(qMax(0, count));
+    CantorLibsSettings::self()->save();
+
+    //a higher limit lets the waiting sessions run immediately
+    grantNext();
+    Q_EMIT sessionsChanged();
+}
+
+int SessionScheduler::maxRunningSessions() const
+{
+    return CantorLibsSettings::maxRunningSessions();
+}
+
+void SessionScheduler::setThreadLimitEnabled(bool enabled)
+{
+    CantorLibsSettings::setLimitBackendThreads(enabled);
+    CantorLibsSettings::self()->save();
+}
+
+bool SessionScheduler::isThreadLimitEnabled() const
+{
+    return CantorLibsSettings::limitBackendThreads();
+}
+
+int SessionScheduler::threadBudget() const
+{
+    return d->threadBudget(maxRunningSessions());
+}
+
+QProcessEnvironment SessionScheduler::processEnvironment(const QProcessEnvironment& base) const
+{
+    return threadEnvironment(base, threadBudget());
+}
+
+QVector<SessionScheduler::SessionStatistics> SessionScheduler::statistics()
+{
+#ifdef Q_OS_LINUX
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+#endif
+
+    QVector<SessionStatistics> statistics;
+    const qint64 now = d->clock.elapsed();
+    for (auto& entry : d->entries)
+    {
+        if (!entry.session)
+            continue;
+
+        SessionStatistics s;
+        s.session = entry.session;
+        s.queueDepth = entry.session->pendingExpressionCount();
+        s.threadBudget = entry.threadBudget;
+        s.running = entry.running;
+        s.waiting = d->waiting.contains(entry.session);
+
+        if (entry.process && entry.process->state() == QProcess::Running)
+        {
+            s.processId = entry.process->processId();
+            qint64 ticks = 0;
+            if (readProcessUsage(s.processId, &ticks, &s.residentMemory))
+            {
+#ifdef Q_OS_LINUX
+                if (entry.lastTicks != -1 && now > entry.lastTime)
+                    s.cpuUsage = 100. * (ticks - entry.lastTicks) / ticksPerSecond / ((now - entry.lastTime) / 1000.);
+#endif
+                entry.lastTicks = ticks;
+                entry.lastTime = now;
+            }
+        }
+
+        statistics << s;
+    }
+
+    return statistics;
+}
+
+void SessionScheduler::addSession(Session* session)
+{
+    if (d->find(session))
+        return;
+
+    SessionSchedulerPrivate::Entry entry;
+    entry.session = session;
+    d->entries << entry;
+    Q_EMIT sessionsChanged();
+}
+
+void SessionScheduler::removeSession(Session* session)
+{
+    for (int i = 0; i < d->entries.size(); ++i)
+    {
+        //the entries of deleted sessions are removed too
+        if (d->entries.at(i).session == session || !d->entries.at(i).session)
+            d->entries.remove(i--);
+    }
+
+    d->waiting.removeAll(session);
+    grantNext();
+    Q_EMIT sessionsChanged();
+}
+
+void SessionScheduler::addProcess(Session* session, QProcess* process)
+{
+    auto* entry = d->find(session);
+    if (!entry)
+        return;
+
+    entry->process = process;
+    entry->lastTicks = -1;
+    entry->threadBudget = 0;
+
+    //the threads of the numerical libraries are created with the process, the limit can't be changed later
+    if (isThreadLimitEnabled() && process->state() == QProcess::NotRunning)
+    {
+        const auto& base = process->processEnvironment().isEmpty() ? QProcessEnvironment::systemEnvironment() : process->processEnvironment();
+        entry->threadBudget = d->threadBudget(maxRunningSessions(), session);
+        process->setProcessEnvironment(threadEnvironment(base, entry->threadBudget));
+        qDebug() << "starting the backend process with" << entry->threadBudget << "threads";
+    }
+
+    Q_EMIT sessionsChanged();
+}
+
+bool SessionScheduler::acquire(Session* session)
+{
+    auto* entry = d->find(session);
+    if (!entry || entry->running)
+        return true;
+
+    if (maxRunningSessions() == 0 || d->runningCount() < maxRunningSessions())
+    {
+        entry->running = true;
+        Q_EMIT sessionsChanged();
+        return true;
+    }
+
+    if (!d->waiting.contains(session))
+        d->waiting << session;
+
+    qDebug() << "session queued," << d->runningCount() << "sessions are running";
+    Q_EMIT sessionsChanged();
+    return false;
+}
+
+void SessionScheduler::release(Session* session)
+{
+    auto* entry = d->find(session);
+    if (!entry)
+        return;
+
+    const bool wasWaiting = d->waiting.removeAll(session) > 0;
+    if (!entry->running && !wasWaiting)
+        return;
+
+    entry->running = false;
+    grantNext();
+    Q_EMIT sessionsChanged();
+}
+
+/*!
+ * lets the waiting sessions run as long as the limit of the running sessions is not reached.
+ * The sessions are started from the event loop and not from within the session that was just released.
+ */
+void SessionScheduler::grantNext()
+{
+    while (!d->waiting.isEmpty() && (maxRunningSessions() == 0 || d->runningCount() < maxRunningSessions()))
+    {
+        QPointer<Session> session = d->waiting.takeFirst();
+        auto* entry = d->find(session);
+        if (!session || !entry)
+            continue;
+
+        entry->running = true;
+        QMetaObject::invokeMethod(this, [this, session]() {
+            if (session)
+                Q_EMIT granted(session);
+        }, Qt::QueuedConnection);
+    }
+}
@@ -0,0 +1,132 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef _SESSIONSCHEDULER_H
+#define _SESSIONSCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QProcessEnvironment>
+#include <QVector>
+
+#include "cantor_export.h"
+
+class QProcess;
+
+namespace Cantor
+{
+class Session;
+class SessionSchedulerPrivate;
+
+/**
+ * Coordinates the sessions of all worksheets of the application.
+ *
+ * Every session evaluates its expressions one after another, but the sessions of different worksheets run in parallel
+ * and the numerical libraries of every backend (BLAS, OpenMP, etc.) start as many threads as there are cores.
+ * The scheduler limits the number of sessions evaluating at the same time, the expressions of further sessions
+ * are queued until one of the running sessions is done. The backend processes are started with a CPU budget,
+ * the thread variables of the common numerical libraries are set to the number of cores divided by the limit
+ * of the sessions evaluating at the same time, so the threads of the evaluating backends don't exceed the cores.
+ * The limit is two sessions by default. Without a limit the cores are divided by the number of backends already
+ * started plus the new one, idle sessions that are not logged in are not counted; the budgets of the backends
+ * started one after another can then sum up to more than the number of cores.
+ *
+ * The sessions register themselves, the scheduler is configured by the application.
+ */
+class CANTOR_EXPORT SessionScheduler : public QObject
+{
+  Q_OBJECT
+  public:
+    /**
+     * Resource usage of a session, see statistics()
+     */
+    struct SessionStatistics {
+        QPointer<Session> session;
+        qint64 processId{0};      ///< 0 if the backend doesn't run in a separate process
+        double cpuUsage{-1.};     ///< in percent of one core since the previous call of statistics(), -1 if unknown
+        qint64 residentMemory{-1};///< resident memory of the backend process in bytes, -1 if unknown
+        int queueDepth{0};        ///< number of expressions in the queue of the session
+        int threadBudget{0};      ///< number of threads the backend process was started with, 0 if not limited
+        bool running{false};      ///< the session is evaluating
+        bool waiting{false};      ///< the session waits for another session to finish
+    };
+
+    ~SessionScheduler() override;
+
+    static SessionScheduler* instance();
+
+    /**
+     * Sets the number of sessions evaluating expressions at the same time, 0 for no limit.
+     * The value is stored in the settings.
+     */
+    void setMaxRunningSessions(int);
+    int maxRunningSessions() const;
+
+    /**
+     * Enables the limit of the threads of the backend processes started from now on.
+     * The value is stored in the settings.
+     */
+    void setThreadLimitEnabled(bool);
+    bool isThreadLimitEnabled() const;
+
+    /**
+     * Returns the number of threads of a backend process started now for a session not logged in yet
+     */
+    int threadBudget() const;
+
+    /**
+     * Returns the environment for a backend process with the thread variables set to threadBudget(),
+     * variables already set by the user are not changed.
+     */
+    QProcessEnvironment processEnvironment(const QProcessEnvironment& base = QProcessEnvironment::systemEnvironment()) const;
+
+    /**
+     * Returns the resource usage of all sessions, the CPU and memory usage is only available on Linux.
+     */
+    QVector<SessionStatistics> statistics();
+
+    //the following functions are called by the sessions
+    void addSession(Session*);
+    void removeSession(Session*);
+
+    /**
+     * Applies the CPU budget to the process @p process of the session @p session, if it's not started yet,
+     * and shows its resource usage in the statistics
+     */
+    void addProcess(Session* session, QProcess* process);
+
+    /**
+     * Returns \c true if @p session can evaluate its expressions now. Otherwise the session is queued
+     * and granted() is emitted once it can run.
+     */
+    bool acquire(Session*);
+
+    /**
+     * @p session is done with its expressions, the next waiting session can run
+     */
+    void release(Session*);
+
+  Q_SIGNALS:
+    /**
+     * The waiting session @p session can evaluate its expressions now
+     */
+    void granted(Cantor::Session* session);
+
+    /**
+     * A session was added, removed, started or finished the evaluation
+     */
+    void sessionsChanged();
+
+  private:
+    SessionScheduler();
+    Q_DISABLE_COPY(SessionScheduler)
+
+    void grantNext();
+
+    SessionSchedulerPrivate* d;
+};
+
+}
+#endif /* _SESSIONSCHEDULER_H */
@@ -7,18 +7,25 @@
 #include "textresult.h"
 using namespace Cantor;
 
+#include <algorithm>
+
 #include <QFile>
+#include <QVector>
 #include <QTextStream>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QStringDecoder>
+#include <QUuid>
+
+#include <KZip>
 
 QString rtrim(const QString& s)
 {
-    QString result = s;
-    while (result.count() > 0 && result[result.count()-1].isSpace() )
-        result = result.left(result.count() -1 );
+    qsizetype end = s.size();
+    while (end > 0 && s.at(end - 1).isSpace())
+        --end;
 
-    return result;
+    return s.left(end);
 }
 
 class Cantor::TextResultPrivate
@@ -29,6 +36,102 @@ public:
     TextResult::Format format{TextResult::PlainTextFormat};
     bool isStderr{false};
     bool isWarning{false};
+
+    //start offsets of the lines in plain, built on demand
+    QVector<qsizetype> lineStarts;
+
+    //the omitted middle part of a truncated output
+    QString omittedFileName;
+    QString archiveFileName;
+    qsizetype headLength{0};
+    qsizetype noteLength{0};
+
+    //the complete output of a truncated result is paged in from the file once it's requested,
+    //the line starts are byte offsets in the UTF-8 encoded head, omitted part and tail
+    bool omittedOutputLoaded{false};
+    QByteArray head;
+    QByteArray tail;
+    qint64 omittedSize{0};
+    QVector<qint64> fullLineStarts;
+
+    qint64 fullSize() const
+    {
+        return head.size() + omittedSize + tail.size();
+    }
+
+    void buildFullLineIndex()
+    {
+        if (!fullLineStarts.isEmpty())
+            return;
+
+        fullLineStarts.append(0);
+        auto addLines = [this](const QByteArray& bytes, qint64 offset) {
+            qsizetype index = bytes.indexOf('\n');
+            while (index != -1)
+            {
+                fullLineStarts.append(offset + index + 1);
+                index = bytes.indexOf('\n', index + 1);
+            }
+        };
+
+        addLines(head, 0);
+
+        QFile file(omittedFileName);
+        omittedSize = 0;
+        if (file.open(QIODevice::ReadOnly))
+        {
+            while (!file.atEnd())
+            {
+                const QByteArray& chunk = file.read(1024 * 1024);
+                addLines(chunk, head.size() + omittedSize);
+                omittedSize += chunk.size();
+            }
+        }
+
+        addLines(tail, head.size() + omittedSize);
+    }
+
+    //returns the bytes [start, end) of the complete output
+    QByteArray readFull(qint64 start, qint64 end) const
+    {
+        QByteArray bytes;
+        bytes.reserve(end - start);
+
+        const qint64 headEnd = head.size();
+        const qint64 tailStart = headEnd + omittedSize;
+        if (start < headEnd)
+            bytes += head.mid(start, std::min(end, headEnd) - start);
+
+        if (start < tailStart && end > headEnd)
+        {
+            const qint64 from = std::max(start, headEnd);
+            QFile file(omittedFileName);
+            if (file.open(QIODevice::ReadOnly) && file.seek(from - headEnd))
+                bytes += file.read(std::min(end, tailStart) - from);
+        }
+
+        if (end > tailStart)
+        {
+            const qint64 from = std::max(start, tailStart);
+            bytes += tail.mid(from - tailStart, end - from);
+        }
+
+        return bytes;
+    }
+
+    void buildLineIndex()
+    {
+        if (!lineStarts.isEmpty())
+            return;
+
+        lineStarts.append(0);
+        qsizetype index = plain.indexOf(QLatin1Char('\n'));
+        while (index != -1)
+        {
+            lineStarts.append(index + 1);
+            index = plain.indexOf(QLatin1Char('\n'), index + 1);
+        }
+    }
 };
 
 TextResult::TextResult(const QString& data) : d(new TextResultPrivate)
@@ -40,14 +143,64 @@ TextResult::TextResult(const QString& data) : d(new TextResultPrivate)
 TextResult::TextResult(const QString& data, const QString& plain) : d(new TextResultPrivate)
 {
     d->data = rtrim(data);
-    d->plain = rtrim(plain);
+
+    //share the text if both representations are the same
+    const QString& trimmedPlain = rtrim(plain);
+    d->plain = (trimmedPlain == d->data) ? d->data : trimmedPlain;
 }
 
 TextResult::~TextResult()
 {
+    if (!d->omittedFileName.isEmpty())
+        QFile::remove(d->omittedFileName);
     delete d;
 }
 
+void TextResult::setOmittedOutput(const QString& fileName, qsizetype headLength, qsizetype noteLength)
+{
+    d->omittedFileName = fileName;
+    d->archiveFileName = QLatin1String("output-") + QUuid::createUuid().toString(QUuid::WithoutBraces) + QLatin1String(".txt");
+    d->headLength = headLength;
+    d->noteLength = noteLength;
+}
+
+bool TextResult::isTruncated() const
+{
+    return !d->omittedFileName.isEmpty();
+}
+
+QString TextResult::fullText()
+{
+    if (!isTruncated())
+        return d->data;
+
+    QFile file(d->omittedFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return d->data;
+
+    return d->data.left(d->headLength) + QString::fromUtf8(file.readAll()) + d->data.mid(d->headLength + d->noteLength);
+}
+
+/*!
+ * switches the line access via lineCount(), lines() and findLine() to the complete output.
+ * The omitted part stays in the file and only the requested lines are read from it.
+ */
+void TextResult::loadOmittedOutput()
+{
+    if (!isTruncated() || d->omittedOutputLoaded)
+        return;
+
+    d->head = QStringView(d->data).left(d->headLength).toUtf8();
+    d->tail = QStringView(d->data).mid(d->headLength + d->noteLength).toUtf8();
+    d->fullLineStarts.clear();
+    d->omittedOutputLoaded = true;
+}
+
+bool TextResult::isOmittedOutputLoaded() const
+{
+    return d->omittedOutputLoaded;
+}
+
 void TextResult::setIsWarning(bool value)
 {
     d->isWarning = value;
@@ -60,9 +213,35 @@ bool TextResult::isWarning() const
 
 QString TextResult::toHtml()
 {
-    QString s = d->data.toHtmlEscaped();
-    s.replace(QLatin1Char('\n'), QLatin1String("<br/>\n"));
-    s.replace(QLatin1Char(' '), QLatin1String("&nbsp;"));
+    //escape the text, the line breaks and the spaces in one pass
+    QString s;
+    s.reserve(d->data.size() + d->data.size() / 8);
+    for (const QChar c : std::as_const(d->data))
+    {
+        switch (c.unicode())
+        {
+        case '<':
+            s += QLatin1String("&lt;");
+            break;
+        case '>':
+            s += QLatin1String("&gt;");
+            break;
+        case '&':
+            s += QLatin1String("&amp;");
+            break;
+        case '"':
+            s += QLatin1String("&quot;");
+            break;
+        case '\n':
+            s += QLatin1String("<br/>\n");
+            break;
+        case ' ':
+            s += QLatin1String("&nbsp;");
+            break;
+        default:
+            s += c;
+        }
+    }
     return s;
 }
 
@@ -76,6 +255,77 @@ QString TextResult::plain()
     return d->plain;
 }
 
+int TextResult::lineCount()
+{
+    if (d->omittedOutputLoaded)
+    {
+        d->buildFullLineIndex();
+        return d->fullLineStarts.size();
+    }
+
+    d->buildLineIndex();
+    return d->lineStarts.size();
+}
+
+QString TextResult::lines(int first, int count)
+{
+    if (d->omittedOutputLoaded)
+    {
+        d->buildFullLineIndex();
+        const int size = d->fullLineStarts.size();
+        if (first < 0 || first >= size || count <= 0)
+            return QString();
+
+        const int last = std::min(first + count, size);
+        const qint64 start = d->fullLineStarts.at(first);
+        const qint64 end = (last == size) ? d->fullSize() : d->fullLineStarts.at(last) - 1;
+        return QString::fromUtf8(d->readFull(start, end));
+    }
+
+    d->buildLineIndex();
+    const int size = d->lineStarts.size();
+    if (first < 0 || first >= size || count <= 0)
+        return QString();
+
+    const int last = std::min(first + count, size);
+    const qsizetype start = d->lineStarts.at(first);
+    const qsizetype end = (last == size) ? d->plain.size() : d->lineStarts.at(last) - 1;
+    return d->plain.mid(start, end - start);
+}
+
+int TextResult::findLine(const QString& pattern, int from, Qt::CaseSensitivity cs)
+{
+    if (d->omittedOutputLoaded)
+    {
+        //search the complete output page by page
+        const int size = lineCount();
+        if (from < 0 || pattern.isEmpty())
+            return -1;
+
+        const int pageLineCount = 1000;
+        for (int first = from; first < size; first += pageLineCount)
+        {
+            const QString& page = lines(first, pageLineCount);
+            const qsizetype index = page.indexOf(pattern, 0, cs);
+            if (index != -1)
+                return first + static_cast<int>(QStringView(page).left(index).count(QLatin1Char('\n')));
+        }
+
+        return -1;
+    }
+
+    d->buildLineIndex();
+    if (from < 0 || from >= d->lineStarts.size() || pattern.isEmpty())
+        return -1;
+
+    const qsizetype index = d->plain.indexOf(pattern, d->lineStarts.at(from), cs);
+    if (index == -1)
+        return -1;
+
+    const auto it = std::upper_bound(d->lineStarts.cbegin(), d->lineStarts.cend(), index);
+    return static_cast<int>(it - d->lineStarts.cbegin()) - 1;
+}
+
 int TextResult::type()
 {
     return TextResult::Type;
@@ -114,7 +364,11 @@ QDomElement TextResult::toXml(QDomDocument& doc)
     if (d->format == LatexFormat)
         e.setAttribute(QStringLiteral("format"), QStringLiteral("latex"));
 
-    QDomText txt = doc.createTextNode(data().toString());
+    //the complete output of a truncated result is saved as a separate file in the archive
+    if (isTruncated())
+        e.setAttribute(QStringLiteral("filename"), d->archiveFileName);
+
+    QDomText txt = doc.createTextNode(d->data);
     e.appendChild(txt);
 
     return e;
@@ -124,6 +378,9 @@ QJsonValue Cantor::TextResult::toJupyterJson()
 {
     QJsonObject root;
 
+    //the notebook has no place for the omitted output, the complete text is exported
+    const QString& text = fullText();
+
     switch (d->format)
     {
         case PlainTextFormat:
@@ -134,7 +391,7 @@ QJsonValue Cantor::TextResult::toJupyterJson()
                 root.insert(QLatin1String("execution_count"), executionIndex());
 
                 QJsonObject data;
-                data.insert(QLatin1String("text/plain"), jupyterText(d->data));
+                data.insert(QLatin1String("text/plain"), jupyterText(text));
                 root.insert(QLatin1String("data"), data);
 
                 root.insert(QLatin1String("metadata"), jupyterMetadata());
@@ -150,7 +407,7 @@ QJsonValue Cantor::TextResult::toJupyterJson()
                 // Jupyter don't support a few text result (it merges them into one text),
                 // so add additional \n to end
                 // See https://github.com/jupyter/notebook/issues/4699
-                root.insert(QLatin1String("text"), jupyterText(d->data, true));
+                root.insert(QLatin1String("text"), jupyterText(text, true));
             }
             break;
         }
@@ -178,6 +435,33 @@ QJsonValue Cantor::TextResult::toJupyterJson()
     return root;
 }
 
+void TextResult::saveAdditionalData(KZip* archive)
+{
+    if (!isTruncated())
+        return;
+
+    QFile omitted(d->omittedFileName);
+    if (!omitted.open(QIODevice::ReadOnly))
+        return;
+
+    //stream the omitted part into the archive without loading it into the memory
+    const QByteArray& head = QStringView(d->data).left(d->headLength).toUtf8();
+    const QByteArray& tail = QStringView(d->data).mid(d->headLength + d->noteLength).toUtf8();
+    const qint64 size = head.size() + omitted.size() + tail.size();
+
+    if (!archive->prepareWriting(d->archiveFileName, QString(), QString(), size))
+        return;
+
+    archive->writeData(head.constData(), head.size());
+    while (!omitted.atEnd())
+    {
+        const QByteArray& chunk = omitted.read(1024 * 1024);
+        archive->writeData(chunk.constData(), chunk.size());
+    }
+    archive->writeData(tail.constData(), tail.size());
+    archive->finishWriting(size);
+}
+
 void TextResult::save(const QString& filename)
 {
     QFile file(filename);
@@ -187,6 +471,21 @@ void TextResult::save(const QString& filename)
 
     QTextStream stream(&file);
 
+    if (isTruncated())
+    {
+        QFile omitted(d->omittedFileName);
+        if (omitted.open(QIODevice::ReadOnly))
+        {
+            QStringDecoder decoder(QStringDecoder::Utf8);
+            stream << QStringView(d->data).left(d->headLength);
+            while (!omitted.atEnd())
+                stream << QString(decoder.decode(omitted.read(1024 * 1024)));
+            stream << QStringView(d->data).mid(d->headLength + d->noteLength);
+            file.close();
+            return;
+        }
+    }
+
     stream<<d->data;
 
     file.close();
@@ -33,6 +33,24 @@ class CANTOR_EXPORT TextResult : public Result
 
     QString plain();
 
+    /**
+     * Returns the number of lines in the plain text representation.
+     * The line index is built once on the first access, the text is not copied.
+     */
+    int lineCount();
+
+    /**
+     * Returns @p count lines of the plain text representation starting at line @p first,
+     * separated by newlines.
+     */
+    QString lines(int first, int count);
+
+    /**
+     * Returns the index of the first line starting from line @p from that contains @p pattern,
+     * or -1 if there is no such line.
+     */
+    int findLine(const QString& pattern, int from = 0, Qt::CaseSensitivity cs = Qt::CaseInsensitive);
+
     int type() override;
     QString mimeType() override;
 
@@ -44,9 +62,32 @@ class CANTOR_EXPORT TextResult : public Result
 
     QDomElement toXml(QDomDocument& doc) override;
     QJsonValue toJupyterJson() override;
+    void saveAdditionalData(KZip* archive) override;
 
     void save(const QString& filename) override;
 
+    /**
+     * Marks the result as truncated. The text of the result consists of the head of the output,
+     * a note about the omitted part of the length @p noteLength and the tail of the output.
+     * The omitted part is stored in the UTF-8 encoded file @p fileName that is removed together with the result.
+     * @see OutputCapture
+     */
+    void setOmittedOutput(const QString& fileName, qsizetype headLength, qsizetype noteLength);
+    bool isTruncated() const;
+
+    /**
+     * Returns the complete output including the omitted part.
+     * The omitted part is read completely, use lines() to access the output page by page.
+     */
+    QString fullText();
+
+    /**
+     * Makes lineCount(), lines() and findLine() operate on the complete output of a truncated result.
+     * The omitted part is not loaded into the memory, the requested lines are read from the file.
+     */
+    void loadOmittedOutput();
+    bool isOmittedOutputLoaded() const;
+
   private:
     QJsonArray jupyterText(const QString& text, bool addEndNewLine = false);
 
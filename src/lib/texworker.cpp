@@ -0,0 +1,333 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "texworker.h"
+#include "latexrenderer.h"
+#include "renderer.h"
+using namespace Cantor;
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <QThreadStorage>
+
+namespace {
+
+struct FormatCache
+{
+    QMutex mutex;
+    QMutex buildMutex; //only one format is compiled at a time
+    QHash<QByteArray, QString> names; //empty name if the format couldn't be created
+    QSet<QByteArray> pending;
+    bool cleanupRegistered{false};
+};
+
+FormatCache& formatCache()
+{
+    static FormatCache cache;
+    return cache;
+}
+
+QString tempDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+}
+
+void removeFormats()
+{
+    auto& cache = formatCache();
+    QMutexLocker locker(&cache.mutex);
+    for (const auto& name : std::as_const(cache.names))
+        if (!name.isEmpty())
+            QFile::remove(tempDir() + QDir::separator() + name + QLatin1String(".fmt"));
+}
+
+void removeJobFiles(const QString& uuid, bool removePdf)
+{
+    const QString& pathWithoutExtension = tempDir() + QDir::separator() + QLatin1String("cantor_") + uuid;
+    QFile::remove(pathWithoutExtension + QLatin1String(".log"));
+    QFile::remove(pathWithoutExtension + QLatin1String(".aux"));
+    if (removePdf)
+    {
+        Renderer::releasePdf(pathWithoutExtension + QLatin1String(".pdf"));
+        QFile::remove(pathWithoutExtension + QLatin1String(".pdf"));
+    }
+}
+
+}
+
+TexWorker::~TexWorker()
+{
+    stopStandby();
+}
+
+TexWorker* TexWorker::instance()
+{
+    static QThreadStorage<TexWorker*> workers;
+    if (!workers.hasLocalData())
+        workers.setLocalData(new TexWorker);
+
+    return workers.localData();
+}
+
+bool TexWorker::typeset(const QString& tex, QString* uuid, QString* output, const std::function<bool()>& isCanceled, int timeout)
+{
+    const QString& pdflatex = QStandardPaths::findExecutable(QLatin1String("pdflatex"));
+    if (pdflatex.isEmpty())
+    {
+        *output = QStringLiteral("failed to find pdflatex executable");
+        return false;
+    }
+
+    QString preamble;
+    QString body;
+    QString formatName;
+    if (splitDocument(tex, &preamble, &body))
+        formatName = format(preamble);
+
+    QTemporaryFile texFile(tempDir() + QDir::separator() + QLatin1String("cantor_tex-XXXXXX.tex"));
+    QScopedPointer<QProcess> process;
+    if (!formatName.isEmpty())
+    {
+        //the waiting process has the format loaded already, it only needs the body of the document
+        if (m_standby && m_standbyFormat == formatName && m_standby->state() == QProcess::Running)
+        {
+            process.reset(m_standby);
+            m_standby = nullptr;
+            *uuid = m_standbyUuid;
+        }
+        else
+        {
+            stopStandby();
+            *uuid = LatexRenderer::genUuid();
+            process.reset(startProcess(formatName, *uuid));
+            process->waitForStarted();
+        }
+
+        process->write(body.toUtf8() + '\n');
+        process->closeWriteChannel();
+
+        //the next document is typeset by a new process, it loads the format while this one is running
+        m_standbyUuid = LatexRenderer::genUuid();
+        m_standbyFormat = formatName;
+        m_standby = startProcess(formatName, m_standbyUuid);
+    }
+    else
+    {
+        if (!texFile.open())
+        {
+            *output = QStringLiteral("Failed to create the temporary file for LaTeX.");
+            return false;
+        }
+
+        texFile.write(tex.toUtf8());
+        texFile.flush();
+
+        *uuid = LatexRenderer::genUuid();
+        process.reset(new QProcess);
+        process->setWorkingDirectory(tempDir());
+        process->setProgram(pdflatex);
+        process->setArguments({QStringLiteral("-jobname=cantor_") + *uuid, QStringLiteral("-halt-on-error"), texFile.fileName()});
+        process->start();
+    }
+
+    bool finished = process->waitForStarted();
+    if (finished)
+    {
+        const QDeadlineTimer deadline(timeout);
+        finished = false;
+        while (!finished && !(isCanceled && isCanceled()) && !deadline.hasExpired())
+            finished = process->waitForFinished(100) || process->state() == QProcess::NotRunning;
+    }
+
+    if (!finished)
+    {
+        process->kill();
+        process->waitForFinished();
+        removeJobFiles(*uuid, true);
+    }
+
+    *output = QString::fromUtf8(process->readAllStandardOutput());
+    const bool success = finished && process->exitStatus() == QProcess::NormalExit && process->exitCode() == 0;
+
+    if (!success && finished && !formatName.isEmpty() && !hasTexErrors(*output))
+    {
+        qDebug() << "the format" << formatName << "can't be used, typesetting the complete document";
+        removeJobFiles(*uuid, true);
+        discardFormat(formatName);
+        stopStandby();
+        return typeset(tex, uuid, output, isCanceled, timeout);
+    }
+
+    if (!success)
+        texFile.setAutoRemove(false); //Useful for debug
+
+    return success;
+}
+
+QProcess* TexWorker::startProcess(const QString& format, const QString& uuid) const
+{
+    auto* process = new QProcess;
+    process->setWorkingDirectory(tempDir());
+    process->setProgram(QStandardPaths::findExecutable(QLatin1String("pdflatex")));
+
+    //without an input file pdflatex loads the format and waits for the document on the standard input
+    process->setArguments({QStringLiteral("-fmt=") + format, QStringLiteral("-jobname=cantor_") + uuid, QStringLiteral("-halt-on-error")});
+    process->start();
+    return process;
+}
+
+void TexWorker::stopStandby()
+{
+    if (!m_standby)
+        return;
+
+    m_standby->kill();
+    m_standby->waitForFinished();
+    delete m_standby;
+    m_standby = nullptr;
+    removeJobFiles(m_standbyUuid, true);
+}
+
+QString TexWorker::format(const QString& preamble, bool wait)
+{
+    auto& cache = formatCache();
+    const QByteArray& key = QCryptographicHash::hash(preamble.toUtf8(), QCryptographicHash::Sha1);
+
+    {
+        QMutexLocker locker(&cache.mutex);
+        const auto it = cache.names.constFind(key);
+        if (it != cache.names.constEnd())
+            return it.value();
+
+        if (!wait)
+        {
+            if (!cache.pending.contains(key))
+            {
+                cache.pending.insert(key);
+                QThreadPool::globalInstance()->start([preamble]() { format(preamble); });
+            }
+            return QString();
+        }
+    }
+
+    QMutexLocker buildLocker(&cache.buildMutex);
+
+    //the format could have been created while this thread was waiting
+    {
+        QMutexLocker locker(&cache.mutex);
+        const auto it = cache.names.constFind(key);
+        if (it != cache.names.constEnd())
+            return it.value();
+    }
+
+    const QString& name = buildFormat(preamble);
+
+    QMutexLocker locker(&cache.mutex);
+    cache.names.insert(key, name);
+    cache.pending.remove(key);
+    if (!name.isEmpty() && !cache.cleanupRegistered)
+    {
+        cache.cleanupRegistered = true;
+        qAddPostRoutine(removeFormats);
+    }
+
+    return name;
+}
+
+void TexWorker::discardFormat(const QString& name)
+{
+    auto& cache = formatCache();
+    QMutexLocker locker(&cache.mutex);
+    for (auto it = cache.names.begin(); it != cache.names.end(); ++it)
+    {
+        if (it.value() != name)
+            continue;
+
+        it.value().clear();
+        QFile::remove(tempDir() + QDir::separator() + name + QLatin1String(".fmt"));
+    }
+}
+
+/*!
+ * compiles the preamble \c preamble into a new format file in the temporary directory
+ * and returns its name, an empty string if pdflatex failed.
+ */
+QString TexWorker::buildFormat(const QString& preamble)
+{
+    const QString& pdflatex = QStandardPaths::findExecutable(QLatin1String("pdflatex"));
+    if (pdflatex.isEmpty())
+        return QString();
+
+    //the format is only valid for the running pdflatex, every instance of Cantor creates its own one
+    const QByteArray& hash = QCryptographicHash::hash(preamble.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    const QString& name = QStringLiteral("cantor_fmt_%1_%2").arg(QString::fromLatin1(hash)).arg(QCoreApplication::applicationPid());
+    const QString& pathWithoutExtension = tempDir() + QDir::separator() + name;
+
+    QFile texFile(pathWithoutExtension + QLatin1String(".tex"));
+    if (!texFile.open(QIODevice::WriteOnly))
+        return QString();
+
+    texFile.write(preamble.toUtf8());
+    texFile.write("\n\\dump\n");
+    texFile.close();
+
+    QProcess p;
+    p.setWorkingDirectory(tempDir());
+    p.setProgram(pdflatex);
+    p.setArguments({QStringLiteral("-ini"), QStringLiteral("-halt-on-error"), QStringLiteral("-interaction=nonstopmode"),
+                    QStringLiteral("-jobname=") + name, QStringLiteral("&pdflatex"), texFile.fileName()});
+    p.start();
+
+    const bool finished = p.waitForFinished(60000);
+    if (!finished)
+    {
+        p.kill();
+        p.waitForFinished();
+    }
+
+    texFile.remove();
+    QFile::remove(pathWithoutExtension + QLatin1String(".log"));
+
+    const QString& formatFileName = pathWithoutExtension + QLatin1String(".fmt");
+    if (!finished || p.exitCode() != 0 || !QFile::exists(formatFileName))
+    {
+        qDebug() << "failed to create the format" << name << QString::fromUtf8(p.readAllStandardOutput());
+        QFile::remove(formatFileName);
+        return QString();
+    }
+
+    return name;
+}
+
+bool TexWorker::splitDocument(const QString& tex, QString* preamble, QString* body)
+{
+    const int index = tex.indexOf(QLatin1String("\\begin{document}"));
+    if (index == -1)
+        return false;
+
+    *preamble = tex.left(index);
+    *body = tex.mid(index);
+    return true;
+}
+
+bool TexWorker::hasTexErrors(const QString& output)
+{
+    //TeX starts the lines of its error messages with "! "
+    static const QRegularExpression errorRegex(QStringLiteral("^! "), QRegularExpression::MultilineOption);
+    return errorRegex.match(output).hasMatch();
+}
@@ -0,0 +1,82 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef _TEXWORKER_H
+#define _TEXWORKER_H
+
+#include <QString>
+
+#include <functional>
+
+#include "cantor_export.h"
+
+class QProcess;
+
+namespace Cantor{
+
+/**
+ * Typesets LaTeX documents with pdflatex without loading the preamble for every document.
+ *
+ * The preamble of a document, everything in front of \\begin{document}, is compiled once into a format file.
+ * The worker of a thread keeps a pdflatex process with this format already loaded waiting for the next document,
+ * typesetting a formula then only takes the time needed for the body of the document.
+ * If the format can't be created or loaded the documents are typeset with a new pdflatex process as before.
+ */
+class CANTOR_EXPORT TexWorker
+{
+  public:
+    ~TexWorker();
+
+    /**
+     * returns the worker of the calling thread, it's deleted together with the thread.
+     */
+    static TexWorker* instance();
+
+    /**
+     * Typesets the document @p tex into the file cantor_<uuid>.pdf in the temporary directory.
+     * @p uuid is set to the id of the job and @p output to the output of pdflatex.
+     * @p isCanceled is polled while pdflatex is running, the process is stopped if it returns true.
+     * Returns false if the document couldn't be typeset, the typesetting timed out or was canceled.
+     */
+    bool typeset(const QString& tex, QString* uuid, QString* output, const std::function<bool()>& isCanceled = nullptr, int timeout = 30000);
+
+    /**
+     * Returns the name of the format in the temporary directory with the preamble @p preamble compiled into it,
+     * or an empty string if the format can't be created. If @p wait is false, the format is created in the background
+     * and an empty string is returned until it's available.
+     */
+    static QString format(const QString& preamble, bool wait = true);
+
+    /**
+     * Don't use the format @p name anymore, e.g. because it can't be loaded by pdflatex.
+     */
+    static void discardFormat(const QString& name);
+
+    /**
+     * Splits the document @p tex into the preamble and the body starting with \\begin{document}.
+     */
+    static bool splitDocument(const QString& tex, QString* preamble, QString* body);
+
+    /**
+     * returns \c true if the output @p output of pdflatex contains errors in the document,
+     * \c false if pdflatex failed for other reasons, e.g. because the format couldn't be loaded.
+     */
+    static bool hasTexErrors(const QString& output);
+
+  private:
+    TexWorker() = default;
+    Q_DISABLE_COPY(TexWorker)
+
+    QProcess* startProcess(const QString& format, const QString& uuid) const;
+    void stopStandby();
+    static QString buildFormat(const QString& preamble);
+
+    QProcess* m_standby{nullptr};
+    QString m_standbyFormat;
+    QString m_standbyUuid;
+};
+
+}
+#endif /* _TEXWORKER_H */
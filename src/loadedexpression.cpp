@@ -14,6 +14,7 @@
 #include "lib/mimeresult.h"
 #include "lib/htmlresult.h"
 #include "lib/pdfresult.h"
+#include "lib/outputcapture.h"
 
 #include <QDir>
 #include <QStandardPaths>
@@ -24,6 +25,9 @@
 #include <QPixmap>
 #include <QRegularExpression>
 #include <QTemporaryFile>
+#include <QStringDecoder>
+
+#include <memory>
 
 LoadedExpression::LoadedExpression( Cantor::Session* session ) : Cantor::Expression( session, false, -1)
 {
@@ -90,7 +94,24 @@ void LoadedExpression::loadFromXml(const QDomElement& xml, const KZip& file)
         {
             const QString& format = resultElement.attribute(QLatin1String("format"));
             bool isStderr = resultElement.attribute(QLatin1String("stderr")).toInt();
-            Cantor::TextResult* result = new Cantor::TextResult(resultElement.text());
+            Cantor::TextResult* result = nullptr;
+
+            //the complete output of a truncated result is stored in a separate file,
+            //read it through a capture so only its head and tail are kept in memory again
+            const QString& filename = resultElement.attribute(QLatin1String("filename"));
+            const KArchiveEntry* outputEntry = filename.isEmpty() ? nullptr : file.directory()->entry(filename);
+            if (outputEntry && outputEntry->isFile())
+            {
+                std::unique_ptr<QIODevice> device(static_cast<const KArchiveFile*>(outputEntry)->createDevice());
+                Cantor::OutputCapture capture;
+                QStringDecoder decoder(QStringDecoder::Utf8);
+                while (device && !device->atEnd())
+                    capture.append(decoder.decode(device->read(1024 * 1024)));
+                result = capture.createResult();
+            }
+            else
+                result = new Cantor::TextResult(resultElement.text());
+
             if (format == QLatin1String("latex"))
                 result->setFormat(Cantor::TextResult::LatexFormat);
             result->setStdErr(isStderr);
@@ -152,62 +173,15 @@ void LoadedExpression::loadFromXml(const QDomElement& xml, const KZip& file)
                 QString dir=QStandardPaths::writableLocation(QStandardPaths::TempLocation);
                 imageFile->copyTo(dir);
                 QUrl imageUrl = QUrl::fromLocalFile(QDir(dir).absoluteFilePath(imageFile->name()));
+                //the PDF content is taken from the archive directly, the extracted file is not read again
                 if(type==QLatin1String("latex"))
-                {
-                    const QString& filename=resultElement.attribute(QLatin1String("filename"));
-                    const KArchiveEntry* imageEntry=file.directory()->entry(filename);
-                    if (imageEntry&&imageEntry->isFile())
-                    {
-                        const KArchiveFile* imageFile=static_cast<const KArchiveFile*>(imageEntry);
-                        const QString& dir=QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-                        imageFile->copyTo(dir);
-                        QUrl imageUrl=QUrl::fromLocalFile(dir+QDir::separator()+imageFile->name());
-
-                        QByteArray pdfData;
-                        QFile f(imageUrl.toLocalFile());
-                        if (f.open(QIODevice::ReadOnly))
-                        {
-                            pdfData = f.readAll();
-                            f.close();
-                        }
-
-                        addLoadedResult(new Cantor::LatexResult(resultElement.text(), imageUrl, QString(), pdfData));
-                    }
-                }
+                    addLoadedResult(new Cantor::LatexResult(resultElement.text(), imageUrl, QString(), imageFile->data()));
                 else if (type == QLatin1String("pdf"))
-                {
-                    QByteArray pdfData;
-                    QFile f(imageUrl.toLocalFile());
-                    if (f.open(QIODevice::ReadOnly))
-                    {
-                        pdfData = f.readAll();
-                        f.close();
-                    }
-
-                    addLoadedResult(new Cantor::PdfResult(imageUrl, pdfData));
-                }
+                    addLoadedResult(new Cantor::PdfResult(imageUrl, imageFile->data()));
                 else if (type == QLatin1String("animation"))
-                {
                     addLoadedResult(new Cantor::AnimationResult(imageUrl));
-                }
-                else if (type == QLatin1String("epsimage"))
-                {
-                    const QByteArray& ba = QByteArray::fromBase64(resultElement.attribute(QLatin1String("image")).toLatin1());
-                    QImage image;
-                    image.loadFromData(ba);
-                    addLoadedResult(new Cantor::ImageResult(imageUrl, resultElement.text()));
-                }
-                else if (imageFile->name().endsWith(QLatin1String(".eps"), Qt::CaseInsensitive))
-                {
-                    const QByteArray& ba = QByteArray::fromBase64(resultElement.attribute(QLatin1String("image")).toLatin1());
-                    QImage image;
-                    image.loadFromData(ba);
-                    addLoadedResult(new Cantor::ImageResult(imageUrl, resultElement.text()));
-                }
                 else
-                {
                     addLoadedResult(new Cantor::ImageResult(imageUrl, resultElement.text()));
-                }
             }
         }
     }
@@ -364,9 +338,14 @@ void LoadedExpression::loadFromJupyter(const QJsonObject& cell)
             // So this is image
             else if (Cantor::JupyterUtils::imageKeys(data).contains(mainKey))
             {
-                const QImage& image = Cantor::JupyterUtils::loadImage(data, mainKey);
-                result = new Cantor::ImageResult(image, text);
+                //raster images are stored in a file as they are and decoded only when they're shown
+                const QString& fileName = Cantor::JupyterUtils::saveEncodedImage(data, mainKey);
+                if (!fileName.isEmpty())
+                    result = new Cantor::ImageResult(QUrl::fromLocalFile(fileName), text);
+                else
+                    result = new Cantor::ImageResult(Cantor::JupyterUtils::loadImage(data, mainKey), text);
                 static_cast<Cantor::ImageResult*>(result)->setOriginalFormat(mainKey);
+                static_cast<Cantor::ImageResult*>(result)->setJupyterBundle(data);
 
                 if (mainKey == Cantor::JupyterUtils::svgMime)
                     static_cast<Cantor::ImageResult*>(result)->setSvgContent(Cantor::JupyterUtils::fromJupyterMultiline(data[Cantor::JupyterUtils::svgMime]));
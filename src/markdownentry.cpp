@@ -20,6 +20,7 @@
 #include <QDebug>
 #include <QKeyEvent>
 #include <QRegularExpression>
+#include <QSet>
 #include <QStandardPaths>
 #include <QDir>
 #include <QFileDialog>
@@ -49,6 +50,7 @@ rendered(false)
     connect(m_textItem, &WorksheetTextItem::moveToPrevious, this, &MarkdownEntry::moveToPreviousEntry);
     connect(m_textItem, &WorksheetTextItem::moveToNext, this, &MarkdownEntry::moveToNextEntry);
     connect(m_textItem, SIGNAL(execute()), this, SLOT(evaluate()));
+    connect(worksheet->mathRenderer(), &MathRenderer::rerendered, this, &MarkdownEntry::updateRenderedMath);
 }
 
 void MarkdownEntry::populateMenu(QMenu* menu, QPointF pos)
@@ -384,10 +386,63 @@ bool MarkdownEntry::evaluate(EvaluationOption evalOp)
     return true;
 }
 
+/*!
+ * renders the Markdown source \c plain. The source is split into blocks, only the blocks changed
+ * since the last rendering are compiled again, the HTML and the formulas of the unchanged blocks are reused.
+ */
 bool MarkdownEntry::renderMarkdown(QString& plain)
 {
 #ifdef Discount_FOUND
-    QByteArray mdCharArray = plain.toUtf8();
+    //the reference links and footnotes can be defined in another block, compile the whole document in this case
+    static const QRegularExpression referenceDefinition(QStringLiteral("^\\s{0,3}\\[[^\\]]+\\]:"), QRegularExpression::MultilineOption);
+    const QStringList& sources = plain.contains(referenceDefinition) ? QStringList(plain) : splitBlocks(plain);
+
+    QHash<QString, RenderedBlock> blocks;
+    QStringList htmlBlocks;
+    foundMath.clear();
+    for (const auto& source : sources)
+    {
+        RenderedBlock block;
+        auto it = renderedBlocks.constFind(source);
+        if (it != renderedBlocks.constEnd())
+            block = *it;
+        else if (!compileMarkdown(source, block))
+            return false;
+
+        htmlBlocks << block.html;
+        for (const auto& latex : std::as_const(block.math))
+            foundMath.push_back(std::make_pair(latex, false));
+        blocks.insert(source, block);
+    }
+
+    //keep the blocks and the formulas of the current source only
+    renderedBlocks = blocks;
+    QSet<QString> codes;
+    for (const auto& math : foundMath)
+        codes.insert(math.first);
+    for (auto it = renderedMath.begin(); it != renderedMath.end();)
+    {
+        if (codes.contains(it.key()))
+            ++it;
+        else
+            it = renderedMath.erase(it);
+    }
+
+    html = htmlBlocks.join(QLatin1Char('\n'));
+    setRenderedHtml(html);
+    markUpMath();
+
+    return true;
+#else
+    Q_UNUSED(plain);
+    return false;
+#endif
+}
+
+bool MarkdownEntry::compileMarkdown(const QString& source, RenderedBlock& block) const
+{
+#ifdef Discount_FOUND
+    QByteArray mdCharArray = source.toUtf8();
     MMIOT* mdHandle = mkd_string(mdCharArray.data(), mdCharArray.size()+1, 0);
     if(!mkd_compile(mdHandle, MKD_LATEX | MKD_FENCEDCODE | MKD_GITHUBTAGS))
     {
@@ -397,42 +452,106 @@ bool MarkdownEntry::renderMarkdown(QString& plain)
     }
     char *htmlDocument;
     int htmlSize = mkd_document(mdHandle, &htmlDocument);
-    html = QString::fromUtf8(htmlDocument, htmlSize);
+    block.html = QString::fromUtf8(htmlDocument, htmlSize);
 
     char *latexData;
     int latexDataSize = mkd_latextext(mdHandle, &latexData);
-    QStringList latexUnits = QString::fromUtf8(latexData, latexDataSize).split(QLatin1Char(31), Qt::SkipEmptyParts);
-    foundMath.clear();
+    block.math = QString::fromUtf8(latexData, latexDataSize).split(QLatin1Char(31), Qt::SkipEmptyParts);
 
     mkd_cleanup(mdHandle);
+    return true;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(block);
+    return false;
+#endif
+}
 
-    setRenderedHtml(html);
+/*!
+ * splits the Markdown source into blocks separated by blank lines which can be compiled independently.
+ * Fenced code and displayed formulas are kept in one block, indented lines and the items of a list
+ * are added to the previous block since they can continue it.
+ */
+QStringList MarkdownEntry::splitBlocks(const QString& source)
+{
+    static const QRegularExpression fence(QStringLiteral("^\\s{0,3}(?:```|~~~)"));
+    static const QRegularExpression listItem(QStringLiteral("^\\s{0,3}(?:[-*+]|\\d+[.)])\\s"));
 
-    QTextCursor cursor(m_textItem->document());
-    for (const QString& latex : latexUnits)
-        foundMath.push_back(std::make_pair(latex, false));
+    QStringList blocks;
+    QStringList current;
+    bool inFence = false;
+    bool inMath = false;
+    bool inList = false;
+    bool afterBlankLine = false;
 
-    markUpMath();
+    const auto& lines = source.split(QLatin1Char('\n'));
+    for (const auto& line : lines)
+    {
+        if (!inFence && !inMath && line.trimmed().isEmpty())
+        {
+            afterBlankLine = true;
+            current << line;
+            continue;
+        }
 
-    return true;
-#else
-    Q_UNUSED(plain);
+        const bool continuesBlock = (!line.isEmpty() && line.at(0).isSpace()) || (inList && line.contains(listItem));
+        if (afterBlankLine && !continuesBlock && !current.isEmpty())
+        {
+            blocks << current.join(QLatin1Char('\n'));
+            current.clear();
+            inList = false;
+        }
+        afterBlankLine = false;
+        current << line;
 
-    return false;
-#endif
+        if (line.contains(fence))
+            inFence = !inFence;
+        else if (!inFence && line.count(QStringLiteral("$$")) % 2 == 1)
+            inMath = !inMath;
+
+        if (!inFence && line.contains(listItem))
+            inList = true;
+    }
+
+    if (!current.isEmpty())
+        blocks << current.join(QLatin1Char('\n'));
+
+    return blocks;
 }
 
 void MarkdownEntry::updateEntry()
 {
+    QVector<QTextImageFormat> formulas;
     QTextCursor cursor = m_textItem->document()->find(QString(QChar::ObjectReplacementCharacter));
     while(!cursor.isNull())
     {
         QTextImageFormat format=cursor.charFormat().toImageFormat();
         if (format.hasProperty(Cantor::Renderer::CantorFormula))
-            worksheet()->mathRenderer()->rerender(m_textItem->document(), format);
+            formulas << format;
 
         cursor = m_textItem->document()->find(QString(QChar::ObjectReplacementCharacter), cursor);
     }
+
+    worksheet()->mathRenderer()->rerender(m_textItem->document(), formulas, m_textItem);
+}
+
+/*!
+ * keeps the images of the formulas rerendered for the scale \c scale for their reuse.
+ */
+void MarkdownEntry::updateRenderedMath(QTextDocument* document, qreal scale)
+{
+    if (document != m_textItem->document())
+        return;
+
+    for (auto& math : renderedMath)
+    {
+        const QImage& image = document->resource(QTextDocument::ImageResource, math.internal).value<QImage>();
+        if (!image.isNull())
+        {
+            math.image = image;
+            math.scale = scale;
+        }
+    }
 }
 
 WorksheetCursor MarkdownEntry::search(const QString& pattern, unsigned flags,
@@ -573,12 +692,15 @@ bool MarkdownEntry::wantToEvaluate()
 
 void MarkdownEntry::setRenderedHtml(const QString& html)
 {
+    //the pending formulas of the replaced content are not needed anymore
+    worksheet()->mathRenderer()->cancel(this);
     m_textItem->setHtml(html);
     m_textItem->denyEditing();
 }
 
 void MarkdownEntry::setPlainText(const QString& plain)
 {
+    worksheet()->mathRenderer()->cancel(this);
     QTextDocument* doc = m_textItem->document();
     doc->setPlainText(plain);
     m_textItem->setDocument(doc);
@@ -587,10 +709,28 @@ void MarkdownEntry::setPlainText(const QString& plain)
 
 void MarkdownEntry::renderMath()
 {
-    QTextCursor cursor(m_textItem->document());
+    const qreal scale = worksheet()->mathRenderer()->scale();
+    QVector<QTextImageFormat> outdatedFormulas;
     for (int i = 0; i < (int)foundMath.size(); i++)
-        if (foundMath[i].second == false)
+    {
+        if (foundMath[i].second)
+            continue;
+
+        //the formulas rendered before are inserted again without running LaTeX
+        const auto it = renderedMath.constFind(foundMath[i].first);
+        if (it == renderedMath.constEnd())
+        {
             renderMathExpression(i+1, foundMath[i].first);
+            continue;
+        }
+
+        const RenderedMath math = *it;
+        setRenderedMath(i+1, math.format, math.internal, math.image);
+        if (math.scale != scale)
+            outdatedFormulas << math.format;
+    }
+
+    worksheet()->mathRenderer()->rerender(m_textItem->document(), outdatedFormulas, m_textItem);
 }
 
 void MarkdownEntry::handleMathRender(QSharedPointer<MathRenderResult> result)
@@ -716,6 +856,7 @@ void MarkdownEntry::setRenderedMath(int jobId, const QTextImageFormat& format, c
 
         // Set that the formulas is rendered
         iter->second = true;
+        renderedMath.insert(iter->first, RenderedMath{format, internal, image, worksheet()->mathRenderer()->scale()});
 
         m_textItem->document()->clearUndoRedoStacks();
     }
@@ -8,6 +8,7 @@
 
 #include <vector>
 
+#include <QHash>
 #include <QSharedPointer>
 
 #include "worksheetentry.h"
@@ -61,7 +62,29 @@ class MarkdownEntry : public WorksheetEntry
     void updateAfterSettingsChanges() override;
 
   protected:
+    /**
+     * HTML and formulas of a block of the Markdown source, kept to compile only the changed blocks again
+     */
+    struct RenderedBlock
+    {
+        QString html;
+        QStringList math;
+    };
+
+    /**
+     * Rendered formula, reused for the formulas whose code didn't change
+     */
+    struct RenderedMath
+    {
+        QTextImageFormat format;
+        QUrl internal;
+        QImage image;
+        qreal scale;
+    };
+
     bool renderMarkdown(QString& plain);
+    bool compileMarkdown(const QString& source, RenderedBlock& block) const;
+    static QStringList splitBlocks(const QString& source);
     bool eventFilter(QObject* object, QEvent* event) override;
     bool wantToEvaluate() override;
     void setRenderedHtml(const QString& html);
@@ -77,6 +100,7 @@ class MarkdownEntry : public WorksheetEntry
 
   protected Q_SLOTS:
     void handleMathRender(QSharedPointer<MathRenderResult> result);
+    void updateRenderedMath(QTextDocument* document, qreal scale);
     void insertImage();
     void clearAttachments();
     void enterEditMode();
@@ -88,6 +112,8 @@ class MarkdownEntry : public WorksheetEntry
     bool rendered;
     std::vector<std::pair<QUrl,QString>> attachedImages;
     std::vector<std::pair<QString, bool>> foundMath;
+    QHash<QString, RenderedBlock> renderedBlocks;
+    QHash<QString, RenderedMath> renderedMath;
     static const int JobProperty = 10000;
 };
 
@@ -5,8 +5,12 @@
 
 #include "mathrender.h"
 
-#include <QThreadPool>
+#include <algorithm>
+
 #include <QDebug>
+#include <QPointer>
+#include <QGraphicsObject>
+#include <QThread>
 #include <QStandardPaths>
 #include <QFile>
 #include <QFileInfo>
@@ -17,10 +21,24 @@
 MathRenderer::MathRenderer(): m_scale(1.0), m_useHighRes(false)
 {
     qRegisterMetaType<QSharedPointer<MathRenderResult>>();
+
+    //the threads only wait for pdflatex, don't occupy the global pool used for other work
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
 }
 
 MathRenderer::~MathRenderer()
 {
+    for (const auto& job : std::as_const(m_jobs))
+    {
+        if (!job.task)
+            continue;
+
+        if (m_pool.tryTake(job.task))
+            delete job.task;
+        else
+            job.task->cancel();
+    }
+    m_pool.waitForDone();
 }
 
 bool MathRenderer::mathRenderAvailable()
@@ -36,6 +54,10 @@ qreal MathRenderer::scale()
 
 void MathRenderer::setScale(qreal scale)
 {
+    //the running rerender jobs for the old scale are not needed anymore
+    if (scale != m_scale)
+        m_scaleGeneration.ref();
+
     m_scale = scale;
 }
 
@@ -46,11 +68,109 @@ void MathRenderer::useHighResolution(bool b)
 
 void MathRenderer::renderExpression(int jobId, const QString& mathExpression, Cantor::LatexRenderer::EquationType type, const QObject* receiver, const char* resultHandler)
 {
+    removeFinishedJobs();
+
+    //a new job with the same id supersedes the pending one
+    cancel(receiver, jobId);
+
     MathRenderTask* task = new MathRenderTask(jobId, mathExpression, type, m_scale, m_useHighRes);
     task->setHandler(receiver, resultHandler);
     task->setAutoDelete(false);
 
-    QThreadPool::globalInstance()->start(task);
+    //the jobs of deleted receivers are not needed anymore
+    if (!m_receivers.contains(receiver))
+    {
+        m_receivers.insert(receiver);
+        connect(receiver, &QObject::destroyed, this, [this, receiver]() {
+            cancel(receiver);
+            m_receivers.remove(receiver);
+        });
+    }
+
+    const Priority priority = this->priority(receiver);
+    m_jobs.append(Job{receiver, jobId, task, priority});
+    m_pool.start(task, priority);
+}
+
+void MathRenderer::cancel(const QObject* receiver, int jobId)
+{
+    for (auto it = m_jobs.begin(); it != m_jobs.end();)
+    {
+        if (it->receiver != receiver || (jobId != -1 && it->jobId != jobId))
+        {
+            ++it;
+            continue;
+        }
+
+        if (it->task)
+        {
+            if (m_pool.tryTake(it->task))
+                delete it->task;
+            else
+                it->task->cancel();
+        }
+        it = m_jobs.erase(it);
+    }
+}
+
+int MathRenderer::pendingJobCount() const
+{
+    int count = 0;
+    for (const auto& job : m_jobs)
+        if (job.task)
+            ++count;
+
+    return count;
+}
+
+int MathRenderer::maxThreadCount() const
+{
+    return m_pool.maxThreadCount();
+}
+
+/*!
+ * updates the priorities of the queued jobs for the new visible area \c rect of the worksheet.
+ */
+void MathRenderer::setViewRect(const QRectF& rect)
+{
+    m_viewRect = rect;
+    removeFinishedJobs();
+
+    for (auto& job : m_jobs)
+    {
+        const Priority priority = this->priority(job.receiver);
+        if (priority == job.priority)
+            continue;
+
+        job.priority = priority;
+
+        //the running jobs can't be taken from the pool anymore
+        if (m_pool.tryTake(job.task))
+            m_pool.start(job.task, priority);
+    }
+}
+
+MathRenderer::Priority MathRenderer::priority(const QObject* receiver) const
+{
+    const auto* item = qobject_cast<const QGraphicsObject*>(receiver);
+    if (!item || m_viewRect.isEmpty())
+        return Visible;
+
+    const QRectF& rect = item->sceneBoundingRect();
+    if (rect.intersects(m_viewRect))
+        return Visible;
+
+    //one view height above and below the visible area
+    const qreal height = m_viewRect.height();
+    if (rect.intersects(m_viewRect.adjusted(0, -height, 0, height)))
+        return Nearby;
+
+    return Background;
+}
+
+void MathRenderer::removeFinishedJobs()
+{
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), [](const Job& job) { return !job.task; }), m_jobs.end());
 }
 
 void MathRenderer::rerender(QTextDocument* document, const QTextImageFormat& math)
@@ -74,6 +194,67 @@ void MathRenderer::rerender(QTextDocument* document, const QTextImageFormat& mat
     }
 }
 
+void MathRenderer::rerender(QTextDocument* document, const QVector<QTextImageFormat>& formulas, const QObject* item)
+{
+    if (formulas.isEmpty())
+        return;
+
+    //the images are needed at once when printing
+    if (m_useHighRes)
+    {
+        for (const auto& math : formulas)
+            rerender(document, math);
+        Q_EMIT rerendered(document, m_scale);
+        return;
+    }
+
+    QVector<std::pair<QUrl, QString>> files;
+    for (const auto& math : formulas)
+        files.append(std::make_pair(QUrl(math.name()), math.property(Cantor::Renderer::ImagePath).toString()));
+
+    const quint64 jobId = ++m_rerenderJobId;
+    m_rerenderJobs[document] = jobId;
+
+    const double scale = m_scale;
+    const int scaleGeneration = m_scaleGeneration.loadAcquire();
+    const QPointer<QTextDocument> target(document);
+    m_pool.start([this, files, scale, scaleGeneration, jobId, target, document]() {
+        QVector<std::pair<QUrl, QImage>> images;
+        for (const auto& file : files)
+        {
+            //the scale was changed again in the meantime, a newer job renders the formulas
+            if (m_scaleGeneration.loadAcquire() != scaleGeneration)
+                return;
+
+            if (!QFile::exists(file.second))
+                continue;
+
+            QString errorMessage;
+            const QImage& image = Cantor::Renderer::pdfRenderToImage(QUrl::fromLocalFile(file.second), scale, false, nullptr, &errorMessage);
+            if (image.isNull())
+                qDebug() << "Rerender embedded math failed with message: " << errorMessage;
+            else
+                images.append(std::make_pair(file.first, image));
+        }
+
+        QMetaObject::invokeMethod(this, [this, images, scale, jobId, target, document]() {
+            if (m_rerenderJobs.value(document) != jobId)
+                return;
+
+            m_rerenderJobs.remove(document);
+            if (!target)
+                return;
+
+            for (const auto& image : images)
+                target->addResource(QTextDocument::ImageResource, image.first, QVariant(image.second));
+
+            //the size of the formulas is unchanged, the document only needs to be repainted
+            target->markContentsDirty(0, target->characterCount());
+            Q_EMIT rerendered(target, scale);
+        }, Qt::QueuedConnection);
+    }, priority(item));
+}
+
 std::pair<QTextImageFormat, QImage> MathRenderer::renderExpressionFromPdf(const QString& filename, const QString& uuid, const QString& code, Cantor::LatexRenderer::EquationType type, bool* outSuccess)
 {
     if (!QFile::exists(filename))
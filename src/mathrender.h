@@ -5,20 +5,34 @@
 #ifndef MATHRENDER_H
 #define MATHRENDER_H
 
+#include <QAtomicInt>
+#include <QHash>
 #include <QObject>
+#include <QPointer>
+#include <QRectF>
+#include <QSet>
 #include <QTextImageFormat>
+#include <QThreadPool>
+#include <QVector>
 #include <QMutex>
 
 #include "lib/latexrenderer.h"
 
+class MathRenderTask;
+
 /**
  * Special class for rendering embedded math in MarkdownEntry and TextEntry
  * Instead of LatexRenderer+EpsRenderer provide all needed functianality in one class
  * Even if we add some speed optimization in future, API of the class probably won't change
+ *
+ * The render jobs run in a thread pool of the renderer with a bounded number of threads.
+ * Jobs of receivers visible in the view are run first, followed by the jobs close to the visible area
+ * and by all other jobs. The priorities are updated when the view is scrolled.
  */
 class MathRenderer : public QObject {
   Q_OBJECT
   public:
+    enum Priority {Background = 0, Nearby = 1, Visible = 2};
 
     MathRenderer();
     ~MathRenderer();
@@ -50,6 +64,27 @@ class MathRenderer : public QObject {
      */
     void rerender(QTextDocument* document, const QTextImageFormat& math);
 
+    /**
+     * Rerenders the formulas @p formulas of @p document for the current scale in one job of the thread pool.
+     * The formulas keep their old images, scaled to the size of the formula, until the new images are ready.
+     * A newer job for the same document supersedes the older one. @p item is the item showing the document,
+     * it defines the priority of the job.
+     * In the high resolution mode used for printing the images are replaced before the function returns.
+     */
+    void rerender(QTextDocument* document, const QVector<QTextImageFormat>& formulas, const QObject* item);
+
+    /**
+     * Cancels the pending render jobs of @p receiver, all of them if @p jobId is -1.
+     * Queued jobs are removed, the results of the running jobs are not delivered anymore.
+     */
+    void cancel(const QObject* receiver, int jobId = -1);
+
+    /**
+     * Returns the number of the queued and running render jobs
+     */
+    int pendingJobCount() const;
+    int maxThreadCount() const;
+
     /**
      * Render math expression from existing .pdf
      * Like MathRenderer::rerender is blocking
@@ -58,9 +93,36 @@ class MathRenderer : public QObject {
         const QString& filename, const QString& uuid, const QString& code, Cantor::LatexRenderer::EquationType type, bool* success
     );
 
+  public Q_SLOTS:
+    void setViewRect(const QRectF&);
+
+  Q_SIGNALS:
+    /**
+     * Emitted once the images of the formulas in @p document are replaced by the ones for the scale @p scale
+     */
+    void rerendered(QTextDocument* document, qreal scale);
+
   private:
+    struct Job
+    {
+        const QObject* receiver;
+        int jobId;
+        QPointer<MathRenderTask> task;
+        Priority priority;
+    };
+
+    Priority priority(const QObject* receiver) const;
+    void removeFinishedJobs();
+
     double m_scale;
     bool m_useHighRes;
+    QThreadPool m_pool;
+    QRectF m_viewRect;
+    QVector<Job> m_jobs;
+    QSet<const QObject*> m_receivers;
+    QHash<const QTextDocument*, quint64> m_rerenderJobs; //the latest rerender job of the documents
+    quint64 m_rerenderJobId{0};
+    QAtomicInt m_scaleGeneration{0};
 };
 
 #endif /* MATHRENDER_H */
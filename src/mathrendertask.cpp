@@ -5,17 +5,16 @@
 
 #include "mathrendertask.h"
 
-#include <QTemporaryFile>
 #include <QStandardPaths>
 #include <QUuid>
 #include <QDir>
 #include <KColorScheme>
-#include <KProcess>
 #include <QScopedPointer>
 #include <QApplication>
 #include <QDebug>
 
 #include "lib/renderer.h"
+#include "lib/texworker.h"
 
 static const QLatin1String mathTex("\\documentclass%9{minimal}"\
                          "\\usepackage{amsfonts,amssymb}"\
@@ -58,16 +57,30 @@ void MathRenderTask::setHandler(const QObject* receiver, const char* resultHandl
     connect(this, SIGNAL(finish(QSharedPointer<MathRenderResult>)), receiver, resultHandler);
 }
 
+void MathRenderTask::cancel()
+{
+    m_canceled.storeRelease(1);
+}
+
+bool MathRenderTask::isCanceled() const
+{
+    return m_canceled.loadAcquire() != 0;
+}
+
 void MathRenderTask::run()
 {
     qDebug()<<"MathRenderTask::run " << m_jobId;
     QSharedPointer<MathRenderResult> result(new MathRenderResult());
+    result->jobId = m_jobId;
+    result->successful = false;
 
-    const QString& tempDir=QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-
-    QTemporaryFile texFile(tempDir + QDir::separator() + QLatin1String("cantor_tex-XXXXXX.tex"));
-    if (!texFile.open())
+    if (isCanceled())
+    {
+        finalize(result);
         return;
+    }
+
+    const QString& tempDir=QStandardPaths::writableLocation(QStandardPaths::TempLocation);
 
     // make sure we have preview.sty available
     if (!tempDir.contains(QLatin1String("preview.sty")))
@@ -121,35 +134,31 @@ void MathRenderTask::run()
 
     expressionTex=expressionTex.arg(latex);
 
-    texFile.write(expressionTex.toUtf8());
-    texFile.flush();
-
-    QProcess p;
-    p.setWorkingDirectory(tempDir);
-
-    // Create unique uuid for this job
-    // It will be used as pdf filename, for preventing names collisions
+    // The preamble is loaded only once by the worker of this thread, see TexWorker.
+    // The uuid of the job is used as pdf filename, for preventing names collisions
     // And as internal url path too
-    const QString& uuid = Cantor::LatexRenderer::genUuid();
+    QString uuid;
+    QString output;
+    const bool success = Cantor::TexWorker::instance()->typeset(expressionTex, &uuid, &output, [this]() { return isCanceled(); });
 
-    const QString& pdflatex = QStandardPaths::findExecutable(QLatin1String("pdflatex"));
-    p.setProgram(pdflatex);
-    p.setArguments({QStringLiteral("-jobname=cantor_") + uuid, QStringLiteral("-halt-on-error"), texFile.fileName()});
+    if (isCanceled())
+    {
+        finalize(result);
+        return;
+    }
 
-    p.start();
-    if (!p.waitForFinished() || p.exitCode() != 0)
+    if (!success)
     {
         // pdflatex render failed and we haven't pdf file
         result->successful = false;
 
-        QString renderErrorText = QString::fromUtf8(p.readAllStandardOutput());
+        QString renderErrorText = std::move(output);
         renderErrorText.remove(0, renderErrorText.indexOf(QLatin1Char('!')));
         renderErrorText.remove(renderErrorText.indexOf(QLatin1String("!  ==> Fatal error occurred")), renderErrorText.size());
         renderErrorText = renderErrorText.trimmed();
         result->errorMessage = std::move(renderErrorText);
 
         finalize(result);
-        texFile.setAutoRemove(false); //Useful for debug
         return;
     }
 
@@ -170,7 +179,6 @@ void MathRenderTask::run()
 
     result->renderedMath = data.first;
     result->image = data.second;
-    result->jobId = m_jobId;
 
     QUrl internal;
     internal.setScheme(QLatin1String("internal"));
@@ -182,7 +190,8 @@ void MathRenderTask::run()
 
 void MathRenderTask::finalize(QSharedPointer<MathRenderResult> result)
 {
-    Q_EMIT finish(std::move(result));
+    if (!isCanceled())
+        Q_EMIT finish(std::move(result));
     deleteLater();
 }
 
@@ -5,6 +5,7 @@
 #ifndef MATHRENDERTASK_H
 #define MATHRENDERTASK_H
 
+#include <QAtomicInt>
 #include <QObject>
 #include <QString>
 #include <QTextImageFormat>
@@ -43,6 +44,13 @@ class MathRenderTask : public QObject, public QRunnable
 
     void setHandler(const QObject *receiver, const char *resultHandler);
 
+    /**
+     * Cancels the task, can be called from any thread. A running pdflatex process is stopped,
+     * the result isn't delivered to the handler.
+     */
+    void cancel();
+    bool isCanceled() const;
+
     void run() override;
 
     static std::pair<QTextImageFormat, QImage> renderPdfToFormat(
@@ -72,7 +80,7 @@ class MathRenderTask : public QObject, public QRunnable
     bool m_highResolution;
     QColor m_backgroundColor;
     QColor m_foregroundColor;
-
+    QAtomicInt m_canceled{0};
 };
 
 #endif /* MATHRENDERTASK_H */
@@ -152,6 +152,7 @@ QWidget* TableOfContentPanelPlugin::widget()
 void TableOfContentPanelPlugin::connectToShell(QObject* cantorShell)
 {
     connect(cantorShell, SIGNAL(tocNodesChanged(QVariantList)), this, SLOT(handleTocNodeChanges(QVariantList)));
+    connect(cantorShell, SIGNAL(tocNodesUpdated(QVariantMap)), this, SLOT(handleTocNodeDelta(QVariantMap)));
     connect(this, SIGNAL(requestNavigateToTocNode(QString)), cantorShell, SIGNAL(requestNavigateToTocNode(QString)));
     connect(this, SIGNAL(requestRenameHierarchyEntry(QString,QString)), cantorShell, SIGNAL(requestRenameHierarchyEntry(QString,QString)));
     connect(cantorShell, SIGNAL(currentTocNodeChanged(QString)), this, SLOT(handleCurrentTocNodeChanged(QString)));
@@ -417,26 +418,8 @@ void TableOfContentPanelPlugin::rebuildModel()
         const int parentIndex = findVisibleAncestorIndex(node.parentIndex);
         QStandardItem* parentItem = parentIndex >= 0 ? visibleItems.at(parentIndex) : m_model.invisibleRootItem();
 
-        auto* item = new QStandardItem(node.displayText);
-        item->setIcon(iconForTocNodeType(node.type));
-        item->setEditable(node.editable && !m_readOnly);
-
-        item->setData(node.id, NodeIdRole);
-        item->setData(node.parentId, ParentNodeIdRole);
-        item->setData(node.type, NodeTypeRole);
-        item->setData(node.depth, DepthRole);
-        item->setData(node.title, NameRole);
-        item->setData(node.displayText, DisplayTextRole);
-        item->setData(node.hierarchyText, HierarchyTextRole);
-        item->setData(node.hierarchyId, HierarchyIdRole);
-        item->setData(node.entryId, EntryIdRole);
-        item->setData(node.resultId, ResultIdRole);
-        item->setData(node.customTitle, CustomTitleRole);
-        item->setData(node.resultIndex, ResultIndexRole);
-        item->setData(node.editable, EditableRole);
-        item->setData(node.navigable, NavigableRole);
-        item->setData(node.canPromote, CanPromoteRole);
-        item->setData(node.canDemote, CanDemoteRole);
+        auto* item = new QStandardItem();
+        setItemData(item, node);
 
         parentItem->appendRow(item);
         visibleItems[i] = item;
@@ -448,6 +431,12 @@ void TableOfContentPanelPlugin::rebuildModel()
     if (!m_searchText.isEmpty() && m_mainWidget)
         m_mainWidget->expandAll();
     updateCurrentNodeSelection();
+    updateEmptyState();
+    m_modelFilteredBySearch = !m_searchText.isEmpty();
+}
+
+void TableOfContentPanelPlugin::updateEmptyState()
+{
     const bool isEmpty = m_model.rowCount() == 0;
     if (m_emptyLabel)
     {
@@ -458,7 +447,69 @@ void TableOfContentPanelPlugin::rebuildModel()
     }
     if (m_mainWidget)
         m_mainWidget->setVisible(!isEmpty);
-    m_modelFilteredBySearch = !m_searchText.isEmpty();
+}
+
+void TableOfContentPanelPlugin::setItemData(QStandardItem* item, const TocNode& node) const
+{
+    item->setText(node.displayText);
+    item->setIcon(iconForTocNodeType(node.type));
+    item->setEditable(node.editable && !m_readOnly);
+
+    item->setData(node.id, NodeIdRole);
+    item->setData(node.parentId, ParentNodeIdRole);
+    item->setData(node.type, NodeTypeRole);
+    item->setData(node.depth, DepthRole);
+    item->setData(node.title, NameRole);
+    item->setData(node.displayText, DisplayTextRole);
+    item->setData(node.hierarchyText, HierarchyTextRole);
+    item->setData(node.hierarchyId, HierarchyIdRole);
+    item->setData(node.entryId, EntryIdRole);
+    item->setData(node.resultId, ResultIdRole);
+    item->setData(node.customTitle, CustomTitleRole);
+    item->setData(node.resultIndex, ResultIndexRole);
+    item->setData(node.editable, EditableRole);
+    item->setData(node.navigable, NavigableRole);
+    item->setData(node.canPromote, CanPromoteRole);
+    item->setData(node.canDemote, CanDemoteRole);
+}
+
+/*!
+ * creates the item for the node at \c index in the current model and inserts it
+ * after the item of its preceding visible sibling. Returns \c false if the node is not shown.
+ */
+bool TableOfContentPanelPlugin::insertNodeItem(int index)
+{
+    if (!shouldDisplayNode(index))
+        return false;
+
+    const TocNode& node = m_nodes.at(index);
+    const int parentIndex = findVisibleAncestorIndex(node.parentIndex);
+    QStandardItem* parentItem = parentIndex >= 0
+        ? m_itemsByNodeId.value(m_nodes.at(parentIndex).id)
+        : m_model.invisibleRootItem();
+    if (!parentItem)
+        return false;
+
+    int row = 0;
+    for (int i = index - 1; i >= 0 && i != parentIndex; --i)
+    {
+        auto* item = m_itemsByNodeId.value(m_nodes.at(i).id);
+        if (!item)
+            continue;
+
+        auto* itemParent = item->parent() ? item->parent() : m_model.invisibleRootItem();
+        if (itemParent == parentItem)
+        {
+            row = item->row() + 1;
+            break;
+        }
+    }
+
+    auto* item = new QStandardItem();
+    setItemData(item, node);
+    parentItem->insertRow(row, item);
+    m_itemsByNodeId.insert(node.id, item);
+    return true;
 }
 
 void TableOfContentPanelPlugin::saveCurrentExpansionState()
@@ -657,12 +708,24 @@ void TableOfContentPanelPlugin::handleTocNodeChanges(const QVariantList& nodes)
     {
         m_pendingNodeSnapshot = nodes;
         m_hasPendingNodeSnapshot = true;
+        m_pendingNodeDeltas.clear();
         return;
     }
 
     applyTocNodeChanges(nodes);
 }
 
+void TableOfContentPanelPlugin::handleTocNodeDelta(const QVariantMap& delta)
+{
+    if (m_editorActive)
+    {
+        m_pendingNodeDeltas.append(delta);
+        return;
+    }
+
+    applyTocNodeDelta(delta);
+}
+
 void TableOfContentPanelPlugin::applyTocNodeChanges(const QVariantList& nodes)
 {
     if (!m_modelFilteredBySearch)
@@ -673,6 +736,29 @@ void TableOfContentPanelPlugin::applyTocNodeChanges(const QVariantList& nodes)
 
     QSet<QString> seenNodeIds;
 
+    for (const QVariant& value : nodes)
+    {
+        const QVariantMap node = value.toMap();
+        const TocNode tocNode = tocNodeFromMap(node);
+
+        if (tocNode.id.isEmpty() || tocNode.type.isEmpty() || seenNodeIds.contains(tocNode.id))
+        {
+            qWarning() << "Ignoring invalid TOC node" << node;
+            continue;
+        }
+
+        seenNodeIds.insert(tocNode.id);
+        m_nodeIndexById.insert(tocNode.id, m_nodes.size());
+        m_nodes.append(tocNode);
+    }
+
+    updateNodeIndices();
+    cleanupStateAfterNodeChange();
+    rebuildModel();
+}
+
+TableOfContentPanelPlugin::TocNode TableOfContentPanelPlugin::tocNodeFromMap(const QVariantMap& node) const
+{
     const auto nodeTypeFromValue = [](const QVariant& value) -> QString
     {
         if (value.typeId() == QMetaType::QString)
@@ -698,50 +784,181 @@ void TableOfContentPanelPlugin::applyTocNodeChanges(const QVariantList& nodes)
         }
     };
 
-    for (const QVariant& value : nodes)
+    TocNode tocNode;
+    tocNode.id = node.value(QStringLiteral("id")).toString();
+    tocNode.parentId = node.value(QStringLiteral("parentId")).toString();
+    tocNode.type = nodeTypeFromValue(node.value(QStringLiteral("type")));
+    tocNode.title = node.value(QStringLiteral("title")).toString();
+    tocNode.displayText = node.value(QStringLiteral("displayText")).toString();
+    tocNode.hierarchyText = node.value(QStringLiteral("hierarchyText")).toString();
+    tocNode.hierarchyId = node.value(QStringLiteral("hierarchyId")).toString();
+    tocNode.entryId = node.value(QStringLiteral("entryId")).toString();
+    tocNode.resultId = node.value(QStringLiteral("resultId")).toString();
+    tocNode.customTitle = node.value(QStringLiteral("customTitle")).toString();
+    tocNode.resultIndex = node.value(QStringLiteral("resultIndex"), -1).toInt();
+    tocNode.depth = node.value(QStringLiteral("depth"), 0).toInt();
+    tocNode.editable = node.value(QStringLiteral("editable"), false).toBool();
+    tocNode.navigable = node.value(QStringLiteral("navigable"), false).toBool();
+    tocNode.canPromote = node.value(QStringLiteral("canPromote"), false).toBool();
+    tocNode.canDemote = node.value(QStringLiteral("canDemote"), false).toBool();
+
+    if (tocNode.displayText.isEmpty())
+        tocNode.displayText = tocNode.title;
+
+    return tocNode;
+}
+
+void TableOfContentPanelPlugin::updateNodeIndices()
+{
+    m_nodeIndexById.clear();
+    for (int i = 0; i < m_nodes.size(); ++i)
+        m_nodeIndexById.insert(m_nodes.at(i).id, i);
+
+    for (int i = 0; i < m_nodes.size(); ++i)
     {
-        const QVariantMap node = value.toMap();
+        const QString& parentId = m_nodes.at(i).parentId;
+        m_nodes[i].parentIndex = parentId.isEmpty() ? -1 : m_nodeIndexById.value(parentId, -1);
+    }
+}
 
-        TocNode tocNode;
-        tocNode.id = node.value(QStringLiteral("id")).toString();
-        tocNode.parentId = node.value(QStringLiteral("parentId")).toString();
-        tocNode.type = nodeTypeFromValue(node.value(QStringLiteral("type")));
-        tocNode.title = node.value(QStringLiteral("title")).toString();
-        tocNode.displayText = node.value(QStringLiteral("displayText")).toString();
-        tocNode.hierarchyText = node.value(QStringLiteral("hierarchyText")).toString();
-        tocNode.hierarchyId = node.value(QStringLiteral("hierarchyId")).toString();
-        tocNode.entryId = node.value(QStringLiteral("entryId")).toString();
-        tocNode.resultId = node.value(QStringLiteral("resultId")).toString();
-        tocNode.customTitle = node.value(QStringLiteral("customTitle")).toString();
-        tocNode.resultIndex = node.value(QStringLiteral("resultIndex"), -1).toInt();
-        tocNode.depth = node.value(QStringLiteral("depth"), 0).toInt();
-        tocNode.editable = node.value(QStringLiteral("editable"), false).toBool();
-        tocNode.navigable = node.value(QStringLiteral("navigable"), false).toBool();
-        tocNode.canPromote = node.value(QStringLiteral("canPromote"), false).toBool();
-        tocNode.canDemote = node.value(QStringLiteral("canDemote"), false).toBool();
-
-        if (tocNode.displayText.isEmpty())
-            tocNode.displayText = tocNode.title;
+void TableOfContentPanelPlugin::applyTocNodeDelta(const QVariantMap& delta)
+{
+    const QStringList removed = delta.value(QStringLiteral("removed")).toStringList();
+    const QVariantList inserted = delta.value(QStringLiteral("inserted")).toList();
+    const QVariantList changed = delta.value(QStringLiteral("changed")).toList();
 
-        if (tocNode.id.isEmpty() || tocNode.type.isEmpty() || seenNodeIds.contains(tocNode.id))
+    // the items are updated in place unless the structure of the tree changes,
+    // with an active search the visibility of the ancestors depends on all nodes
+    bool rebuild = !m_searchText.isEmpty();
+
+    for (const QVariant& value : changed)
+    {
+        const TocNode node = tocNodeFromMap(value.toMap());
+        const int index = m_nodeIndexById.value(node.id, -1);
+        if (index < 0)
         {
-            qWarning() << "Ignoring invalid TOC node" << node;
+            rebuild = true;
             continue;
         }
 
-        seenNodeIds.insert(tocNode.id);
-        m_nodeIndexById.insert(tocNode.id, m_nodes.size());
-        m_nodes.append(tocNode);
+        TocNode& oldNode = m_nodes[index];
+        if (oldNode.parentId != node.parentId || oldNode.type != node.type)
+            rebuild = true;
+        oldNode = node;
     }
 
-    for (int i = 0; i < m_nodes.size(); ++i)
+    const QSet<QString> removedIds(removed.cbegin(), removed.cend());
+    QSet<QString> insertedIds;
+    QHash<QString, TocNode> insertedAfter;
+    for (const QVariant& value : inserted)
     {
-        const QString& parentId = m_nodes.at(i).parentId;
-        m_nodes[i].parentIndex = parentId.isEmpty() ? -1 : m_nodeIndexById.value(parentId, -1);
+        const QVariantMap map = value.toMap();
+        const TocNode node = tocNodeFromMap(map);
+        if (node.id.isEmpty() || node.type.isEmpty() || m_nodeIndexById.contains(node.id) || insertedIds.contains(node.id))
+        {
+            qWarning() << "Ignoring invalid TOC node" << map;
+            continue;
+        }
+
+        if (node.type == TocNodeTypeChapter || node.type == TocNodeTypeSection)
+            rebuild = true;
+
+        insertedIds.insert(node.id);
+        insertedAfter.insert(map.value(QStringLiteral("afterId")).toString(), node);
+    }
+
+    for (const QString& id : removed)
+    {
+        const int index = m_nodeIndexById.value(id, -1);
+        if (index >= 0 && (m_nodes.at(index).type == TocNodeTypeChapter || m_nodes.at(index).type == TocNodeTypeSection))
+            rebuild = true;
+    }
+
+    // merge the inserted nodes into the list, each of them follows the node given by its "afterId"
+    QVector<TocNode> nodes;
+    nodes.reserve(m_nodes.size() + insertedIds.size());
+    const auto appendWithInserted = [&nodes, &insertedAfter](const QString& id)
+    {
+        for (auto it = insertedAfter.find(id); it != insertedAfter.end(); it = insertedAfter.find(nodes.last().id))
+        {
+            nodes.append(it.value());
+            insertedAfter.erase(it);
+        }
+    };
+
+    appendWithInserted(QString());
+    for (const TocNode& node : std::as_const(m_nodes))
+    {
+        if (removedIds.contains(node.id))
+            continue;
+
+        nodes.append(node);
+        appendWithInserted(node.id);
+    }
+
+    if (!insertedAfter.isEmpty())
+    {
+        for (const TocNode& node : std::as_const(insertedAfter))
+            nodes.append(node);
+        rebuild = true;
     }
 
+    m_nodes = nodes;
+    updateNodeIndices();
     cleanupStateAfterNodeChange();
-    rebuildModel();
+
+    if (rebuild)
+    {
+        rebuildModel();
+        return;
+    }
+
+    QScopedValueRollback<bool> guard(m_updatingModel, true);
+
+    // remove the items of the removed nodes, the items of removed descendants are deleted with their ancestors
+    QSet<QStandardItem*> removedItems;
+    for (const QString& id : removed)
+    {
+        if (auto* item = m_itemsByNodeId.take(id))
+            removedItems.insert(item);
+    }
+
+    for (auto* item : std::as_const(removedItems))
+    {
+        bool removedWithAncestor = false;
+        for (auto* parent = item->parent(); parent; parent = parent->parent())
+        {
+            if (removedItems.contains(parent))
+            {
+                removedWithAncestor = true;
+                break;
+            }
+        }
+
+        if (!removedWithAncestor)
+            (item->parent() ? item->parent() : m_model.invisibleRootItem())->removeRow(item->row());
+    }
+
+    for (const QVariant& value : changed)
+    {
+        const QString id = value.toMap().value(QStringLiteral("id")).toString();
+        const int index = m_nodeIndexById.value(id, -1);
+        if (auto* item = m_itemsByNodeId.value(id))
+            setItemData(item, m_nodes.at(index));
+    }
+
+    // insert in the order of the nodes so the parents are created before their children
+    if (!insertedIds.isEmpty())
+    {
+        for (int i = 0; i < m_nodes.size(); ++i)
+        {
+            if (insertedIds.contains(m_nodes.at(i).id))
+                insertNodeItem(i);
+        }
+    }
+
+    updateCurrentNodeSelection();
+    updateEmptyState();
 }
 
 void TableOfContentPanelPlugin::beginRename(const QModelIndex& index)
@@ -869,7 +1086,7 @@ void TableOfContentPanelPlugin::finishEditorSession()
     m_editorActive = false;
     m_editingNodeId.clear();
 
-    if (!hadEditor && !m_hasPendingNodeSnapshot && !m_hasPendingRename)
+    if (!hadEditor && !m_hasPendingNodeSnapshot && m_pendingNodeDeltas.isEmpty() && !m_hasPendingRename)
         return;
 
     if (m_hasPendingNodeSnapshot)
@@ -880,6 +1097,14 @@ void TableOfContentPanelPlugin::finishEditorSession()
         applyTocNodeChanges(pendingNodes);
     }
 
+    if (!m_pendingNodeDeltas.isEmpty())
+    {
+        const QVector<QVariantMap> pendingDeltas = m_pendingNodeDeltas;
+        m_pendingNodeDeltas.clear();
+        for (const QVariantMap& delta : pendingDeltas)
+            applyTocNodeDelta(delta);
+    }
+
     if (m_hasPendingRename)
     {
         const QString nodeType = m_pendingRenameNodeType;
@@ -916,6 +1141,7 @@ void TableOfContentPanelPlugin::cancelEditorSession()
     m_pendingRenameResultId.clear();
     m_pendingRenameTitle.clear();
     m_pendingNodeSnapshot.clear();
+    m_pendingNodeDeltas.clear();
 }
 
 bool TableOfContentPanelPlugin::shouldDisplayNode(int index) const
@@ -14,6 +14,7 @@
 #include <QStandardItemModel>
 #include <QString>
 #include <QVariantList>
+#include <QVariantMap>
 #include <QVector>
 #include "panelplugin.h"
 
@@ -60,6 +61,7 @@ class TableOfContentPanelPlugin : public Cantor::PanelPlugin
     void handleClicked(const QModelIndex&);
     void handleDoubleClicked(const QModelIndex&);
     void handleTocNodeChanges(const QVariantList& nodes);
+    void handleTocNodeDelta(const QVariantMap& delta);
     void handleCurrentTocNodeChanged(const QString& nodeId);
     void handleExpanded(const QModelIndex& index);
     void handleCollapsed(const QModelIndex& index);
@@ -112,6 +114,12 @@ private:
     void constructMainWidget();
     void rebuildModel();
     void applyTocNodeChanges(const QVariantList& nodes);
+    void applyTocNodeDelta(const QVariantMap& delta);
+    TocNode tocNodeFromMap(const QVariantMap& node) const;
+    void updateNodeIndices();
+    void setItemData(QStandardItem* item, const TocNode& node) const;
+    bool insertNodeItem(int index);
+    void updateEmptyState();
     void updateCurrentNodeSelection();
     void restoreExpansionState();
     void expandIndexParents(const QModelIndex& index);
@@ -172,6 +180,7 @@ private:
     QString m_pendingRenameResultId;
     QString m_pendingRenameTitle;
     QVariantList m_pendingNodeSnapshot;
+    QVector<QVariantMap> m_pendingNodeDeltas;
 };
 
 #endif /* _FILEBROWSERPANELPLUGIN_H */
@@ -6,6 +6,7 @@
 #include "searchbar.h"
 
 #include "commandentry.h"
+#include "searchindex.h"
 #include "worksheet.h"
 #include "worksheetentry.h"
 #include "worksheettextitem.h"
@@ -150,9 +151,20 @@ void SearchBar::searchForward(bool skipFirstChar)
 
     if (!startEntry) { setStatus(i18n("Not found")); return; }
 
+    //only the entries containing the pattern according to the search index are searched
+    const QSet<WorksheetEntry*>& candidates = worksheet()->searchIndex()->candidates(m_pattern, m_searchFlags, caseSensitivity());
+
     WorksheetEntry* entry = startEntry;
     while (entry)
     {
+        if (!candidates.contains(entry))
+        {
+            entry = entry->next();
+            kPos = KWorksheetCursor();
+            legacyPos = WorksheetCursor();
+            continue;
+        }
+
         bool searchInCommandArea = true;
 
         if (dynamic_cast<CommandEntry*>(entry) && legacyPos.isValid() && legacyPos.entry() == entry)
@@ -168,7 +180,7 @@ void SearchBar::searchForward(bool skipFirstChar)
                 setCurrentCursor(result);
                 worksheet()->setWorksheetCursor(result);
                 worksheet()->makeVisible(result);
-                clearStatus();
+                showMatchCount();
                 return;
             }
         }
@@ -183,7 +195,7 @@ void SearchBar::searchForward(bool skipFirstChar)
                 setCurrentLegacyCursor(result);
                 worksheet()->setWorksheetCursor(result);
                 worksheet()->makeVisible(result);
-                clearStatus();
+                showMatchCount();
                 return;
             }
         }
@@ -202,7 +214,7 @@ void SearchBar::searchForward(bool skipFirstChar)
                 setCurrentLegacyCursor(resultInResults);
                 worksheet()->setWorksheetCursor(resultInResults);
                 worksheet()->makeVisible(resultInResults);
-                clearStatus();
+                showMatchCount();
                 return;
             }
         }
@@ -261,9 +273,19 @@ void SearchBar::searchBackward(bool skipFirstChar)
 
     if (!startEntry) { setStatus(i18n("Not found")); return; }
 
+    const QSet<WorksheetEntry*>& candidates = worksheet()->searchIndex()->candidates(m_pattern, m_searchFlags, caseSensitivity());
+
     WorksheetEntry* entry = startEntry;
     while (entry)
     {
+        if (!candidates.contains(entry))
+        {
+            entry = entry->previous();
+            kPos = KWorksheetCursor();
+            legacyPos = WorksheetCursor();
+            continue;
+        }
+
         bool searchInResultArea = true;
 
         if (dynamic_cast<CommandEntry*>(entry) && kPos.isValid() && kPos.entry() == entry)
@@ -285,7 +307,7 @@ void SearchBar::searchBackward(bool skipFirstChar)
                     setCurrentLegacyCursor(resultInResults);
                     worksheet()->setWorksheetCursor(resultInResults);
                     worksheet()->makeVisible(resultInResults);
-                    clearStatus();
+                    showMatchCount();
                     return;
                 }
             }
@@ -302,7 +324,7 @@ void SearchBar::searchBackward(bool skipFirstChar)
                 setCurrentCursor(result);
                 worksheet()->setWorksheetCursor(result);
                 worksheet()->makeVisible(result);
-                clearStatus();
+                showMatchCount();
                 return;
             }
         }
@@ -317,7 +339,7 @@ void SearchBar::searchBackward(bool skipFirstChar)
                 setCurrentLegacyCursor(result);
                 worksheet()->setWorksheetCursor(result);
                 worksheet()->makeVisible(result);
-                clearStatus();
+                showMatchCount();
                 return;
             }
         }
@@ -389,9 +411,16 @@ void SearchBar::handleReplaceAllClicked()
     if (m_pattern.isEmpty())
         return;
 
+    //only the inputs are replaced
+    const unsigned flags = WorksheetEntry::SearchCommand | WorksheetEntry::SearchText | WorksheetEntry::SearchLaTeX;
+    const QSet<WorksheetEntry*>& candidates = worksheet()->searchIndex()->candidates(m_pattern, flags, caseSensitivity());
+
     int count = 0;
     for (WorksheetEntry* entry = worksheet()->firstEntry(); entry; entry = entry->next())
     {
+        if (!candidates.contains(entry))
+            continue;
+
         QGraphicsObject* item = entry->mainTextItem();
         if (!item) continue;
 
@@ -594,6 +623,17 @@ void SearchBar::clearStatus()
     setStatus(QLatin1String(""));
 }
 
+void SearchBar::showMatchCount()
+{
+    const int count = worksheet()->searchIndex()->count(m_pattern, m_searchFlags, caseSensitivity());
+    setStatus(i18np("1 match", "%1 matches", count));
+}
+
+Qt::CaseSensitivity SearchBar::caseSensitivity() const
+{
+    return (m_kateOptions & KTextEditor::CaseInsensitive) ? Qt::CaseInsensitive : Qt::CaseSensitive;
+}
+
 void SearchBar::setupStdUi()
 {
     if (!m_stdUi)
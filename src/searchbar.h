@@ -69,6 +69,8 @@ class SearchBar : public QWidget
 
     void setStatus(QString);
     void clearStatus();
+    void showMatchCount();
+    Qt::CaseSensitivity caseSensitivity() const;
 
     void setStartCursor(KWorksheetCursor);
     void setCurrentCursor(KWorksheetCursor);
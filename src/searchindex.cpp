@@ -0,0 +1,286 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "searchindex.h"
+#include "commandentry.h"
+#include "latexentry.h"
+#include "textentry.h"
+#include "textresultitem.h"
+#include "worksheet.h"
+#include "worksheetentry.h"
+#include "worksheettexteditoritem.h"
+#include "worksheettextitem.h"
+#include "lib/textresult.h"
+
+#include <QHashFunctions>
+#include <QTextDocument>
+
+SearchIndex::SearchIndex(Worksheet* worksheet) : QObject(worksheet),
+    m_worksheet(worksheet)
+{
+}
+
+QSet<WorksheetEntry*> SearchIndex::candidates(const QString& pattern, unsigned flags, Qt::CaseSensitivity cs)
+{
+    QSet<WorksheetEntry*> entries;
+    if (pattern.isEmpty())
+        return entries;
+
+    update();
+
+    //only the entries in the shortest posting list of the trigrams of the pattern can contain it,
+    //they are checked on the text directly. shorter patterns are checked on all entries.
+    QSet<quint64> patternTrigrams;
+    addTrigrams(pattern.toCaseFolded(), patternTrigrams);
+
+    const QSet<WorksheetEntry*>* shortest = nullptr;
+    bool found = true;
+    for (quint64 trigram : std::as_const(patternTrigrams))
+    {
+        const auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd())
+        {
+            found = false;
+            break;
+        }
+
+        if (!shortest || it->size() < shortest->size())
+            shortest = &(*it);
+    }
+
+    if (found)
+    {
+        if (shortest)
+        {
+            for (auto* entry : *shortest)
+                if (matches(m_documents.value(entry), pattern, flags, cs))
+                    entries.insert(entry);
+        }
+        else
+        {
+            for (auto it = m_documents.constBegin(); it != m_documents.constEnd(); ++it)
+                if (matches(*it, pattern, flags, cs))
+                    entries.insert(it.key());
+        }
+    }
+
+    if (flags & WorksheetEntry::SearchLaTeX)
+    {
+        for (auto it = m_documents.constBegin(); it != m_documents.constEnd(); ++it)
+            if (it->hasEmbeddedFormulas)
+                entries.insert(it.key());
+    }
+
+    return entries;
+}
+
+int SearchIndex::count(const QString& pattern, unsigned flags, Qt::CaseSensitivity cs)
+{
+    int count = 0;
+    for (auto* entry : candidates(pattern, flags, cs))
+    {
+        const Document& document = m_documents.value(entry);
+        if (flags & document.inputFlag)
+            count += occurrences(document.input, pattern, cs);
+
+        if (flags & WorksheetEntry::SearchResult)
+            for (const auto& result : document.results)
+                count += occurrences(result, pattern, cs);
+    }
+
+    return count;
+}
+
+int SearchIndex::size() const
+{
+    return m_documents.size();
+}
+
+void SearchIndex::clear()
+{
+    //the connections are made again when the entries are indexed the next time
+    for (auto it = m_documents.cbegin(); it != m_documents.cend(); ++it)
+    {
+        disconnect(it.key(), nullptr, this, nullptr);
+        if (auto* editorItem = qobject_cast<WorksheetTextEditorItem*>(it.key()->mainTextItem()))
+            disconnect(editorItem->document(), nullptr, this, nullptr);
+    }
+
+    m_documents.clear();
+    m_postings.clear();
+    m_editRevisions.clear();
+}
+
+/*!
+ * indexes the entries that were added or changed since the last query.
+ */
+void SearchIndex::update()
+{
+    for (auto* entry = m_worksheet->firstEntry(); entry; entry = entry->next())
+    {
+        const size_t revision = this->revision(entry);
+        const auto it = m_documents.constFind(entry);
+        if (it == m_documents.constEnd() || it->revision != revision)
+            index(entry, revision);
+    }
+}
+
+void SearchIndex::index(WorksheetEntry* entry, size_t revision)
+{
+    auto it = m_documents.find(entry);
+    if (it == m_documents.end())
+    {
+        it = m_documents.insert(entry, Document());
+        connect(entry, &QObject::destroyed, this, [this, entry]() { remove(entry); });
+
+        //the revision of the KTextEditor document is not available, count the changes instead
+        if (auto* editorItem = qobject_cast<WorksheetTextEditorItem*>(entry->mainTextItem()))
+            connect(editorItem->document(), &KTextEditor::Document::textChanged, this, [this, entry]() {
+                ++m_editRevisions[entry];
+            });
+    }
+    else
+        removeTrigrams(entry, *it);
+
+    Document& document = *it;
+    document.revision = revision;
+    document.input.clear();
+    document.results.clear();
+    document.hasEmbeddedFormulas = false;
+
+    if (entry->type() == CommandEntry::Type)
+        document.inputFlag = WorksheetEntry::SearchCommand;
+    else if (entry->type() == LatexEntry::Type)
+        document.inputFlag = WorksheetEntry::SearchLaTeX;
+    else
+        document.inputFlag = WorksheetEntry::SearchText;
+
+    QGraphicsObject* item = entry->mainTextItem();
+    if (auto* editorItem = qobject_cast<WorksheetTextEditorItem*>(item))
+        document.input = editorItem->toPlainText();
+    else if (auto* textItem = qobject_cast<WorksheetTextItem*>(item))
+    {
+        document.input = textItem->document()->toPlainText();
+        document.hasEmbeddedFormulas = entry->type() == TextEntry::Type && document.input.contains(QChar::ObjectReplacementCharacter);
+    }
+
+    if (entry->type() == CommandEntry::Type)
+    {
+        auto* commandEntry = static_cast<CommandEntry*>(entry);
+        for (int i = 0; i < commandEntry->resultItemCount(); ++i)
+        {
+            //only the text results are searched, see CommandEntry::search()
+            auto* resultItem = dynamic_cast<TextResultItem*>(commandEntry->resultItemAt(i));
+            if (!resultItem || !resultItem->result())
+                continue;
+
+            if (resultItem->result()->type() == Cantor::TextResult::Type)
+                document.results << static_cast<Cantor::TextResult*>(resultItem->result())->plain();
+            else
+                document.results << resultItem->document()->toPlainText();
+        }
+    }
+
+    QSet<quint64> trigrams;
+    addTrigrams(document.input.toCaseFolded(), trigrams);
+    for (const auto& result : std::as_const(document.results))
+        addTrigrams(result.toCaseFolded(), trigrams);
+
+    document.trigrams = QVector<quint64>(trigrams.cbegin(), trigrams.cend());
+    for (quint64 trigram : std::as_const(document.trigrams))
+        m_postings[trigram].insert(entry);
+}
+
+void SearchIndex::removeTrigrams(WorksheetEntry* entry, const Document& document)
+{
+    for (quint64 trigram : document.trigrams)
+    {
+        auto it = m_postings.find(trigram);
+        if (it == m_postings.end())
+            continue;
+
+        it->remove(entry);
+        if (it->isEmpty())
+            m_postings.erase(it);
+    }
+}
+
+void SearchIndex::remove(WorksheetEntry* entry)
+{
+    const auto it = m_documents.constFind(entry);
+    if (it != m_documents.constEnd())
+    {
+        removeTrigrams(entry, *it);
+        m_documents.erase(it);
+    }
+    m_editRevisions.remove(entry);
+}
+
+/*!
+ * returns a signature changing whenever the indexed text of \c entry changes.
+ * The texts themselves are not accessed here, this is done for every entry on every query.
+ */
+size_t SearchIndex::revision(WorksheetEntry* entry) const
+{
+    size_t seed = qHash(m_editRevisions.value(entry));
+
+    if (auto* textItem = qobject_cast<WorksheetTextItem*>(entry->mainTextItem()))
+        seed = qHashMulti(seed, textItem->document(), textItem->document()->revision());
+
+    if (entry->type() == CommandEntry::Type)
+    {
+        auto* commandEntry = static_cast<CommandEntry*>(entry);
+        for (int i = 0; i < commandEntry->resultItemCount(); ++i)
+        {
+            auto* resultItem = dynamic_cast<TextResultItem*>(commandEntry->resultItemAt(i));
+            if (!resultItem || !resultItem->result())
+                continue;
+
+            //the text of a text result only changes when the omitted output is loaded, the document
+            //of its item changes also when the next lines are laid out
+            auto* result = resultItem->result();
+            if (result->type() == Cantor::TextResult::Type)
+                seed = qHashMulti(seed, result, static_cast<Cantor::TextResult*>(result)->isTruncated());
+            else
+                seed = qHashMulti(seed, result, resultItem->document()->revision());
+        }
+    }
+
+    return seed;
+}
+
+bool SearchIndex::matches(const Document& document, const QString& pattern, unsigned flags, Qt::CaseSensitivity cs)
+{
+    if ((flags & document.inputFlag) && document.input.contains(pattern, cs))
+        return true;
+
+    if (flags & WorksheetEntry::SearchResult)
+        for (const auto& result : document.results)
+            if (result.contains(pattern, cs))
+                return true;
+
+    return false;
+}
+
+int SearchIndex::occurrences(const QString& text, const QString& pattern, Qt::CaseSensitivity cs)
+{
+    int count = 0;
+    qsizetype position = text.indexOf(pattern, 0, cs);
+    while (position != -1)
+    {
+        ++count;
+        position = text.indexOf(pattern, position + pattern.size(), cs);
+    }
+
+    return count;
+}
+
+void SearchIndex::addTrigrams(const QString& foldedText, QSet<quint64>& trigrams)
+{
+    for (qsizetype i = 0; i + 2 < foldedText.size(); ++i)
+        trigrams.insert(static_cast<quint64>(foldedText.at(i).unicode()) << 32
+                        | static_cast<quint64>(foldedText.at(i + 1).unicode()) << 16
+                        | foldedText.at(i + 2).unicode());
+}
@@ -0,0 +1,79 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class Worksheet;
+class WorksheetEntry;
+
+/**
+ * Inverted index over the inputs and the text results of the entries of a worksheet.
+ * The index maps the trigrams of the case folded texts to the entries containing them, so the search
+ * only has to look into the entries that can contain the pattern at all.
+ * The index is maintained incrementally: before every query only the entries whose text or results
+ * changed since the last query, detected via cheap revision signatures, are indexed again.
+ * The complete text of the text results is indexed, also the parts that are collapsed or not laid out yet.
+ */
+class SearchIndex : public QObject
+{
+  Q_OBJECT
+  public:
+    explicit SearchIndex(Worksheet*);
+
+    /**
+     * Returns the entries that contain @p pattern in one of the parts selected by @p flags
+     * (WorksheetEntry::SearchFlag). Text entries with embedded formulas are always returned
+     * when searching in LaTeX code, the code of the formulas is not indexed.
+     */
+    QSet<WorksheetEntry*> candidates(const QString& pattern, unsigned flags, Qt::CaseSensitivity);
+
+    /**
+     * Returns the number of non-overlapping occurrences of @p pattern in the parts of the entries selected by @p flags.
+     */
+    int count(const QString& pattern, unsigned flags, Qt::CaseSensitivity);
+
+    /**
+     * Returns the number of indexed entries
+     */
+    int size() const;
+
+    /**
+     * Removes all entries and their revisions from the index, they're indexed again on the next query
+     */
+    void clear();
+
+  private:
+    struct Document {
+        size_t revision{0};
+        unsigned inputFlag{0};
+        bool hasEmbeddedFormulas{false};
+        QString input;
+        QStringList results;
+        QVector<quint64> trigrams;
+    };
+
+    void update();
+    void index(WorksheetEntry*, size_t revision);
+    void removeTrigrams(WorksheetEntry*, const Document&);
+    void remove(WorksheetEntry*);
+    size_t revision(WorksheetEntry*) const;
+    static bool matches(const Document&, const QString& pattern, unsigned flags, Qt::CaseSensitivity);
+    static int occurrences(const QString& text, const QString& pattern, Qt::CaseSensitivity);
+    static void addTrigrams(const QString& foldedText, QSet<quint64>&);
+
+    Worksheet* m_worksheet;
+    QHash<WorksheetEntry*, Document> m_documents;
+    QHash<quint64, QSet<WorksheetEntry*>> m_postings;
+    QHash<WorksheetEntry*, quint64> m_editRevisions;
+};
+
+#endif /* SEARCHINDEX_H */
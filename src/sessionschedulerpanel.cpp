@@ -0,0 +1,124 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#include "sessionschedulerpanel.h"
+#include "lib/backend.h"
+#include "lib/session.h"
+#include "lib/sessionscheduler.h"
+
+#include <KLocalizedString>
+
+#include <QCheckBox>
+#include <QFormLayout>
+#include <QHeaderView>
+#include <QLocale>
+#include <QSpinBox>
+#include <QThread>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+SessionSchedulerPanel::SessionSchedulerPanel(QWidget* parent) : QWidget(parent),
+    m_view(new QTreeWidget(this)),
+    m_maxRunningSessions(new QSpinBox(this)),
+    m_limitThreads(new QCheckBox(i18n("Limit the threads of the backends"), this))
+{
+    auto* scheduler = Cantor::SessionScheduler::instance();
+
+    m_view->setRootIsDecorated(false);
+    m_view->setHeaderLabels({i18n("Session"), i18n("State"), i18n("Queue"), i18n("CPU"), i18n("Memory"), i18n("Threads")});
+    m_view->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    for (int i = 1; i < m_view->columnCount(); ++i)
+        m_view->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+
+    m_maxRunningSessions->setRange(0, QThread::idealThreadCount());
+    m_maxRunningSessions->setSpecialValueText(i18n("Unlimited"));
+    m_maxRunningSessions->setValue(scheduler->maxRunningSessions());
+    m_maxRunningSessions->setToolTip(i18n("Number of sessions evaluating at the same time, the expressions of further sessions are queued until a session is done."));
+
+    m_limitThreads->setChecked(scheduler->isThreadLimitEnabled());
+    m_limitThreads->setToolTip(i18n("Start the backends with a share of the CPU cores for the threads of their numerical libraries (OpenMP, BLAS, etc.). Applies to the backends started from now on."));
+
+    auto* settingsLayout = new QFormLayout;
+    settingsLayout->addRow(i18n("Parallel sessions:"), m_maxRunningSessions);
+    settingsLayout->addRow(m_limitThreads);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_view);
+    layout->addLayout(settingsLayout);
+
+    connect(m_maxRunningSessions, QOverload<int>::of(&QSpinBox::valueChanged), scheduler, &Cantor::SessionScheduler::setMaxRunningSessions);
+    connect(m_limitThreads, &QCheckBox::toggled, scheduler, &Cantor::SessionScheduler::setThreadLimitEnabled);
+    connect(scheduler, &Cantor::SessionScheduler::sessionsChanged, this, [this]() {
+        if (isVisible())
+            updateStatistics();
+    });
+
+    m_timer.setInterval(1000);
+    connect(&m_timer, &QTimer::timeout, this, &SessionSchedulerPanel::updateStatistics);
+}
+
+void SessionSchedulerPanel::setNameProvider(const std::function<QString(Cantor::Session*)>& provider)
+{
+    m_nameProvider = provider;
+}
+
+void SessionSchedulerPanel::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    updateStatistics();
+    m_timer.start();
+}
+
+void SessionSchedulerPanel::hideEvent(QHideEvent* event)
+{
+    QWidget::hideEvent(event);
+    m_timer.stop();
+}
+
+void SessionSchedulerPanel::updateStatistics()
+{
+    const auto& statistics = Cantor::SessionScheduler::instance()->statistics();
+    const QLocale locale;
+    const QString& unknown = QStringLiteral("-");
+
+    m_view->setUpdatesEnabled(false);
+    while (m_view->topLevelItemCount() > statistics.size())
+        delete m_view->takeTopLevelItem(m_view->topLevelItemCount() - 1);
+
+    for (int i = 0; i < statistics.size(); ++i)
+    {
+        const auto& s = statistics.at(i);
+        auto* item = m_view->topLevelItem(i);
+        if (!item)
+            item = new QTreeWidgetItem(m_view);
+
+        QString name = m_nameProvider ? m_nameProvider(s.session) : QString();
+        if (name.isEmpty())
+            name = s.session->backend()->name();
+        item->setText(0, name);
+        item->setIcon(0, QIcon::fromTheme(s.session->backend()->icon()));
+
+        QString state;
+        if (s.waiting)
+            state = i18n("Waiting");
+        else if (s.running)
+            state = i18n("Running");
+        else if (s.session->status() == Cantor::Session::Disable)
+            state = i18n("Not running");
+        else
+            state = i18n("Ready");
+        item->setText(1, state);
+
+        item->setText(2, QString::number(s.queueDepth));
+        item->setText(3, s.cpuUsage < 0 ? unknown : i18n("%1%", locale.toString(s.cpuUsage, 'f', 0)));
+        item->setText(4, s.residentMemory < 0 ? unknown : locale.formattedDataSize(s.residentMemory));
+        item->setText(5, s.threadBudget == 0 ? unknown : QString::number(s.threadBudget));
+
+        for (int column = 2; column < m_view->columnCount(); ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    m_view->setUpdatesEnabled(true);
+}
@@ -0,0 +1,54 @@
+/*
+    SPDX-License-Identifier: GPL-2.0-or-later
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+*/
+
+#ifndef _SESSIONSCHEDULERPANEL_H
+#define _SESSIONSCHEDULERPANEL_H
+
+#include <QTimer>
+#include <QWidget>
+
+#include <functional>
+
+class QCheckBox;
+class QSpinBox;
+class QTreeWidget;
+
+namespace Cantor {
+class Session;
+}
+
+/**
+ * Shows the sessions of all worksheets with the CPU and memory usage of their backend processes
+ * and the number of queued expressions, and the settings of the Cantor::SessionScheduler.
+ * The statistics are only updated while the panel is visible.
+ */
+class SessionSchedulerPanel : public QWidget
+{
+  Q_OBJECT
+  public:
+    explicit SessionSchedulerPanel(QWidget* parent = nullptr);
+    ~SessionSchedulerPanel() override = default;
+
+    /**
+     * Sets the function returning the name shown for a session, e.g. the name of its worksheet
+     */
+    void setNameProvider(const std::function<QString(Cantor::Session*)>&);
+
+  public Q_SLOTS:
+    void updateStatistics();
+
+  protected:
+    void showEvent(QShowEvent*) override;
+    void hideEvent(QHideEvent*) override;
+
+  private:
+    QTreeWidget* m_view;
+    QSpinBox* m_maxRunningSessions;
+    QCheckBox* m_limitThreads;
+    QTimer m_timer;
+    std::function<QString(Cantor::Session*)> m_nameProvider;
+};
+
+#endif /* _SESSIONSCHEDULERPANEL_H */
@@ -7,6 +7,9 @@
 #include <QDebug>
 #include <KLocalizedString>
 #include <QMovie>
+#include <QBuffer>
+#include <QPdfWriter>
+#include <QDomDocument>
 #include <KZip>
 #include <KActionCollection>
 
@@ -19,15 +22,26 @@
 #include "../markdownentry.h"
 #include "../commandentry.h"
 #include "../latexentry.h"
+#include "../textresultitem.h"
+#include "../imagecache.h"
+#include "../searchindex.h"
+#include "../animationclock.h"
+#include "../animationresultitem.h"
 #include "../lib/backend.h"
 #include "../lib/expression.h"
 #include "../lib/result.h"
 #include "../lib/textresult.h"
 #include "../lib/imageresult.h"
 #include "../lib/latexresult.h"
+#include "../lib/latexrenderer.h"
+#include "../lib/texworker.h"
 #include "../lib/animationresult.h"
 #include "../lib/mimeresult.h"
 #include "../lib/htmlresult.h"
+#include "../lib/outputcapture.h"
+#include "../lib/jupyterutils.h"
+#include "../lib/sessionscheduler.h"
+#include "../lib/defaultvariablemodel.h"
 
 #include "config-cantor-test.h"
 
@@ -35,6 +49,9 @@ static const QString dataPath = QString::fromLocal8Bit(PATH_TO_TEST_NOTEBOOKS)+Q
 
 void WorksheetTest::initTestCase()
 {
+    // the tests change the settings, don't overwrite the configuration of the user
+    QStandardPaths::setTestModeEnabled(true);
+
     const QStringList& backends = Cantor::Backend::listAvailableBackends();
     if (backends.isEmpty())
     {
@@ -6982,6 +6999,684 @@ void WorksheetTest::testRemovingAllResultsAction()
     QCOMPARE(entry, nullptr);
 }
 
+void WorksheetTest::testResultMemoization()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    Cantor::Session* session = w->session();
+    session->setResultMemoizationEnabled(true);
+
+    // the results are only reused once the values of the variables are known
+    Cantor::Expression* definition = session->evaluateExpression(QLatin1String("memoized_base = 1"));
+    waitForSignal(definition, SIGNAL(statusChanged(Cantor::Expression::Status)));
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QTRY_VERIFY(!session->dependencyFingerprint(QLatin1String("2+2")).isEmpty());
+
+    CommandEntry* entry = static_cast<CommandEntry*>(WorksheetEntry::create(CommandEntry::Type, w.data()));
+    entry->setContent(QLatin1String("2+2"));
+    entry->evaluate();
+    waitForSignal(entry->expression(), SIGNAL(gotResult()));
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    testTextResult(entry, 0, QLatin1String("4"));
+
+    // unchanged command, the previous expression and its results are reused
+    Cantor::Expression* expression = entry->expression();
+    entry->evaluate();
+    QCOMPARE(entry->expression(), expression);
+    testTextResult(entry, 0, QLatin1String("4"));
+
+    // changed command, the entry is evaluated again
+    entry->setContent(QLatin1String("3+3"));
+    entry->evaluate();
+    QVERIFY(entry->expression() != expression);
+    waitForSignal(entry->expression(), SIGNAL(gotResult()));
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    testTextResult(entry, 0, QLatin1String("6"));
+
+    // the fingerprint changes with the values of the referenced variables only
+    const QByteArray& fingerprint = session->dependencyFingerprint(QLatin1String("memoized_value*2"));
+    const QByteArray& otherFingerprint = session->dependencyFingerprint(QLatin1String("other_value*2"));
+    Cantor::Expression* assignment = session->evaluateExpression(QLatin1String("memoized_value = 5"));
+    waitForSignal(assignment, SIGNAL(statusChanged(Cantor::Expression::Status)));
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QVERIFY(session->dependencyFingerprint(QLatin1String("memoized_value*2")) != fingerprint);
+    QCOMPARE(session->dependencyFingerprint(QLatin1String("other_value*2")), otherFingerprint);
+}
+
+void WorksheetTest::testMemoizedFunctionRedefinition()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("maxima"));
+    if (!backend || backend->isEnabled() == false)
+        QSKIP("Skip, because maxima backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(new Worksheet(backend, nullptr, false));
+    new WorksheetView(w.data(), nullptr);
+    w->loginToSession();
+    Cantor::Session* session = w->session();
+    QTRY_COMPARE_WITH_TIMEOUT(session->loginState(), Cantor::Session::LoggedIn, 25000);
+    session->setResultMemoizationEnabled(true);
+
+    Cantor::Expression* definition = session->evaluateExpression(QLatin1String("memoized_f(x) := x + 1"));
+    QTRY_COMPARE_WITH_TIMEOUT(definition->status(), Cantor::Expression::Done, 25000);
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QTRY_VERIFY(session->variableModel()->functions().contains(QLatin1String("memoized_f")));
+    const QByteArray& fingerprint = session->dependencyFingerprint(QLatin1String("memoized_f(1)"));
+    QVERIFY(!fingerprint.isEmpty());
+
+    // the function isn't redefined by calling it
+    Cantor::Expression* call = session->evaluateExpression(QLatin1String("memoized_f(1)"));
+    QTRY_COMPARE_WITH_TIMEOUT(call->status(), Cantor::Expression::Done, 25000);
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QCOMPARE(session->dependencyFingerprint(QLatin1String("memoized_f(1)")), fingerprint);
+
+    // the redefined function changes the fingerprint of the commands calling it
+    definition = session->evaluateExpression(QLatin1String("memoized_f(x) := x + 2"));
+    QTRY_COMPARE_WITH_TIMEOUT(definition->status(), Cantor::Expression::Done, 25000);
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QVERIFY(session->dependencyFingerprint(QLatin1String("memoized_f(1)")) != fingerprint);
+}
+
+void WorksheetTest::testStaleEntries()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    Cantor::Session* session = w->session();
+
+    auto* first = static_cast<CommandEntry*>(w->appendCommandEntry());
+    first->setContent(QLatin1String("stale_a = 2"));
+    auto* second = static_cast<CommandEntry*>(w->appendCommandEntry());
+    second->setContent(QLatin1String("stale_b = stale_a * 3"));
+    auto* third = static_cast<CommandEntry*>(w->appendCommandEntry());
+    third->setContent(QLatin1String("stale_c = 5"));
+
+    // not evaluated yet
+    QVERIFY(first->isStale());
+    QVERIFY(second->isStale());
+    QVERIFY(third->isStale());
+
+    w->evaluate();
+    QTRY_VERIFY_WITH_TIMEOUT(!third->isStale(), 25000);
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QVERIFY(!first->isStale());
+    QVERIFY(!second->isStale());
+
+    // modifying the first entry invalidates the second one, the third one is independent
+    first->setContent(QLatin1String("stale_a = 4"));
+    QVERIFY(first->isStale());
+    QVERIFY(second->isStale());
+    QVERIFY(!third->isStale());
+
+    Cantor::Expression* thirdExpression = third->expression();
+    w->evaluateStaleEntries();
+    QTRY_VERIFY_WITH_TIMEOUT(!second->isStale(), 25000);
+    QTRY_COMPARE(session->status(), Cantor::Session::Done);
+    QVERIFY(!first->isStale());
+    QCOMPARE(third->expression(), thirdExpression);
+}
+
+void WorksheetTest::testSessionStateSnapshot()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    w->enableSessionStateSaving(true);
+
+    auto* first = static_cast<CommandEntry*>(w->appendCommandEntry());
+    first->setContent(QLatin1String("snapshot_a = 21"));
+    auto* second = static_cast<CommandEntry*>(w->appendCommandEntry());
+    second->setContent(QLatin1String("snapshot_b = snapshot_a * 2"));
+
+    w->evaluate();
+    QTRY_VERIFY_WITH_TIMEOUT(!second->isStale(), 25000);
+    QTRY_COMPARE(w->session()->status(), Cantor::Session::Done);
+
+    // the state is collected on request, saving the worksheet doesn't wait for the backend
+    QVERIFY(!w->isSessionStateCollected());
+    w->collectSessionState();
+    QTRY_VERIFY_WITH_TIMEOUT(w->isSessionStateCollected(), 25000);
+    QTRY_COMPARE(w->session()->status(), Cantor::Session::Done);
+    QByteArray data = w->saveToByteArray();
+
+    // every evaluation outdates the collected state, also the ones not changing the variable model
+    auto* mutation = w->session()->evaluateExpression(QLatin1String("snapshot_list = [1]; snapshot_list.append(2)"));
+    QTRY_COMPARE(mutation->status(), Cantor::Expression::Done);
+    QTRY_COMPARE(w->session()->status(), Cantor::Session::Done);
+    QVERIFY(!w->isSessionStateCollected());
+
+    const auto findEntry = [](Worksheet* worksheet, const QString& command) -> CommandEntry* {
+        for (auto* entry = worksheet->firstEntry(); entry; entry = entry->next())
+            if (entry->type() == CommandEntry::Type && static_cast<CommandEntry*>(entry)->command() == command)
+                return static_cast<CommandEntry*>(entry);
+        return nullptr;
+    };
+
+    // the state is restored after the login, the entries don't need to be evaluated again
+    QScopedPointer<Worksheet> restored(new Worksheet(Cantor::Backend::getBackend(QLatin1String("maxima")), nullptr, false));
+    new WorksheetView(restored.data(), nullptr);
+    restored->load(&data);
+    auto* restoredFirst = findEntry(restored.data(), QLatin1String("snapshot_a = 21"));
+    auto* restoredSecond = findEntry(restored.data(), QLatin1String("snapshot_b = snapshot_a * 2"));
+    QVERIFY(restoredFirst);
+    QVERIFY(restoredSecond);
+    QVERIFY(restoredFirst->isStale());
+    QVERIFY(restoredSecond->isStale());
+
+    restored->loginToSession();
+    QTRY_VERIFY_WITH_TIMEOUT(!restoredSecond->isStale(), 25000);
+    QTRY_COMPARE(restored->session()->status(), Cantor::Session::Done);
+    QVERIFY(!restoredFirst->isStale());
+
+    Cantor::Expression* expression = restored->session()->evaluateExpression(QLatin1String("snapshot_b"));
+    waitForSignal(expression, SIGNAL(gotResult()));
+    QVERIFY(expression->result());
+    QCOMPARE(expression->result()->data().toString(), QLatin1String("42"));
+
+    // the entries changed before the login and the entries depending on them stay stale
+    QScopedPointer<Worksheet> changed(new Worksheet(Cantor::Backend::getBackend(QLatin1String("maxima")), nullptr, false));
+    new WorksheetView(changed.data(), nullptr);
+    changed->load(&data);
+    auto* changedFirst = findEntry(changed.data(), QLatin1String("snapshot_a = 21"));
+    auto* changedSecond = findEntry(changed.data(), QLatin1String("snapshot_b = snapshot_a * 2"));
+    QVERIFY(changedFirst);
+    QVERIFY(changedSecond);
+    changedFirst->setContent(QLatin1String("snapshot_a = 1"));
+
+    changed->loginToSession();
+    QTRY_COMPARE_WITH_TIMEOUT(changed->session()->status(), Cantor::Session::Done, 25000);
+    QVERIFY(changedFirst->isStale());
+    QVERIFY(changedSecond->isStale());
+}
+
+void WorksheetTest::testTocNodeDelta()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+
+    auto* first = static_cast<CommandEntry*>(w->appendCommandEntry());
+    auto* second = static_cast<CommandEntry*>(w->appendCommandEntry());
+    w->refreshTocStructure();
+    QCoreApplication::processEvents();
+
+    QSignalSpy snapshotSpy(w.data(), &Worksheet::tocNodesChanged);
+    QSignalSpy deltaSpy(w.data(), &Worksheet::tocNodesUpdated);
+
+    // nothing is sent if nothing changed
+    w->refreshTocStructure();
+    QCOMPARE(deltaSpy.count(), 0);
+
+    // renaming sends the renamed node only
+    w->renameCommandEntry(first->commandId(), QLatin1String("First"));
+    QTRY_COMPARE(deltaSpy.count(), 1);
+    QVariantMap delta = deltaSpy.last().first().toMap();
+    QVERIFY(!delta.contains(QLatin1String("inserted")));
+    QVERIFY(!delta.contains(QLatin1String("removed")));
+    const QVariantList changed = delta.value(QLatin1String("changed")).toList();
+    QCOMPARE(changed.size(), 1);
+    QCOMPARE(changed.first().toMap().value(QLatin1String("customTitle")).toString(), QLatin1String("First"));
+
+    // a new entry is sent as an insertion after its predecessor
+    auto* third = static_cast<CommandEntry*>(w->appendCommandEntry());
+    w->refreshTocStructure();
+    QVERIFY(deltaSpy.count() >= 2);
+    delta = deltaSpy.last().first().toMap();
+    const QVariantList inserted = delta.value(QLatin1String("inserted")).toList();
+    QCOMPARE(inserted.size(), 1);
+    QCOMPARE(inserted.first().toMap().value(QLatin1String("id")).toString(), QLatin1String("command:") + third->commandId());
+    QCOMPARE(inserted.first().toMap().value(QLatin1String("afterId")).toString(), QLatin1String("command:") + second->commandId());
+    QVERIFY(!delta.contains(QLatin1String("changed")));
+
+    QCOMPARE(snapshotSpy.count(), 0);
+}
+
+void WorksheetTest::testLargeTextResult()
+{
+    QString text;
+    for (int i = 0; i < 5000; ++i)
+        text += QLatin1String("line ") + QString::number(i) + QLatin1Char('\n');
+
+    Cantor::TextResult result(text);
+    QCOMPARE(result.lineCount(), 5000);
+    QCOMPARE(result.lines(10, 2), QLatin1String("line 10\nline 11"));
+    QCOMPARE(result.lines(4999, 5), QLatin1String("line 4999"));
+    QCOMPARE(result.findLine(QLatin1String("line 4321")), 4321);
+    QCOMPARE(result.findLine(QLatin1String("line 12"), 13), 120);
+    QCOMPARE(result.findLine(QLatin1String("missing")), -1);
+
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+
+    CommandEntry* entry = static_cast<CommandEntry*>(WorksheetEntry::create(CommandEntry::Type, w.data()));
+    entry->setContent(QLatin1String("print('\\n'.join('line ' + str(i) for i in range(5000)))"));
+    entry->evaluate();
+    waitForSignal(entry->expression(), SIGNAL(gotResult()));
+
+    // only the first page is laid out
+    QCOMPARE(entry->resultItemCount(), 1);
+    auto* item = dynamic_cast<TextResultItem*>(entry->resultItemAt(0));
+    QVERIFY(item);
+    QVERIFY(item->document()->blockCount() < 5000);
+
+    // the search pages in the lines up to the match
+    const QTextCursor& cursor = item->search(QLatin1String("line 4998"), QTextDocument::FindFlags(), WorksheetCursor());
+    QVERIFY(!cursor.isNull());
+    QCOMPARE(cursor.selectedText(), QLatin1String("line 4998"));
+}
+
+void WorksheetTest::testOutputCapture()
+{
+    QString text;
+    for (int i = 0; i < 2000; ++i)
+        text += QLatin1String("line ") + QString::number(i) + QLatin1Char('\n');
+    text.chop(1);
+
+    // the output fits into the budget and is kept completely
+    Cantor::OutputCapture small(text.size());
+    small.append(text);
+    QVERIFY(!small.isTruncated());
+    QCOMPARE(small.text(), text);
+
+    // only the head and the tail are kept in memory, the rest is spilled to disk
+    Cantor::OutputCapture capture(1000);
+    for (int i = 0; i < text.size(); i += 100)
+        capture.append(text.mid(i, 100));
+    QVERIFY(capture.isTruncated());
+    QCOMPARE(capture.size(), text.size());
+    QVERIFY(capture.text().startsWith(text.left(500)));
+    QVERIFY(capture.text().endsWith(text.right(500)));
+
+    QScopedPointer<Cantor::TextResult> result(capture.createResult());
+    QVERIFY(capture.isEmpty());
+    QVERIFY(result->isTruncated());
+    QVERIFY(result->data().toString().size() < text.size());
+    QCOMPARE(result->fullText(), text);
+
+    // the complete output is saved in the archive
+    QBuffer buffer;
+    KZip zip(&buffer);
+    QVERIFY(zip.open(QIODevice::WriteOnly));
+    result->saveAdditionalData(&zip);
+    QDomDocument doc;
+    const QDomElement& xml = result->toXml(doc);
+    zip.close();
+
+    QVERIFY(zip.open(QIODevice::ReadOnly));
+    const KArchiveEntry* entry = zip.directory()->entry(xml.attribute(QLatin1String("filename")));
+    QVERIFY(entry && entry->isFile());
+    QCOMPARE(QString::fromUtf8(static_cast<const KArchiveFile*>(entry)->data()), text);
+    zip.close();
+
+    // and in the notebook
+    QString exported;
+    const auto& lines = result->toJupyterJson().toObject().value(QLatin1String("text")).toArray();
+    for (const auto& line : lines)
+        exported += line.toString();
+    QVERIFY(exported.startsWith(text));
+
+    // the omitted part is paged in from the file
+    const int truncatedLineCount = result->lineCount();
+    result->loadOmittedOutput();
+    QVERIFY(result->isOmittedOutputLoaded());
+    QVERIFY(result->isTruncated());
+    QVERIFY(result->data().toString().size() < text.size());
+    QCOMPARE(result->lineCount(), 2000);
+    QVERIFY(result->lineCount() > truncatedLineCount);
+    QCOMPARE(result->lines(0, 2000), text);
+    QCOMPARE(result->lines(1000, 2), QLatin1String("line 1000\nline 1001"));
+    QCOMPARE(result->lines(1999, 5), QLatin1String("line 1999"));
+    QCOMPARE(result->findLine(QLatin1String("line 1500"), 10), 1500);
+    QCOMPARE(result->findLine(QLatin1String("line 15"), 1600), -1);
+}
+
+void WorksheetTest::testImageCache()
+{
+    QCOMPARE(ImageCache::mipLevelSize(QSize(2000, 1000), QSize(400, 200)), QSize(500, 250));
+    QCOMPARE(ImageCache::mipLevelSize(QSize(2000, 1000), QSize(600, 300)), QSize(1000, 500));
+    QCOMPARE(ImageCache::mipLevelSize(QSize(2000, 1000), QSize(3000, 1500)), QSize(2000, 1000));
+
+    QTemporaryFile file(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.png"));
+    QVERIFY(file.open());
+    QImage original(2000, 1000, QImage::Format_RGB32);
+    original.fill(Qt::red);
+    QVERIFY(original.save(file.fileName(), "PNG"));
+
+    ImageCache cache;
+
+    // the image is decoded asynchronously into the mip level
+    QVERIFY(cache.image(file.fileName(), QSize(400, 200)).isNull());
+    QSignalSpy spy(&cache, &ImageCache::imageDecoded);
+    QVERIFY(spy.wait(5000));
+    const QImage& image = cache.image(file.fileName(), QSize(400, 200));
+    QCOMPARE(image.size(), QSize(500, 250));
+    QCOMPARE(image.pixelColor(10, 10), QColor(Qt::red));
+
+    // the least recently used images are dropped when the cache is full
+    cache.setMaxSize(image.sizeInBytes() * 2);
+    cache.decodedImage(file.fileName(), QSize(200, 100));
+    cache.decodedImage(file.fileName(), QSize(100, 50));
+    QVERIFY(cache.size() <= cache.maxSize());
+
+    // a file overwritten under the same name is decoded again
+    QImage overwritten(1000, 1000, QImage::Format_RGB32);
+    overwritten.fill(Qt::blue);
+    QVERIFY(overwritten.save(file.fileName(), "PNG"));
+    const QImage& newImage = cache.decodedImage(file.fileName(), QSize(1000, 1000));
+    QCOMPARE(newImage.size(), QSize(1000, 1000));
+    QCOMPARE(newImage.pixelColor(10, 10), QColor(Qt::blue));
+    QVERIFY(original.save(file.fileName(), "PNG"));
+
+    // the full resolution of raster image results is not kept in memory
+    Cantor::ImageResult result(QUrl::fromLocalFile(file.fileName()));
+    QVERIFY(!result.isVector());
+    QCOMPARE(result.originalSize(), QSize(2000, 1000));
+
+    // only a copy in the display resolution is kept and it's decoded only once
+    result.setDisplaySize(QSize(400, 200));
+    const QImage& displayed = result.data().value<QImage>();
+    QVERIFY(!displayed.isNull());
+    QVERIFY(displayed.width() < 2000);
+    QCOMPARE(result.data().value<QImage>().constBits(), displayed.constBits());
+
+    // the full resolution is read from the file again when saving
+    QTemporaryFile saved(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.png"));
+    QVERIFY(saved.open());
+    result.save(saved.fileName());
+    QCOMPARE(QImage(saved.fileName()).size(), QSize(2000, 1000));
+}
+
+void WorksheetTest::testSearchIndex()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    SearchIndex* index = w->searchIndex();
+
+    auto* command = static_cast<CommandEntry*>(w->appendCommandEntry());
+    command->setContent(QLatin1String("print('needle ' * 3)"));
+    auto* text = static_cast<TextEntry*>(w->appendTextEntry());
+    text->setContent(QLatin1String("A Needle in a haystack"));
+    w->appendCommandEntry()->setContent(QLatin1String("1+1"));
+
+    // only the entries containing the pattern are candidates
+    QCOMPARE(index->candidates(QLatin1String("needle"), WorksheetEntry::SearchAll, Qt::CaseInsensitive), (QSet<WorksheetEntry*>{command, text}));
+    QCOMPARE(index->candidates(QLatin1String("needle"), WorksheetEntry::SearchAll, Qt::CaseSensitive), QSet<WorksheetEntry*>{command});
+    QCOMPARE(index->candidates(QLatin1String("needle"), WorksheetEntry::SearchText, Qt::CaseInsensitive), QSet<WorksheetEntry*>{text});
+    QVERIFY(index->candidates(QLatin1String("haystacks"), WorksheetEntry::SearchAll, Qt::CaseInsensitive).isEmpty());
+    QCOMPARE(index->candidates(QLatin1String("1"), WorksheetEntry::SearchAll, Qt::CaseInsensitive).size(), 1);
+
+    // edits and results are indexed on the next query
+    text->setContent(QLatin1String("no match here"));
+    QCOMPARE(index->candidates(QLatin1String("needle"), WorksheetEntry::SearchAll, Qt::CaseInsensitive), QSet<WorksheetEntry*>{command});
+
+    command->evaluate();
+    waitForSignal(command->expression(), SIGNAL(gotResult()));
+    QTRY_COMPARE(w->session()->status(), Cantor::Session::Done);
+    QCOMPARE(index->count(QLatin1String("needle"), WorksheetEntry::SearchResult, Qt::CaseSensitive), 3);
+    QCOMPARE(index->count(QLatin1String("needle"), WorksheetEntry::SearchAll, Qt::CaseSensitive), 4);
+
+    // deleted entries are removed from the index
+    const int size = index->size();
+    text->startRemoving(false);
+    QTRY_COMPARE(index->size(), size - 1);
+
+    // the cleared index is built again on the next query
+    index->clear();
+    QCOMPARE(index->size(), 0);
+    QCOMPARE(index->candidates(QLatin1String("needle"), WorksheetEntry::SearchAll, Qt::CaseInsensitive), QSet<WorksheetEntry*>{command});
+    QCOMPARE(index->size(), size - 1);
+}
+
+void WorksheetTest::testPrint()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    w->appendCommandEntry()->setContent(QLatin1String("1+1"));
+    w->appendPageBreakEntry();
+    w->appendCommandEntry()->setContent(QLatin1String("2+2"));
+
+    QTemporaryFile file(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.pdf"));
+    QVERIFY(file.open());
+
+    // the worksheet is printed page by page
+    {
+        QPdfWriter writer(file.fileName());
+        QSignalSpy spy(w.data(), &Worksheet::printProgress);
+        QVERIFY(w->print(&writer));
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(spy.last().at(0).toInt(), 2);
+        QCOMPARE(spy.last().at(1).toInt(), 2);
+    }
+    QVERIFY(QFileInfo(file.fileName()).size() > 0);
+    QVERIFY(!w->isPrinting());
+
+    // printing stops after the current page when it's canceled
+    {
+        QPdfWriter writer(file.fileName());
+        QSignalSpy spy(w.data(), &Worksheet::printProgress);
+        connect(w.data(), &Worksheet::printProgress, w.data(), &Worksheet::cancelPrinting);
+        QVERIFY(!w->print(&writer));
+        QCOMPARE(spy.count(), 1);
+    }
+}
+
+/*!
+ * the worksheet is exported to LaTeX entry by entry, the header and the footer are written once
+ */
+void WorksheetTest::testLatexExport()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    if (QStandardPaths::locate(QStandardPaths::AppDataLocation, QLatin1String("xslt/latex.xsl")).isEmpty())
+        QSKIP("Skip, because the LaTeX stylesheet is not installed", SkipSingle);
+
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    w->appendCommandEntry()->setContent(QLatin1String("x = 1 < 2 & True"));
+    w->appendTextEntry()->setContent(QLatin1String("Some text"));
+    w->appendPageBreakEntry();
+    w->appendCommandEntry()->setContent(QLatin1String("print(x)"));
+
+    QTemporaryFile file(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.tex"));
+    QVERIFY(file.open());
+    w->saveLatex(file.fileName());
+
+    QFile tex(file.fileName());
+    QVERIFY(tex.open(QIODevice::ReadOnly));
+    const QString& latex = QString::fromUtf8(tex.readAll());
+
+    QVERIFY(latex.startsWith(QLatin1String("\\documentclass")));
+    QVERIFY(latex.trimmed().endsWith(QLatin1String("\\end{document}")));
+    QCOMPARE(latex.count(QLatin1String("\\documentclass")), 1);
+    QCOMPARE(latex.count(QLatin1String("\\begin{document}")), 1);
+    QCOMPARE(latex.count(QLatin1String("\\end{document}")), 1);
+
+    // the entries follow each other in their order, the escaped characters of the commands are restored
+    const qsizetype command1 = latex.indexOf(QLatin1String("\\begin{verbatim}\nx = 1 < 2 & True\n\\end{verbatim}"));
+    const qsizetype text = latex.indexOf(QLatin1String("Some text"));
+    const qsizetype pageBreak = latex.indexOf(QLatin1String("\\newpage{}"));
+    const qsizetype command2 = latex.indexOf(QLatin1String("\\begin{verbatim}\nprint(x)\n\\end{verbatim}"));
+    QVERIFY(latex.indexOf(QLatin1String("\\begin{document}")) < command1);
+    QVERIFY(command1 != -1);
+    QVERIFY(command1 < text);
+    QVERIFY(text < pageBreak);
+    QVERIFY(pageBreak < command2);
+    QVERIFY(command2 < latex.indexOf(QLatin1String("\\end{document}")));
+}
+
+void WorksheetTest::testJupyterImagePassthrough()
+{
+    QImage image(40, 20, QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+
+    QJsonObject bundle;
+    bundle.insert(Cantor::JupyterUtils::pngMime, QString::fromLatin1(png.toBase64()));
+    bundle.insert(Cantor::JupyterUtils::textMime, QLatin1String("<Figure size 40x20>"));
+
+    // the encoded image is written to the file as it is
+    const QString& fileName = Cantor::JupyterUtils::saveEncodedImage(bundle, Cantor::JupyterUtils::pngMime);
+    QVERIFY(!fileName.isEmpty());
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), png);
+    file.close();
+
+    // the image is decoded from the file on demand and the bundle is saved unchanged
+    Cantor::ImageResult result(QUrl::fromLocalFile(fileName), QLatin1String("<Figure size 40x20>"));
+    result.setOriginalFormat(Cantor::JupyterUtils::pngMime);
+    result.setJupyterBundle(bundle);
+    QCOMPARE(result.originalSize(), QSize(40, 20));
+    QCOMPARE(result.data().value<QImage>().pixelColor(0, 0), QColor(Qt::blue));
+    QCOMPARE(result.toJupyterJson().toObject().value(QLatin1String("data")).toObject(), bundle);
+
+    QFile::remove(fileName);
+}
+
+void WorksheetTest::testResultPayloadSharing()
+{
+    QString text;
+    for (int i = 0; i < 100000; ++i)
+        text += QLatin1String("line ") + QString::number(i) + QLatin1Char('\n');
+
+    // the text is shared between the representations and not copied when accessed
+    Cantor::TextResult result(text, QString(text));
+    QCOMPARE(result.plain().constData(), result.data().toString().constData());
+
+    // vector images are kept in the encoded form only and rendered on demand
+    QTemporaryFile file(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.svg"));
+    QVERIFY(file.open());
+    file.write("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"72pt\" height=\"36pt\"><rect width=\"100%\" height=\"100%\" fill=\"red\"/></svg>");
+    file.close();
+    Cantor::ImageResult image(QUrl::fromLocalFile(file.fileName()));
+    QVERIFY(image.isVector());
+    QVERIFY(image.displaySize().isValid());
+    QCOMPARE(image.renderToDisplaySize(image.displaySize()).deviceIndependentSize().toSize(), image.displaySize());
+    const QImage& rendered = image.data().value<QImage>();
+    QVERIFY(!rendered.isNull());
+
+    // the rendered image is kept once and shared, not rendered again for every access
+    QCOMPARE(image.data().value<QImage>().constBits(), rendered.constBits());
+    QCOMPARE(image.renderToDisplaySize(image.displaySize()).constBits(), image.renderToDisplaySize(image.displaySize()).constBits());
+
+    // the shared text is saved once
+    QDomDocument doc;
+    doc.appendChild(result.toXml(doc));
+    QCOMPARE(doc.toString().count(QLatin1String("line 99999")), 1);
+
+    // the encoded vector image is saved once as a file of the archive and not embedded in the XML
+    QBuffer buffer;
+    KZip zip(&buffer);
+    QVERIFY(zip.open(QIODevice::WriteOnly));
+    image.saveAdditionalData(&zip);
+    QDomDocument imageDoc;
+    imageDoc.appendChild(image.toXml(imageDoc));
+    zip.close();
+    QVERIFY(!imageDoc.toString().contains(QLatin1String("<svg")));
+
+    QVERIFY(zip.open(QIODevice::ReadOnly));
+    QCOMPARE(zip.directory()->entries().size(), 1);
+    const KArchiveEntry* entry = zip.directory()->entry(QFileInfo(file.fileName()).fileName());
+    QVERIFY(entry && entry->isFile());
+    QVERIFY(static_cast<const KArchiveFile*>(entry)->data().startsWith("<svg"));
+    zip.close();
+}
+
+void WorksheetTest::testAnimationClock()
+{
+    // take the animation from a notebook, GIF files can't be written with Qt
+    QFile notebook(dataPath + QLatin1String("TestResultsLoad.ipynb"));
+    QVERIFY(notebook.open(QIODevice::ReadOnly));
+    const QByteArray& content = notebook.readAll();
+    const QByteArray prefix("data:image/gif;base64,");
+    const qsizetype start = content.indexOf(prefix) + prefix.size();
+    QVERIFY(start >= prefix.size());
+    const QByteArray& gif = QByteArray::fromBase64(content.mid(start, content.indexOf('"', start) - start));
+
+    QTemporaryFile file1(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.gif"));
+    QTemporaryFile file2(QDir::tempPath() + QLatin1String("/cantor_test-XXXXXX.gif"));
+    for (auto* file : {&file1, &file2})
+    {
+        QVERIFY(file->open());
+        file->write(gif);
+        file->close();
+    }
+
+    // the frames of identical animations are decoded and kept only once
+    AnimationClock clock(nullptr);
+    QVERIFY(clock.frameCount(file1.fileName()) > 1);
+    const qint64 size = clock.size();
+    QVERIFY(size > 0);
+    QCOMPARE(clock.frame(file2.fileName(), 1).constBits(), clock.frame(file1.fileName(), 1).constBits());
+    QCOMPARE(clock.size(), size);
+
+    // animations exceeding the budget are not cached but still played
+    clock.setMaxSize(size / 2);
+    QVERIFY(clock.size() <= clock.maxSize());
+    QVERIFY(!clock.frame(file1.fileName(), 1).isNull());
+    QCOMPARE(clock.size(), 0);
+
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    Cantor::AnimationResult result(QUrl::fromLocalFile(file1.fileName()));
+    QScopedPointer<Worksheet> w(std::move(loadWorksheet(QLatin1String("EmptyPythonWorksheet.cws"))));
+    AnimationClock* worksheetClock = w->animationClock();
+
+    auto* command = static_cast<CommandEntry*>(w->appendCommandEntry());
+    auto* item = new AnimationResultItem(command, &result);
+    QCOMPARE(worksheetClock->state(item), AnimationClock::Running);
+    QCOMPARE(item->imageSize(), clock.frame(file1.fileName(), 0).size());
+
+    // only the first frame is decoded right away, the other frames are decoded in the thread pool
+    QTRY_VERIFY(worksheetClock->size() > 0);
+
+    // the animation is only advanced while it's visible in the view
+    item->setPos(command->mapFromScene(w->worksheetView()->viewRect().topLeft()));
+    worksheetClock->updateVisibility();
+    QCOMPARE(worksheetClock->activeCount(), 1);
+
+    item->setPos(command->mapFromScene(w->worksheetView()->viewRect().bottomLeft() + QPointF(0, 10000)));
+    worksheetClock->updateVisibility();
+    QCOMPARE(worksheetClock->activeCount(), 0);
+    QCOMPARE(worksheetClock->state(item), AnimationClock::Running);
+
+    item->setPos(command->mapFromScene(w->worksheetView()->viewRect().topLeft()));
+    worksheetClock->updateVisibility();
+    QCOMPARE(worksheetClock->activeCount(), 1);
+
+    worksheetClock->pause(item);
+    QCOMPARE(worksheetClock->activeCount(), 0);
+    worksheetClock->stop(item);
+    QCOMPARE(worksheetClock->state(item), AnimationClock::Stopped);
+
+    delete item;
+    QCOMPARE(worksheetClock->state(item), AnimationClock::Stopped);
+    QCOMPARE(worksheetClock->activeCount(), 0);
+}
+
 void WorksheetTest::testMathRender()
 {
     Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
@@ -7049,4 +7744,264 @@ void WorksheetTest::testMathRender2()
     QCOMPARE(mathNode.text(), QLatin1String("$12$"));
 }
 
+void WorksheetTest::testMathRenderReuse()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    Worksheet* w = new Worksheet(Cantor::Backend::getBackend(QLatin1String("python")), nullptr);
+    WorksheetView v(w, nullptr);
+    v.setEnabled(false);
+    w->enableEmbeddedMath(true);
+
+    if (!w->mathRenderer()->mathRenderAvailable())
+        QSKIP("This test needs workable embedded math (pdflatex)", SkipSingle);
+
+    MarkdownEntry* entry = static_cast<MarkdownEntry*>(WorksheetEntry::create(MarkdownEntry::Type, w));
+    entry->setContent(QLatin1String("first $12$ block\n\nsecond $13$ block"));
+    entry->evaluate(WorksheetEntry::InternalEvaluation);
+
+    // Give 1 second to math renderer
+    QTest::qWait(1000);
+
+    // only the second block is changed, the unchanged formula is inserted again right away
+    entry->setContent(QLatin1String("first $12$ block\n\nsecond $13$ block"));
+    static_cast<WorksheetTextItem*>(entry->mainTextItem())->setPlainText(QLatin1String("first $12$ block\n\nchanged $14$ block"));
+    entry->evaluate(WorksheetEntry::InternalEvaluation);
+
+    QDomDocument doc;
+    QBuffer buffer;
+    KZip archive(&buffer);
+    QDomElement elem = entry->toXml(doc, &archive);
+
+    QDomNodeList list = elem.elementsByTagName(QLatin1String("EmbeddedMath"));
+    QCOMPARE(list.count(), 2);
+    QCOMPARE(list.at(0).toElement().text(), QLatin1String("$12$"));
+    QCOMPARE(list.at(0).toElement().attribute(QStringLiteral("rendered")).toInt(), 1);
+    QCOMPARE(list.at(1).toElement().text(), QLatin1String("$14$"));
+    QCOMPARE(list.at(1).toElement().attribute(QStringLiteral("rendered")).toInt(), 0);
+
+    QTest::qWait(1000);
+
+    elem = entry->toXml(doc, &archive);
+    list = elem.elementsByTagName(QLatin1String("EmbeddedMath"));
+    QCOMPARE(list.count(), 2);
+    QCOMPARE(list.at(1).toElement().attribute(QStringLiteral("rendered")).toInt(), 1);
+
+    QDomElement htmlElem = elem.firstChildElement(QLatin1String("HTML"));
+    QVERIFY(htmlElem.text().contains(QLatin1String("first")));
+    QVERIFY(htmlElem.text().contains(QLatin1String("changed")));
+}
+
+void WorksheetTest::testMathRenderCancel()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    Worksheet* w = new Worksheet(Cantor::Backend::getBackend(QLatin1String("python")), nullptr);
+    WorksheetView v(w, nullptr);
+    v.setEnabled(false);
+    w->enableEmbeddedMath(true);
+
+    if (!w->mathRenderer()->mathRenderAvailable())
+        QSKIP("This test needs workable embedded math (pdflatex)", SkipSingle);
+
+    MathRenderer* renderer = w->mathRenderer();
+    QVERIFY(renderer->maxThreadCount() >= 2);
+
+    MarkdownEntry* entry = static_cast<MarkdownEntry*>(WorksheetEntry::create(MarkdownEntry::Type, w));
+    entry->setContent(QLatin1String("$1$ $2$ $3$ $4$ $5$ $6$ $7$ $8$"));
+    entry->evaluate(WorksheetEntry::InternalEvaluation);
+    QCOMPARE(renderer->pendingJobCount(), 8);
+
+    // editing the entry again supersedes the pending jobs, no results are delivered anymore
+    entry->setContent(QLatin1String("no math"));
+    QCOMPARE(renderer->pendingJobCount(), 0);
+
+    // the jobs of a deleted entry are canceled
+    entry = static_cast<MarkdownEntry*>(WorksheetEntry::create(MarkdownEntry::Type, w));
+    entry->setContent(QLatin1String("$9$ $10$"));
+    entry->evaluate(WorksheetEntry::InternalEvaluation);
+    QCOMPARE(renderer->pendingJobCount(), 2);
+    delete entry;
+    QCOMPARE(renderer->pendingJobCount(), 0);
+}
+
+void WorksheetTest::testMathRerender()
+{
+    Cantor::Backend* backend = Cantor::Backend::getBackend(QLatin1String("python"));
+    if (backend && backend->isEnabled() == false)
+        QSKIP("Skip, because python backend don't available", SkipSingle);
+
+    Worksheet* w = new Worksheet(Cantor::Backend::getBackend(QLatin1String("python")), nullptr);
+    WorksheetView v(w, nullptr);
+    v.setEnabled(false);
+    w->enableEmbeddedMath(true);
+
+    if (!w->mathRenderer()->mathRenderAvailable())
+        QSKIP("This test needs workable embedded math (pdflatex)", SkipSingle);
+
+    MarkdownEntry* entry = static_cast<MarkdownEntry*>(WorksheetEntry::create(MarkdownEntry::Type, w));
+    entry->setContent(QLatin1String("$x^2$"));
+    entry->evaluate(WorksheetEntry::InternalEvaluation);
+
+    // Give 1 second to math renderer
+    QTest::qWait(1000);
+
+    QTextDocument* document = static_cast<WorksheetTextItem*>(entry->mainTextItem())->document();
+    const QTextCursor& cursor = document->find(QString(QChar::ObjectReplacementCharacter));
+    QVERIFY(!cursor.isNull());
+    const QUrl url(cursor.charFormat().toImageFormat().name());
+    const QImage& image = document->resource(QTextDocument::ImageResource, url).value<QImage>();
+    QVERIFY(!image.isNull());
+
+    // the old image is shown until the formula is rendered for the new scale in the background
+    QSignalSpy spy(w->mathRenderer(), &MathRenderer::rerendered);
+    w->setViewSize(800, 500, w->mathRenderer()->scale() * 2);
+    QCOMPARE(document->resource(QTextDocument::ImageResource, url).value<QImage>().size(), image.size());
+
+    QVERIFY(spy.wait(5000));
+    QCOMPARE(spy.first().at(0).value<QTextDocument*>(), document);
+    QVERIFY(document->resource(QTextDocument::ImageResource, url).value<QImage>().width() > image.width());
+}
+
+void WorksheetTest::testTexWorker()
+{
+    if (!Cantor::LatexRenderer::isLatexAvailable())
+        QSKIP("This test needs pdflatex", SkipSingle);
+
+    const QString& tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    const QString& preamble = QLatin1String("\\documentclass{minimal}\\usepackage{amsmath}");
+    auto* worker = Cantor::TexWorker::instance();
+
+    // the second document is typeset by the process which was started while the first one was typeset
+    for (const auto& formula : {QLatin1String("$x^2$"), QLatin1String("$\\frac{1}{y}$")})
+    {
+        QString uuid;
+        QString output;
+        QVERIFY2(worker->typeset(preamble + QLatin1String("\\begin{document}") + formula + QLatin1String("\\end{document}"), &uuid, &output), qPrintable(output));
+
+        const QString& pathWithoutExtension = tempDir + QDir::separator() + QLatin1String("cantor_") + uuid;
+        QVERIFY(QFile::exists(pathWithoutExtension + QLatin1String(".pdf")));
+        QFile::remove(pathWithoutExtension + QLatin1String(".pdf"));
+        QFile::remove(pathWithoutExtension + QLatin1String(".log"));
+        QFile::remove(pathWithoutExtension + QLatin1String(".aux"));
+    }
+
+    QVERIFY(!Cantor::TexWorker::format(preamble).isEmpty());
+
+    // errors in the document are reported, the document isn't typeset again without the format
+    QString uuid;
+    QString output;
+    QVERIFY(!worker->typeset(preamble + QLatin1String("\\begin{document}$\\undefinedcommand$\\end{document}"), &uuid, &output));
+    QVERIFY(Cantor::TexWorker::hasTexErrors(output));
+    QVERIFY(!Cantor::TexWorker::format(preamble).isEmpty());
+}
+
+/*!
+ * the lines announcing the plot files are removed from the output of the backend,
+ * the remaining output is kept as it is.
+ */
+void WorksheetTest::testPlotAnnouncements()
+{
+    QString output = QLatin1String("text before\ncantor-plot:png:1234:/tmp/cantor plot.png\r\ntext after\ncantor-plot:PDF:-1:/tmp/plot.pdf");
+    auto files = Cantor::Expression::takePlotAnnouncements(output);
+    QCOMPARE(output, QLatin1String("text before\ntext after\n"));
+    QCOMPARE(files.size(), 2);
+    QCOMPARE(files.at(0).fileName, QLatin1String("/tmp/cantor plot.png"));
+    QCOMPARE(files.at(0).format, QLatin1String("png"));
+    QCOMPARE(files.at(0).size, qint64(1234));
+    QCOMPARE(files.at(1).fileName, QLatin1String("/tmp/plot.pdf"));
+    QCOMPARE(files.at(1).format, QLatin1String("pdf"));
+    QCOMPARE(files.at(1).size, qint64(-1));
+
+    // the same file written twice is only loaded once, in the last version
+    output = QLatin1String("cantor-plot:png:10:/tmp/plot.png\ncantor-plot:png:20:/tmp/plot.png\n");
+    files = Cantor::Expression::takePlotAnnouncements(output);
+    QVERIFY(output.isEmpty());
+    QCOMPARE(files.size(), 1);
+    QCOMPARE(files.at(0).size, qint64(20));
+
+    // the announcement has to be on a separate line
+    output = QLatin1String("print('cantor-plot:png:10:/tmp/plot.png')");
+    QVERIFY(Cantor::Expression::takePlotAnnouncements(output).isEmpty());
+
+    // the announcements are removed from the head and the tail of a truncated output
+    Cantor::OutputCapture capture(1000);
+    capture.append(QLatin1String("cantor-plot:png:10:/tmp/first.png\n"));
+    for (int i = 0; i < 300; ++i)
+        capture.append(QLatin1String("line ") + QString::number(i) + QLatin1Char('\n'));
+    capture.append(QLatin1String("cantor-plot:svg:20:/tmp/last.svg\n"));
+    QVERIFY(capture.isTruncated());
+    files = Cantor::Expression::takePlotAnnouncements(capture);
+    QCOMPARE(files.size(), 2);
+    QCOMPARE(files.at(0).fileName, QLatin1String("/tmp/first.png"));
+    QCOMPARE(files.at(1).fileName, QLatin1String("/tmp/last.svg"));
+    QVERIFY(!capture.text().contains(QLatin1String("cantor-plot:")));
+}
+
+/*!
+ * the thread variables of the backend processes are set to the share of the cores of one session,
+ * the variables set by the user are kept.
+ */
+void WorksheetTest::testSessionScheduler()
+{
+    auto* scheduler = Cantor::SessionScheduler::instance();
+    const int maxRunningSessions = scheduler->maxRunningSessions();
+
+    // with only one session evaluating at a time it gets all cores
+    scheduler->setMaxRunningSessions(1);
+    QCOMPARE(scheduler->threadBudget(), qMax(1, QThread::idealThreadCount()));
+
+    QProcessEnvironment environment;
+    environment.insert(QLatin1String("MKL_NUM_THREADS"), QLatin1String("3"));
+    environment = scheduler->processEnvironment(environment);
+    QCOMPARE(environment.value(QLatin1String("OMP_NUM_THREADS")), QString::number(scheduler->threadBudget()));
+    QCOMPARE(environment.value(QLatin1String("OPENBLAS_NUM_THREADS")), QString::number(scheduler->threadBudget()));
+    QCOMPARE(environment.value(QLatin1String("MKL_NUM_THREADS")), QLatin1String("3"));
+
+    // the budget is derived from the limit, the budgets of the evaluating sessions don't exceed the cores
+    scheduler->setMaxRunningSessions(2);
+    QCOMPARE(scheduler->threadBudget(), qMax(1, QThread::idealThreadCount() / 2));
+    QVERIFY(scheduler->threadBudget() * 2 <= qMax(2, QThread::idealThreadCount()));
+
+    // sessions that are not logged in don't reduce the budget of a new backend
+    Cantor::Backend* backend = Cantor::Backend::getBackend(Cantor::Backend::listAvailableBackends().first());
+    QScopedPointer<Cantor::Session> session1(backend->createSession());
+    QScopedPointer<Cantor::Session> session2(backend->createSession());
+    scheduler->setMaxRunningSessions(0);
+    QCOMPARE(scheduler->threadBudget(), qMax(1, QThread::idealThreadCount()));
+
+    // with the limit of one session the second session waits until the first one is done
+    scheduler->setMaxRunningSessions(1);
+    QSignalSpy spy(scheduler, &Cantor::SessionScheduler::granted);
+    QVERIFY(scheduler->acquire(session1.data()));
+    QVERIFY(!scheduler->acquire(session2.data()));
+
+    const auto isWaiting = [scheduler](Cantor::Session* session) {
+        for (const auto& statistics : scheduler->statistics())
+            if (statistics.session == session)
+                return statistics.waiting;
+        return false;
+    };
+    QVERIFY(isWaiting(session2.data()));
+
+    scheduler->release(session1.data());
+    QVERIFY(!isWaiting(session2.data()));
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<Cantor::Session*>(), session2.data());
+
+    // the first session has to wait now
+    QVERIFY(!scheduler->acquire(session1.data()));
+    scheduler->release(session2.data());
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).value<Cantor::Session*>(), session1.data());
+    scheduler->release(session1.data());
+
+    scheduler->setMaxRunningSessions(maxRunningSessions);
+    QCOMPARE(scheduler->maxRunningSessions(), maxRunningSessions);
+}
+
 QTEST_MAIN( WorksheetTest )
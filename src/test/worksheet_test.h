@@ -37,10 +37,30 @@ class WorksheetTest: public QObject
     void testCommandEntryExecutionAction2();
     void testCollapsingAllResultsAction();
     void testRemovingAllResultsAction();
+    void testResultMemoization();
+    void testMemoizedFunctionRedefinition();
+    void testStaleEntries();
+    void testSessionStateSnapshot();
+    void testTocNodeDelta();
+    void testLargeTextResult();
+    void testOutputCapture();
+    void testImageCache();
+    void testSearchIndex();
+    void testPrint();
+    void testLatexExport();
+    void testJupyterImagePassthrough();
+    void testResultPayloadSharing();
+    void testAnimationClock();
 
     /* common features tests */
     void testMathRender();
     void testMathRender2();
+    void testMathRenderReuse();
+    void testMathRenderCancel();
+    void testMathRerender();
+    void testTexWorker();
+    void testPlotAnnouncements();
+    void testSessionScheduler();
 
   private:
     void waitForSignal( QObject* sender, const char* signal);
@@ -324,6 +324,9 @@ QString TextEntry::toPlain(const QString& commandSep, const QString& commentStar
 
 bool TextEntry::evaluate(EvaluationOption evalOp)
 {
+    //the formulas are looked up again, the pending jobs of the previous evaluation are superseded
+    worksheet()->mathRenderer()->cancel(this);
+
     int i = 0;
     if (worksheet()->embeddedMathEnabled() && !m_rawCell)
     {
@@ -354,16 +357,19 @@ bool TextEntry::evaluate(EvaluationOption evalOp)
 void TextEntry::updateEntry()
 {
     qDebug() << "update Entry";
+    QVector<QTextImageFormat> formulas;
     QTextCursor cursor = m_textItem->document()->find(QString(QChar::ObjectReplacementCharacter));
     while(!cursor.isNull())
     {
         QTextImageFormat format=cursor.charFormat().toImageFormat();
 
         if (format.hasProperty(Cantor::Renderer::CantorFormula))
-            worksheet()->mathRenderer()->rerender(m_textItem->document(), format);
+            formulas << format;
 
         cursor = m_textItem->document()->find(QString(QChar::ObjectReplacementCharacter), cursor);
     }
+
+    worksheet()->mathRenderer()->rerender(m_textItem->document(), formulas, m_textItem);
 }
 
 void TextEntry::resolveImagesAtCursor()
@@ -24,6 +24,12 @@
 #include <KStandardAction>
 #include <KLocalizedString>
 
+namespace
+{
+// number of lines laid out at once for large plain text results
+constexpr int PageLineCount = 1000;
+}
+
 TextResultItem::TextResultItem(WorksheetEntry* parent, Cantor::Result* result)
     : WorksheetTextItem(parent), ResultItem(result)
 {
@@ -63,7 +69,11 @@ void TextResultItem::populateMenu(QMenu* menu, QPointF)
     ResultItem::addCommonActions(this, menu);
 
     auto* res = result();
-    if (res->type() == Cantor::LatexResult::Type) {
+    if (res->type() == Cantor::TextResult::Type) {
+        auto* tres = static_cast<Cantor::TextResult*>(res);
+        if (tres->isTruncated() && !tres->isOmittedOutputLoaded())
+            connect(menu->addAction(i18n("Load Omitted Output")), &QAction::triggered, this, &TextResultItem::loadOmittedOutput);
+    } else if (res->type() == Cantor::LatexResult::Type) {
         QAction* showCodeAction = nullptr;
         auto* lres = static_cast<Cantor::LatexResult*>(res);
         if (lres->isCodeShown())
@@ -107,7 +117,7 @@ void TextResultItem::update()
     );
     switch(m_result->type()) {
     case Cantor::TextResult::Type:
-        setPlainText(static_cast<Cantor::TextResult*>(m_result)->plain());
+        setTextResult(static_cast<Cantor::TextResult*>(m_result));
         break;
     case Cantor::MimeResult::Type:
     case Cantor::HtmlResult::Type:
@@ -121,6 +131,126 @@ void TextResultItem::update()
     }
 }
 
+/*!
+ * shows the plain text result. Only the lines that are visible are laid out:
+ * the head and the last line if the result is collapsed to the visible lines limit,
+ * the first page otherwise. Further pages are loaded when the end of the item is scrolled into the view.
+ */
+void TextResultItem::setTextResult(Cantor::TextResult* result)
+{
+    disconnect(m_viewRectConnection);
+    m_totalLineCount = result->lineCount();
+    m_loadedLineCount = 0;
+
+    const int limit = Settings::visibleLinesLimit();
+    m_isCollapsed = (limit != 0 && m_totalLineCount > limit);
+
+    if (m_isCollapsed && !m_userCollapseOverride)
+    {
+        if (limit > 4)
+            setPlainText(result->lines(0, limit - 4) + QLatin1String("\n\n...\n\n") + result->lines(m_totalLineCount - 1, 1));
+        else
+            setPlainText(result->lines(0, limit - 1) + QLatin1String("..."));
+
+        m_loadedLineCount = m_totalLineCount;
+        m_widthWhenCollapsed = (int)width();
+        return;
+    }
+
+    if (m_totalLineCount <= PageLineCount)
+    {
+        setPlainText(result->lines(0, m_totalLineCount));
+        m_loadedLineCount = m_totalLineCount;
+        return;
+    }
+
+    setPlainText(QString());
+    loadLines(PageLineCount);
+}
+
+void TextResultItem::loadLines(int count)
+{
+    auto* result = static_cast<Cantor::TextResult*>(m_result);
+    count = std::min(count, m_totalLineCount - m_loadedLineCount);
+    if (count <= 0)
+        return;
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+
+    //remove the marker for the not yet loaded lines
+    if (m_loadedLineCount != 0)
+    {
+        cursor.movePosition(QTextCursor::StartOfBlock, QTextCursor::KeepAnchor);
+        cursor.movePosition(QTextCursor::PreviousCharacter, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+        cursor.insertText(QLatin1String("\n"));
+    }
+
+    cursor.insertText(result->lines(m_loadedLineCount, count));
+    m_loadedLineCount += count;
+
+    const int remaining = m_totalLineCount - m_loadedLineCount;
+    if (remaining > 0)
+    {
+        cursor.insertText(QLatin1String("\n") + i18np("[... 1 more line]", "[... %1 more lines]", remaining));
+
+        auto* view = worksheet() ? worksheet()->worksheetView() : nullptr;
+        if (view && !m_viewRectConnection)
+            m_viewRectConnection = connect(view, &WorksheetView::viewRectChanged, this, &TextResultItem::viewRectChanged);
+    }
+    else
+        disconnect(m_viewRectConnection);
+}
+
+void TextResultItem::viewRectChanged(const QRectF& viewRect)
+{
+    if (m_loadedLineCount >= m_totalLineCount)
+        return;
+
+    //load the next page once the end of the laid out lines is less than one screen away
+    const qreal bottom = mapToScene(boundingRect().bottomLeft()).y();
+    if (bottom < viewRect.bottom() + viewRect.height())
+    {
+        loadLines(PageLineCount);
+        Q_EMIT collapseActionSizeChanged();
+    }
+}
+
+QTextCursor TextResultItem::search(QString pattern, QTextDocument::FindFlags qt_flags, const WorksheetCursor& pos)
+{
+    QTextCursor cursor = WorksheetTextItem::search(pattern, qt_flags, pos);
+    if (!cursor.isNull() || m_result->type() != Cantor::TextResult::Type || (qt_flags & QTextDocument::FindBackward))
+        return cursor;
+
+    //look for the pattern in the lines that are not laid out yet and load them up to the match
+    auto* result = static_cast<Cantor::TextResult*>(m_result);
+    const auto cs = (qt_flags & QTextDocument::FindCaseSensitively) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    if (m_isCollapsed && !m_userCollapseOverride)
+    {
+        if (result->findLine(pattern, 0, cs) == -1)
+            return cursor;
+
+        m_userCollapseOverride = true;
+        update();
+        Q_EMIT collapseActionSizeChanged();
+        cursor = WorksheetTextItem::search(pattern, qt_flags, pos);
+    }
+
+    while (cursor.isNull() && m_loadedLineCount < m_totalLineCount)
+    {
+        const int line = result->findLine(pattern, m_loadedLineCount, cs);
+        if (line == -1)
+            break;
+
+        loadLines(line + 1 - m_loadedLineCount);
+        Q_EMIT collapseActionSizeChanged();
+        cursor = WorksheetTextItem::search(pattern, qt_flags, pos);
+    }
+
+    return cursor;
+}
+
 void TextResultItem::setLatex(Cantor::LatexResult* result)
 {
     QTextCursor cursor = textCursor();
@@ -210,6 +340,12 @@ void TextResultItem::saveResult()
         result()->save(fileName);
 }
 
+void TextResultItem::loadOmittedOutput()
+{
+    static_cast<Cantor::TextResult*>(m_result)->loadOmittedOutput();
+    update();
+}
+
 void TextResultItem::deleteLater()
 {
     WorksheetTextItem::deleteLater();
@@ -242,7 +378,7 @@ void TextResultItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent* event)
     m_userCollapseOverride = !m_userCollapseOverride;
     if (m_isCollapsed)
     {
-        if (m_userCollapseOverride)
+        if (m_userCollapseOverride || m_result->type() == Cantor::TextResult::Type)
             update();
         else
         {
@@ -283,6 +419,10 @@ void TextResultItem::collapseExtraLines()
     if (limit == 0)
         return;
 
+    // plain text results are collapsed in setTextResult() using the line index of the result
+    if (m_result->type() == Cantor::TextResult::Type)
+        return;
+
     // for situation, when we have collapsed text result and resized Cantor window
     if (m_isCollapsed && (int)width() != m_widthWhenCollapsed)
     {
@@ -11,6 +11,7 @@
 
 namespace Cantor {
     class LatexResult;
+    class TextResult;
 }
 
 class TextResultItem : public WorksheetTextItem, public ResultItem
@@ -35,6 +36,8 @@ class TextResultItem : public WorksheetTextItem, public ResultItem
     void deleteLater() override;
 
     void updateTheme() override;
+
+    QTextCursor search(QString pattern, QTextDocument::FindFlags, const WorksheetCursor&);
   Q_SIGNALS:
     void collapseActionSizeChanged();
 
@@ -44,16 +47,28 @@ class TextResultItem : public WorksheetTextItem, public ResultItem
     void showHtmlSource();
     void showPlain();
     void saveResult();
+    void loadOmittedOutput();
 
   protected:
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent*) override;
     int visibleLineCount();
     void collapseExtraLines();
     void paint(QPainter*, const QStyleOptionGraphicsItem*, QWidget* widget = nullptr) override;
+
+  private:
+    void setTextResult(Cantor::TextResult*);
+    void loadLines(int count);
+    void viewRectChanged(const QRectF&);
+
   protected:
     bool m_isCollapsed{false};
     bool m_userCollapseOverride{false};
     int m_widthWhenCollapsed{0};
+
+    //number of lines of the plain text result currently laid out, the remaining lines are paged in on demand
+    int m_loadedLineCount{0};
+    int m_totalLineCount{0};
+    QMetaObject::Connection m_viewRectConnection;
 };
 
 #endif //TEXTRESULTITEM_H
@@ -14,6 +14,8 @@
 #include "markdownentry.h"
 #include "pagebreakentry.h"
 #include "placeholderentry.h"
+#include "searchindex.h"
+#include "animationclock.h"
 #include "settings.h"
 #include "textentry.h"
 #include "worksheethierarchymanager.h"
@@ -30,6 +32,8 @@
 #include <QApplication>
 #include <QBuffer>
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDir>
 #include <QEventLoop>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsSceneMouseEvent>
@@ -37,9 +41,12 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMouseEvent>
-#include <QPrinter>
+#include <QPagedPaintDevice>
+#include <QPainter>
+#include <QPointer>
 #include <QRegularExpression>
 #include <QSet>
+#include <QTemporaryDir>
 #include <QTimer>
 #include <QActionGroup>
 #include <QFile>
@@ -71,7 +78,31 @@ namespace
 constexpr int DragScrollMargin = 48;
 constexpr int DragScrollInterval = 50;
 constexpr int DragScrollStep = 4;
+
+QByteArray commandHash(const QString& command)
+{
+    return QCryptographicHash::hash(command.toUtf8(), QCryptographicHash::Sha1).toHex();
 }
+}
+
+/*!
+ * state of the backend saved with the worksheet, extracted from the archive into a temporary folder
+ * and restored after the next login. The hashes of the commands of the entries reflected by this state
+ * are used to check which entries were changed after the state was saved.
+ */
+struct Worksheet::SessionSnapshot
+{
+    QTemporaryDir dir;
+    QMap<QString, QByteArray> commandHashes;
+    QMap<QString, QStringList> definedVariables;
+};
+
+struct Worksheet::SessionCheckpoint
+{
+    QTemporaryDir dir;
+    quint64 epoch{0};
+    bool saved{false};
+};
 
 Worksheet::Worksheet(Cantor::Backend* backend, QWidget* parent, bool useDefaultWorksheetParameters)
     : QGraphicsScene(parent),
@@ -79,6 +110,8 @@ Worksheet::Worksheet(Cantor::Backend* backend, QWidget* parent, bool useDefaultW
     m_useDefaultWorksheetParameters(useDefaultWorksheetParameters)
 {
     m_hierarchyManager = new WorksheetHierarchyManager(this);
+    m_searchIndex = new SearchIndex(this);
+    m_animationClock = new AnimationClock(this);
 
     m_entryCursorItem = addLine(0,0,0,0);
     const QColor& color = (palette().color(QPalette::Base).lightness() < 128) ? Qt::white : Qt::black;
@@ -91,6 +124,7 @@ Worksheet::Worksheet(Cantor::Backend* backend, QWidget* parent, bool useDefaultW
     m_cursorItemTimer->start(500);
 
     m_variableHighlightingEnabled = Settings::self()->highlightDefault();
+    m_sessionStateSavingEnabled = Settings::self()->sessionStateSavingDefault();
 
     if (backend)
         initSession(backend);
@@ -174,13 +208,30 @@ Worksheet::~Worksheet()
 void Worksheet::loginToSession()
 {
     m_session->login();
+
+    //the state saved with the worksheet is restored before the expressions submitted during the login are evaluated
+    if (m_sessionSnapshot)
+    {
+        if (m_session->isLoggingIn())
+            connect(m_session, &Cantor::Session::loginDone, this, &Worksheet::restoreSessionState, Qt::SingleShotConnection);
+        else
+            restoreSessionState();
+    }
 }
 
-void Worksheet::print(QPrinter* printer)
+/*!
+ * prints the worksheet to \c device page by page. The high resolution images of the math and of
+ * the image results are rendered for the entries on the current page only and released once the page is done,
+ * so the memory needed for them is bounded by one page. printProgress() is emitted after every page,
+ * printing can be canceled via cancelPrinting(). No events are processed here, but the progress dialog
+ * processes them when it's updated. The entries can be laid out again then (e.g. by the asynchronously
+ * rendered formulas), so every page is determined with the current positions of the entries right before it's printed.
+ * Returns \c false if printing was canceled.
+ */
+bool Worksheet::print(QPagedPaintDevice* device)
 {
-    m_renderer.useHighResolution(true);
-    m_mathRenderer.useHighResolution(true);
     m_isPrinting = true;
+    m_printingCanceled = false;
 
     const auto originalTheme = m_currentTheme;
     const auto& repository = KTextEditor::Editor::instance()->repository();
@@ -197,44 +248,74 @@ void Worksheet::print(QPrinter* printer)
             entry->updateAfterSettingsChanges();
     }
 
-    QRectF pageRect = printer->pageRect(QPrinter::Point);
-    qreal scale = 1; // todo: find good scale for page size
-    // todo: use epsRenderer()->scale() for printing ?
+    //lay out the worksheet for the page width, the images are rendered in the normal resolution here
+    const QRectF pageRect = device->pageLayout().paintRectPoints();
+    const qreal scale = 1;
     const qreal width = pageRect.width()/scale;
     const qreal height = pageRect.height()/scale;
-    setViewSize(width, height, scale, true);
-
-    QPainter painter(printer);
-    painter.scale(scale, scale);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    auto* entry = firstEntry();
-    qreal y = TopMargin;
+    setViewSize(width, height, scale);
 
-    while (entry) {
-        qreal h = 0;
+    //the page starting at the entry \c entry with the entries fitting on it
+    struct Page {
+        qreal y;
+        qreal height;
+        QVector<WorksheetEntry*> entries;
+        WorksheetEntry* next; //the first entry of the next page
+    };
+    const auto pageAt = [height](WorksheetEntry* entry) {
+        Page page{entry->pos().y(), 0, {}, nullptr};
         do {
             if (entry->type() == PageBreakEntry::Type) {
                 entry = entry->next();
                 break;
             }
-            h += entry->size().height();
+            page.height += entry->size().height();
+            page.entries << entry;
             entry = entry->next();
-        } while (entry && h + entry->size().height() <= height);
+        } while (entry && page.height + entry->size().height() <= height);
+
+        page.next = entry;
+        return page;
+    };
+
+    //the number of pages for the progress, the pages themselves are determined again when they're printed
+    int pageCount = 0;
+    for (auto* entry = firstEntry(); entry; entry = pageAt(entry).next)
+        ++pageCount;
+
+    QPainter painter(device);
+    painter.scale(device->width() / width, device->width() / width);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QPointer<WorksheetEntry> entry = firstEntry();
+    for (int i = 0; entry && !m_printingCanceled; ++i) {
+        const Page page = pageAt(entry);
+
+        m_renderer.useHighResolution(true);
+        m_mathRenderer.useHighResolution(true);
+        for (auto* pageEntry : page.entries)
+            pageEntry->updateEntry();
 
         render(&painter, QRectF(0, 0, width, height),
-               QRectF(0, y, width, h));
-        y += h;
-        if (entry)
-            printer->newPage();
-    }
+               QRectF(0, page.y, width, page.height));
 
-    //render(&painter);
+        //release the high resolution images again
+        m_renderer.useHighResolution(false);
+        m_mathRenderer.useHighResolution(false);
+        for (auto* pageEntry : page.entries)
+            pageEntry->updateEntry();
+
+        //the entries can be deleted while the progress dialog processes the events
+        entry = page.next;
+        pageCount = qMax(pageCount, i + 1);
+        Q_EMIT printProgress(i + 1, pageCount);
+
+        if (entry && !m_printingCanceled)
+            device->newPage();
+    }
 
     painter.end();
     m_isPrinting = false;
-    m_renderer.useHighResolution(false);
-    m_mathRenderer.useHighResolution(false);
     m_renderer.setScale(-1);  // force update in next call to setViewSize,
     worksheetView()->updateSceneSize(); // ... which happens in here
 
@@ -245,6 +326,13 @@ void Worksheet::print(QPrinter* printer)
             entry->updateAfterSettingsChanges();
     }
     worksheetView()->updateSceneSize();
+
+    return !m_printingCanceled;
+}
+
+void Worksheet::cancelPrinting()
+{
+    m_printingCanceled = true;
 }
 
 bool Worksheet::isPrinting()
@@ -252,6 +340,12 @@ bool Worksheet::isPrinting()
     return m_isPrinting;
 }
 
+bool Worksheet::isSessionStateCollected() const
+{
+    return m_session && m_sessionCheckpoint && m_sessionCheckpoint->saved
+        && m_sessionCheckpoint->epoch == m_session->stateEpoch();
+}
+
 void Worksheet::setViewSize(qreal w, qreal h, qreal s, bool forceUpdate)
 {
     Q_UNUSED(h);
@@ -314,14 +408,14 @@ void Worksheet::updateLayout()
     drawEntryCursor();
 }
 
-void Worksheet::refreshTocStructure()
+void Worksheet::refreshTocStructure(WorksheetEntry* changedEntry)
 {
-    m_hierarchyManager->refreshTocStructure();
+    m_hierarchyManager->refreshTocStructure(changedEntry);
 }
 
-void Worksheet::scheduleTocStructureRefresh()
+void Worksheet::scheduleTocStructureRefresh(WorksheetEntry* changedEntry)
 {
-    m_hierarchyManager->scheduleTocStructureRefresh();
+    m_hierarchyManager->scheduleTocStructureRefresh(changedEntry);
 }
 
 void Worksheet::emitTocNodeSnapshot()
@@ -904,9 +998,20 @@ void Worksheet::evaluateEntries(WorksheetEntry* first, WorksheetEntry* last)
     resetEvaluationEndpoint();
 
     // login if not done yet
-    if (!m_readOnly && m_session && m_session->status() == Cantor::Session::Disable)
+    if (!m_readOnly && m_session && m_session->status() == Cantor::Session::Disable && !m_session->isLoggingIn())
         loginToSession();
 
+    // the login is asynchronous, evaluate the entries once the session is ready
+    if (m_session && m_session->isLoggingIn()) {
+        QPointer<WorksheetEntry> firstEntry(first);
+        QPointer<WorksheetEntry> lastEntry(last);
+        evaluateAfterLogin([this, firstEntry, lastEntry]() {
+            if (firstEntry)
+                evaluateEntries(firstEntry, lastEntry);
+        });
+        return;
+    }
+
     // evaluate the worksheet if the login was successful
     if (m_session && m_session->status() == Cantor::Session::Done && first) {
         m_evaluationLastEntry = last;
@@ -915,6 +1020,122 @@ void Worksheet::evaluateEntries(WorksheetEntry* first, WorksheetEntry* last)
     }
 }
 
+/*!
+ * calls \c evaluation once the running login of the session is done. Only the last requested evaluation is done,
+ * nothing is evaluated if the login failed or was aborted - evaluating would start the next login.
+ */
+void Worksheet::evaluateAfterLogin(const std::function<void()>& evaluation)
+{
+    disconnect(m_pendingLoginEvaluation);
+    m_pendingLoginEvaluation = connect(m_session, &Cantor::Session::loginDone, this, [this, evaluation]() {
+        disconnect(m_pendingLoginEvaluation);
+        if (m_session->loginState() == Cantor::Session::LoggedIn)
+            evaluation();
+    }, Qt::SingleShotConnection);
+}
+
+void Worksheet::evaluateStaleEntries()
+{
+    resetEvaluationEndpoint();
+
+    // login if not done yet
+    if (!m_readOnly && m_session && m_session->status() == Cantor::Session::Disable && !m_session->isLoggingIn())
+        loginToSession();
+
+    if (m_session && m_session->isLoggingIn()) {
+        evaluateAfterLogin([this]() { evaluateStaleEntries(); });
+        return;
+    }
+
+    if (m_session && m_session->status() == Cantor::Session::Done) {
+        evaluateNextStaleEntry(nullptr);
+        setModified();
+    }
+}
+
+/*!
+ * evaluates the first stale command entry after \c after, or the first stale entry of the worksheet
+ * if \c after is \c nullptr. The evaluated entry continues with the next stale entry once it's done.
+ */
+void Worksheet::evaluateNextStaleEntry(WorksheetEntry* after)
+{
+    if (!m_session)
+        return;
+
+    //the variable model is updated after the evaluation of the previous entry,
+    //wait for it to report the changed variables before determining the next stale entry
+    disconnect(m_pendingStaleEvaluation);
+    if (m_session->status() == Cantor::Session::Running)
+    {
+        QPointer<WorksheetEntry> afterEntry(after);
+        const bool fromStart = (after == nullptr);
+        m_pendingStaleEvaluation = connect(m_session, &Cantor::Session::statusChanged, this, [this, afterEntry, fromStart](Cantor::Session::Status status) {
+            if (status == Cantor::Session::Running)
+                return;
+
+            disconnect(m_pendingStaleEvaluation);
+            if (status == Cantor::Session::Done && (fromStart || afterEntry))
+                evaluateNextStaleEntry(afterEntry);
+        });
+        return;
+    }
+
+    auto* entry = after ? after->next() : firstEntry();
+    for (; entry; entry = entry->next())
+    {
+        if (entry->type() != CommandEntry::Type)
+            continue;
+
+        auto* commandEntry = static_cast<CommandEntry*>(entry);
+        if (commandEntry->isStale() && !commandEntry->isExcludedFromExecution() && !commandEntry->isEmpty())
+        {
+            commandEntry->evaluate(WorksheetEntry::EvaluateStale);
+            return;
+        }
+    }
+}
+
+void Worksheet::commandEntryChanged(CommandEntry* entry)
+{
+    QSet<QString> names = entry->definedVariables();
+    entry->markStale();
+    invalidateDependentEntries(entry, names);
+}
+
+void Worksheet::commandEntryEvaluated(CommandEntry* entry)
+{
+    invalidateDependentEntries(entry, entry->definedVariables());
+}
+
+void Worksheet::commandEntryVariablesChanged(CommandEntry* entry, const QStringList& names)
+{
+    entry->addDefinedVariables(names);
+    invalidateDependentEntries(entry, QSet<QString>(names.begin(), names.end()));
+}
+
+/*!
+ * marks the command entries after \c entry referencing one of \c names as stale,
+ * the names defined by the stale entries are followed transitively.
+ */
+void Worksheet::invalidateDependentEntries(WorksheetEntry* entry, QSet<QString> names)
+{
+    if (names.isEmpty())
+        return;
+
+    for (auto* next = entry->next(); next; next = next->next())
+    {
+        if (next->type() != CommandEntry::Type)
+            continue;
+
+        auto* commandEntry = static_cast<CommandEntry*>(next);
+        if (!commandEntry->referencedVariables().intersects(names))
+            continue;
+
+        commandEntry->markStale();
+        names.unite(commandEntry->definedVariables());
+    }
+}
+
 void Worksheet::resetEvaluationEndpoint()
 {
     m_evaluationLastEntry = nullptr;
@@ -932,13 +1153,19 @@ bool Worksheet::stopEvaluationAfter(WorksheetEntry* entry)
 void Worksheet::evaluateCurrentEntry()
 {
     // login if not done yet
-    if (!m_readOnly && m_session && m_session->status() == Cantor::Session::Disable)
+    if (!m_readOnly && m_session && m_session->status() == Cantor::Session::Disable && !m_session->isLoggingIn())
         loginToSession();
 
     // evaluate the current entry if the login was successful
     if (!m_session)
         return;
 
+    // the login is asynchronous, evaluate the entry once the session is ready
+    if (m_session->isLoggingIn()) {
+        evaluateAfterLogin([this]() { evaluateCurrentEntry(); });
+        return;
+    }
+
     // the current status of the session should be Done or Running - the later is the case when we're
     // waiting for the additional input like Maxima's help requests or assumptions for integrate(), etc.
     if (m_session->status() == Cantor::Session::Done || m_session->status() == Cantor::Session::Running)
@@ -1198,7 +1425,14 @@ void Worksheet::interrupt()
 {
     resetEvaluationEndpoint();
 
-    if (m_session->status() == Cantor::Session::Running)
+    //the entries waiting for the session to be done are not evaluated after the interruption
+    for (auto* entry = firstEntry(); entry; entry = entry->next())
+        if (entry->type() == CommandEntry::Type)
+            static_cast<CommandEntry*>(entry)->cancelPendingEvaluation();
+
+    if (m_session->interruptScheduledExpressions())
+        Q_EMIT updatePrompt();
+    else if (m_session->status() == Cantor::Session::Running)
     {
         m_session->interrupt();
         Q_EMIT updatePrompt();
@@ -1243,7 +1477,7 @@ Cantor::Session* Worksheet::session() const
 
 bool Worksheet::isRunning()
 {
-    return m_session && m_session->status()==Cantor::Session::Running;
+    return m_session && (m_session->status()==Cantor::Session::Running || m_session->isWaitingForScheduler());
 }
 
 bool Worksheet::isReadOnly()
@@ -1276,6 +1510,19 @@ void Worksheet::enableEmbeddedMath(bool enable)
     m_embeddedMathEnabled = enable;
 }
 
+void Worksheet::enableResultMemoization(bool enable)
+{
+    if (m_session)
+        m_session->setResultMemoizationEnabled(enable);
+}
+
+void Worksheet::enableSessionStateSaving(bool enable)
+{
+    m_sessionStateSavingEnabled = enable;
+    if (!enable)
+        m_sessionCheckpoint.reset();
+}
+
 void Worksheet::enableExpressionNumbering(bool enable)
 {
     m_showExpressionIds=enable;
@@ -1375,6 +1622,7 @@ void Worksheet::save( QIODevice* device)
 
             QByteArray content = toXML(&zipFile).toByteArray();
             zipFile.writeFile( QLatin1String("content.xml"), content.data());
+            saveSessionState(zipFile);
             break;
         }
 
@@ -1437,6 +1685,11 @@ void Worksheet::savePlain(const QString& filename)
     file.close();
 }
 
+/*!
+ * exports the worksheet to LaTeX. The stylesheet is applied to the header, to every entry on its own
+ * and to the footer and the results are written to the file one after another,
+ * so only the XML and the LaTeX code of one entry are kept in memory at a time.
+ */
 void Worksheet::saveLatex(const QString& filename)
 {
     qDebug()<<"exporting to Latex: " <<filename;
@@ -1455,32 +1708,61 @@ void Worksheet::saveLatex(const QString& filename)
     }
 
     xsltStylesheetPtr xsltStyleSheet = xsltParseStylesheetFile((const xmlChar *)stylesheet.toLocal8Bit().constData());
-    xmlDocPtr output = xmlReadDoc((const xmlChar *)toXML().toString().toStdString().c_str(), nullptr, "utf-8", XML_PARSE_RECOVER | XML_PARSE_NOENT | XML_PARSE_DTDLOAD);
-
-    const char *params[16+1];
-    params[0] = nullptr;
-    auto res = xsltApplyStylesheet(xsltStyleSheet, output, params);
-    if (res) {
-        xmlChar *xmlResultBuffer = nullptr;
-        int xmlResultLength = 0;
-        int res = xsltSaveResultToString(&xmlResultBuffer, &xmlResultLength, output, xsltStyleSheet);
-        if (res != -1) {
-            QString outString = QString::fromUtf8((char *)xmlResultBuffer);
-
-            // Transform HTML escaped special characters to valid LaTeX characters (&, <, >)
-            QTextStream stream(&file);
-            stream << outString.replace(QLatin1String("&amp;"), QLatin1String("&"))
-                         .replace(QLatin1String("&gt;"), QLatin1String(">"))
-                         .replace(QLatin1String("&lt;"), QLatin1String("<"));
-            file.close();
+    if (!xsltStyleSheet) {
+        KMessageBox::error(worksheetView(), i18n("Error loading latex.xsl stylesheet"), i18n("Export to LaTeX"));
+        return;
+    }
+
+    QTextStream stream(&file);
+
+    //transforms the worksheet element containing the XML of at most one entry
+    auto transform = [&stream, xsltStyleSheet](const QDomDocument& doc, const char* part) {
+        const QByteArray& xml = doc.toByteArray(-1);
+        xmlDocPtr input = xmlReadMemory(xml.constData(), xml.size(), nullptr, "utf-8", XML_PARSE_RECOVER | XML_PARSE_NOENT | XML_PARSE_DTDLOAD);
+        if (!input)
+            return;
+
+        const char* params[] = {"part", part, nullptr};
+        xmlDocPtr res = xsltApplyStylesheet(xsltStyleSheet, input, params);
+        if (res) {
+            xmlChar* xmlResultBuffer = nullptr;
+            int xmlResultLength = 0;
+            if (xsltSaveResultToString(&xmlResultBuffer, &xmlResultLength, res, xsltStyleSheet) != -1 && xmlResultBuffer) {
+                QString outString = QString::fromUtf8(reinterpret_cast<const char*>(xmlResultBuffer), xmlResultLength);
+
+                // Transform HTML escaped special characters to valid LaTeX characters (&, <, >)
+                stream << outString.replace(QLatin1String("&amp;"), QLatin1String("&"))
+                             .replace(QLatin1String("&gt;"), QLatin1String(">"))
+                             .replace(QLatin1String("&lt;"), QLatin1String("<"));
+            }
+            xmlFree(xmlResultBuffer);
+            xmlFreeDoc(res);
         }
+        xmlFreeDoc(input);
+    };
+
+    auto worksheetDocument = [this]() {
+        QDomDocument doc(QLatin1String("CantorWorksheet"));
+        QDomElement root = doc.createElement(QLatin1String("Worksheet"));
+        root.setAttribute(QLatin1String("backend"), (m_session ? m_session->backend()->name(): m_backendName));
+        doc.appendChild(root);
+        return doc;
+    };
 
-        xmlFree(xmlResultBuffer);
+    transform(worksheetDocument(), "'header'");
+
+    for (auto* entry = firstEntry(); entry; entry = entry->next())
+    {
+        QDomDocument doc = worksheetDocument();
+        doc.documentElement().appendChild(entry->toXml(doc, nullptr));
+        transform(doc, "'body'");
     }
 
+    transform(worksheetDocument(), "'footer'");
+
+    file.close();
+
     xsltFreeStylesheet(xsltStyleSheet);
-    xmlFreeDoc(res);
-    xmlFreeDoc(output);
 
     xsltCleanupGlobals();
     xmlCleanupParser();
@@ -1636,6 +1918,8 @@ bool Worksheet::loadCantorWorksheet(const KZip& archive)
 
     if (m_readOnly)
         clearFocus();
+    else
+        loadSessionState(archive);
 
     m_isLoadingFromFile = false;
     updateHierarchyLayout();
@@ -1648,6 +1932,233 @@ bool Worksheet::loadCantorWorksheet(const KZip& archive)
     return true;
 }
 
+/*!
+ * saves the state of the backend with the variable management extension of the backend into a temporary folder
+ * if anything was evaluated since the state was collected the last time. Dumping the state can be expensive,
+ * it's therefore only done when the worksheet is saved, s.a. saveSessionState(), and not after every evaluation.
+ * Once the state is collected the worksheet is marked as modified so it's saved with the next save.
+ */
+void Worksheet::collectSessionState()
+{
+    if (!m_sessionStateSavingEnabled || m_sessionStateCollecting || !m_session || m_session->status() != Cantor::Session::Done)
+        return;
+
+    if (m_sessionCheckpoint && m_sessionCheckpoint->epoch == m_session->stateEpoch())
+        return;
+
+    auto* extension = dynamic_cast<Cantor::VariableManagementExtension*>(m_session->backend()->extension(QLatin1String("VariableManagementExtension")));
+    if (!extension)
+        return;
+
+    std::shared_ptr<SessionCheckpoint> checkpoint(new SessionCheckpoint);
+    if (!checkpoint->dir.isValid())
+        return;
+
+    checkpoint->epoch = m_session->stateEpoch();
+    m_sessionStateCollecting = true;
+
+    const QString& command = extension->saveVariables(checkpoint->dir.filePath(QLatin1String("state")));
+    auto* expression = m_session->evaluateExpression(command, Cantor::Expression::DeleteOnFinish, true);
+    connect(expression, &Cantor::Expression::expressionFinished, this, [this, checkpoint](Cantor::Expression::Status status) {
+        m_sessionStateCollecting = false;
+
+        //some backends don't support saving the variables to a file, the checkpoint is kept to not try it again
+        checkpoint->saved = (status == Cantor::Expression::Done) && !QDir(checkpoint->dir.path()).entryList(QDir::Files).isEmpty();
+        if (!checkpoint->saved)
+            qDebug() << "the state of the session couldn't be saved";
+
+        m_sessionCheckpoint = checkpoint;
+        if (isSessionStateCollected())
+            Q_EMIT modified();
+    });
+}
+
+/*!
+ * adds the state of the backend collected by collectSessionState() to the folder "session" of \c archive.
+ * The file "session.xml" lists the command entries reflected by this state together with the hashes
+ * of their commands, s.a. restoreSessionState(). If anything was evaluated after the state was collected,
+ * the outdated state isn't saved, the collection of the current state is started and the user is informed about it.
+ */
+void Worksheet::saveSessionState(KZip& archive)
+{
+    if (!m_sessionStateSavingEnabled || !m_session || m_session->status() == Cantor::Session::Disable)
+        return;
+
+    //only the entries evaluated in the current session are reflected by the state of the backend
+    QDomDocument doc(QLatin1String("CantorSessionState"));
+    QDomElement root = doc.createElement(QLatin1String("SessionState"));
+    root.setAttribute(QLatin1String("backend"), m_session->backend()->name());
+    doc.appendChild(root);
+
+    for (auto* entry = firstEntry(); entry; entry = entry->next())
+    {
+        if (entry->type() != CommandEntry::Type)
+            continue;
+
+        auto* commandEntry = static_cast<CommandEntry*>(entry);
+        if (commandEntry->isStale())
+            continue;
+
+        QDomElement entryElem = doc.createElement(QLatin1String("Entry"));
+        entryElem.setAttribute(QLatin1String("command-id"), commandEntry->commandId());
+        entryElem.setAttribute(QLatin1String("hash"), QString::fromLatin1(commandHash(commandEntry->command())));
+        for (const auto& name : commandEntry->definedVariables())
+        {
+            QDomElement variableElem = doc.createElement(QLatin1String("Variable"));
+            variableElem.appendChild(doc.createTextNode(name));
+            entryElem.appendChild(variableElem);
+        }
+        root.appendChild(entryElem);
+    }
+
+    if (!root.hasChildNodes())
+        return;
+
+    //the backend couldn't save its variables the last time, e.g. because it doesn't support it
+    if (m_sessionCheckpoint && m_sessionCheckpoint->epoch == m_session->stateEpoch() && !m_sessionCheckpoint->saved)
+        return;
+
+    if (m_session->status() != Cantor::Session::Done)
+    {
+        KMessageBox::information(worksheetView(),
+                                 i18n("The state of the session couldn't be saved since the session is still busy. "
+                                      "The entries need to be evaluated again once the worksheet is opened."),
+                                 i18n("Save Session State"),
+                                 QLatin1String("SessionStateNotSaved"));
+        return;
+    }
+
+    if (!isSessionStateCollected())
+    {
+        KMessageBox::information(worksheetView(),
+                                 i18n("The state of the session is being collected, it will be saved the next time the worksheet is saved. "
+                                      "Otherwise the entries need to be evaluated again once the worksheet is opened."),
+                                 i18n("Save Session State"),
+                                 QLatin1String("SessionStateCollecting"));
+        collectSessionState();
+        return;
+    }
+
+    const auto& files = QDir(m_sessionCheckpoint->dir.path()).entryList(QDir::Files);
+    for (const auto& file : files)
+        archive.addLocalFile(m_sessionCheckpoint->dir.filePath(file), QLatin1String("session/") + file);
+    archive.writeFile(QLatin1String("session.xml"), doc.toByteArray());
+}
+
+/*!
+ * reads the state of the backend saved in \c archive by saveSessionState(), it's restored after the next login.
+ */
+void Worksheet::loadSessionState(const KZip& archive)
+{
+    m_sessionSnapshot.reset();
+
+    const auto* manifestEntry = archive.directory()->entry(QLatin1String("session.xml"));
+    const auto* stateEntry = archive.directory()->entry(QLatin1String("session"));
+    if (!m_session || !manifestEntry || !manifestEntry->isFile() || !stateEntry || !stateEntry->isDirectory())
+        return;
+
+    QDomDocument doc;
+    doc.setContent(static_cast<const KArchiveFile*>(manifestEntry)->data());
+    const QDomElement& root = doc.documentElement();
+    if (root.attribute(QLatin1String("backend")) != m_session->backend()->name())
+        return;
+
+    std::unique_ptr<SessionSnapshot> snapshot(new SessionSnapshot);
+    if (!snapshot->dir.isValid() || !static_cast<const KArchiveDirectory*>(stateEntry)->copyTo(snapshot->dir.path()))
+    {
+        qDebug() << "failed to extract the saved state of the session";
+        return;
+    }
+
+    QDomElement entryElem = root.firstChildElement(QLatin1String("Entry"));
+    while (!entryElem.isNull())
+    {
+        const QString& id = entryElem.attribute(QLatin1String("command-id"));
+        snapshot->commandHashes.insert(id, entryElem.attribute(QLatin1String("hash")).toLatin1());
+
+        QStringList variables;
+        QDomElement variableElem = entryElem.firstChildElement(QLatin1String("Variable"));
+        while (!variableElem.isNull())
+        {
+            variables << variableElem.text();
+            variableElem = variableElem.nextSiblingElement(QLatin1String("Variable"));
+        }
+        snapshot->definedVariables.insert(id, variables);
+
+        entryElem = entryElem.nextSiblingElement(QLatin1String("Entry"));
+    }
+
+    m_sessionSnapshot = std::move(snapshot);
+}
+
+/*!
+ * restores the state of the backend saved with the worksheet, called once the login is done.
+ * The entries whose commands didn't change since the state was saved are marked as evaluated in the session,
+ * the changed entries and the entries depending on them stay stale and need to be evaluated again.
+ */
+void Worksheet::restoreSessionState()
+{
+    if (!m_sessionSnapshot || !m_session || m_session->status() == Cantor::Session::Disable)
+        return;
+
+    auto* extension = dynamic_cast<Cantor::VariableManagementExtension*>(m_session->backend()->extension(QLatin1String("VariableManagementExtension")));
+    if (!extension)
+        return;
+
+    //the temporary folder is kept until the backend has read the state
+    std::shared_ptr<SessionSnapshot> snapshot(std::move(m_sessionSnapshot));
+
+    QList<QPointer<CommandEntry>> restoredEntries;
+    QList<CommandEntry*> changedEntries;
+    for (auto* entry = firstEntry(); entry; entry = entry->next())
+    {
+        if (entry->type() != CommandEntry::Type)
+            continue;
+
+        auto* commandEntry = static_cast<CommandEntry*>(entry);
+        const auto it = snapshot->commandHashes.constFind(commandEntry->commandId());
+        if (it == snapshot->commandHashes.constEnd())
+            continue;
+
+        if (*it == commandHash(commandEntry->command()))
+        {
+            commandEntry->restoreSessionState(snapshot->definedVariables.value(commandEntry->commandId()));
+            restoredEntries << commandEntry;
+        }
+        else
+            changedEntries << commandEntry;
+    }
+
+    if (restoredEntries.isEmpty())
+    {
+        qDebug() << "all entries were changed after the state of the session was saved, not restoring it";
+        return;
+    }
+
+    //the variables defined by the changed entries have outdated values in the restored state
+    for (auto* entry : std::as_const(changedEntries))
+    {
+        const auto& names = snapshot->definedVariables.value(entry->commandId());
+        invalidateDependentEntries(entry, QSet<QString>(names.begin(), names.end()));
+    }
+
+    const QString& command = extension->loadVariables(snapshot->dir.filePath(QLatin1String("state")));
+    auto* expression = m_session->evaluateExpression(command, Cantor::Expression::DeleteOnFinish, true);
+    connect(expression, &Cantor::Expression::expressionFinished, this, [this, snapshot, restoredEntries](Cantor::Expression::Status status) {
+        if (status == Cantor::Expression::Done)
+        {
+            //the internal expressions don't update the variable model
+            m_session->updateVariables();
+            return;
+        }
+
+        qDebug() << "the saved state of the session couldn't be restored";
+        for (const auto& entry : restoredEntries)
+            if (entry)
+                entry->invalidateSessionState();
+    });
+}
+
 int Worksheet::typeForTagName(const QString& tag)
 {
     if (tag == QLatin1String("Expression"))
@@ -1683,6 +2194,19 @@ void Worksheet::initSession(Cantor::Backend* backend)
         enableAnimations(Settings::self()->animationDefault());
         enableEmbeddedMath(Settings::self()->embeddedMathDefault());
     }
+
+    enableResultMemoization(Settings::self()->resultMemoizationDefault());
+
+    //the state of the backend is lost on logout, all entries need to be evaluated again
+    connect(m_session, &Cantor::Session::statusChanged, this, [this](Cantor::Session::Status status) {
+        if (status != Cantor::Session::Disable)
+            return;
+
+        m_sessionCheckpoint.reset();
+        for (auto* entry = firstEntry(); entry; entry = entry->next())
+            if (entry->type() == CommandEntry::Type)
+                static_cast<CommandEntry*>(entry)->invalidateSessionState();
+    });
 }
 
 bool Worksheet::loadJupyterNotebook(const QJsonDocument& doc)
@@ -1946,6 +2470,21 @@ MathRenderer* Worksheet::mathRenderer()
     return &m_mathRenderer;
 }
 
+ImageCache* Worksheet::imageCache()
+{
+    return &m_imageCache;
+}
+
+SearchIndex* Worksheet::searchIndex()
+{
+    return m_searchIndex;
+}
+
+AnimationClock* Worksheet::animationClock()
+{
+    return m_animationClock;
+}
+
 QMenu* Worksheet::createContextMenu()
 {
     auto* menu = new QMenu(worksheetView());
@@ -14,11 +14,18 @@
 
 #include <QDomDocument>
 #include <QGraphicsScene>
+#include <QPointer>
 #include <QQueue>
+#include <QSet>
 #include <QVariantList>
+#include <QVariantMap>
+
+#include <functional>
+#include <memory>
 
 #include "lib/renderer.h"
 #include "mathrender.h"
+#include "imagecache.h"
 #include "worksheetcursor.h"
 
 namespace Cantor {
@@ -33,6 +40,8 @@ class CommandEntry;
 class WorksheetView;
 class HierarchyEntry;
 class WorksheetHierarchyManager;
+class SearchIndex;
+class AnimationClock;
 class PlaceHolderEntry;
 class WorksheetTextItem;
 
@@ -42,7 +51,7 @@ class QGraphicsObject;
 class QGraphicsPixmapItem;
 class QMenu;
 class QPixmap;
-class QPrinter;
+class QPagedPaintDevice;
 class QSyntaxHighlighter;
 class KActionCollection;
 class KToggleAction;
@@ -67,6 +76,11 @@ class Worksheet : public QGraphicsScene
 
     void loginToSession();
 
+    void evaluateNextStaleEntry(WorksheetEntry* after);
+    void commandEntryChanged(CommandEntry*);
+    void commandEntryEvaluated(CommandEntry*);
+    void commandEntryVariablesChanged(CommandEntry*, const QStringList& names);
+
     bool isRunning();
     bool isReadOnly();
     bool showExpressionIds();
@@ -75,6 +89,19 @@ class Worksheet : public QGraphicsScene
 
     bool isPrinting();
 
+    /**
+     * Returns @c true if the state of the session saved with the worksheet was collected
+     * after the last evaluation, s.a. collectSessionState()
+     */
+    bool isSessionStateCollected() const;
+
+    /**
+     * Saves the state of the backend to be stored with the worksheet, s.a. enableSessionStateSaving().
+     * The state is collected asynchronously once the session is done, it's not collected again
+     * if nothing was evaluated since the last time.
+     */
+    void collectSessionState();
+
     WorksheetView* worksheetView();
 
     void stopAnimations();
@@ -94,6 +121,9 @@ class Worksheet : public QGraphicsScene
     void populateMenu(QMenu*, QPointF);
     Cantor::Renderer* renderer();
     MathRenderer* mathRenderer();
+    ImageCache* imageCache();
+    SearchIndex* searchIndex();
+    AnimationClock* animationClock();
     bool isEmpty();
     bool isLoadingFromFile();
 
@@ -196,7 +226,8 @@ class Worksheet : public QGraphicsScene
     void followHierarchyFromView();
     void updateEntrySize(WorksheetEntry*);
 
-    void print(QPrinter*);
+    bool print(QPagedPaintDevice*);
+    void cancelPrinting();
     void paste();
     void focusEntry(WorksheetEntry*);
     void focusEntry(WorksheetEntry*, int pos, qreal xCoord = 0);
@@ -206,6 +237,7 @@ class Worksheet : public QGraphicsScene
     void evaluateToEntry(WorksheetEntry* entry);
     void resetEvaluationEndpoint();
     void evaluateCurrentEntry();
+    void evaluateStaleEntries();
     void interrupt();
     void interruptCurrentEntryEvaluation();
 
@@ -219,6 +251,8 @@ class Worksheet : public QGraphicsScene
     void enableExpressionNumbering(bool);
     void enableAnimations(bool);
     void enableEmbeddedMath(bool);
+    void enableResultMemoization(bool);
+    void enableSessionStateSaving(bool);
 
     QDomDocument toXML(KZip* archive = nullptr);
 
@@ -232,8 +266,8 @@ class Worksheet : public QGraphicsScene
     bool load(const QString&);
 
     void gotResult(Cantor::Expression* expr = nullptr);
-    void refreshTocStructure();
-    void scheduleTocStructureRefresh();
+    void refreshTocStructure(WorksheetEntry* changedEntry = nullptr);
+    void scheduleTocStructureRefresh(WorksheetEntry* changedEntry = nullptr);
     void emitTocNodeSnapshot();
 
     void removeCurrentEntry();
@@ -297,6 +331,7 @@ class Worksheet : public QGraphicsScene
     void loaded();
     void showHelp(const QString&);
     void tocNodesChanged(QVariantList nodes);
+    void tocNodesUpdated(QVariantMap delta);
     void currentTocNodeChanged(QString nodeId);
     void updatePrompt();
     void undoAvailable(bool);
@@ -309,6 +344,7 @@ class Worksheet : public QGraphicsScene
     void cut();
     void copy();
     void requestDocumentation(const QString&);
+    void printProgress(int page, int pageCount);
 
   protected:
     void contextMenuEvent(QGraphicsSceneContextMenuEvent*) override;
@@ -349,7 +385,9 @@ class Worksheet : public QGraphicsScene
 
   private:
     void evaluateEntries(WorksheetEntry* first, WorksheetEntry* last);
+    void evaluateAfterLogin(const std::function<void()>&);
     bool stopEvaluationAfter(WorksheetEntry* entry);
+    void invalidateDependentEntries(WorksheetEntry* entry, QSet<QString> names);
 
     WorksheetEntry* entryAt(qreal x, qreal y);
     WorksheetEntry* entryAt(QPointF);
@@ -362,6 +400,9 @@ class Worksheet : public QGraphicsScene
     void drawEntryCursor();
     int entryCount();
     bool loadCantorWorksheet(const KZip& archive);
+    void saveSessionState(KZip& archive);
+    void loadSessionState(const KZip& archive);
+    void restoreSessionState();
     bool loadJupyterNotebook(const QJsonDocument& doc);
     void showInvalidNotebookSchemeError(QString additionalInfo = QString());
     void initSession(Cantor::Backend*);
@@ -378,13 +419,23 @@ class Worksheet : public QGraphicsScene
     static const double EntryCursorWidth;
 
     WorksheetHierarchyManager* m_hierarchyManager{nullptr};
+    SearchIndex* m_searchIndex{nullptr};
+    AnimationClock* m_animationClock{nullptr};
 
     Cantor::Session* m_session{nullptr};
     Cantor::Renderer m_renderer;
     MathRenderer m_mathRenderer;
+    ImageCache m_imageCache;
     WorksheetEntry* m_firstEntry{nullptr};
     WorksheetEntry* m_lastEntry{nullptr};
     WorksheetEntry* m_evaluationLastEntry{nullptr};
+    QMetaObject::Connection m_pendingLoginEvaluation;
+    QMetaObject::Connection m_pendingStaleEvaluation;
+    struct SessionSnapshot;
+    std::unique_ptr<SessionSnapshot> m_sessionSnapshot;
+    struct SessionCheckpoint;
+    std::shared_ptr<SessionCheckpoint> m_sessionCheckpoint;
+    bool m_sessionStateCollecting{false};
     WorksheetEntry* m_dragEntry{nullptr};
     QEventLoop* m_entryDragEventLoop{nullptr};
     QGraphicsPixmapItem* m_dragPixmapItem{nullptr};
@@ -431,8 +482,10 @@ class Worksheet : public QGraphicsScene
     bool m_embeddedMathEnabled{false};
     bool m_showExpressionIds{false};
     bool m_animationsEnabled{false};
+    bool m_sessionStateSavingEnabled{false};
 
     bool m_isPrinting{false};
+    bool m_printingCanceled{false};
     bool m_isLoadingFromFile{false};
     bool m_isClosing{false};
     bool m_readOnly{false};
@@ -503,6 +503,11 @@ void WorksheetEntry::evaluateNext(EvaluationOption opt)
     if (opt == InternalEvaluation)
         return;
 
+    if (opt == EvaluateStale) {
+        worksheet()->evaluateNextStaleEntry(this);
+        return;
+    }
+
     if (opt == EvaluateNext && worksheet()->stopEvaluationAfter(this))
         return;
 
@@ -86,7 +86,7 @@ class WorksheetEntry : public QGraphicsObject
     QSizeF size();
 
     enum EvaluationOption {
-        InternalEvaluation, DoNothing, FocusNext, EvaluateNext
+        InternalEvaluation, DoNothing, FocusNext, EvaluateNext, EvaluateStale
     };
 
     virtual QGraphicsObject* mainTextItem() const;
@@ -47,35 +47,37 @@ size_t WorksheetHierarchyManager::hierarchyMaxDepth() const
     return m_hierarchyMaxDepth;
 }
 
-void WorksheetHierarchyManager::refreshTocStructure()
+void WorksheetHierarchyManager::refreshTocStructure(WorksheetEntry* changedEntry)
 {
+    if (changedEntry)
+        m_changedTocEntries.insert(changedEntry);
+
     if (m_worksheet->m_isClosing || m_worksheet->m_isLoadingFromFile)
         return;
 
     m_tocRefreshScheduled = false;
-    m_tocNodeSnapshot = collectTocNodes();
+    const QVariantList nodes = collectTocNodes();
 
-    if (!m_currentTocNodeId.isEmpty())
-    {
-        bool currentNodeStillExists = false;
-        for (const QVariant& nodeValue : m_tocNodeSnapshot)
-        {
-            if (nodeValue.toMap().value(QStringLiteral("id")).toString() == m_currentTocNodeId)
-            {
-                currentNodeStillExists = true;
-                break;
-            }
-        }
+    // only send what changed compared to the previous snapshot, the full snapshot
+    // is only sent if nodes were moved
+    bool reordered = false;
+    const QVariantMap delta = tocNodesDelta(m_tocNodeSnapshot, nodes, &reordered);
+    m_tocNodeSnapshot = nodes;
 
-        if (!currentNodeStillExists)
-            setCurrentTocNode(QString());
-    }
+    if (!m_currentTocNodeId.isEmpty() && delta.value(QStringLiteral("removed")).toStringList().contains(m_currentTocNodeId))
+        setCurrentTocNode(QString());
 
-    Q_EMIT m_worksheet->tocNodesChanged(m_tocNodeSnapshot);
+    if (reordered)
+        Q_EMIT m_worksheet->tocNodesChanged(m_tocNodeSnapshot);
+    else if (!delta.isEmpty())
+        Q_EMIT m_worksheet->tocNodesUpdated(delta);
 }
 
-void WorksheetHierarchyManager::scheduleTocStructureRefresh()
+void WorksheetHierarchyManager::scheduleTocStructureRefresh(WorksheetEntry* changedEntry)
 {
+    if (changedEntry)
+        m_changedTocEntries.insert(changedEntry);
+
     if (m_worksheet->m_isClosing || m_worksheet->m_isLoadingFromFile || m_tocRefreshScheduled)
         return;
 
@@ -100,9 +102,76 @@ void WorksheetHierarchyManager::emitTocNodeSnapshot()
     Q_EMIT m_worksheet->tocNodesChanged(m_tocNodeSnapshot);
 }
 
-QVariantList WorksheetHierarchyManager::collectTocNodes() const
+/*!
+ * compares two snapshots of the TOC nodes and returns the nodes that were inserted, removed or changed.
+ * Inserted nodes carry the id of the preceding node in "afterId". \c reordered is set to \c true
+ * if nodes present in both snapshots changed their order, the delta can't describe this.
+ */
+QVariantMap WorksheetHierarchyManager::tocNodesDelta(const QVariantList& oldNodes, const QVariantList& newNodes, bool* reordered)
+{
+    const QString idKey = QStringLiteral("id");
+
+    QHash<QString, int> oldIndexById;
+    oldIndexById.reserve(oldNodes.size());
+    for (int i = 0; i < oldNodes.size(); ++i)
+        oldIndexById.insert(oldNodes.at(i).toMap().value(idKey).toString(), i);
+
+    QVariantList inserted;
+    QVariantList changed;
+    QSet<QString> newIds;
+    newIds.reserve(newNodes.size());
+    int lastOldIndex = -1;
+    QString previousId;
+    *reordered = false;
+
+    for (const QVariant& node : newNodes)
+    {
+        const QString id = node.toMap().value(idKey).toString();
+        newIds.insert(id);
+
+        const auto it = oldIndexById.constFind(id);
+        if (it == oldIndexById.constEnd())
+        {
+            QVariantMap insertedNode = node.toMap();
+            insertedNode.insert(QStringLiteral("afterId"), previousId);
+            inserted.append(insertedNode);
+        }
+        else
+        {
+            if (*it < lastOldIndex)
+                *reordered = true;
+            lastOldIndex = *it;
+
+            // unchanged nodes share their data with the previous snapshot, the comparison is cheap for them
+            if (oldNodes.at(*it) != node)
+                changed.append(node);
+        }
+
+        previousId = id;
+    }
+
+    QStringList removed;
+    for (auto it = oldIndexById.constBegin(); it != oldIndexById.constEnd(); ++it)
+    {
+        if (!newIds.contains(it.key()))
+            removed.append(it.key());
+    }
+
+    QVariantMap delta;
+    if (!inserted.isEmpty())
+        delta.insert(QStringLiteral("inserted"), inserted);
+    if (!removed.isEmpty())
+        delta.insert(QStringLiteral("removed"), removed);
+    if (!changed.isEmpty())
+        delta.insert(QStringLiteral("changed"), changed);
+
+    return delta;
+}
+
+QVariantList WorksheetHierarchyManager::collectTocNodes()
 {
     QVariantList nodes;
+    QHash<QString, CommandTocNodes> commandTocNodes;
     QVector<QString> hierarchyNodeIds;
     QVector<int> hierarchyDepths;
 
@@ -196,66 +265,92 @@ QVariantList WorksheetHierarchyManager::collectTocNodes() const
         {
             auto* commandEntry = static_cast<CommandEntry*>(entry);
             const QString parentNodeId = hierarchyNodeIds.isEmpty() ? QString() : hierarchyNodeIds.last();
-            const QString commandNodeId = buildCommandNodeId(commandEntry);
-
-            QVariantMap commandNode;
-            commandNode.insert(QStringLiteral("id"), commandNodeId);
-            commandNode.insert(QStringLiteral("parentId"), parentNodeId);
-            commandNode.insert(QStringLiteral("type"), QString(TocNodeTypeCommand));
-            commandNode.insert(QStringLiteral("title"), commandTocTitle(commandEntry));
-            commandNode.insert(QStringLiteral("customTitle"), commandEntry->displayName());
-            commandNode.insert(QStringLiteral("displayText"), commandTocDisplayText(commandEntry));
-            commandNode.insert(QStringLiteral("hierarchyText"), QString());
-            commandNode.insert(QStringLiteral("depth"), hierarchyDepths.isEmpty() ? 0 : hierarchyDepths.last() + 1);
-            commandNode.insert(QStringLiteral("editable"), true);
-            commandNode.insert(QStringLiteral("navigable"), true);
-            commandNode.insert(QStringLiteral("hierarchyId"), QString());
-            commandNode.insert(QStringLiteral("resultIndex"), -1);
-            commandNode.insert(QStringLiteral("entryId"), commandEntry->commandId());
-            nodes.append(commandNode);
+            const int depth = hierarchyDepths.isEmpty() ? 0 : hierarchyDepths.last() + 1;
 
-            if (auto* expression = commandEntry->expression())
+            auto cached = m_commandTocNodes.take(commandEntry->commandId());
+            if (cached.entry != commandEntry || cached.parentNodeId != parentNodeId || cached.depth != depth
+                || cached.showExpressionIds != m_worksheet->m_showExpressionIds || m_changedTocEntries.contains(commandEntry))
             {
-                const auto& results = expression->results();
-                int plotCount = 0;
-                for (auto* result : results)
-                {
-                    if (isPlotResult(result))
-                        ++plotCount;
-                }
-
-                int plotOrdinal = 0;
-                for (int index = 0; index < results.size(); ++index)
-                {
-                    auto* result = results.at(index);
-                    if (!isPlotResult(result))
-                        continue;
-
-                    ++plotOrdinal;
-
-                    QVariantMap plotNode;
-                    const QString customTitle = result->displayName();
-                    plotNode.insert(QStringLiteral("id"), buildPlotNodeId(commandEntry->commandId(), result->resultId()));
-                    plotNode.insert(QStringLiteral("parentId"), commandNodeId);
-                    plotNode.insert(QStringLiteral("type"), QString(TocNodeTypePlot));
-                    plotNode.insert(QStringLiteral("title"), plotTocTitle(result));
-                    plotNode.insert(QStringLiteral("customTitle"), customTitle);
-                    plotNode.insert(QStringLiteral("displayText"), plotTocDisplayText(commandEntry, result, plotOrdinal, plotCount));
-                    plotNode.insert(QStringLiteral("hierarchyText"), QString());
-                    plotNode.insert(QStringLiteral("depth"), hierarchyDepths.isEmpty() ? 1 : hierarchyDepths.last() + 2);
-                    plotNode.insert(QStringLiteral("editable"), true);
-                    plotNode.insert(QStringLiteral("navigable"), true);
-                    plotNode.insert(QStringLiteral("hierarchyId"), QString());
-                    plotNode.insert(QStringLiteral("resultIndex"), index);
-                    plotNode.insert(QStringLiteral("resultId"), result->resultId());
-                    plotNode.insert(QStringLiteral("entryId"), commandEntry->commandId());
-                    nodes.append(plotNode);
-                }
+                cached.entry = commandEntry;
+                cached.parentNodeId = parentNodeId;
+                cached.depth = depth;
+                cached.showExpressionIds = m_worksheet->m_showExpressionIds;
+                cached.nodes = collectCommandTocNodes(commandEntry, parentNodeId, depth);
             }
+
+            nodes.append(cached.nodes);
+            commandTocNodes.insert(commandEntry->commandId(), cached);
         }
         return true;
     });
 
+    // the nodes of the removed command entries are dropped
+    m_commandTocNodes = commandTocNodes;
+    m_changedTocEntries.clear();
+
+    return nodes;
+}
+
+QVariantList WorksheetHierarchyManager::collectCommandTocNodes(CommandEntry* commandEntry, const QString& parentNodeId, int depth) const
+{
+    QVariantList nodes;
+    const QString commandNodeId = buildCommandNodeId(commandEntry);
+
+    QVariantMap commandNode;
+    commandNode.insert(QStringLiteral("id"), commandNodeId);
+    commandNode.insert(QStringLiteral("parentId"), parentNodeId);
+    commandNode.insert(QStringLiteral("type"), QString(TocNodeTypeCommand));
+    commandNode.insert(QStringLiteral("title"), commandTocTitle(commandEntry));
+    commandNode.insert(QStringLiteral("customTitle"), commandEntry->displayName());
+    commandNode.insert(QStringLiteral("displayText"), commandTocDisplayText(commandEntry));
+    commandNode.insert(QStringLiteral("hierarchyText"), QString());
+    commandNode.insert(QStringLiteral("depth"), depth);
+    commandNode.insert(QStringLiteral("editable"), true);
+    commandNode.insert(QStringLiteral("navigable"), true);
+    commandNode.insert(QStringLiteral("hierarchyId"), QString());
+    commandNode.insert(QStringLiteral("resultIndex"), -1);
+    commandNode.insert(QStringLiteral("entryId"), commandEntry->commandId());
+    nodes.append(commandNode);
+
+    if (auto* expression = commandEntry->expression())
+    {
+        const auto& results = expression->results();
+        int plotCount = 0;
+        for (auto* result : results)
+        {
+            if (isPlotResult(result))
+                ++plotCount;
+        }
+
+        int plotOrdinal = 0;
+        for (int index = 0; index < results.size(); ++index)
+        {
+            auto* result = results.at(index);
+            if (!isPlotResult(result))
+                continue;
+
+            ++plotOrdinal;
+
+            QVariantMap plotNode;
+            const QString customTitle = result->displayName();
+            plotNode.insert(QStringLiteral("id"), buildPlotNodeId(commandEntry->commandId(), result->resultId()));
+            plotNode.insert(QStringLiteral("parentId"), commandNodeId);
+            plotNode.insert(QStringLiteral("type"), QString(TocNodeTypePlot));
+            plotNode.insert(QStringLiteral("title"), plotTocTitle(result));
+            plotNode.insert(QStringLiteral("customTitle"), customTitle);
+            plotNode.insert(QStringLiteral("displayText"), plotTocDisplayText(commandEntry, result, plotOrdinal, plotCount));
+            plotNode.insert(QStringLiteral("hierarchyText"), QString());
+            plotNode.insert(QStringLiteral("depth"), depth + 1);
+            plotNode.insert(QStringLiteral("editable"), true);
+            plotNode.insert(QStringLiteral("navigable"), true);
+            plotNode.insert(QStringLiteral("hierarchyId"), QString());
+            plotNode.insert(QStringLiteral("resultIndex"), index);
+            plotNode.insert(QStringLiteral("resultId"), result->resultId());
+            plotNode.insert(QStringLiteral("entryId"), commandEntry->commandId());
+            nodes.append(plotNode);
+        }
+    }
+
     return nodes;
 }
 
@@ -912,7 +1007,7 @@ void WorksheetHierarchyManager::renameCommandEntry(const QString& commandId, con
 
     commandEntry->setDisplayName(normalizedTitle);
     m_worksheet->setModified();
-    scheduleTocStructureRefresh();
+    scheduleTocStructureRefresh(commandEntry);
 }
 
 void WorksheetHierarchyManager::deleteCommandEntry(const QString& commandId)
@@ -965,7 +1060,7 @@ void WorksheetHierarchyManager::renamePlot(const QString& commandId, const QStri
 
         result->setDisplayName(normalizedTitle);
         m_worksheet->setModified();
-        scheduleTocStructureRefresh();
+        scheduleTocStructureRefresh(commandEntry);
         return;
     }
 }
@@ -996,7 +1091,7 @@ void WorksheetHierarchyManager::deletePlot(const QString& commandId, const QStri
             setCurrentTocNode(buildCommandNodeId(commandEntry));
 
         m_worksheet->setModified();
-        scheduleTocStructureRefresh();
+        scheduleTocStructureRefresh(commandEntry);
         return;
     }
 }
@@ -1,7 +1,9 @@
 #ifndef WORKSHEETHIERARCHYMANAGER_H
 #define WORKSHEETHIERARCHYMANAGER_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QVariantList>
 #include <QVector>
@@ -26,8 +28,8 @@ class WorksheetHierarchyManager : public QObject
 
     size_t hierarchyMaxDepth() const;
 
-    void refreshTocStructure();
-    void scheduleTocStructureRefresh();
+    void refreshTocStructure(WorksheetEntry* changedEntry = nullptr);
+    void scheduleTocStructureRefresh(WorksheetEntry* changedEntry = nullptr);
     void emitTocNodeSnapshot();
 
     void updateHierarchyLayout();
@@ -74,7 +76,19 @@ class WorksheetHierarchyManager : public QObject
         QVector<HierarchyEntry*> collapsedAncestors;
     };
 
-    QVariantList collectTocNodes() const;
+    // nodes of a command entry and its plots, reused as long as the entry and its position in the hierarchy didn't change
+    struct CommandTocNodes
+    {
+        CommandEntry* entry{nullptr};
+        QString parentNodeId;
+        int depth{0};
+        bool showExpressionIds{false};
+        QVariantList nodes;
+    };
+
+    QVariantList collectTocNodes();
+    QVariantList collectCommandTocNodes(CommandEntry* entry, const QString& parentNodeId, int depth) const;
+    static QVariantMap tocNodesDelta(const QVariantList& oldNodes, const QVariantList& newNodes, bool* reordered);
     bool visitLogicalEntries(WorksheetEntry* first, const std::function<bool(WorksheetEntry*)>& visitor) const;
     bool visitLogicalEntries(const std::function<bool(WorksheetEntry*)>& visitor) const;
     bool findHierarchyEntryById(WorksheetEntry* first, const QString& hierarchyId, QVector<HierarchyEntry*> collapsedAncestors, HierarchySearchResult& result) const;
@@ -100,6 +114,8 @@ class WorksheetHierarchyManager : public QObject
     TrackingSource m_trackingSource{TrackingSource::Viewport};
     size_t m_hierarchyMaxDepth{0};
     QVariantList m_tocNodeSnapshot;
+    QHash<QString, CommandTocNodes> m_commandTocNodes;
+    QSet<WorksheetEntry*> m_changedTocEntries;
     bool m_tocRefreshScheduled{false};
 };
 
@@ -26,6 +26,9 @@ WorksheetView::WorksheetView(Worksheet* scene, QWidget* parent) : QGraphicsView(
     setRenderHint(QPainter::TextAntialiasing, true);
     setRenderHint(QPainter::SmoothPixmapTransform, true);
 
+    //the formulas in the visible area are rendered first
+    connect(this, &WorksheetView::viewRectChanged, scene->mathRenderer(), &MathRenderer::setViewRect);
+
     connect(verticalScrollBar(), &QScrollBar::sliderMoved, this, [this](int) {
         Q_EMIT userScrollStarted();
     });
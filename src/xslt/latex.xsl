@@ -2,7 +2,11 @@
 <xsl:output method = "text"/>
 <xsl:strip-space elements = "*"/>
 
+<!-- the worksheet is exported in parts: the header, every entry on its own and the footer -->
+<xsl:param name="part" select="'all'"/>
+
 <xsl:template match="Worksheet">
+<xsl:if test="$part = 'all' or $part = 'header'">
 <xsl:text>\documentclass[a4paper,10pt,fleqn]{article}
 
 \usepackage{fullpage}
@@ -12,8 +16,11 @@
 
 \begin{document}
 </xsl:text>
+</xsl:if>
 <xsl:apply-templates/>
+<xsl:if test="$part = 'all' or $part = 'footer'">
 <xsl:text>\end{document}&#xA;</xsl:text>
+</xsl:if>
 </xsl:template>
 
 <xsl:template match="Result">